@@ -67,7 +67,7 @@ static void bitslice_butterflies12_256(__m256i out[][12], uint64_t (*in)[12], ui
 {
     int32_t i, j, k, b, s;
     int32_t twiddle_idx = 0;
-    __m256i tmp[12];
+    __m256i tmp[12], w0[12], w1[12];
     __m256i va, vb;
     
     /**
@@ -91,29 +91,41 @@ static void bitslice_butterflies12_256(__m256i out[][12], uint64_t (*in)[12], ui
         }
     }
     
-    /* i <- 0 */
-    for (j=0; j<16; j++) {
-        for (k=j; k<j+1; k++) {
-            bitslice_mul12_256(tmp, out[k], twiddle_factors[0]);
-            for (b=0; b<12; b++) {
-                vb = _mm256_shuffle_epi32(tmp[b], _MM_SHUFFLE(3, 2, 3, 2));
-                va = _mm256_slli_si256(out[k][b], 8);
-                vb = _mm256_xor_si256(va, vb);
-                out[k][b] = _mm256_xor_si256(out[k][b], vb);
-            }
+    /**
+     * i <- 0 and i <- 1
+     *
+     * Half of the lanes of twiddle_factors[0] and twiddle_factors[1]
+     * are zero, so the points to be multiplied from two consecutive
+     * 256-bit blocks are gathered into a single block.
+     **/
+    for (b=0; b<12; b++) {
+        w0[b] = _mm256_unpackhi_epi64(twiddle_factors[0][b], twiddle_factors[0][b]);
+        w1[b] = _mm256_permute2x128_si256(twiddle_factors[1][b], twiddle_factors[1][b], 0x11);
+    }
+    for (k=0; k<16; k+=2) {
+        for (b=0; b<12; b++)
+            tmp[b] = _mm256_unpackhi_epi64(out[k][b], out[k+1][b]);
+        bitslice_mul12_256(tmp, tmp, w0);
+        for (b=0; b<12; b++) {
+            va = _mm256_slli_si256(out[k][b], 8);
+            vb = _mm256_unpacklo_epi64(tmp[b], tmp[b]);
+            out[k][b] = _mm256_xor_si256(out[k][b], _mm256_xor_si256(va, vb));
+            va = _mm256_slli_si256(out[k+1][b], 8);
+            vb = _mm256_unpackhi_epi64(tmp[b], tmp[b]);
+            out[k+1][b] = _mm256_xor_si256(out[k+1][b], _mm256_xor_si256(va, vb));
         }
     }
-    
-    /* i <- 1 */
-    for (j=0; j<16; j++) {
-        for (k=j; k<j+1; k++) {
-            bitslice_mul12_256(tmp, out[k], twiddle_factors[1]);
-            for (b=0; b<12; b++) {
-                vb = _mm256_set_epi64x(tmp[b][3], tmp[b][2], tmp[b][3], tmp[b][2]);
-                va = _mm256_permute2x128_si256(out[k][b], out[k][b], _MM_SHUFFLE(0, 0, 2, 0));
-                vb = _mm256_xor_si256(va, vb);
-                out[k][b] = _mm256_xor_si256(out[k][b], vb);
-            }
+    for (k=0; k<16; k+=2) {
+        for (b=0; b<12; b++)
+            tmp[b] = _mm256_permute2x128_si256(out[k][b], out[k+1][b], 0x31);
+        bitslice_mul12_256(tmp, tmp, w1);
+        for (b=0; b<12; b++) {
+            va = _mm256_permute2x128_si256(out[k][b], out[k][b], _MM_SHUFFLE(0, 0, 2, 0));
+            vb = _mm256_permute2x128_si256(tmp[b], tmp[b], 0x00);
+            out[k][b] = _mm256_xor_si256(out[k][b], _mm256_xor_si256(va, vb));
+            va = _mm256_permute2x128_si256(out[k+1][b], out[k+1][b], _MM_SHUFFLE(0, 0, 2, 0));
+            vb = _mm256_permute2x128_si256(tmp[b], tmp[b], 0x11);
+            out[k+1][b] = _mm256_xor_si256(out[k+1][b], _mm256_xor_si256(va, vb));
         }
     }
     
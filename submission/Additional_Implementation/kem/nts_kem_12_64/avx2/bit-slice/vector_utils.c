@@ -19,6 +19,144 @@
 #undef bit_value
 #define bit_value(v,i)          (((v)[(i)>>6] & (1ULL<<((i) & 63))) >> ((i) & 63))
 
+/* Transpose an 8x8 bit matrix stored one row per byte */
+static inline uint64_t transpose_8x8(uint64_t x)
+{
+    uint64_t t;
+
+    t = (x ^ (x >>  7)) & 0x00AA00AA00AA00AAULL; x ^= t ^ (t <<  7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL; x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL; x ^= t ^ (t << 28);
+    return x;
+}
+
+/* Bitslice 64 field elements, 8 at a time as two 8x8 bit matrices */
+static void load_block_64(uint64_t b[PARAM_M], const uint16_t* a)
+{
+    int32_t i, j, k;
+    uint64_t lo, hi;
+
+    for (i=0; i<PARAM_M; i++)
+        b[i] = 0ULL;
+    for (j=0; j<8; j++) {
+        lo = hi = 0ULL;
+        for (k=0; k<8; k++) {
+            lo |= (uint64_t)(a[8*j + k] & 0xFF) << (8*k);
+            hi |= (uint64_t)(a[8*j + k] >> 8) << (8*k);
+        }
+        lo = transpose_8x8(lo);
+        hi = transpose_8x8(hi);
+        for (i=0; i<8; i++)
+            b[i] |= ((lo >> (8*i)) & 0xFF) << (8*j);
+        for (i=8; i<PARAM_M; i++)
+            b[i] |= ((hi >> (8*(i-8))) & 0xFF) << (8*j);
+    }
+}
+
+/* Inverse of load_block_64 */
+static void store_block_64(uint16_t* b, const uint64_t a[PARAM_M])
+{
+    int32_t i, j, k;
+    uint64_t lo, hi;
+
+    for (j=0; j<8; j++) {
+        lo = hi = 0ULL;
+        for (i=0; i<8; i++)
+            lo |= ((a[i] >> (8*j)) & 0xFF) << (8*i);
+        for (i=8; i<PARAM_M; i++)
+            hi |= ((a[i] >> (8*j)) & 0xFF) << (8*(i-8));
+        lo = transpose_8x8(lo);
+        hi = transpose_8x8(hi);
+        for (k=0; k<8; k++)
+            b[8*j + k] = (uint16_t)(((lo >> (8*k)) & 0xFF) | (((hi >> (8*k)) & 0xFF) << 8));
+    }
+}
+
+/**
+ *  Bitslice 128 field elements. The low and high bytes of 16 elements
+ *  are packed into separate registers, and each bit-plane is then
+ *  extracted with a single shift and movemask.
+ **/
+static void load_block_128(__m128i b[PARAM_M], const uint16_t* a)
+{
+    int32_t i, j;
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    __m128i x0, x1, lo, hi;
+    uint16_t v[PARAM_M][8];
+
+    for (j=0; j<8; j++) {
+        x0 = _mm_loadu_si128((const __m128i*)&a[16*j]);
+        x1 = _mm_loadu_si128((const __m128i*)&a[16*j + 8]);
+        lo = _mm_packus_epi16(_mm_and_si128(x0, mask), _mm_and_si128(x1, mask));
+        hi = _mm_packus_epi16(_mm_srli_epi16(x0, 8), _mm_srli_epi16(x1, 8));
+        for (i=0; i<8; i++)
+            v[i][j] = (uint16_t)_mm_movemask_epi8(_mm_slli_epi16(lo, 7-i));
+        for (i=8; i<PARAM_M; i++)
+            v[i][j] = (uint16_t)_mm_movemask_epi8(_mm_slli_epi16(hi, 15-i));
+    }
+    for (i=0; i<PARAM_M; i++)
+        b[i] = _mm_loadu_si128((const __m128i*)v[i]);
+    CT_memset(v, 0, sizeof(v));
+}
+
+/**
+ *  Bitslice 256 field elements, 32 at a time. This is the 256-bit
+ *  counterpart of load_block_128; the permute undoes the in-lane
+ *  ordering of _mm256_packus_epi16.
+ **/
+static void load_block_256(__m256i b[PARAM_M], const uint16_t* a)
+{
+    int32_t i, j;
+    const __m256i mask = _mm256_set1_epi16(0x00FF);
+    __m256i x0, x1, lo, hi;
+    uint32_t v[PARAM_M][8];
+
+    for (j=0; j<8; j++) {
+        x0 = _mm256_loadu_si256((const __m256i*)&a[32*j]);
+        x1 = _mm256_loadu_si256((const __m256i*)&a[32*j + 16]);
+        lo = _mm256_packus_epi16(_mm256_and_si256(x0, mask), _mm256_and_si256(x1, mask));
+        hi = _mm256_packus_epi16(_mm256_srli_epi16(x0, 8), _mm256_srli_epi16(x1, 8));
+        lo = _mm256_permute4x64_epi64(lo, 0xD8);
+        hi = _mm256_permute4x64_epi64(hi, 0xD8);
+        for (i=0; i<8; i++)
+            v[i][j] = (uint32_t)_mm256_movemask_epi8(_mm256_slli_epi16(lo, 7-i));
+        for (i=8; i<PARAM_M; i++)
+            v[i][j] = (uint32_t)_mm256_movemask_epi8(_mm256_slli_epi16(hi, 15-i));
+    }
+    for (i=0; i<PARAM_M; i++)
+        b[i] = _mm256_loadu_si256((const __m256i*)v[i]);
+    CT_memset(v, 0, sizeof(v));
+}
+
+/**
+ *  Inverse of load_block_256. Each 16-bit slice of a bit-plane is
+ *  broadcast and compared against the lane masks, which expands it
+ *  into one bit of 16 field elements.
+ **/
+static void store_block_256(uint16_t* b, const __m256i a[PARAM_M])
+{
+    int32_t i, j;
+    const __m256i lane = _mm256_set_epi16((short)0x8000, 0x4000, 0x2000, 0x1000,
+                                          0x0800, 0x0400, 0x0200, 0x0100,
+                                          0x0080, 0x0040, 0x0020, 0x0010,
+                                          0x0008, 0x0004, 0x0002, 0x0001);
+    __m256i x, acc;
+    uint16_t v[PARAM_M][16];
+
+    for (i=0; i<PARAM_M; i++)
+        _mm256_storeu_si256((__m256i*)v[i], a[i]);
+    for (j=0; j<16; j++) {
+        acc = _mm256_setzero_si256();
+        for (i=0; i<PARAM_M; i++) {
+            x = _mm256_and_si256(_mm256_set1_epi16((short)v[i][j]), lane);
+            x = _mm256_cmpeq_epi16(x, lane);
+            acc = _mm256_or_si256(acc, _mm256_and_si256(x, _mm256_set1_epi16(1 << i)));
+        }
+        _mm256_storeu_si256((__m256i*)&b[16*j], acc);
+    }
+    CT_memset(v, 0, sizeof(v));
+}
+
 uint64_t vector_ff_or_64(const uint64_t *in)
 {
     int32_t i;
@@ -51,21 +189,17 @@ void vector_load_1d_64(uint64_t b[PARAM_M], const uint16_t* a, int32_t size)
 
 void vector_load_2d_64(uint64_t (*b)[PARAM_M], const uint16_t* a, int32_t size)
 {
-    int32_t i, j, k;
+    int32_t j;
+    uint16_t t[64];
 
-    for (i=0; i<PARAM_M; i++) {
-        for (j=0; j<size/64; j++) {
-            b[j][i] = 0ULL;
-            for (k=0; k<64; k++) {
-                b[j][i] |= ((uint64_t)((a[64*j + k] >> i) & 1) << k);
-            }
-        }
-        if (size & 0x3F) {
-            b[j][i] = 0ULL;
-            for (k=0; k<(size & 0x3F); k++) {
-                b[j][i] |= ((uint64_t)((a[64*j + k] >> i) & 1) << k);
-            }
-        }
+    for (j=0; j<size/64; j++) {
+        load_block_64(b[j], &a[64*j]);
+    }
+    if (size & 0x3F) {
+        CT_memset(t, 0, sizeof(t));
+        memcpy(t, &a[64*j], (size & 0x3F)*sizeof(uint16_t));
+        load_block_64(b[j], t);
+        CT_memset(t, 0, sizeof(t));
     }
 }
 
@@ -85,24 +219,17 @@ void vector_load_1d_256(__m256i b[PARAM_M], const uint16_t* a, int32_t size)
 
 void vector_load_2d_256(__m256i (*b)[PARAM_M], const uint16_t* a, int32_t size)
 {
-    int32_t i, j, k;
-    uint64_t v[4];
-    
-    for (i=0; i<PARAM_M; i++) {
-        for (j=0; j<size/256; j++) {
-            CT_memset(v, 0, sizeof(v));
-            for (k=0; k<256; k++) {
-                v[k >> 6] |= ((uint64_t)((a[256*j + k] >> i) & 1) << (k & 63));
-            }
-            b[j][i] = _mm256_set_epi64x(v[3], v[2], v[1], v[0]);
-        }
-        if (size & 0xFF) {
-            CT_memset(v, 0, sizeof(v));
-            for (k=0; k<(size & 0xFF); k++) {
-                v[k >> 6] |= ((uint64_t)((a[256*j + k] >> i) & 1) << (k & 63));
-            }
-            b[j][i] = _mm256_set_epi64x(v[3], v[2], v[1], v[0]);
-        }
+    int32_t j;
+    uint16_t t[256];
+
+    for (j=0; j<size/256; j++) {
+        load_block_256(b[j], &a[256*j]);
+    }
+    if (size & 0xFF) {
+        CT_memset(t, 0, sizeof(t));
+        memcpy(t, &a[256*j], (size & 0xFF)*sizeof(uint16_t));
+        load_block_256(b[j], t);
+        CT_memset(t, 0, sizeof(t));
     }
 }
 
@@ -120,46 +247,32 @@ void vector_store_1d_64(uint16_t* b, const uint64_t a[PARAM_M], int32_t size)
 
 void vector_store_2d_64(uint16_t* b, const uint64_t (*a)[PARAM_M], int32_t size)
 {
-    int32_t i, j, k;
-    uint64_t v[1];
-    
-    CT_memset(b, 0, size*sizeof(uint16_t));
-    for (i=0; i<PARAM_M; i++) {
-        for (j=0; j<size/64; j++) {
-            v[0] = a[j][i];
-            for (k=0; k<64; k++) {
-                b[j*64 + k] |= (bit_value(v, k) << i);
-            }
-        }
-        if (size & 0x3F) {
-            v[0] = a[j][i];
-            for (k=0; k<(size & 0x3F); k++) {
-                b[j*64 + k] |= (bit_value(v, k) << i);
-            }
-        }
+    int32_t j;
+    uint16_t t[64];
+
+    for (j=0; j<size/64; j++) {
+        store_block_64(&b[64*j], a[j]);
+    }
+    if (size & 0x3F) {
+        store_block_64(t, a[j]);
+        memcpy(&b[64*j], t, (size & 0x3F)*sizeof(uint16_t));
+        CT_memset(t, 0, sizeof(t));
     }
 }
 
 void vector_load_2d_128(__m128i (*b)[PARAM_M], const uint16_t* a, int32_t size)
 {
-    int32_t i, j, k;
-    uint64_t v[2];
-    
-    for (i=0; i<PARAM_M; i++) {
-        for (j=0; j<size/128; j++) {
-            CT_memset(v, 0, sizeof(v));
-            for (k=0; k<128; k++) {
-                v[k >> 6] |= ((uint64_t)((a[128*j + k] >> i) & 1) << (k & 63));
-            }
-            b[j][i] = _mm_set_epi64x(v[1], v[0]);
-        }
-        if (size & 0x7F) {
-            CT_memset(v, 0, sizeof(v));
-            for (k=0; k<(size & 0x7F); k++) {
-                v[k >> 6] |= ((uint64_t)((a[128*j + k] >> i) & 1) << (k & 63));
-            }
-            b[j][i] = _mm_set_epi64x(v[1], v[0]);
-        }
+    int32_t j;
+    uint16_t t[128];
+
+    for (j=0; j<size/128; j++) {
+        load_block_128(b[j], &a[128*j]);
+    }
+    if (size & 0x7F) {
+        CT_memset(t, 0, sizeof(t));
+        memcpy(t, &a[128*j], (size & 0x7F)*sizeof(uint16_t));
+        load_block_128(b[j], t);
+        CT_memset(t, 0, sizeof(t));
     }
 }
 
@@ -179,22 +292,15 @@ void vector_store_1d_256(uint16_t* b, const __m256i a[PARAM_M], int32_t size)
 
 void vector_store_2d_256(uint16_t* b, const __m256i (*a)[PARAM_M], int32_t size)
 {
-    int32_t i, j, k;
-    uint64_t v[4];
-    
-    CT_memset(b, 0, size*sizeof(uint16_t));
-    for (i=0; i<PARAM_M; i++) {
-        for (j=0; j<size/256; j++) {
-            _mm256_store_si256((__m256i*)v, a[j][i]);
-            for (k=0; k<256; k++) {
-                b[j*256 + k] |= (bit_value(v, k) << i);
-            }
-        }
-        if (size & 0xFF) {
-            _mm256_store_si256((__m256i*)v, a[j][i]);
-            for (k=0; k<(size & 0xFF); k++) {
-                b[j*128 + k] |= (bit_value(v, k) << i);
-            }
-        }
+    int32_t j;
+    uint16_t t[256];
+
+    for (j=0; j<size/256; j++) {
+        store_block_256(&b[256*j], a[j]);
+    }
+    if (size & 0xFF) {
+        store_block_256(t, a[j]);
+        memcpy(&b[256*j], t, (size & 0xFF)*sizeof(uint16_t));
+        CT_memset(t, 0, sizeof(t));
     }
 }
@@ -14,6 +14,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include "api.h"
+#include "ff.h"
+#include "vector_ff.h"
 #include "ntskem_test.h"
 #include "random.h"
 
@@ -117,3 +119,94 @@ int testkem_nts(int iterations)
 
     return status;
 }
+
+void bitslice_mul12_64(uint64_t* c, const uint64_t* a, const uint64_t* b);
+void bitslice_mul12_128(__m128i* c, const __m128i* a, const __m128i* b);
+void bitslice_mul12_256(__m256i* c, const __m256i* a, const __m256i* b);
+
+static void mul_64(const FF2m* ff2m, uint64_t* c, const uint64_t* a, const uint64_t* b)
+{
+    bitslice_mul12_64(c, a, b);
+}
+
+static void mul_128(const FF2m* ff2m, uint64_t* c, const uint64_t* a, const uint64_t* b)
+{
+    bitslice_mul12_128((__m128i *)c, (const __m128i *)a, (const __m128i *)b);
+}
+
+static void mul_256(const FF2m* ff2m, uint64_t* c, const uint64_t* a, const uint64_t* b)
+{
+    bitslice_mul12_256((__m256i *)c, (const __m256i *)a, (const __m256i *)b);
+}
+
+static void mul_vector(const FF2m* ff2m, uint64_t* c, const uint64_t* a, const uint64_t* b)
+{
+    ff2m->vector_ff_mul(ff2m, (vector *)c, (const vector *)a, (const vector *)b);
+}
+
+/**
+ *  Check the bit-sliced field multipliers against ff_mul on all
+ *  the pairs of field elements, 256 pairs at a time. A multiplier
+ *  of 64.w lanes handles these in slices of w words per bit plane.
+ **/
+int testkem_ff_mul()
+{
+    int i, j, k, l, s, status = 1;
+    uint32_t x, y;
+    ff_unit z;
+    const FF2m *ff2m = NULL;
+    uint64_t a[NTSKEM_M*4] __attribute__((aligned(32)));
+    uint64_t b[NTSKEM_M*4] __attribute__((aligned(32)));
+    uint64_t c[NTSKEM_M*4] __attribute__((aligned(32)));
+    uint64_t d[NTSKEM_M*4] __attribute__((aligned(32)));
+    uint64_t e[NTSKEM_M*4] __attribute__((aligned(32)));
+    uint64_t f[NTSKEM_M*4] __attribute__((aligned(32)));
+    struct {
+        void (*mul)(const FF2m*, uint64_t*, const uint64_t*, const uint64_t*);
+        int words;
+    } muls[] = {
+        { mul_64, 1 },
+        { mul_128, 2 },
+        { mul_256, 4 },
+        { mul_vector, sizeof(vector)/sizeof(uint64_t) }
+    };
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Field Multiplication Test\n", NTSKEM_M, NTSKEM_T);
+    
+    if (!(ff2m = ff_create()))
+        return 0;
+    
+    for (x=0; x<(1 << NTSKEM_M); x++) {
+        for (y=0; y<(1 << NTSKEM_M); y+=256) {
+            memset(b, 0, sizeof(b));
+            memset(d, 0, sizeof(d));
+            for (i=0; i<256; i++) {
+                z = ff2m->ff_mul(ff2m, (ff_unit)x, (ff_unit)(y + i));
+                for (j=0; j<NTSKEM_M; j++) {
+                    b[j*4 + (i >> 6)] |= (uint64_t)(((y + i) >> j) & 1) << (i & 63);
+                    d[j*4 + (i >> 6)] |= (uint64_t)((z >> j) & 1) << (i & 63);
+                }
+            }
+            for (k=0; k<sizeof(muls)/sizeof(muls[0]); k++) {
+                for (s=0; s<4; s+=muls[k].words) {
+                    for (j=0; j<NTSKEM_M; j++) {
+                        for (l=0; l<muls[k].words; l++) {
+                            a[j*muls[k].words + l] = -(uint64_t)((x >> j) & 1);
+                            e[j*muls[k].words + l] = b[j*4 + s + l];
+                        }
+                    }
+                    muls[k].mul(ff2m, c, a, e);
+                    for (j=0; j<NTSKEM_M; j++) {
+                        for (l=0; l<muls[k].words; l++)
+                            f[j*4 + s + l] = c[j*muls[k].words + l];
+                    }
+                }
+                status &= (0 == memcmp(d, f, sizeof(f)));
+            }
+        }
+    }
+    
+    ff_release(ff2m);
+    
+    return status;
+}
@@ -0,0 +1,342 @@
+/**
+ *  vector_ff.h
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(12, 64)
+ *  Platform: AVX2
+ *
+ *  Vectorised arithmetic over F_{2^12}. The functions used in
+ *  the hot loops are defined here so that they can be called
+ *  directly and inlined, rather than through an FF2m instance.
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#ifndef __NTSKEM_VECTOR_FF_H
+#define __NTSKEM_VECTOR_FF_H
+
+#include "ff.h"
+
+/**
+ *  Vectorised multiplication, {@see FF2m}
+ *
+ *  @param[in]  ff2m  Unused, may be NULL
+ *  @param[out] d     Pointer to an output array
+ *  @param[in]  a     Pointer to an input array
+ *  @param[in]  b     Pointer to another input array
+ **/
+static inline void vector_ff_mul_12(const FF2m* ff2m, vector* d, const vector* a, const vector* b)
+{
+    __m256i c[12] = {{0}};
+    
+    /**
+     * These sequences of & and ^ are obtained from here:
+     * http://www.cs.yale.edu/homes/peralta/CircuitStuff/binary_pol_mult/CMT12.txt
+     *
+     * Circuit Minimization Work
+     *
+     * The gates, including those of the modulo reduction, are listed
+     * in an order which keeps few values live, to avoid register spills
+     **/
+    __m256i h22 = a[11] & b[11];
+    __m256i y2 = a[11] & b[9];
+    __m256i y3 = a[11] & b[10];
+    __m256i y4 = a[9] & b[11];
+    __m256i y179 = y2 ^ y4;
+    __m256i y5 = a[10] & b[11];
+    __m256i h21 = y5 ^ y3;
+    __m256i y6 = a[10] & b[10];
+    __m256i h20 = y6 ^ y179;
+    __m256i y7 = a[10] & b[9];
+    __m256i y8 = a[9] & b[10];
+    __m256i y10 = y8 ^ y7;
+    __m256i y9 = a[9] & b[9];
+    __m256i y12 = a[8] & b[8];
+    __m256i y51 = y12 ^ y10;
+    __m256i y13 = a[8] & b[6];
+    __m256i y14 = a[8] & b[7];
+    __m256i y15 = a[6] & b[8];
+    __m256i y16 = y13 ^ y15;
+    __m256i y17 = a[7] & b[8];
+    __m256i y23 = y17 ^ y14;
+    __m256i y50 = y23 ^ y9;
+    __m256i y92 = h21 ^ y50;
+    __m256i y18 = a[7] & b[7];
+    __m256i y183 = y16 ^ y18;
+    __m256i y186 = h20 ^ y183;
+    __m256i y19 = a[7] & b[6];
+    __m256i y20 = a[6] & b[7];
+    __m256i y22 = y20 ^ y19;
+    __m256i y21 = a[6] & b[6];
+    __m256i y24 = a[5] & b[5];
+    __m256i y49 = y24 ^ y22;
+    __m256i y91 = y51 ^ y49;
+    __m256i y25 = a[5] & b[3];
+    __m256i y26 = a[5] & b[4];
+    __m256i y27 = a[3] & b[5];
+    __m256i y184 = y25 ^ y27;
+    __m256i y28 = a[4] & b[5];
+    __m256i y34 = y28 ^ y26;
+    __m256i y48 = y34 ^ y21;
+    __m256i y29 = a[4] & b[4];
+    __m256i y185 = y29 ^ y184;
+    __m256i y200 = y185 ^ y186;
+    __m256i y30 = a[4] & b[3];
+    __m256i y31 = a[3] & b[4];
+    __m256i y33 = y31 ^ y30;
+    __m256i y32 = a[3] & b[3];
+    __m256i y35 = a[2] & b[2];
+    __m256i y47 = y35 ^ y33;
+    __m256i y36 = a[2] & b[0];
+    __m256i y37 = a[2] & b[1];
+    __m256i y38 = a[0] & b[2];
+    __m256i y181 = y36 ^ y38;
+    __m256i y39 = a[1] & b[2];
+    __m256i y45 = y39 ^ y37;
+    __m256i y46 = y45 ^ y32;
+    __m256i y88 = y48 ^ y46;
+    __m256i y40 = a[1] & b[1];
+    c[2] = y40 ^ y181;
+    __m256i y187 = c[2] ^ y185;
+    __m256i y198 = y183 ^ y187;
+    __m256i y41 = a[1] & b[0];
+    __m256i y42 = a[0] & b[1];
+    c[1] = y42 ^ y41;
+    __m256i y87 = y47 ^ c[1];
+    c[0] = a[0] & b[0];
+    __m256i y52 = b[6] ^ b[9];
+    __m256i y53 = b[7] ^ b[10];
+    __m256i y54 = b[8] ^ b[11];
+    __m256i y55 = a[6] ^ a[9];
+    __m256i y61 = y55 & y54;
+    __m256i y65 = y55 & y53;
+    __m256i y66 = y55 & y52;
+    __m256i y90 = y50 ^ y66;
+    __m256i y98 = y90 ^ y48;
+    __m256i y56 = a[7] ^ a[10];
+    __m256i y62 = y56 & y54;
+    __m256i y63 = y56 & y53;
+    __m256i y64 = y56 & y52;
+    __m256i y67 = y65 ^ y64;
+    __m256i y99 = y91 ^ y67;
+    __m256i y57 = a[8] ^ a[11];
+    __m256i y58 = y57 & y54;
+    __m256i y93 = h22 ^ y58;
+    __m256i h19 = y93 ^ y51;
+    __m256i y59 = y57 & y52;
+    __m256i y188 = y59 ^ y61;
+    __m256i y189 = y63 ^ y188;
+    __m256i h17 = y186 ^ y189;
+    __m256i y60 = y57 & y53;
+    __m256i y68 = y62 ^ y60;
+    __m256i h18 = y92 ^ y68;
+    __m256i y69 = b[0] ^ b[3];
+    __m256i y70 = b[1] ^ b[4];
+    __m256i y71 = b[2] ^ b[5];
+    __m256i y72 = a[0] ^ a[3];
+    __m256i y78 = y72 & y71;
+    __m256i y82 = y72 & y70;
+    __m256i y83 = y72 & y69;
+    __m256i y86 = y83 ^ c[0];
+    c[3] = y86 ^ y46;
+    __m256i y165 = y98 ^ c[3];
+    __m256i y73 = a[1] ^ a[4];
+    __m256i y79 = y73 & y71;
+    __m256i y80 = y73 & y70;
+    __m256i y81 = y73 & y69;
+    __m256i y84 = y82 ^ y81;
+    c[4] = y87 ^ y84;
+    __m256i y166 = y99 ^ c[4];
+    __m256i y74 = a[2] ^ a[5];
+    __m256i y75 = y74 & y71;
+    __m256i y89 = y49 ^ y75;
+    __m256i y97 = y89 ^ y47;
+    __m256i y76 = y74 & y69;
+    __m256i y191 = y76 ^ y78;
+    __m256i y192 = y80 ^ y191;
+    c[5] = y187 ^ y192;
+    __m256i y77 = y74 & y70;
+    __m256i y85 = y79 ^ y77;
+    __m256i y96 = y88 ^ y85;
+    __m256i y167 = h18 ^ y96;
+    __m256i y202 = h17 ^ c[5];
+    c[5] ^= h17;
+    __m256i y168 = h19 ^ y97;
+    __m256i y102 = b[3] ^ b[9];
+    __m256i y103 = b[4] ^ b[10];
+    __m256i y104 = b[5] ^ b[11];
+    __m256i y105 = b[0] ^ b[6];
+    __m256i y136 = y105 ^ y102;
+    __m256i y106 = b[1] ^ b[7];
+    __m256i y137 = y106 ^ y103;
+    __m256i y107 = b[2] ^ b[8];
+    __m256i y138 = y107 ^ y104;
+    __m256i y108 = a[3] ^ a[9];
+    __m256i y128 = y108 & y104;
+    __m256i y132 = y108 & y103;
+    __m256i y133 = y108 & y102;
+    __m256i y109 = a[4] ^ a[10];
+    __m256i y129 = y109 & y104;
+    __m256i y130 = y109 & y103;
+    __m256i y131 = y109 & y102;
+    __m256i y134 = y132 ^ y131;
+    __m256i y110 = a[5] ^ a[11];
+    __m256i y125 = y110 & y104;
+    __m256i y126 = y110 & y102;
+    __m256i y196 = y126 ^ y128;
+    __m256i y197 = y130 ^ y196;
+    __m256i h14 = y197 ^ y200;
+    c[5] ^= h14;
+    c[2] ^= h14;
+    __m256i y127 = y110 & y103;
+    __m256i y135 = y129 ^ y127;
+    __m256i y169 = h21 ^ y135;
+    __m256i h15 = y169 ^ y98;
+    c[3] ^= h15;
+    __m256i y170 = h22 ^ y125;
+    __m256i h16 = y170 ^ y99;
+    c[4] ^= h16;
+    __m256i y111 = a[0] ^ a[6];
+    __m256i y139 = y111 ^ y108;
+    __m256i y145 = y139 & y138;
+    __m256i y149 = y139 & y137;
+    __m256i y150 = y139 & y136;
+    __m256i y117 = y111 & y107;
+    __m256i y121 = y111 & y106;
+    __m256i y122 = y111 & y105;
+    __m256i y155 = y150 ^ y122;
+    __m256i y163 = y122 ^ c[0];
+    c[6] = y163 ^ y96;
+    c[6] ^= h18;
+    c[6] ^= h15;
+    __m256i y112 = a[1] ^ a[7];
+    __m256i y140 = y112 ^ y109;
+    __m256i y146 = y140 & y138;
+    __m256i y147 = y140 & y137;
+    __m256i y206 = y145 ^ y147;
+    __m256i y204 = y197 ^ y206;
+    __m256i y148 = y140 & y136;
+    __m256i y151 = y149 ^ y148;
+    __m256i y118 = y112 & y107;
+    __m256i y119 = y112 & y106;
+    __m256i y120 = y112 & y105;
+    __m256i y123 = y121 ^ y120;
+    __m256i y156 = y151 ^ y123;
+    __m256i y164 = y123 ^ c[1];
+    c[7] = y164 ^ y97;
+    c[7] ^= h19;
+    c[7] ^= h16;
+    __m256i y113 = a[2] ^ a[8];
+    __m256i y114 = y113 & y107;
+    __m256i y154 = y114 ^ y134;
+    __m256i y160 = y156 ^ y154;
+    c[10] = y166 ^ y160;
+    c[10] ^= h22;
+    c[10] ^= h19;
+    __m256i y115 = y113 & y105;
+    __m256i y194 = y115 ^ y117;
+    __m256i y195 = y119 ^ y194;
+    c[8] = y195 ^ y198;
+    c[8] ^= h20;
+    c[8] ^= h17;
+    __m256i y116 = y113 & y106;
+    __m256i y124 = y118 ^ y116;
+    __m256i y153 = y124 ^ y133;
+    __m256i y141 = y113 ^ y110;
+    __m256i y142 = y141 & y138;
+    __m256i y158 = y142 ^ y125;
+    __m256i y162 = y158 ^ y154;
+    __m256i h13 = y168 ^ y162;
+    h13 ^= h22;
+    c[4] ^= h13;
+    c[1] ^= h13;
+    __m256i y143 = y141 & y136;
+    __m256i y203 = y195 ^ y143;
+    __m256i y205 = y204 ^ y203;
+    c[11] = y205 ^ y202;
+    c[11] ^= h20;
+    __m256i y144 = y141 & y137;
+    __m256i y152 = y146 ^ y144;
+    __m256i y157 = y152 ^ y135;
+    __m256i y161 = y157 ^ y153;
+    __m256i h12 = y167 ^ y161;
+    __m256i y159 = y155 ^ y153;
+    c[9] = y165 ^ y159;
+    c[9] ^= h21;
+    c[9] ^= h18;
+    h12 ^= h21;
+    c[3] ^= h12;
+    c[0] ^= h12;
+    
+    d[ 0] = c[ 0]; d[ 1] = c[ 1];
+    d[ 2] = c[ 2]; d[ 3] = c[ 3];
+    d[ 4] = c[ 4]; d[ 5] = c[ 5];
+    d[ 6] = c[ 6]; d[ 7] = c[ 7];
+    d[ 8] = c[ 8]; d[ 9] = c[ 9];
+    d[10] = c[10]; d[11] = c[11];
+}
+
+/**
+ *  Vectorised squaring, {@see FF2m}
+ *
+ *  @param[in]  ff2m  Unused, may be NULL
+ *  @param[out] b     Pointer to an output array
+ *  @param[in]  a     Pointer to an input array
+ **/
+static inline void vector_ff_sqr_12(const FF2m* ff2m, vector* b, const vector* a)
+{
+    b[ 0] = a[ 0] ^ a[ 6];
+    b[ 1] = a[11];
+    b[ 2] = a[ 1] ^ a[ 7];
+    b[ 3] = a[ 6];
+    b[ 4] = a[ 2] ^ a[ 8] ^ a[11];
+    b[ 5] = a[ 7];
+    b[ 6] = a[ 3] ^ a[ 9];
+    b[ 7] = a[ 8];
+    b[ 8] = a[ 4] ^ a[10];
+    b[ 9] = a[ 9];
+    b[10] = a[ 5] ^ a[11];
+    b[11] = a[10];
+}
+
+/**
+ *  Obtain the XOR of the tranposed of the input array, {@see FF2m}
+ *
+ *  @param[in]  ff2m  Unused, may be NULL
+ *  @param[in]  a     Pointer to an input array
+ *  @return The XOR output
+ **/
+static inline ff_unit vector_ff_transpose_xor_12(const struct FF2m* ff2m,
+                                                 const vector* a)
+{
+    ff_unit s = 0;
+
+    s  = (vector_popcount(a[ 0]) & 1);
+    s |= (vector_popcount(a[ 1]) & 1) <<  1;
+    s |= (vector_popcount(a[ 2]) & 1) <<  2;
+    s |= (vector_popcount(a[ 3]) & 1) <<  3;
+    s |= (vector_popcount(a[ 4]) & 1) <<  4;
+    s |= (vector_popcount(a[ 5]) & 1) <<  5;
+    s |= (vector_popcount(a[ 6]) & 1) <<  6;
+    s |= (vector_popcount(a[ 7]) & 1) <<  7;
+    s |= (vector_popcount(a[ 8]) & 1) <<  8;
+    s |= (vector_popcount(a[ 9]) & 1) <<  9;
+    s |= (vector_popcount(a[10]) & 1) << 10;
+    s |= (vector_popcount(a[11]) & 1) << 11;
+    
+    return s;
+}
+
+/**
+ *  Vectorised inversion, {@see FF2m}
+ **/
+void vector_ff_inv_12(const FF2m* ff2m, vector* b, const vector* a);
+
+/**
+ *  Vectorised square and inversion, {@see FF2m}
+ **/
+void vector_ff_sqr_inv_12(const FF2m* ff2m, vector* b, const vector* a);
+
+#endif /* __NTSKEM_VECTOR_FF_H */
@@ -64,7 +64,7 @@ static void bitslice_butterflies12_128(__m128i out[][12], uint64_t (*in)[12], ui
 {
     int32_t i, j, k, b, s;
     int32_t twiddle_idx = 0;
-    __m128i v[12];
+    __m128i v[12], w[12];
     
     /**
      * Broadcast
@@ -86,14 +86,25 @@ static void bitslice_butterflies12_128(__m128i out[][12], uint64_t (*in)[12], ui
         }
     }
     
-    /* i <- 0 */
-    for (j=0; j<32; j++) {
-        bitslice_mul12_128(v, out[j], twiddle_factors[ twiddle_idx ]);
+    /**
+     * i <- 0
+     *
+     * The lower lane of twiddle_factors[0] is zero, so the odd points
+     * of two consecutive 128-bit blocks are gathered into a single block.
+     **/
+    for (b=0; b<12; b++)
+        w[b] = _mm_unpackhi_epi64(twiddle_factors[ twiddle_idx ][b], twiddle_factors[ twiddle_idx ][b]);
+    for (j=0; j<32; j+=2) {
+        for (b=0; b<12; b++)
+            v[b] = _mm_unpackhi_epi64(out[j][b], out[j+1][b]);
+        bitslice_mul12_128(v, v, w);
         for (b=0; b<12; b++) {
-            v[b] = _mm_shuffle_epi32(v[b], _MM_SHUFFLE(3, 2, 3, 2));
             out[j][b] = _mm_xor_si128(out[j][b],
-                                      _mm_xor_si128(v[b],
+                                      _mm_xor_si128(_mm_unpacklo_epi64(v[b], v[b]),
                                                     _mm_slli_si128(out[j][b], 8)));
+            out[j+1][b] = _mm_xor_si128(out[j+1][b],
+                                        _mm_xor_si128(_mm_unpackhi_epi64(v[b], v[b]),
+                                                      _mm_slli_si128(out[j+1][b], 8)));
         }
     }
     
@@ -16,6 +16,7 @@
 #include <inttypes.h>
 #include "nts_kem.h"
 #include "ff.h"
+#include "vector_ff.h"
 #include "bits.h"
 #include "matrix_ff2.h"
 #include "polynomial.h"
@@ -33,12 +34,12 @@
 
 typedef struct {
     uint32_t m;
-    FF2m *ff2m;
+    const FF2m *ff2m;
     ff_unit a[ NTS_KEM_PARAM_BC ];
     ff_unit h[ NTS_KEM_PARAM_BC ];
     ff_unit p[ NTS_KEM_PARAM_N ];
     uint8_t z[ NTS_KEM_KEY_SIZE ];
-    uint8_t pk[ NTS_KEM_PUBLIC_KEY_SIZE ];
+    const uint8_t *pk;          /* The public key within the private key */
 } NTSKEM_private;
 
 static const int kNTSKEMKeysize = NTS_KEM_KEY_SIZE;
@@ -72,6 +73,7 @@ void unpack_buffer(const uint8_t *src, ff_unit *dst, int dst_len);
 int serialise_public_key(NTSKEM* nts_kem, const matrix_ff2* SGP);
 int serialise_private_key(NTSKEM *nts_kem, const matrix_ff2* Q);
 int deserialise_private_key(NTSKEM* nts_kem, const uint8_t *buf);
+void load_private_key(NTSKEM* nts_kem, NTSKEM_private* priv, const uint8_t *sk);
 void load_input_ciphertext(vector *out, const uint8_t *in);
 
 /**
@@ -263,8 +265,14 @@ int nts_kem_init_from_private_key(NTSKEM** nts_kem,
     if (!priv->ff2m)
         goto nts_kem_init_fail;
     
+    /* Keep a copy of the private key blob, the public-key is read from it */
+    nts_kem_ptr->private_key = (uint8_t *)malloc(NTS_KEM_PRIVATE_KEY_SIZE);
+    if (!nts_kem_ptr->private_key)
+        goto nts_kem_init_fail;
+    memcpy(nts_kem_ptr->private_key, ptr, NTS_KEM_PRIVATE_KEY_SIZE);
+    
     /* Deserialise the private key blob */
-    if (deserialise_private_key(nts_kem_ptr, ptr) != NTS_KEM_SUCCESS) {
+    if (deserialise_private_key(nts_kem_ptr, nts_kem_ptr->private_key) != NTS_KEM_SUCCESS) {
         goto nts_kem_init_fail;
     }
     
@@ -407,7 +415,8 @@ int nts_kem_decapsulate(const uint8_t *sk,
     int32_t i, status = NTS_KEM_BAD_MEMORY_ALLOCATION;
     int32_t extended_error = 0;
     uint32_t checksum = 0, error_weight = 0;
-    NTSKEM *nts_kem = NULL;
+    NTSKEM nts_kem_sk, *nts_kem = &nts_kem_sk;
+    NTSKEM_private priv_sk;
     NTSKEM_private *priv = NULL;
     vector in_cipher[NTS_KEM_PARAM_BC_VEC];
     __m128i vec_syndromes[1][NTS_KEM_PARAM_M] = {{{0}}};
@@ -431,17 +440,16 @@ int nts_kem_decapsulate(const uint8_t *sk,
     uint64_t start_clock, end_clock;
 #endif
     
-    if (!k_r || !c_ast) {
+    if (!sk || !k_r || !c_ast) {
         status = NTS_KEM_BAD_PARAMETERS;
         goto decapsulation_failure;
     }
     
     /**
-     * Construct an NTS object from private key
+     * Construct an NTS object from private key, a, h, p and z are
+     * unpacked to the stack and the public key is read from sk
      **/
-    if (NTS_KEM_SUCCESS != nts_kem_init_from_private_key(&nts_kem, sk, NTS_KEM_PRIVATE_KEY_SIZE))
-        goto decapsulation_failure;
-    
+    load_private_key(nts_kem, &priv_sk, sk);
     priv = nts_kem->priv;
 
     /**
@@ -589,8 +597,7 @@ decapsulation_failure:
     CT_memset(c_prime, 0, NTS_KEM_CIPHERTEXT_SIZE);
     CT_memset(syndromes, 0, sizeof(syndromes));
     CT_memset(evals, 0, sizeof(evals));
-    if (nts_kem)
-        nts_kem_release(nts_kem);
+    CT_memset(&priv_sk, 0, sizeof(priv_sk));
     
     return status;
 }
@@ -799,7 +806,7 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
      * Calculate G(a_i)^{-2} using vectorised implementation
      **/
     for (i=0,j=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-        priv->ff2m->vector_ff_sqr_inv(priv->ff2m, hv1[i], hv0[i]);
+        vector_ff_sqr_inv_12(priv->ff2m, hv1[i], hv0[i]);
     }
     vector_store_2d_128(h, (const __m128i (*)[])hv1, NTS_KEM_PARAM_N);
     
@@ -819,7 +826,7 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
     }
     /* h_1 = h_0 * a */
     for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-        priv->ff2m->vector_ff_mul(priv->ff2m, hv0[i], hv1[i], av0[i]);
+        vector_ff_mul_12(priv->ff2m, hv0[i], hv1[i], av0[i]);
     }
     /* The second batch of NTS_KEM_PARAM_M rows of parity-check matrix */
     for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
@@ -832,7 +839,7 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
     for (l=2; l<Gz->degree; l+=2) {
         /* h_l = h_{l-1} * a */
         for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-            priv->ff2m->vector_ff_mul(priv->ff2m, hv1[i], hv0[i], av0[i]);
+            vector_ff_mul_12(priv->ff2m, hv1[i], hv0[i], av0[i]);
         }
         /* The l-th batch of NTS_KEM_PARAM_M rows of parity-check matrix */
         for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
@@ -844,7 +851,7 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
         }
         /* h_l = h_{l-1} * a */
         for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-            priv->ff2m->vector_ff_mul(priv->ff2m, hv0[i], hv1[i], av0[i]);
+            vector_ff_mul_12(priv->ff2m, hv0[i], hv1[i], av0[i]);
         }
         /* The (l+1)-th batch of NTS_KEM_PARAM_M rows of parity-check matrix */
         for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
@@ -912,6 +919,83 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
     return Q;
 }
 
+/**
+ *  Pack 8 units of 12 bits into 12 bytes, using a 64-bit and a 32-bit word
+ **/
+static inline void pack_12x8(const ff_unit *src, uint8_t *dst)
+{
+    int32_t i;
+    uint64_t w0;
+    uint32_t w1;
+    
+    w0 = ((uint64_t)(src[0] & 0x0FFF)      ) | ((uint64_t)(src[1] & 0x0FFF) << 12) |
+         ((uint64_t)(src[2] & 0x0FFF) << 24) | ((uint64_t)(src[3] & 0x0FFF) << 36) |
+         ((uint64_t)(src[4] & 0x0FFF) << 48) | ((uint64_t)(src[5] & 0x0FFF) << 60);
+    w1 = ((uint32_t)(src[5] & 0x0FFF) >>  4) | ((uint32_t)(src[6] & 0x0FFF) <<  8) |
+         ((uint32_t)(src[7] & 0x0FFF) << 20);
+    for (i=0; i<8; i++) dst[i]   = (uint8_t)(w0 >> (i << 3));
+    for (i=0; i<4; i++) dst[8+i] = (uint8_t)(w1 >> (i << 3));
+}
+
+/**
+ *  Unpack 12 bytes into 8 units of 12 bits, using a 64-bit and a 32-bit word
+ **/
+static inline void unpack_12x8(const uint8_t *src, ff_unit *dst)
+{
+    int32_t i;
+    uint64_t w0 = 0;
+    uint32_t w1 = 0;
+    
+    for (i=0; i<8; i++) w0 |= ((uint64_t)src[i]   << (i << 3));
+    for (i=0; i<4; i++) w1 |= ((uint32_t)src[8+i] << (i << 3));
+    dst[0] = (ff_unit)( w0        & 0x0FFF);
+    dst[1] = (ff_unit)((w0 >> 12) & 0x0FFF);
+    dst[2] = (ff_unit)((w0 >> 24) & 0x0FFF);
+    dst[3] = (ff_unit)((w0 >> 36) & 0x0FFF);
+    dst[4] = (ff_unit)((w0 >> 48) & 0x0FFF);
+    dst[5] = (ff_unit)(((w0 >> 60) | (w1 << 4)) & 0x0FFF);
+    dst[6] = (ff_unit)((w1 >>  8) & 0x0FFF);
+    dst[7] = (ff_unit)((w1 >> 20) & 0x0FFF);
+}
+
+/**
+ *  Pack 8 units of 12 bits into 12 bytes
+ *
+ *  @note
+ *  The odd units are shifted up by 4 bits, the bytes are then moved
+ *  in place with shuffles, even and odd units separately as they
+ *  share a byte. 16 bytes are written at `dst`.
+ **/
+static inline void pack_12x8_sse(const ff_unit *src, uint8_t *dst)
+{
+    __m128i v, out;
+    
+    v = _mm_and_si128(_mm_loadu_si128((const __m128i *)src), _mm_set1_epi16(0x0FFF));
+    v = _mm_blend_epi16(v, _mm_slli_epi16(v, 4), 0xAA);
+    out = _mm_or_si128(
+            _mm_shuffle_epi8(v, _mm_setr_epi8( 0,  1, -1,  4,  5, -1,  8,  9, -1, 12, 13, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(v, _mm_setr_epi8(-1,  2,  3, -1,  6,  7, -1, 10, 11, -1, 14, 15, -1, -1, -1, -1)));
+    _mm_storeu_si128((__m128i *)dst, out);
+}
+
+/**
+ *  Unpack 12 bytes into 8 units of 12 bits
+ *
+ *  @note
+ *  The 2 bytes holding each unit are gathered into a 16-bit lane
+ *  with shuffles and the odd units are shifted down by 4 bits.
+ *  16 bytes are read from `src`.
+ **/
+static inline void unpack_12x8_sse(const uint8_t *src, ff_unit *dst)
+{
+    __m128i v;
+    
+    v = _mm_loadu_si128((const __m128i *)src);
+    v = _mm_shuffle_epi8(v, _mm_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11));
+    v = _mm_blend_epi16(v, _mm_srli_epi16(v, 4), 0xAA);
+    _mm_storeu_si128((__m128i *)dst, _mm_and_si128(v, _mm_set1_epi16(0x0FFF)));
+}
+
 /**
  *  Pack buffer of 2*src_len bytes into a buffer of
  *  size src_len*3/2.
@@ -922,16 +1006,21 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
  **/
 void pack_buffer(const uint8_t *src, int src_len, uint8_t *dst)
 {
-    int32_t i;
-    const uint8_t* src_ptr = src;
-    uint8_t *dst_ptr = dst;
+    int32_t i = 0;
+    const ff_unit *src_ptr = (const ff_unit *)src;
+    
+    /* The vector stores write past the group, keep them within dst */
+    for (; i+16<=src_len; i+=8) {
+        pack_12x8_sse(&src_ptr[i], &dst[((i*3) >> 1)]);
+    }
+    for (; i+8<=src_len; i+=8) {
+        pack_12x8(&src_ptr[i], &dst[((i*3) >> 1)]);
+    }
     /* Every two units consume three bytes */
-    for (i=0; i<src_len; i+=2) {
-        *dst_ptr  = *src_ptr++; dst_ptr++;
-        *dst_ptr  = *src_ptr++;
-        *dst_ptr |= ((*src_ptr   & 0x0F) << 4); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xF0) >> 4);
-        *dst_ptr |= ((*src_ptr++ & 0x0F) << 4); dst_ptr++;
+    for (; i<src_len; i+=2) {
+        dst[((i*3) >> 1)    ] = (uint8_t)(src_ptr[i] & 0xFF);
+        dst[((i*3) >> 1) + 1] = (uint8_t)(((src_ptr[i] >> 8) & 0x0F) | ((src_ptr[i+1] & 0x0F) << 4));
+        dst[((i*3) >> 1) + 2] = (uint8_t)((src_ptr[i+1] >> 4) & 0xFF);
     }
 }
 
@@ -944,12 +1033,18 @@ void pack_buffer(const uint8_t *src, int src_len, uint8_t *dst)
  **/
 void unpack_buffer(const uint8_t *src, ff_unit *dst, int dst_len)
 {
-    int32_t i, value;
-    const uint8_t *src_ptr = src;
-
+    int32_t i = 0, value;
+    
+    /* The vector loads read past the group, keep them within src */
+    for (; i+16<=dst_len; i+=8) {
+        unpack_12x8_sse(&src[((i*3) >> 1)], &dst[i]);
+    }
+    for (; i+8<=dst_len; i+=8) {
+        unpack_12x8(&src[((i*3) >> 1)], &dst[i]);
+    }
     /* Read three bytes in ago */
-    for (i=0; i<dst_len; i+=2,src_ptr+=3) {
-        value = (*(src_ptr+2) << 16) | (*(src_ptr+1) << 8) | *src_ptr;
+    for (; i<dst_len; i+=2) {
+        value = (src[((i*3) >> 1) + 2] << 16) | (src[((i*3) >> 1) + 1] << 8) | src[((i*3) >> 1)];
         dst[i]   = (value & 0x00000FFF);
         dst[i+1] = (value & 0x00FFF000) >> 12;
     }
@@ -1021,6 +1116,7 @@ int serialise_private_key(NTSKEM *nts_kem, const matrix_ff2* Q)
     
     memcpy(key_ptr, priv->z, NTS_KEM_KEY_SIZE);
     key_ptr += NTS_KEM_KEY_SIZE;
+    priv->pk = key_ptr;
     
     for (i=0; i<NTS_KEM_PARAM_K; i++) {
         v_ptr = (packed_t *)row_ptr_matrix_ff2(Q, i);
@@ -1035,6 +1131,32 @@ int serialise_private_key(NTSKEM *nts_kem, const matrix_ff2* Q)
     return NTS_KEM_SUCCESS;
 }
 
+/**
+ *  Initialise an NTS-KEM object in place from a private key,
+ *  without any memory allocation
+ *
+ *  @note
+ *  The public key is not copied, it is read from the private key
+ *  buffer, which has to outlive the object. The object must not
+ *  be released with {@see nts_kem_release}.
+ *
+ *  @param[out] nts_kem  The NTS-KEM object
+ *  @param[out] priv     The private component of the object
+ *  @param[in]  sk       The pointer to NTS-KEM private key
+ **/
+void load_private_key(NTSKEM* nts_kem, NTSKEM_private* priv, const uint8_t *sk)
+{
+    nts_kem->length = NTS_KEM_PARAM_N;
+    nts_kem->t = NTS_KEM_PARAM_T;
+    nts_kem->public_key = nts_kem->private_key = NULL;
+    nts_kem->public_key_size = 0;
+    nts_kem->private_key_size = NTS_KEM_PRIVATE_KEY_SIZE;
+    nts_kem->priv = priv;
+    priv->m = NTS_KEM_PARAM_M;
+    priv->ff2m = ff_create(priv->m);
+    deserialise_private_key(nts_kem, sk);
+}
+
 /**
  *  Deserialise NTS-KEM private key
  *
@@ -1062,8 +1184,8 @@ int deserialise_private_key(NTSKEM* nts_kem, const uint8_t *buf)
     memcpy(priv->z, buf, NTS_KEM_KEY_SIZE);
     buf += NTS_KEM_KEY_SIZE;
     
-    /* Deserialise public-key */
-    memcpy(priv->pk, buf, NTS_KEM_PUBLIC_KEY_SIZE);
+    /* The public-key is used in place */
+    priv->pk = buf;
 
     return NTS_KEM_SUCCESS;
 }
@@ -1109,20 +1231,16 @@ int encapsulate(const uint8_t *e,
     int status = NTS_KEM_BAD_MEMORY_ALLOCATION;
     int32_t i, j, l;
     packed_t v;
-    const uint8_t *pk_ptr = pk;
     vector c_c[NTS_KEM_PARAM_R_VEC];
-    vector Q[NTS_KEM_PARAM_K][NTS_KEM_PARAM_R_VEC];
+    vector q[NTS_KEM_PARAM_R_VEC];
     uint8_t kr_in_buf[kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_N_BYTE];
     uint8_t k_e[kNTSKEMKeysize];
     
     /**
-     * Populate the generator matrix, but only the parity section
+     * The rows of the parity section Q of the generator matrix
+     * are read from the public key as they are needed
      **/
-    for (i=0; i<NTS_KEM_PARAM_K; i++) {
-        Q[i][NTS_KEM_PARAM_R_VEC-1] = _mm_setzero_si128();
-        memcpy(Q[i], pk_ptr, NTS_KEM_PARAM_CEIL_R_BYTE);
-        pk_ptr += NTS_KEM_PARAM_CEIL_R_BYTE;
-    }
+    q[NTS_KEM_PARAM_R_VEC-1] = _mm_setzero_si128();
     
     /**
      * Step 3. Compute SHA3_256(e) to produce k_e
@@ -1153,8 +1271,9 @@ int encapsulate(const uint8_t *e,
             l = (int32_t)lowest_bit_idx(v);
             v ^= (ONE << l);
             l += (BITSIZE*i);
+            memcpy(q, &pk[l*NTS_KEM_PARAM_CEIL_R_BYTE], NTS_KEM_PARAM_CEIL_R_BYTE);
             for (j=0; j<NTS_KEM_PARAM_R_VEC; j++) {
-                c_c[j] ^= Q[l][j];
+                c_c[j] ^= q[j];
             }
         }
     }
@@ -1164,8 +1283,9 @@ int encapsulate(const uint8_t *e,
         l = (int32_t)lowest_bit_idx(v);
         v ^= (ONE << l);
         l += (BITSIZE*i);
+        memcpy(q, &pk[l*NTS_KEM_PARAM_CEIL_R_BYTE], NTS_KEM_PARAM_CEIL_R_BYTE);
         for (j=0; j<NTS_KEM_PARAM_R_VEC; j++) {
-            c_c[j] ^= Q[l][j];
+            c_c[j] ^= q[j];
         }
     }
     for (i=0; i<NTS_KEM_PARAM_B >> LOG2; i++) {
@@ -1174,8 +1294,9 @@ int encapsulate(const uint8_t *e,
             l = (int32_t)lowest_bit_idx(v);
             v ^= (ONE << l);
             l += ((BITSIZE*i) + NTS_KEM_PARAM_A);
+            memcpy(q, &pk[l*NTS_KEM_PARAM_CEIL_R_BYTE], NTS_KEM_PARAM_CEIL_R_BYTE);
             for (j=0; j<NTS_KEM_PARAM_R_VEC; j++) {
-                c_c[j] ^= Q[l][j];
+                c_c[j] ^= q[j];
             }
         }
     }
@@ -1217,6 +1338,7 @@ int encapsulate(const uint8_t *e,
     sha3_256(kr_in_buf, kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_N_BYTE, k_r);
     
     status = NTS_KEM_SUCCESS;
+    CT_memset(q, 0, sizeof(q));
     CT_memset(kr_in_buf, 0, kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_N_BYTE);
     
     return status;
@@ -1244,7 +1366,7 @@ int compute_syndrome(const NTSKEM* nts_kem,
                      ff_unit* s)
 {
     int32_t i, j;
-    FF2m *ff2m = NULL;
+    const FF2m *ff2m = NULL;
     NTSKEM_private *priv = NULL;
     vector a[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
     vector g[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
@@ -1265,15 +1387,15 @@ int compute_syndrome(const NTSKEM* nts_kem,
         for (j=0; j<NTS_KEM_PARAM_M; j++)
             g[i][j] &= *c_ptr;
         c_ptr++;
-        s[0] ^= ff2m->vector_ff_transpose_xor(ff2m, g[i]);
+        s[0] ^= vector_ff_transpose_xor_12(ff2m, g[i]);
         for (j=1; j<=2*NTS_KEM_PARAM_T-2; j+=2) {
-            ff2m->vector_ff_mul(ff2m, h[i], a[i], g[i]);
-            s[j]   ^= ff2m->vector_ff_transpose_xor(ff2m, h[i]);
-            ff2m->vector_ff_mul(ff2m, g[i], a[i], h[i]);
-            s[j+1] ^= ff2m->vector_ff_transpose_xor(ff2m, g[i]);
+            vector_ff_mul_12(ff2m, h[i], a[i], g[i]);
+            s[j]   ^= vector_ff_transpose_xor_12(ff2m, h[i]);
+            vector_ff_mul_12(ff2m, g[i], a[i], h[i]);
+            s[j+1] ^= vector_ff_transpose_xor_12(ff2m, g[i]);
         }
-        ff2m->vector_ff_mul(ff2m, h[i], a[i], g[i]);
-        s[j] ^= ff2m->vector_ff_transpose_xor(ff2m, h[i]);
+        vector_ff_mul_12(ff2m, h[i], a[i], g[i]);
+        s[j] ^= vector_ff_transpose_xor_12(ff2m, h[i]);
     }
     
     CT_memset(a, 0, sizeof(a));
@@ -37,6 +37,7 @@ int main(int argc, char *argv[])
 
     randombytes_init(entropy_input, (const unsigned char *)nonce, 256);
     status = testkem_nts(iterations);
+    status &= testkem_ff_mul();
     printf("NTS-KEM(%d, %d) test: %s\n", NTSKEM_M, NTSKEM_T, status ? "PASS" : "FAIL");
 
     return 0;
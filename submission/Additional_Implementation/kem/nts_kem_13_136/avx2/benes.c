@@ -0,0 +1,433 @@
+/**
+ *  benes.c
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+#include "benes.h"
+#include "mem.h"
+#include "nts_kem_errors.h"
+
+#define int32_MINMAX(a,b) \
+do { \
+    int32_t ab = (b) ^ (a); \
+    int32_t c = (b) - (a); \
+    c ^= ab & (c ^ (b)); \
+    c >>= 31; \
+    c &= ab; \
+    (a) ^= c; \
+    (b) ^= c; \
+} while(0)
+
+static inline int32_t int32_min(int32_t a, int32_t b)
+{
+    int32_MINMAX(a, b);
+    return a;
+}
+
+/**
+ *  Compare-and-swap two disjoint runs of integers, x_i <- min(x_i, y_i)
+ *  and y_i <- max(x_i, y_i)
+ **/
+static void int32_minmax_run(int32_t * restrict x, int32_t * restrict y, int32_t len)
+{
+    int32_t i;
+    __m256i a, b;
+    
+    for (i=0; i+8<=len; i+=8) {
+        a = _mm256_loadu_si256((const __m256i *)&x[i]);
+        b = _mm256_loadu_si256((const __m256i *)&y[i]);
+        _mm256_storeu_si256((__m256i *)&x[i], _mm256_min_epi32(a, b));
+        _mm256_storeu_si256((__m256i *)&y[i], _mm256_max_epi32(a, b));
+    }
+    for (; i<len; ++i)
+        int32_MINMAX(x[i], y[i]);
+}
+
+/**
+ *  Compare-and-swap x_i and x_{i+j} for all i with bit j clear, where
+ *  j >= 8. The order is ascending if bit k of i is clear, otherwise
+ *  descending.
+ **/
+static void int32_minmax_blocks(int32_t *x, int32_t n, int32_t j, int32_t k)
+{
+    int32_t i, l;
+    __m256i v, w;
+    
+    for (i=0; i<n; i+=2*j) {
+        for (l=i; l<i+j; l+=8) {
+            v = _mm256_loadu_si256((const __m256i *)&x[l]);
+            w = _mm256_loadu_si256((const __m256i *)&x[l+j]);
+            if (i & k) {
+                _mm256_storeu_si256((__m256i *)&x[l], _mm256_max_epi32(v, w));
+                _mm256_storeu_si256((__m256i *)&x[l+j], _mm256_min_epi32(v, w));
+            }
+            else {
+                _mm256_storeu_si256((__m256i *)&x[l], _mm256_min_epi32(v, w));
+                _mm256_storeu_si256((__m256i *)&x[l+j], _mm256_max_epi32(v, w));
+            }
+        }
+    }
+}
+
+/**
+ *  Compare-and-swap x_i and x_{i+j} for all i with bit j clear, where
+ *  j < 8, within each vector of 8 integers. The order is ascending if
+ *  bit k of i is clear, otherwise descending.
+ **/
+static void int32_minmax_lanes(int32_t *x, int32_t n, int32_t j, int32_t k)
+{
+    int32_t i, l;
+    int32_t take_min[8];
+    __m256i v, w, m;
+    
+    /* The lanes that take the minimum of an ascending block of 8 */
+    for (l=0; l<8; l++)
+        take_min[l] = -(int32_t)(((l & j) == 0) ^ ((l & k) != 0));
+    m = _mm256_loadu_si256((const __m256i *)take_min);
+    
+    for (i=0; i<n; i+=8) {
+        v = _mm256_loadu_si256((const __m256i *)&x[i]);
+        if (j == 4)
+            w = _mm256_permute2x128_si256(v, v, 0x01);
+        else if (j == 2)
+            w = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+        else
+            w = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm256_blendv_epi8(_mm256_max_epi32(v, w), _mm256_min_epi32(v, w),
+                               (i & k) ? _mm256_xor_si256(m, _mm256_set1_epi32(-1)) : m);
+        _mm256_storeu_si256((__m256i *)&x[i], v);
+    }
+}
+
+/**
+ *  Constant-time bitonic sorting network on 32-bit integers, the
+ *  number of integers n is a power of 2
+ *
+ *  @note
+ *  Within a merge step of span j, the comparators of a block of 2j
+ *  integers all go the same way, so once the blocks are at least 8
+ *  long they are done 8 at a time with vector minimum and maximum,
+ *  shorter blocks are done within vectors
+ **/
+static void int32_sort(int32_t *x, int32_t n)
+{
+    int32_t i, j, k;
+    
+    for (k=2; k<=n; k<<=1) {
+        for (j=k>>1; j>0; j>>=1) {
+            if (n < 8) {
+                for (i=0; i<n; i+=2*j) {
+                    if (i & k)
+                        int32_minmax_run(&x[i+j], &x[i], j);
+                    else
+                        int32_minmax_run(&x[i], &x[i+j], j);
+                }
+            }
+            else if (j >= 8)
+                int32_minmax_blocks(x, n, j, k);
+            else
+                int32_minmax_lanes(x, n, j, k);
+        }
+    }
+}
+
+/**
+ *  Control bits of a permutation pi of {0, 1, ..., n-1}, n = 2^w,
+ *  following [2]. The (2w-1)n/2 control bits are written at bit
+ *  positions pos, pos+step, ... of out, which must be zeroed first.
+ *  temp must have space for 2n integers.
+ **/
+static void cbrecursion(uint8_t *out,
+                        int32_t pos,
+                        int32_t step,
+                        const int16_t *pi,
+                        int32_t w,
+                        int32_t n,
+                        int32_t *temp)
+{
+    int32_t x, i, j, k;
+    int32_t *A = temp;
+    int32_t *B = temp + n;
+    int16_t *q = (int16_t *)(temp + n + n/4);
+    int32_t Ax, px, cx, fj, Fx, lk, Ly, cpx, ppcx, ppcpx;
+    
+    if (w == 1) {
+        out[pos >> 3] ^= pi[0] << (pos & 7);
+        return;
+    }
+    
+    for (x=0; x<n; ++x)
+        A[x] = ((pi[x] ^ 1) << 16) | pi[x ^ 1];
+    int32_sort(A, n);                       /* A = (id << 16) + pibar */
+    
+    for (x=0; x<n; ++x) {
+        Ax = A[x];
+        px = Ax & 0xFFFF;
+        cx = int32_min(px, x);
+        B[x] = (px << 16) | cx;
+    }                                       /* B = (p << 16) + c */
+    
+    for (x=0; x<n; ++x)
+        A[x] = (A[x] << 16) | x;            /* A = (pibar << 16) + id */
+    int32_sort(A, n);                       /* A = (id << 16) + pibar^-1 */
+    
+    for (x=0; x<n; ++x)
+        A[x] = (A[x] << 16) + (B[x] >> 16); /* A = (pibar^-1 << 16) + pibar */
+    int32_sort(A, n);                       /* A = (id << 16) + pibar^2 */
+    
+    if (w <= 10) {
+        for (x=0; x<n; ++x)
+            B[x] = ((A[x] & 0xFFFF) << 10) | (B[x] & 0x3FF);
+        
+        for (i=1; i<w-1; ++i) {
+            /* B = (p << 10) + c */
+            for (x=0; x<n; ++x)
+                A[x] = ((B[x] & ~0x3FF) << 6) | x;  /* A = (p << 16) + id */
+            int32_sort(A, n);                       /* A = (id << 16) + p^-1 */
+            
+            for (x=0; x<n; ++x)
+                A[x] = (A[x] << 20) | B[x];         /* A = (p^-1 << 20) + (p << 10) + c */
+            int32_sort(A, n);                       /* A = (id << 20) + (pp << 10) + cp */
+            
+            for (x=0; x<n; ++x) {
+                ppcpx = A[x] & 0xFFFFF;
+                ppcx = (A[x] & 0xFFC00) | (B[x] & 0x3FF);
+                B[x] = int32_min(ppcx, ppcpx);
+            }
+        }
+        for (x=0; x<n; ++x)
+            B[x] &= 0x3FF;
+    }
+    else {
+        for (x=0; x<n; ++x)
+            B[x] = (A[x] << 16) | (B[x] & 0xFFFF);
+        
+        for (i=1; i<w-1; ++i) {
+            /* B = (p << 16) + c */
+            for (x=0; x<n; ++x)
+                A[x] = (B[x] & ~0xFFFF) | x;
+            int32_sort(A, n);                       /* A = (id << 16) + p^-1 */
+            
+            for (x=0; x<n; ++x)
+                A[x] = (A[x] << 16) | (B[x] & 0xFFFF);  /* A = (p^-1 << 16) + c */
+            
+            if (i < w-2) {
+                for (x=0; x<n; ++x)
+                    B[x] = (A[x] & ~0xFFFF) | (B[x] >> 16); /* B = (p^-1 << 16) + p */
+                int32_sort(B, n);                           /* B = (id << 16) + p^-2 */
+                for (x=0; x<n; ++x)
+                    B[x] = (B[x] << 16) | (A[x] & 0xFFFF);  /* B = (p^-2 << 16) + c */
+            }
+            
+            int32_sort(A, n);                       /* A = (id << 16) + cp */
+            for (x=0; x<n; ++x) {
+                cpx = (B[x] & ~0xFFFF) | (A[x] & 0xFFFF);
+                B[x] = int32_min(B[x], cpx);
+            }
+        }
+        for (x=0; x<n; ++x)
+            B[x] &= 0xFFFF;
+    }
+    
+    for (x=0; x<n; ++x)
+        A[x] = (((int32_t)pi[x]) << 16) + x;
+    int32_sort(A, n);                       /* A = (id << 16) + pi^-1 */
+    
+    for (j=0; j<n/2; ++j) {
+        x = 2*j;
+        fj = B[x] & 1;                      /* f[j] */
+        Fx = x + fj;                        /* F[x] */
+        
+        out[pos >> 3] ^= fj << (pos & 7);
+        pos += step;
+        
+        B[x] = (A[x] << 16) | Fx;
+        B[x+1] = (A[x+1] << 16) | (Fx ^ 1);
+    }                                       /* B = (pi^-1 << 16) + F */
+    int32_sort(B, n);                       /* B = (id << 16) + F(pi) */
+    
+    pos += (2*w - 3)*step*(n/2);
+    
+    for (k=0; k<n/2; ++k) {
+        x = 2*k;
+        lk = B[x] & 1;                      /* l[k] */
+        Ly = x + lk;                        /* L[y] */
+        
+        out[pos >> 3] ^= lk << (pos & 7);
+        pos += step;
+        
+        A[x] = (Ly << 16) | (B[x] & 0xFFFF);
+        A[x+1] = ((Ly ^ 1) << 16) | (B[x+1] & 0xFFFF);
+    }                                       /* A = (L << 16) + F(pi) */
+    int32_sort(A, n);                       /* A = (id << 16) + F(pi(L)) */
+    
+    pos -= (2*w - 2)*step*(n/2);
+    
+    for (j=0; j<n/2; ++j) {
+        q[j] = (A[2*j] & 0xFFFF) >> 1;
+        q[j + n/2] = (A[2*j + 1] & 0xFFFF) >> 1;
+    }
+    
+    cbrecursion(out, pos, step*2, q, w-1, n/2, temp);
+    cbrecursion(out, pos + step, step*2, q + n/2, w-1, n/2, temp);
+}
+
+/**
+ *  The stride exponent of a layer of the network
+ **/
+static inline int32_t layer_stride(int32_t layer)
+{
+    return (layer < NTS_KEM_PARAM_M) ? layer : (2*NTS_KEM_PARAM_M - 2 - layer);
+}
+
+int benes_compile(uint64_t *masks, const uint16_t *p)
+{
+    int32_t i, k, l, s, pos, status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+    int32_t *temp = NULL;
+    int16_t *pi = NULL, *t = NULL;
+    uint8_t *bits = NULL;
+    int16_t d, diff = 0;
+    const int32_t n = NTS_KEM_PARAM_N;
+    const int32_t nbytes = (BENES_LAYERS*(n >> 1)) >> 3;
+    
+    temp = (int32_t *)malloc(2*n*sizeof(int32_t));
+    pi = (int16_t *)malloc(n*sizeof(int16_t));
+    t = (int16_t *)malloc(n*sizeof(int16_t));
+    bits = (uint8_t *)calloc(nbytes, sizeof(uint8_t));
+    if (!temp || !pi || !t || !bits)
+        goto benes_compile_fail;
+    
+    for (i=0; i<n; i++)
+        pi[i] = (int16_t)p[i];
+    cbrecursion(bits, 0, 1, pi, NTS_KEM_PARAM_M, n, temp);
+    
+    /**
+     * Spread the n/2 control bits of each layer to the lower
+     * position of the pair of elements they swap
+     **/
+    CT_memset(masks, 0, BENES_SIZE*sizeof(uint64_t));
+    for (l=0; l<BENES_LAYERS; l++) {
+        s = layer_stride(l);
+        for (k=0; k<(n >> 1); k++) {
+            pos = ((k >> s) << (s+1)) | (k & ((1 << s) - 1));
+            masks[l*BENES_LAYER_WORDS + (pos >> 6)] |=
+                (uint64_t)((bits[(l*(n >> 1) + k) >> 3] >> (k & 7)) & 1) << (pos & 63);
+        }
+    }
+    
+    /**
+     * Check the network on the identity permutation, this also
+     * rejects an input that is not a permutation
+     **/
+    for (i=0; i<n; i++)
+        t[i] = (int16_t)i;
+    for (l=0; l<BENES_LAYERS; l++) {
+        s = 1 << layer_stride(l);
+        for (i=0; i<n; i++) {
+            if (i & s)
+                continue;
+            d = (t[i] ^ t[i+s]) & -(int16_t)((masks[l*BENES_LAYER_WORDS + (i >> 6)] >> (i & 63)) & 1);
+            t[i] ^= d;
+            t[i+s] ^= d;
+        }
+    }
+    for (i=0; i<n; i++)
+        diff |= (pi[i] ^ t[i]);
+    status = (diff == 0) ? NTS_KEM_SUCCESS : NTS_KEM_BAD_PARAMETERS;
+    
+benes_compile_fail:
+    if (temp) {
+        CT_memset(temp, 0, 2*n*sizeof(int32_t));
+        free(temp);
+    }
+    if (pi) {
+        CT_memset(pi, 0, n*sizeof(int16_t));
+        free(pi);
+    }
+    if (t) {
+        CT_memset(t, 0, n*sizeof(int16_t));
+        free(t);
+    }
+    if (bits) {
+        CT_memset(bits, 0, nbytes);
+        free(bits);
+    }
+    
+    return status;
+}
+
+/**
+ *  Apply layer l of a network to a bit vector
+ **/
+static void benes_layer(uint64_t *x, const uint64_t *masks, int32_t l)
+{
+    int32_t i, j, s, stride;
+    uint64_t d;
+    
+    masks += l*BENES_LAYER_WORDS;
+    s = layer_stride(l);
+    if (s < 6) {
+        stride = 1 << s;
+        for (i=0; i<BENES_LAYER_WORDS; i++) {
+            d = (x[i] ^ (x[i] >> stride)) & masks[i];
+            x[i] ^= d ^ (d << stride);
+        }
+    }
+    else {
+        stride = 1 << (s - 6);
+        for (i=0; i<BENES_LAYER_WORDS; i+=2*stride) {
+            for (j=i; j<i+stride; j++) {
+                d = (x[j] ^ x[j+stride]) & masks[j];
+                x[j] ^= d;
+                x[j+stride] ^= d;
+            }
+        }
+    }
+}
+
+void benes_permute(uint64_t *x, const uint64_t *masks)
+{
+    int32_t l;
+    
+    for (l=0; l<BENES_LAYERS; l++)
+        benes_layer(x, masks, l);
+}
+
+void benes_permute_inverse(uint64_t *x, const uint64_t *masks)
+{
+    int32_t l;
+    
+    /* Every layer is its own inverse */
+    for (l=BENES_LAYERS-1; l>=0; l--)
+        benes_layer(x, masks, l);
+}
+
+void benes_gather_sorted(uint16_t *x, const uint16_t *p)
+{
+    int32_t i;
+    int32_t t[NTS_KEM_PARAM_N];
+    
+    /* t = (id << 16) + p^-1 */
+    for (i=0; i<NTS_KEM_PARAM_N; i++)
+        t[i] = ((int32_t)p[i] << 16) | i;
+    int32_sort(t, NTS_KEM_PARAM_N);
+    
+    /* t = (p^-1 << 16) + x, sorted into (id << 16) + x(p) */
+    for (i=0; i<NTS_KEM_PARAM_N; i++)
+        t[i] = (t[i] << 16) | x[i];
+    int32_sort(t, NTS_KEM_PARAM_N);
+    
+    for (i=0; i<NTS_KEM_PARAM_N; i++)
+        x[i] = (uint16_t)(t[i] & 0xFFFF);
+    CT_memset(t, 0, sizeof(t));
+}
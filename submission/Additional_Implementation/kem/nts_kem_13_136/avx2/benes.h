@@ -0,0 +1,79 @@
+/**
+ *  benes.h
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  Constant-time permutation of bit vectors with a Beneš network
+ *
+ *  References:
+ *  [1]  David Nassimi and Sartaj Sahni, (1982),
+ *       "Parallel algorithms to set up the Benes permutation network",
+ *       IEEE Transactions on Computers, Volume C-31 (Number 2), 148-154
+ *  [2]  Daniel J. Bernstein, (2020),
+ *       "Verified fast formulas for control bits for permutation networks",
+ *       https://cr.yp.to/papers/controlbits-20200923.pdf
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#ifndef __NTSKEM_BENES_H
+#define __NTSKEM_BENES_H
+
+#include <stdint.h>
+#include "nts_kem_params.h"
+
+#define BENES_LAYERS        (2*NTS_KEM_PARAM_M - 1)
+#define BENES_LAYER_WORDS   (NTS_KEM_PARAM_N >> 6)
+#define BENES_SIZE          (BENES_LAYERS * BENES_LAYER_WORDS)
+
+/**
+ *  Compute the Beneš network of a permutation
+ *
+ *  @note
+ *  Each layer of the network is stored as a mask of n bits, where
+ *  bit i is set if element i is swapped with element i + 2^s of
+ *  the layer's stride 2^s. The computation is constant time.
+ *
+ *  @param[out] masks  The network, BENES_SIZE 64-bit words
+ *  @param[in]  p      The permutation of {0, 1, ..., n-1}
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int benes_compile(uint64_t *masks, const uint16_t *p);
+
+/**
+ *  Permute a bit vector in place, x_i <- x_{p_i}
+ *
+ *  @param[in,out] x      The bit vector of n bits
+ *  @param[in]     masks  The network of p, {@see benes_compile}
+ **/
+void benes_permute(uint64_t *x, const uint64_t *masks);
+
+/**
+ *  Apply the inverse permutation to a bit vector in place,
+ *  x_{p_i} <- x_i
+ *
+ *  @param[in,out] x      The bit vector of n bits
+ *  @param[in]     masks  The network of p, {@see benes_compile}
+ **/
+void benes_permute_inverse(uint64_t *x, const uint64_t *masks);
+
+/**
+ *  Permute n 16-bit values in place, x_i <- x_{p_i}, from p itself
+ *  rather than from a compiled network
+ *
+ *  @note
+ *  The values are moved by two passes of a constant-time sorting
+ *  network, which is much cheaper than {@see benes_compile} but
+ *  costs far more than {@see benes_permute} once compiled
+ *
+ *  @param[in,out] x  The n values
+ *  @param[in]     p  The permutation of {0, 1, ..., n-1}
+ **/
+void benes_gather_sorted(uint16_t *x, const uint16_t *p);
+
+#endif /* __NTSKEM_BENES_H */
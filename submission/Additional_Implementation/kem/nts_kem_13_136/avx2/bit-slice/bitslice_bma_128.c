@@ -22,6 +22,7 @@
 #define PARAM_T         136
 
 extern void bitslice_mul13_128(__m128i* d, const __m128i* a, const __m128i* b);
+extern void bitslice_mul13_256(__m256i* d, const __m256i* a, const __m256i* b);
 
 static inline uint64_t MUX(uint64_t ctl, uint64_t a, uint64_t b)
 {
@@ -47,6 +48,37 @@ static inline __m128i vMUX(uint64_t ctl, __m128i a, __m128i b)
                                        _mm_xor_si128(a, b)));
 }
 
+static inline __m256i vMUX256(uint64_t ctl, __m256i a, __m256i b)
+{
+    return _mm256_xor_si256(b,
+                            _mm256_and_si256(_mm256_set1_epi64x(-ctl),
+                                             _mm256_xor_si256(a, b)));
+}
+
+static inline __m256i join_128(__m128i lo, __m128i hi)
+{
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+static inline uint32_t vector_popcount_256(__m256i a)
+{
+    return (popcount(_mm256_extract_epi64(a, 0)) + popcount(_mm256_extract_epi64(a, 1)) +
+            popcount(_mm256_extract_epi64(a, 2)) + popcount(_mm256_extract_epi64(a, 3)));
+}
+
+/**
+ *  Shift a 256-bit vector to the left by one bit
+ **/
+static inline __m256i shift_left_256(__m256i a)
+{
+    __m256i carry = _mm256_srli_epi64(a, 63);
+    
+    carry = _mm256_permute4x64_epi64(carry, 0x93);
+    carry = _mm256_blend_epi32(carry, _mm256_setzero_si256(), 0x03);
+    
+    return _mm256_or_si256(_mm256_slli_epi64(a, 1), carry);
+}
+
 static inline uint32_t vector_popcount_128(__m128i a)
 {
     const __m128i a_hi = _mm_unpackhi_epi64(a, a);
@@ -102,6 +134,8 @@ void bitslice_bma(__m128i (*out)[13], __m128i s[][PARAM_M], int *xi)
     __m128i d[2][PARAM_M], delta[2][PARAM_M] = {{{0}}};
     __m128i psi[2][PARAM_M] = {{{0}}}, tmp[2][PARAM_M];
     __m128i ss[3][PARAM_M] = {{{0}}};
+    __m256i S[PARAM_M], B[PARAM_M], D[PARAM_M], Dv[PARAM_M];
+    __m256i P[PARAM_M], T[PARAM_M], SS[PARAM_M];
     __m128i mask;
     const __m128i out_mask = _mm_set_epi32(0x00, 0x00, 0x00, 0x000001FF);
     
@@ -166,88 +200,21 @@ void bitslice_bma(__m128i (*out)[13], __m128i s[][PARAM_M], int *xi)
             ss[0][j][0] |= ((s[0][j][1] & (1ULL << (i-63))) >> (i-63));
         }
     }
-    for (;i<191; i++) {
-        bitslice_mul13_128(d[0], sigma[0], ss[0]);
-        bitslice_mul13_128(d[1], sigma[1], ss[1]);
-        for (_d=0,j=0; j<PARAM_M; j++) {
-            c = ((vector_popcount_128(d[0][j]) + vector_popcount_128(d[1][j])) & 1);
-            d[0][j] = _mm_set1_epi64x((long long)-c);
-            _d |= c;
-        }
-        
-        d_eq_0 = EQ0(_d);
-        control = d_eq_0 || LT(i, L<<1);
-        L = MUX(control, L, i-L+1);
-        R = MUX(control, R + d_eq_0, 0);
-        
-        bitslice_mul13_128(tmp[0], delta[0], sigma[0]);
-        bitslice_mul13_128(tmp[1], delta[1], sigma[1]);
-        bitslice_mul13_128(psi[0], d[0], beta[0]);
-        bitslice_mul13_128(psi[1], d[0], beta[1]);
-        
-        for (j=0; j<PARAM_M; j++) {
-            beta[0][j] = vMUX(control, beta[0][j], sigma[0][j]);
-            beta[1][j] = vMUX(control, beta[1][j], sigma[1][j]);
-            beta[1][j] = shift_left(beta[1][j], 1);
-            beta[1][j][0] |= ((beta[0][j][1] >> 63) & 1);
-            beta[0][j] = shift_left(beta[0][j], 1);
-            psi[0][j] = _mm_xor_si128(tmp[0][j], psi[0][j]);
-            psi[1][j] = _mm_xor_si128(tmp[1][j], psi[1][j]);
-            delta[0][j] = vMUX(control, delta[0][j], d[0][j]);
-            delta[1][j] = vMUX(control, delta[1][j], d[0][j]);
-            
-            sigma[0][j][0] = psi[0][j][0]; sigma[0][j][1] = psi[0][j][1];
-            sigma[1][j][0] = psi[1][j][0]; sigma[1][j][1] = psi[1][j][1];
-            ss[1][j] = shift_left(ss[1][j], 1);
-            ss[1][j][0] |= ((ss[0][j][1] >> 63) & 1);
-            ss[0][j] = shift_left(ss[0][j], 1);
-            ss[0][j][0] |= ((s[1][j][0] & (1ULL << (i-127))) >> (i-127));
-        }
-    }
-    for (;i<255; i++) {
-        bitslice_mul13_128(d[0], sigma[0], ss[0]);
-        bitslice_mul13_128(d[1], sigma[1], ss[1]);
-        for (_d=0,j=0; j<PARAM_M; j++) {
-            c = ((vector_popcount_128(d[0][j]) + vector_popcount_128(d[1][j])) & 1);
-            d[0][j] = _mm_set1_epi64x((long long)-c);
-            _d |= c;
-        }
-        
-        d_eq_0 = EQ0(_d);
-        control = d_eq_0 || LT(i, L<<1);
-        L = MUX(control, L, i-L+1);
-        R = MUX(control, R + d_eq_0, 0);
-        
-        bitslice_mul13_128(tmp[0], delta[0], sigma[0]);
-        bitslice_mul13_128(tmp[1], delta[1], sigma[1]);
-        bitslice_mul13_128(psi[0], d[0], beta[0]);
-        bitslice_mul13_128(psi[1], d[0], beta[1]);
-        
-        for (j=0; j<PARAM_M; j++) {
-            beta[0][j] = vMUX(control, beta[0][j], sigma[0][j]);
-            beta[1][j] = vMUX(control, beta[1][j], sigma[1][j]);
-            beta[1][j] = shift_left(beta[1][j], 1);
-            beta[1][j][0] |= ((beta[0][j][1] >> 63) & 1);
-            beta[0][j] = shift_left(beta[0][j], 1);
-            psi[0][j] = _mm_xor_si128(tmp[0][j], psi[0][j]);
-            psi[1][j] = _mm_xor_si128(tmp[1][j], psi[1][j]);
-            delta[0][j] = vMUX(control, delta[0][j], d[0][j]);
-            delta[1][j] = vMUX(control, delta[1][j], d[0][j]);
-            
-            sigma[0][j][0] = psi[0][j][0]; sigma[0][j][1] = psi[0][j][1];
-            sigma[1][j][0] = psi[1][j][0]; sigma[1][j][1] = psi[1][j][1];
-            ss[1][j] = shift_left(ss[1][j], 1);
-            ss[1][j][0] |= ((ss[0][j][1] >> 63) & 1);
-            ss[0][j] = shift_left(ss[0][j], 1);
-            ss[0][j][0] |= ((s[1][j][1] & (1ULL << (i-191))) >> (i-191));
-        }
+    /**
+     * From here on sigma and beta span 256 coefficients, the two
+     * 128-bit halves of the state are processed as one 256-bit vector
+     **/
+    for (j=0; j<PARAM_M; j++) {
+        S[j] = join_128(sigma[0][j], sigma[1][j]);
+        B[j] = join_128(beta[0][j], beta[1][j]);
+        D[j] = join_128(delta[0][j], delta[1][j]);
+        SS[j] = join_128(ss[0][j], ss[1][j]);
     }
     for (;i<2*PARAM_T-1; i++) {
-        bitslice_mul13_128(d[0], sigma[0], ss[0]);
-        bitslice_mul13_128(d[1], sigma[1], ss[1]);
+        bitslice_mul13_256(P, S, SS);
         for (_d=0,j=0; j<PARAM_M; j++) {
-            c = ((vector_popcount_128(d[0][j]) + vector_popcount_128(d[1][j])) & 1);
-            d[0][j] = _mm_set1_epi64x((long long)-c);
+            c = (vector_popcount_256(P[j]) & 1);
+            Dv[j] = _mm256_set1_epi64x((long long)-c);
             _d |= c;
         }
         
@@ -256,45 +223,29 @@ void bitslice_bma(__m128i (*out)[13], __m128i s[][PARAM_M], int *xi)
         L = MUX(control, L, i-L+1);
         R = MUX(control, R + d_eq_0, 0);
         
-        bitslice_mul13_128(tmp[0], delta[0], sigma[0]);
-        bitslice_mul13_128(tmp[1], delta[1], sigma[1]);
-        bitslice_mul13_128(psi[0], d[0], beta[0]);
-        bitslice_mul13_128(psi[1], d[0], beta[1]);
+        bitslice_mul13_256(T, D, S);
+        bitslice_mul13_256(P, Dv, B);
         
         for (j=0; j<PARAM_M; j++) {
-            beta[0][j] = vMUX(control, beta[0][j], sigma[0][j]);
-            beta[1][j] = vMUX(control, beta[1][j], sigma[1][j]);
-            beta[1][j] = shift_left(beta[1][j], 1);
-            beta[1][j][0] |= ((beta[0][j][1] >> 63) & 1);
-            beta[0][j] = shift_left(beta[0][j], 1);
-            psi[0][j] = _mm_xor_si128(tmp[0][j], psi[0][j]);
-            psi[1][j] = _mm_xor_si128(tmp[1][j], psi[1][j]);
-            delta[0][j] = vMUX(control, delta[0][j], d[0][j]);
-            delta[1][j] = vMUX(control, delta[1][j], d[0][j]);
-            
-            sigma[0][j][0] = psi[0][j][0]; sigma[0][j][1] = psi[0][j][1];
-            sigma[1][j][0] = psi[1][j][0]; sigma[1][j][1] = psi[1][j][1];
-            ss[1][j] = shift_left(ss[1][j], 1);
-            ss[1][j][0] |= ((ss[0][j][1] >> 63) & 1);
-            ss[0][j] = shift_left(ss[0][j], 1);
-            ss[0][j][0] |= ((s[2][j][0] & (1ULL << (i-255))) >> (i-255));
+            B[j] = shift_left_256(vMUX256(control, B[j], S[j]));
+            D[j] = vMUX256(control, D[j], Dv[j]);
+            S[j] = _mm256_xor_si256(T[j], P[j]);
+            SS[j] = shift_left_256(SS[j]);
+            SS[j][0] |= ((s[(i+1) >> 7][j][((i+1) >> 6) & 1] >> ((i+1) & 63)) & 1ULL);
         }
     }
-    bitslice_mul13_128(d[0], sigma[0], ss[0]);
-    bitslice_mul13_128(d[1], sigma[1], ss[1]);
+    bitslice_mul13_256(P, S, SS);
     for (_d=0,j=0; j<PARAM_M; j++) {
-        c = ((vector_popcount_128(d[0][j]) + vector_popcount_128(d[1][j])) & 1);
-        d[0][j] = _mm_set1_epi64x((long long)-c);
-        _d |= c;
+        c = (vector_popcount_256(P[j]) & 1);
+        Dv[j] = _mm256_set1_epi64x((long long)-c);
     }
 
-    bitslice_mul13_128(sigma[0], d[0], beta[0]);
-    bitslice_mul13_128(sigma[1], d[0], beta[1]);
-    bitslice_mul13_128(tmp[0], delta[0], psi[0]);
-    bitslice_mul13_128(tmp[1], delta[1], psi[1]);
+    bitslice_mul13_256(P, Dv, B);
+    bitslice_mul13_256(T, D, S);
     for (_d=0,j=0; j<PARAM_M; j++) {
-        psi[0][j] = _mm_xor_si128(tmp[0][j], sigma[0][j]);
-        psi[1][j] = _mm_xor_si128(tmp[1][j], sigma[1][j]);
+        T[j] = _mm256_xor_si256(T[j], P[j]);
+        psi[0][j] = _mm256_castsi256_si128(T[j]);
+        psi[1][j] = _mm256_extracti128_si256(T[j], 1);
         _d |= psi[1][j][0];
     }
 
@@ -17,6 +17,8 @@
 #include <stdio.h>
 
 #include "bitslice_fft_256.h"
+#include "bits.h"
+#include "mem.h"
 #include "twiddles.h"
 #include "twist_factors_13.h"
 #include "vector_utils.h"
@@ -93,7 +95,13 @@ static void radix_conversions13(__m128i (*in)[13])
     bitslice_mul13_128(in[1], in[1], twist_factors[13]); /* Scaling for f(beta.x) */
 }
 
-static void bitslice_butterflies13_256(__m256i out[][13], __m128i (*in)[13])
+/**
+ *  The butterflies of the additive FFT
+ *
+ *  Only the first `layers` of the last 5 butterfly layers are
+ *  applied, {@see bitslice_fft13_256_roots}
+ **/
+static void bitslice_butterflies13_256(__m256i out[][13], __m128i (*in)[13], int32_t layers)
 {
     int32_t i, j, k, s, b;
     uint64_t index = 0;
@@ -188,7 +196,7 @@ static void bitslice_butterflies13_256(__m256i out[][13], __m128i (*in)[13])
         }
     }
     index = 3;
-    for (i=1; i<6; i++) {
+    for (i=1; i<=layers; i++) {
         s = 1 << (i-1);
         for (j=0; j<32; j+=2*s) {
             for (k=j; k<j+s; k++) {
@@ -207,5 +215,198 @@ static void bitslice_butterflies13_256(__m256i out[][13], __m128i (*in)[13])
 void bitslice_fft13_256(__m256i out[][13], __m128i (*in)[13])
 {
     radix_conversions13(in);
-    bitslice_butterflies13_256(out, in);
+    bitslice_butterflies13_256(out, in, 5);
+}
+
+int32_t bitslice_fft13_256_roots(__m256i roots[], __m128i (*in)[13])
+{
+    int32_t k, b, weight = 0;
+    __m256i out[32][13], t[13], x, y;
+    const __m256i allones = _mm256_set1_epi64x(-1);
+    
+    radix_conversions13(in);
+    bitslice_butterflies13_256(out, in, 4);
+    
+    /**
+     * The last butterfly layer, combining out[k] and out[k+16],
+     * with the evaluations reduced to root indicators on the fly
+     **/
+    for (k=0; k<16; k++) {
+        bitslice_mul13_256(t, out[k+16], twiddle_factors[3 + 1 + 2 + 4 + 8 + k]);
+        
+        x = y = _mm256_setzero_si256();
+        for (b=0; b<13; b++) {
+            t[b] = _mm256_xor_si256(out[k][b], t[b]);
+            x = _mm256_or_si256(x, t[b]);
+            y = _mm256_or_si256(y, _mm256_xor_si256(out[k+16][b], t[b]));
+        }
+        roots[k]    = _mm256_xor_si256(x, allones);
+        roots[k+16] = _mm256_xor_si256(y, allones);
+        weight += vector_popcount(roots[k]) + vector_popcount(roots[k+16]);
+    }
+    
+    CT_memset(out, 0, sizeof(out));
+    CT_memset(t, 0, sizeof(t));
+    
+    return weight;
+}
+
+/**
+ *  Transpose of radix_conversions13
+ *
+ *  Each step of radix_conversions13 is applied in the reverse order,
+ *  with a transfer x[d] ^= x[s] between coefficients replaced by
+ *  x[s] ^= x[d]. The twisting is diagonal and kept as it is.
+ **/
+static void radix_conversions13_tr(__m128i (*in)[13])
+{
+    int i, j, k;
+    
+    bitslice_mul13_128(in[0], in[0], twist_factors[12]);
+    bitslice_mul13_128(in[1], in[1], twist_factors[13]);
+    for (i=0; i<13; i++) {
+        in[1][i] = _mm_xor_si128(in[1][i], _mm_srli_si128(in[0][i], 8));
+        in[1][i] = _mm_xor_si128(in[1][i], _mm_slli_si128(in[1][i], 8));
+    }
+    for (j=5; j>=0; j--) {
+        bitslice_mul13_128(in[0], in[0], twist_factors[2*j]);
+        bitslice_mul13_128(in[1], in[1], twist_factors[2*j+1]);
+        for (k=j; k<=4; k++) {
+            for (i=0; i<13; i++) {
+                in[0][i] = _mm_xor_si128(in[0][i], _mm_and_si128(_mm_slli_epi64(in[0][i], (1 << k)), mask[k][1]));
+                in[0][i] = _mm_xor_si128(in[0][i], _mm_and_si128(_mm_slli_epi64(in[0][i], (1 << k)), mask[k][0]));
+                in[1][i] = _mm_xor_si128(in[1][i], _mm_and_si128(_mm_slli_epi64(in[1][i], (1 << k)), mask[k][1]));
+                in[1][i] = _mm_xor_si128(in[1][i], _mm_and_si128(_mm_slli_epi64(in[1][i], (1 << k)), mask[k][0]));
+            }
+        }
+        for (i=0; i<13; i++) {
+            in[0][i][1] ^= ((in[0][i][0] >> 32) & 0x00000000FFFFFFFFULL);
+            in[0][i][1] ^= (in[0][i][1] << 32);
+            in[1][i][1] ^= ((in[1][i][0] >> 32) & 0x00000000FFFFFFFFULL);
+            in[1][i][1] ^= (in[1][i][1] << 32);
+        }
+        for (i=0; i<13; i++) {
+            in[1][i] = _mm_xor_si128(in[1][i], _mm_srli_si128(in[0][i], 8));
+            in[1][i] = _mm_xor_si128(in[1][i], _mm_slli_si128(in[1][i], 8));
+        }
+    }
+}
+
+/**
+ *  Transpose of bitslice_butterflies13_256
+ *
+ *  The layers are applied in the reverse order. The butterfly
+ *  (v, u) <- (v + w.u, u + v + w.u) becomes (v, u) <- (v + u, u + w.(v + u)),
+ *  and the broadcast of a coefficient over 32 points becomes
+ *  the sum of these 32 points.
+ **/
+static void bitslice_butterflies13_256_tr(__m128i (*out)[13], __m256i in[][13])
+{
+    int32_t i, j, k, s, b, l;
+    uint64_t index = 0;
+    uint32_t bits;
+    __m128i x, t1, t0;
+    __m256i t[13], u[13], v[13];
+    const __m256i mask256 = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    
+    index = 3 + 1 + 2 + 4 + 8 + 16;
+    for (i=5; i>=1; i--) {
+        s = 1 << (i-1);
+        index -= s;
+        for (j=0; j<32; j+=2*s) {
+            for (k=j; k<j+s; k++) {
+                for (b=0; b<13; b++)
+                    in[k][b] = _mm256_xor_si256(in[k][b], in[k+s][b]);
+                
+                bitslice_mul13_256(t, in[k], twiddle_factors[index + (k-j)]);
+                
+                for (b=0; b<13; b++)
+                    in[k+s][b] = _mm256_xor_si256(in[k+s][b], t[b]);
+            }
+        }
+    }
+    for (j=0; j<32; j+=2) {
+        for (b=0; b<13; b++) {
+            t0 = _mm_xor_si128(_mm256_extracti128_si256(in[j][b],   0),
+                               _mm256_extracti128_si256(in[j][b],   1));
+            t1 = _mm_xor_si128(_mm256_extracti128_si256(in[j+1][b], 0),
+                               _mm256_extracti128_si256(in[j+1][b], 1));
+            v[b] = _mm256_set_epi64x(t1[1], t1[0], t0[1], t0[0]);
+        }
+        bitslice_mul13_256(t, v, twiddle_factors[2]);
+        for (b=0; b<13; b++) {
+            x  = _mm_xor_si128(_mm256_extracti128_si256(in[j][b], 1),
+                               _mm256_extracti128_si256(t[b], 0));
+            t0 = _mm256_extracti128_si256(v[b], 0);
+            in[j][b]   = _mm256_set_epi64x(x[1], x[0], t0[1], t0[0]);
+            
+            x  = _mm_xor_si128(_mm256_extracti128_si256(in[j+1][b], 1),
+                               _mm256_extracti128_si256(t[b], 1));
+            t1 = _mm256_extracti128_si256(v[b], 1);
+            in[j+1][b] = _mm256_set_epi64x(x[1], x[0], t1[1], t1[0]);
+        }
+    }
+    for (j=0; j<32; j+=2) {
+        for (b=0; b<13; b++) {
+            t[0] = _mm256_permute4x64_epi64(in[ j ][b], 0xD8);
+            t[1] = _mm256_permute4x64_epi64(in[j+1][b], 0xD8);
+            v[b] = _mm256_permute2x128_si256(t[0], t[1], 0x20);
+            u[b] = _mm256_permute2x128_si256(t[0], t[1], 0x31);
+            v[b] = _mm256_xor_si256(v[b], u[b]);
+        }
+        bitslice_mul13_256(t, v, twiddle_factors[1]);
+        for (b=0; b<13; b++) {
+            u[b] = _mm256_xor_si256(u[b], t[b]);
+            in[j][b]   = _mm256_set_epi64x(u[b][1], v[b][1], u[b][0], v[b][0]);
+            in[j+1][b] = _mm256_set_epi64x(u[b][3], v[b][3], u[b][2], v[b][2]);
+        }
+    }
+    for (j=0; j<32; j+=2) {
+        for (b=0; b<13; b++) {
+            t[0] = _mm256_permutevar8x32_epi32(in[ j ][b], mask256);
+            t[1] = _mm256_permutevar8x32_epi32(in[j+1][b], mask256);
+            v[b] = _mm256_permute2x128_si256(t[0], t[1], 0x20);
+            v[b] = _mm256_permute4x64_epi64(v[b], 0xD8);
+            u[b] = _mm256_permute2x128_si256(t[0], t[1], 0x31);
+            u[b] = _mm256_permute4x64_epi64(u[b], 0xD8);
+            v[b] = _mm256_xor_si256(v[b], u[b]);
+        }
+        bitslice_mul13_256(t, v, twiddle_factors[0]);
+        for (b=0; b<13; b++) {
+            u[b] = _mm256_xor_si256(u[b], t[b]);
+            in[ j ][b] = _mm256_unpacklo_epi32(v[b], u[b]);
+            in[j+1][b] = _mm256_unpackhi_epi32(v[b], u[b]);
+        }
+    }
+    
+    /**
+     * Sum the 32 points of each 32-bit lane and put the result
+     * at the coefficient the lane was broadcast from
+     **/
+    for (i=0; i<13; i++) {
+        out[0][i] = out[1][i] = _mm_setzero_si128();
+    }
+    for (j=0; j<32; j++) {
+        for (i=0; i<13; i++) {
+            t[0] = in[j][i];
+            t[0] = _mm256_xor_si256(t[0], _mm256_srli_epi32(t[0], 16));
+            t[0] = _mm256_xor_si256(t[0], _mm256_srli_epi32(t[0],  8));
+            t[0] = _mm256_xor_si256(t[0], _mm256_srli_epi32(t[0],  4));
+            t[0] = _mm256_xor_si256(t[0], _mm256_srli_epi32(t[0],  2));
+            t[0] = _mm256_xor_si256(t[0], _mm256_srli_epi32(t[0],  1));
+            bits = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(t[0], 31)));
+            for (l=0; l<2; l++) {
+                out[0][i][0] |= (uint64_t)((bits >> (4*l    )) & 1) << reversal[2*j + l];
+                out[1][i][0] |= (uint64_t)((bits >> (4*l + 1)) & 1) << reversal[2*j + l];
+                out[0][i][1] |= (uint64_t)((bits >> (4*l + 2)) & 1) << reversal[2*j + l];
+                out[1][i][1] |= (uint64_t)((bits >> (4*l + 3)) & 1) << reversal[2*j + l];
+            }
+        }
+    }
+}
+
+void bitslice_fft13_256_tr(__m128i (*out)[13], __m256i in[][13])
+{
+    bitslice_butterflies13_256_tr(out, in);
+    radix_conversions13_tr(out);
 }
@@ -22,4 +22,26 @@
 
 void bitslice_fft13_256(__m256i out[][13], __m128i (*in)[13]);
 
+/**
+ *  Additive FFT for root finding
+ *
+ *  As bitslice_fft13_256, but instead of the evaluations, output
+ *  for each of the 2^13 field points a bit which is set if and
+ *  only if the point is a root. The evaluations are reduced to
+ *  these bits within the last butterfly layer.
+ *
+ *  @return The number of roots
+ **/
+int32_t bitslice_fft13_256_roots(__m256i roots[], __m128i (*in)[13]);
+
+/**
+ *  Transposed additive FFT
+ *
+ *  Given values v_x at the 2^13 field points, in the output order of
+ *  bitslice_fft13_256, compute the power sums S_j = sum_x v_x.x^j for
+ *  0 <= j < 256, in the input order of bitslice_fft13_256. The input
+ *  values are overwritten.
+ **/
+void bitslice_fft13_256_tr(__m128i (*out)[13], __m256i in[][13]);
+
 #endif /* __NTSKEM_BITSLICE_FFT_256_H */
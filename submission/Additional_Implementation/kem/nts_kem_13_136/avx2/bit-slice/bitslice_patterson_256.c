@@ -0,0 +1,516 @@
+/**
+ *
+ *  bitslice_patterson_256.c
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "bitslice_patterson_256.h"
+#include "vector_ff.h"
+#include "mem.h"
+
+#define PARAM_M         13
+#define PARAM_T         136
+
+extern void bitslice_mul13_256(__m256i* d, const __m256i* a, const __m256i* b);
+extern ff_unit ff_inv_13(const FF2m* ff2m, ff_unit a);
+
+static inline uint64_t EQ0(int64_t a)
+{
+    uint64_t b = (uint64_t)a;
+    return ~(b | -b) >> 63;
+}
+
+static inline __m256i vMUX256(uint64_t ctl, __m256i a, __m256i b)
+{
+    return _mm256_xor_si256(b,
+                            _mm256_and_si256(_mm256_set1_epi64x(-ctl),
+                                             _mm256_xor_si256(a, b)));
+}
+
+/**
+ *  Shift a 256-bit vector by one bit, i.e. multiply by z
+ **/
+static inline __m256i shift_left_256(__m256i a)
+{
+    __m256i carry = _mm256_srli_epi64(a, 63);
+
+    carry = _mm256_permute4x64_epi64(carry, 0x93);
+    carry = _mm256_blend_epi32(carry, _mm256_setzero_si256(), 0x03);
+
+    return _mm256_or_si256(_mm256_slli_epi64(a, 1), carry);
+}
+
+/**
+ *  Shift a 256-bit vector by one bit, i.e. divide by z
+ **/
+static inline __m256i shift_right_256(__m256i a)
+{
+    __m256i carry = _mm256_slli_epi64(a, 63);
+
+    carry = _mm256_permute4x64_epi64(carry, 0x39);
+    carry = _mm256_blend_epi32(carry, _mm256_setzero_si256(), 0xC0);
+
+    return _mm256_or_si256(_mm256_srli_epi64(a, 1), carry);
+}
+
+/**
+ *  Shift a 256-bit vector to the right by a public number of bits
+ **/
+static inline __m256i shift_right_256_n(__m256i a, int32_t cnt)
+{
+    int32_t i, q = cnt >> 6, r = cnt & 63;
+    uint64_t x[4], y[4];
+
+    _mm256_storeu_si256((__m256i *)x, a);
+    for (i=0; i<4; i++) {
+        y[i] = (i + q < 4) ? (x[i + q] >> r) : 0ULL;
+        if (r && i + q + 1 < 4)
+            y[i] |= x[i + q + 1] << (64 - r);
+    }
+
+    return _mm256_loadu_si256((const __m256i *)y);
+}
+
+static inline uint64_t bit_reverse_64(uint64_t x)
+{
+    x = ((x & 0x5555555555555555ULL) << 1) | ((x >> 1) & 0x5555555555555555ULL);
+    x = ((x & 0x3333333333333333ULL) << 2) | ((x >> 2) & 0x3333333333333333ULL);
+    x = ((x & 0x0F0F0F0F0F0F0F0FULL) << 4) | ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL);
+
+    return __builtin_bswap64(x);
+}
+
+static inline __m256i bit_reverse_256(__m256i a)
+{
+    return _mm256_set_epi64x(bit_reverse_64(a[0]), bit_reverse_64(a[1]),
+                             bit_reverse_64(a[2]), bit_reverse_64(a[3]));
+}
+
+/**
+ *  Gather the even bits of a 64-bit word into its lower half
+ **/
+static inline uint64_t compact_even_64(uint64_t x)
+{
+    x &= 0x5555555555555555ULL;
+    x = (x | (x >>  1)) & 0x3333333333333333ULL;
+    x = (x | (x >>  2)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x >>  4)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x >>  8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+
+    return x;
+}
+
+/**
+ *  Spread the lower 32 bits of a word to the even bits
+ **/
+static inline uint64_t spread_32(uint64_t x)
+{
+    x &= 0x00000000FFFFFFFFULL;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x <<  8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x <<  4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x <<  2)) & 0x3333333333333333ULL;
+    x = (x | (x <<  1)) & 0x5555555555555555ULL;
+
+    return x;
+}
+
+/**
+ *  Bit k of the output is bit 2k of the input
+ **/
+static inline __m256i even_bits_256(__m256i a)
+{
+    return _mm256_set_epi64x(0ULL, 0ULL,
+                             compact_even_64(a[2]) | (compact_even_64(a[3]) << 32),
+                             compact_even_64(a[0]) | (compact_even_64(a[1]) << 32));
+}
+
+/**
+ *  Bit 2k of the output is bit k of the input, for k < 128
+ **/
+static inline __m256i spread_bits_256(__m256i a)
+{
+    return _mm256_set_epi64x(spread_32((uint64_t)a[1] >> 32), spread_32(a[1]),
+                             spread_32((uint64_t)a[0] >> 32), spread_32(a[0]));
+}
+
+/**
+ *  Broadcast the coefficient k of a polynomial to all 256 bits
+ **/
+static inline void coefficient(__m256i *c, const __m256i *a, int32_t k)
+{
+    int32_t j;
+
+    for (j=0; j<PARAM_M; j++)
+        c[j] = _mm256_set1_epi64x(-(long long)(((uint64_t)a[j][k >> 6] >> (k & 63)) & 1ULL));
+}
+
+static inline uint64_t coefficient_is_nonzero(const __m256i *a, int32_t k)
+{
+    int32_t j;
+    uint64_t x = 0;
+
+    for (j=0; j<PARAM_M; j++)
+        x |= (uint64_t)a[j][k >> 6];
+
+    return (x >> (k & 63)) & 1ULL;
+}
+
+/**
+ *  Reverse the first len coefficients of a polynomial, the other
+ *  coefficients are discarded
+ **/
+static void poly_reverse(__m256i *b, const __m256i *a, int32_t len)
+{
+    int32_t j;
+
+    for (j=0; j<PARAM_M; j++)
+        b[j] = shift_right_256_n(bit_reverse_256(a[j]), 256 - len);
+}
+
+/**
+ *  Coefficient-wise square root, b_k = a_k^{2^12}
+ **/
+static void coefficient_sqrt(__m256i *b, const __m256i *a)
+{
+    int32_t i;
+    __m256i t[PARAM_M];
+
+    vector_ff_sqr_13(NULL, t, a);
+    vector_ff_sqr_13(NULL, b, t);
+    for (i=2; i<PARAM_M-1; i+=2) {
+        vector_ff_sqr_13(NULL, t, b);
+        vector_ff_sqr_13(NULL, b, t);
+    }
+    CT_memset(t, 0, sizeof(t));
+}
+
+/**
+ *  c(z) = a(z).b(z) mod G(z), with deg a, deg b < τ
+ **/
+static void poly_mulmod(__m256i *c, const __m256i *a, const __m256i *b, const __m256i *g)
+{
+    int32_t j, k;
+    __m256i acc[PARAM_M], t[PARAM_M], x[PARAM_M];
+
+    for (j=0; j<PARAM_M; j++)
+        acc[j] = _mm256_setzero_si256();
+    for (k=PARAM_T-1; k>=0; k--) {
+        /* acc = z.acc mod G(z) */
+        for (j=0; j<PARAM_M; j++)
+            acc[j] = shift_left_256(acc[j]);
+        coefficient(x, acc, PARAM_T);
+        bitslice_mul13_256(t, x, g);
+        for (j=0; j<PARAM_M; j++)
+            acc[j] = _mm256_xor_si256(acc[j], t[j]);
+        /* acc = acc + b_k.a(z) */
+        coefficient(x, b, k);
+        bitslice_mul13_256(t, x, a);
+        for (j=0; j<PARAM_M; j++)
+            acc[j] = _mm256_xor_si256(acc[j], t[j]);
+    }
+    memcpy(c, acc, sizeof(acc));
+
+    CT_memset(acc, 0, sizeof(acc));
+    CT_memset(t, 0, sizeof(t));
+    CT_memset(x, 0, sizeof(x));
+}
+
+/**
+ *  One divstep on f and h, the reversals of two polynomials F and H
+ *  with virtual degrees differing by δ. The cofactors v and r, which
+ *  express F and H in terms of the input modulo G(z), are updated
+ *  accordingly. See the reference in bitslice_patterson_256.h.
+ **/
+static void divstep(__m256i *f, __m256i *h, __m256i *v, __m256i *r, int32_t *delta)
+{
+    int32_t j;
+    uint64_t swap;
+    __m256i mask, x;
+    __m256i f0[PARAM_M], h0[PARAM_M], t0[PARAM_M], t1[PARAM_M];
+
+    swap = ((uint32_t)(-(*delta)) >> 31) & coefficient_is_nonzero(h, 0);
+    *delta ^= (-(int32_t)swap) & (*delta ^ -(*delta));
+    *delta += 1;
+
+    mask = _mm256_set1_epi64x(-(long long)swap);
+    for (j=0; j<PARAM_M; j++) {
+        x = _mm256_and_si256(mask, _mm256_xor_si256(f[j], h[j]));
+        f[j] = _mm256_xor_si256(f[j], x);
+        h[j] = _mm256_xor_si256(h[j], x);
+        x = _mm256_and_si256(mask, _mm256_xor_si256(v[j], r[j]));
+        v[j] = _mm256_xor_si256(v[j], x);
+        r[j] = _mm256_xor_si256(r[j], x);
+    }
+
+    coefficient(f0, f, 0);
+    coefficient(h0, h, 0);
+    bitslice_mul13_256(t0, f0, h);
+    bitslice_mul13_256(t1, h0, f);
+    for (j=0; j<PARAM_M; j++)
+        h[j] = shift_right_256(_mm256_xor_si256(t0[j], t1[j]));
+    bitslice_mul13_256(t0, f0, r);
+    bitslice_mul13_256(t1, h0, v);
+    for (j=0; j<PARAM_M; j++) {
+        r[j] = _mm256_xor_si256(t0[j], t1[j]);
+        v[j] = shift_left_256(v[j]);
+    }
+}
+
+/**
+ *  Initialise the divsteps on G(z) and a(z), deg a < τ
+ **/
+static void divstep_init(__m256i *f, __m256i *h, __m256i *v, __m256i *r,
+                         const __m256i *a, const __m256i *g)
+{
+    int32_t j;
+
+    poly_reverse(f, g, PARAM_T+1);
+    poly_reverse(h, a, PARAM_T);
+    for (j=0; j<PARAM_M; j++) {
+        v[j] = _mm256_setzero_si256();
+        r[j] = _mm256_setzero_si256();
+    }
+    r[0] = _mm256_set_epi64x(0ULL, 0ULL, 0ULL, 1ULL);
+}
+
+/**
+ *  b(z) = a(z)^{-1} mod G(z), with deg a < τ
+ *
+ *  @return 0 if a(z) is invertible, -1 otherwise
+ **/
+static int poly_invmod(__m256i *b, const __m256i *a, const __m256i *g)
+{
+    int32_t j, n, delta = 1;
+    uint16_t f0 = 0;
+    __m256i f[PARAM_M], h[PARAM_M], v[PARAM_M], r[PARAM_M];
+
+    divstep_init(f, h, v, r, a, g);
+    for (n=0; n<2*PARAM_T-1; n++)
+        divstep(f, h, v, r, &delta);
+
+    /**
+     * Now f is the constant gcd, and v(z) is the inverse up to
+     * this constant, with coefficients in reverse order
+     **/
+    for (j=0; j<PARAM_M; j++)
+        f0 |= (uint16_t)((f[j][0] & 1) << j);
+    f0 = ff_inv_13(NULL, f0);
+    for (j=0; j<PARAM_M; j++)
+        f[j] = _mm256_set1_epi64x(-(long long)((f0 >> j) & 1));
+    poly_reverse(v, v, PARAM_T+1);
+    bitslice_mul13_256(b, f, v);
+
+    CT_memset(f, 0, sizeof(f));
+    CT_memset(h, 0, sizeof(h));
+    CT_memset(v, 0, sizeof(v));
+    CT_memset(r, 0, sizeof(r));
+
+    return -(int)(1 - EQ0(delta));
+}
+
+/**
+ *  b(z) = sqrt(a(z)) mod G(z), with deg a < τ
+ *
+ *  Writing a(z) = a_0(z)^2 + z.a_1(z)^2, the square root is
+ *  a_0(z) + sqrt(z).a_1(z)
+ **/
+static void poly_sqrtmod(__m256i *b, const __m256i *a, const __m256i *sqrt_z, const __m256i *g)
+{
+    int32_t j;
+    __m256i e[PARAM_M], o[PARAM_M];
+
+    for (j=0; j<PARAM_M; j++) {
+        e[j] = even_bits_256(a[j]);
+        o[j] = even_bits_256(shift_right_256(a[j]));
+    }
+    coefficient_sqrt(e, e);
+    coefficient_sqrt(o, o);
+    poly_mulmod(o, o, sqrt_z, g);
+    for (j=0; j<PARAM_M; j++)
+        b[j] = _mm256_xor_si256(e[j], o[j]);
+
+    CT_memset(e, 0, sizeof(e));
+    CT_memset(o, 0, sizeof(o));
+}
+
+int bitslice_patterson_setup(__m256i *sqrt_z, const __m256i *g)
+{
+    int32_t i, j, k, status = 0;
+    uint64_t diff = 0;
+    __m256i q[PARAM_T][PARAM_M];
+    __m256i x[PARAM_M], y[PARAM_M], t[PARAM_M], c[PARAM_M], z[PARAM_M];
+
+    for (j=0; j<PARAM_M; j++)
+        z[j] = _mm256_setzero_si256();
+    z[0] = _mm256_set_epi64x(0ULL, 0ULL, 0ULL, 2ULL);
+
+    /**
+     * The Frobenius map x -> x^{2^13} is linear over F_{2^13}, it
+     * is given by the images q_k = z^{2^13.k} mod G(z) of the basis
+     **/
+    memcpy(q[0], z, sizeof(z));
+    q[0][0] = _mm256_set_epi64x(0ULL, 0ULL, 0ULL, 1ULL);
+    memcpy(q[1], z, sizeof(z));
+    for (i=0; i<PARAM_M; i++)
+        poly_mulmod(q[1], q[1], q[1], g);
+    for (k=2; k<PARAM_T; k++)
+        poly_mulmod(q[k], q[k-1], q[1], g);
+
+    /**
+     * Rabin's test, G(z) of degree τ = 136 = 2^3.17 is irreducible iff
+     * z^{q^τ} = z mod G(z) and z^{q^{τ/p}} - z is coprime to G(z) for
+     * the prime divisors p = 2, 17 of τ, where q = 2^13
+     **/
+    memcpy(x, z, sizeof(z));
+    for (i=1; i<=PARAM_T; i++) {
+        for (j=0; j<PARAM_M; j++)
+            y[j] = _mm256_setzero_si256();
+        for (k=0; k<PARAM_T; k++) {
+            coefficient(c, x, k);
+            bitslice_mul13_256(t, c, q[k]);
+            for (j=0; j<PARAM_M; j++)
+                y[j] = _mm256_xor_si256(y[j], t[j]);
+        }
+        memcpy(x, y, sizeof(y));
+        if (i == PARAM_T/17 || i == PARAM_T/2) {
+            for (j=0; j<PARAM_M; j++)
+                t[j] = _mm256_xor_si256(x[j], z[j]);
+            status |= poly_invmod(y, t, g);
+        }
+    }
+    for (j=0; j<PARAM_M; j++) {
+        t[j] = _mm256_xor_si256(x[j], z[j]);
+        diff |= (uint64_t)(t[j][0] | t[j][1] | t[j][2] | t[j][3]);
+    }
+    status |= -(int)(1 - EQ0((int64_t)(diff | (diff >> 1))));
+
+    /**
+     * Writing G(z) = G_0(z)^2 + z.G_1(z)^2, sqrt(z) = G_0(z)/G_1(z)
+     **/
+    for (j=0; j<PARAM_M; j++) {
+        x[j] = even_bits_256(g[j]);
+        y[j] = even_bits_256(shift_right_256(g[j]));
+    }
+    coefficient_sqrt(x, x);
+    coefficient_sqrt(y, y);
+    status |= poly_invmod(t, y, g);
+    poly_mulmod(sqrt_z, x, t, g);
+
+    CT_memset(q, 0, sizeof(q));
+    CT_memset(x, 0, sizeof(x));
+    CT_memset(y, 0, sizeof(y));
+    CT_memset(t, 0, sizeof(t));
+    CT_memset(c, 0, sizeof(c));
+
+    return status ? -1 : 0;
+}
+
+void bitslice_patterson_syndrome(__m256i *s, const __m256i *u, const __m256i *g)
+{
+    int32_t j, m;
+    __m256i acc[PARAM_M], t[PARAM_M], c[PARAM_M], x[PARAM_M];
+
+    /**
+     * S(z) = Σ_m u_m.(G(z) - G_{<=m}(z))/z^{m+1}
+     **/
+    for (j=0; j<PARAM_M; j++) {
+        acc[j] = _mm256_setzero_si256();
+        t[j] = g[j];
+    }
+    for (m=0; m<PARAM_T; m++) {
+        for (j=0; j<PARAM_M; j++)
+            t[j] = shift_right_256(t[j]);
+        coefficient(c, u, m);
+        bitslice_mul13_256(x, c, t);
+        for (j=0; j<PARAM_M; j++)
+            acc[j] = _mm256_xor_si256(acc[j], x[j]);
+    }
+    memcpy(s, acc, sizeof(acc));
+
+    CT_memset(acc, 0, sizeof(acc));
+    CT_memset(c, 0, sizeof(c));
+    CT_memset(x, 0, sizeof(x));
+}
+
+void bitslice_patterson(__m128i (*sigma)[13],
+                        const __m256i *s,
+                        const __m256i *g,
+                        const __m256i *sqrt_z)
+{
+    int32_t j, k, n, len = 0, delta = 1;
+    uint64_t capture;
+    __m256i t[PARAM_M], f[PARAM_M], h[PARAM_M], v[PARAM_M], r[PARAM_M];
+    __m256i a[PARAM_M], b[PARAM_M];
+
+    /* T(z) = S(z)^{-1} mod G(z) */
+    poly_invmod(t, s, g);
+
+    /* R(z) = sqrt(T(z) + z) mod G(z) */
+    t[0] = _mm256_xor_si256(t[0], _mm256_set_epi64x(0ULL, 0ULL, 0ULL, 2ULL));
+    poly_sqrtmod(t, t, sqrt_z, g);
+
+    /**
+     * Solve a(z) = b(z).R(z) mod G(z) with deg a <= τ/2 and
+     * deg b < τ/2. The divsteps on G(z) and R(z) follow the
+     * Euclidean algorithm, the solution is the first remainder
+     * of degree at most τ/2 together with its cofactor. This
+     * is the state where the virtual degree of h is τ/2 while
+     * that of f is larger, i.e. δ = τ-1-n after n divsteps.
+     **/
+    divstep_init(f, h, v, r, t, g);
+    for (j=0; j<PARAM_M; j++) {
+        a[j] = _mm256_setzero_si256();
+        b[j] = _mm256_setzero_si256();
+    }
+    for (n=0; n<PARAM_T-1; n++) {
+        capture = EQ0(delta - (PARAM_T-1-n));
+        for (j=0; j<PARAM_M; j++) {
+            a[j] = vMUX256(capture, h[j], a[j]);
+            b[j] = vMUX256(capture, r[j], b[j]);
+        }
+        len ^= (-(int32_t)capture) & (len ^ (n + 2 - PARAM_T/2));
+        divstep(f, h, v, r, &delta);
+    }
+
+    /* a(z) = Σ_i h_i.z^{τ/2-i} */
+    poly_reverse(a, a, PARAM_T/2+1);
+
+    /* b(z) = Σ_i r_i.z^{len-1-i}, reversed with a constant-time shift */
+    for (j=0; j<PARAM_M; j++)
+        b[j] = bit_reverse_256(b[j]);
+    for (k=0; k<8; k++) {
+        capture = ((256 - len) >> k) & 1;
+        for (j=0; j<PARAM_M; j++)
+            b[j] = vMUX256(capture, shift_right_256_n(b[j], 1 << k), b[j]);
+    }
+
+    /* σ(z) = a(z)^2 + z.b(z)^2 */
+    vector_ff_sqr_13(NULL, f, a);
+    vector_ff_sqr_13(NULL, h, b);
+    for (j=0; j<PARAM_M; j++) {
+        t[j] = _mm256_xor_si256(spread_bits_256(f[j]),
+                                shift_left_256(spread_bits_256(h[j])));
+        sigma[0][j] = _mm256_castsi256_si128(t[j]);
+        sigma[1][j] = _mm256_extracti128_si256(t[j], 1);
+    }
+
+    CT_memset(t, 0, sizeof(t));
+    CT_memset(f, 0, sizeof(f));
+    CT_memset(h, 0, sizeof(h));
+    CT_memset(v, 0, sizeof(v));
+    CT_memset(r, 0, sizeof(r));
+    CT_memset(a, 0, sizeof(a));
+    CT_memset(b, 0, sizeof(b));
+}
@@ -0,0 +1,76 @@
+/**
+ *
+ *  bitslice_patterson_256.h
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  Constant-time Patterson decoding of binary Goppa codes.
+ *
+ *  Polynomials over F_{2^13} of degree less than 256 are bit-sliced
+ *  into 13 vectors of 256 bits, coefficient k is bit k of each vector.
+ *  All arithmetic modulo G(z) is performed with a fixed sequence of
+ *  operations, including the inversion and the partial extended
+ *  Euclidean algorithm which are computed using divsteps, see
+ *
+ *  Daniel J. Bernstein and Bo-Yin Yang, (2019),
+ *  "Fast constant-time gcd computation and modular inversion",
+ *  IACR Transactions on Cryptographic Hardware and Embedded Systems,
+ *  Volume 2019 (Issue 3), 340-398
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#ifndef __NTSKEM_BITSLICE_PATTERSON_256_H
+#define __NTSKEM_BITSLICE_PATTERSON_256_H
+
+#include <stdint.h>
+#include <immintrin.h>
+
+/**
+ *  Prepare a Goppa polynomial G(z) for Patterson decoding
+ *
+ *  @note
+ *  Patterson decoding inverts the syndrome polynomial modulo G(z),
+ *  which is possible for every correctable error pattern only if G(z)
+ *  is irreducible. This is checked with Rabin's irreducibility test.
+ *
+ *  @param[out] sqrt_z  The square root of z modulo G(z)
+ *  @param[in]  g       The monic Goppa polynomial G(z) of degree τ
+ *  @return 0 if G(z) is irreducible, -1 otherwise
+ **/
+int bitslice_patterson_setup(__m256i *sqrt_z, const __m256i *g);
+
+/**
+ *  Compute the syndrome polynomial S(z) = Σ c_i/(z - a_i) mod G(z)
+ *  from the τ weighted power sums u_j = Σ c_i.a_i^j/G(a_i)
+ *
+ *  @param[out] s  The syndrome polynomial S(z)
+ *  @param[in]  u  The power sums, u_j is coefficient j
+ *  @param[in]  g  The Goppa polynomial G(z)
+ **/
+void bitslice_patterson_syndrome(__m256i *s, const __m256i *u, const __m256i *g);
+
+/**
+ *  Patterson decoding, compute the error-locator polynomial
+ *  σ(z) = Π (z - a_i) over the error positions i
+ *
+ *  @note
+ *  The output is in the format of {@see bitslice_bma}, i.e. it can
+ *  be passed to the root finding directly, and no extended error
+ *  has to be accounted for as σ(0) = 0 for an error at a_i = 0.
+ *
+ *  @param[out] sigma   The error-locator polynomial σ(z)
+ *  @param[in]  s       The syndrome polynomial S(z)
+ *  @param[in]  g       The Goppa polynomial G(z)
+ *  @param[in]  sqrt_z  The square root of z modulo G(z)
+ **/
+void bitslice_patterson(__m128i (*sigma)[13],
+                        const __m256i *s,
+                        const __m256i *g,
+                        const __m256i *sqrt_z);
+
+#endif /* __NTSKEM_BITSLICE_PATTERSON_256_H */
@@ -38,4 +38,6 @@ void vector_store_2d_64(uint16_t* b, const uint64_t (*a)[PARAM_M], int32_t size)
 void vector_store_1d_256(uint16_t* b, const __m256i a[PARAM_M],   int32_t size);
 void vector_store_2d_256(uint16_t* b, const __m256i (*a)[PARAM_M], int32_t size);
 
+void vector_store_2d_128(uint16_t* b, const __m128i (*a)[PARAM_M], int32_t size);
+
 #endif /* __NTSKEM_VECTOR_UTILS_H */
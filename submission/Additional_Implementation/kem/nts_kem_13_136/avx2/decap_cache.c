@@ -0,0 +1,285 @@
+/**
+ *  decap_cache.c
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "decap_cache.h"
+#include "nts_kem_errors.h"
+#include "mem.h"
+
+#define DECAP_CACHE_NONE        ((size_t)-1)
+#define DECAP_CACHE_LRU         0       /* Least recently used first */
+#define DECAP_CACHE_AGE         1       /* Least recently stored first */
+
+typedef struct {
+    size_t prev;
+    size_t next;
+} decap_cache_link;
+
+typedef struct {
+    size_t head;
+    size_t tail;
+} decap_cache_list;
+
+typedef struct {
+    uint8_t digest[DECAP_CACHE_DIGEST_SIZE];
+    uint8_t k_r[NTS_KEM_KEY_SIZE];
+    int status;
+    uint64_t expiry;            /* Seconds of the monotonic clock */
+    decap_cache_link link[2];   /* In the LRU and the age lists */
+} decap_cache_entry;
+
+/**
+ *  The entries are indexed by digest in an open-addressing table with
+ *  linear probing of at least twice as many slots as entries. A slot
+ *  holds the index of its entry plus one, 0 if it is empty. As the
+ *  lifetime is the same for all the results, the age list is also in
+ *  the order of expiry and a sweep only visits the expired entries.
+ **/
+struct decap_cache {
+    size_t capacity;
+    uint32_t ttl;
+    pthread_mutex_t lock;
+    decap_cache_entry *entry;
+    size_t *slot;
+    size_t mask;                /* The number of slots minus one */
+    decap_cache_list list[2];
+    size_t free;                /* Unused entries, linked by their LRU link */
+};
+
+static uint64_t decap_cache_now()
+{
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return (uint64_t)ts.tv_sec;
+}
+
+static void decap_cache_unlink(decap_cache* cache, int l, size_t e)
+{
+    decap_cache_link *link = &cache->entry[e].link[l];
+    
+    if (link->prev != DECAP_CACHE_NONE)
+        cache->entry[link->prev].link[l].next = link->next;
+    else
+        cache->list[l].head = link->next;
+    if (link->next != DECAP_CACHE_NONE)
+        cache->entry[link->next].link[l].prev = link->prev;
+    else
+        cache->list[l].tail = link->prev;
+}
+
+static void decap_cache_append(decap_cache* cache, int l, size_t e)
+{
+    decap_cache_link *link = &cache->entry[e].link[l];
+    
+    link->prev = cache->list[l].tail;
+    link->next = DECAP_CACHE_NONE;
+    if (cache->list[l].tail != DECAP_CACHE_NONE)
+        cache->entry[cache->list[l].tail].link[l].next = e;
+    else
+        cache->list[l].head = e;
+    cache->list[l].tail = e;
+}
+
+/**
+ *  The home slot of a digest, the digest is the output of a hash
+ *  function and any of its bits will do
+ **/
+static size_t decap_cache_home(const decap_cache* cache, const uint8_t *digest)
+{
+    uint64_t h;
+    
+    memcpy(&h, digest, sizeof(h));
+    
+    return (size_t)h & cache->mask;
+}
+
+/**
+ *  The slot of a digest, or the empty slot where it would be stored
+ **/
+static size_t decap_cache_find(const decap_cache* cache, const uint8_t *digest)
+{
+    size_t i = decap_cache_home(cache, digest);
+    
+    while (cache->slot[i] &&
+           memcmp(cache->entry[cache->slot[i]-1].digest, digest, DECAP_CACHE_DIGEST_SIZE))
+        i = (i + 1) & cache->mask;
+    
+    return i;
+}
+
+/**
+ *  Empty a slot and shift back the entries that probed past it, so
+ *  that no probe sequence is broken
+ **/
+static void decap_cache_unindex(decap_cache* cache, size_t i)
+{
+    size_t j = i, k;
+    
+    for (;;) {
+        j = (j + 1) & cache->mask;
+        if (!cache->slot[j])
+            break;
+        k = decap_cache_home(cache, cache->entry[cache->slot[j]-1].digest);
+        /* The entry stays if its home is cyclically in (i, j] */
+        if (((j - k) & cache->mask) < ((j - i) & cache->mask))
+            continue;
+        cache->slot[i] = cache->slot[j];
+        i = j;
+    }
+    cache->slot[i] = 0;
+}
+
+/**
+ *  Remove an entry, wipe it and return it to the unused entries
+ **/
+static void decap_cache_remove(decap_cache* cache, size_t e)
+{
+    decap_cache_unindex(cache, decap_cache_find(cache, cache->entry[e].digest));
+    decap_cache_unlink(cache, DECAP_CACHE_LRU, e);
+    decap_cache_unlink(cache, DECAP_CACHE_AGE, e);
+    CT_memset(&cache->entry[e], 0, sizeof(decap_cache_entry));
+    cache->entry[e].link[DECAP_CACHE_LRU].next = cache->free;
+    cache->free = e;
+}
+
+/**
+ *  Wipe all the expired results, so that no key outlives its lifetime
+ *  in memory however seldom its ciphertext is received again
+ **/
+static void decap_cache_sweep(decap_cache* cache, uint64_t now)
+{
+    size_t e;
+    
+    if (!cache->ttl)
+        return;
+    while ((e = cache->list[DECAP_CACHE_AGE].head) != DECAP_CACHE_NONE &&
+           cache->entry[e].expiry <= now)
+        decap_cache_remove(cache, e);
+}
+
+int decap_cache_create(decap_cache** cache, size_t capacity, uint32_t ttl)
+{
+    size_t i, slots = 1;
+    
+    if (!cache || !capacity || capacity > ((size_t)-1)/(4*sizeof(decap_cache_entry)))
+        return NTS_KEM_BAD_PARAMETERS;
+    
+    while (slots < 2*capacity)
+        slots <<= 1;
+    
+    *cache = (decap_cache *)calloc(1, sizeof(decap_cache));
+    if (!(*cache))
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    
+    (*cache)->entry = (decap_cache_entry *)calloc(capacity, sizeof(decap_cache_entry));
+    (*cache)->slot = (size_t *)calloc(slots, sizeof(size_t));
+    if (!(*cache)->entry || !(*cache)->slot) {
+        free((*cache)->slot);
+        free((*cache)->entry);
+        free(*cache);
+        *cache = NULL;
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    }
+    (*cache)->capacity = capacity;
+    (*cache)->ttl = ttl;
+    (*cache)->mask = slots - 1;
+    for (i=0; i<2; i++) {
+        (*cache)->list[i].head = DECAP_CACHE_NONE;
+        (*cache)->list[i].tail = DECAP_CACHE_NONE;
+    }
+    (*cache)->free = DECAP_CACHE_NONE;
+    for (i=capacity; i>0; i--) {
+        (*cache)->entry[i-1].link[DECAP_CACHE_LRU].next = (*cache)->free;
+        (*cache)->free = i-1;
+    }
+    pthread_mutex_init(&(*cache)->lock, NULL);
+    
+    return NTS_KEM_SUCCESS;
+}
+
+int decap_cache_lookup(decap_cache* cache,
+                       const uint8_t *digest,
+                       uint8_t *k_r,
+                       int *status)
+{
+    size_t e;
+    int hit = 0;
+    uint64_t now = decap_cache_now();
+    
+    pthread_mutex_lock(&cache->lock);
+    decap_cache_sweep(cache, now);
+    e = cache->slot[decap_cache_find(cache, digest)];
+    if (e--) {
+        memcpy(k_r, cache->entry[e].k_r, NTS_KEM_KEY_SIZE);
+        *status = cache->entry[e].status;
+        decap_cache_unlink(cache, DECAP_CACHE_LRU, e);
+        decap_cache_append(cache, DECAP_CACHE_LRU, e);
+        hit = 1;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    
+    return hit;
+}
+
+void decap_cache_insert(decap_cache* cache,
+                        const uint8_t *digest,
+                        const uint8_t *k_r,
+                        int status)
+{
+    size_t i, e;
+    uint64_t now = decap_cache_now();
+    decap_cache_entry *entry = NULL;
+    
+    pthread_mutex_lock(&cache->lock);
+    decap_cache_sweep(cache, now);
+    i = decap_cache_find(cache, digest);
+    if (cache->slot[i]) {
+        e = cache->slot[i] - 1;
+        decap_cache_unlink(cache, DECAP_CACHE_LRU, e);
+        decap_cache_unlink(cache, DECAP_CACHE_AGE, e);
+    }
+    else {
+        if (cache->free == DECAP_CACHE_NONE) {
+            decap_cache_remove(cache, cache->list[DECAP_CACHE_LRU].head);
+            i = decap_cache_find(cache, digest);
+        }
+        e = cache->free;
+        cache->free = cache->entry[e].link[DECAP_CACHE_LRU].next;
+        cache->slot[i] = e + 1;
+    }
+    
+    entry = &cache->entry[e];
+    CT_memset(entry, 0, sizeof(decap_cache_entry));
+    memcpy(entry->digest, digest, DECAP_CACHE_DIGEST_SIZE);
+    memcpy(entry->k_r, k_r, NTS_KEM_KEY_SIZE);
+    entry->status = status;
+    entry->expiry = now + cache->ttl;
+    decap_cache_append(cache, DECAP_CACHE_LRU, e);
+    decap_cache_append(cache, DECAP_CACHE_AGE, e);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void decap_cache_release(decap_cache* cache)
+{
+    if (cache) {
+        CT_memset(cache->entry, 0, cache->capacity*sizeof(decap_cache_entry));
+        pthread_mutex_destroy(&cache->lock);
+        free(cache->slot);
+        free(cache->entry);
+        free(cache);
+    }
+}
@@ -0,0 +1,82 @@
+/**
+ *  decap_cache.h
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  Cache of the results of decapsulations, keyed by the digest of
+ *  the ciphertext, for ciphertexts that are received more than once.
+ *  Both valid and implicitly rejected ciphertexts are cached, a hit
+ *  takes the same time regardless of the outcome.
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#ifndef __NTSKEM_DECAP_CACHE_H
+#define __NTSKEM_DECAP_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "nts_kem_params.h"
+
+#define DECAP_CACHE_DIGEST_SIZE 32
+
+typedef struct decap_cache decap_cache;
+
+/**
+ *  Create a cache of decapsulation results
+ *
+ *  @param[out] cache     A pointer of decap_cache object created
+ *  @param[in]  capacity  The maximum number of results
+ *  @param[in]  ttl       The lifetime of a result in seconds,
+ *                        0 if results do not expire
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int decap_cache_create(decap_cache** cache, size_t capacity, uint32_t ttl);
+
+/**
+ *  Look up the result of the decapsulation of a ciphertext
+ *
+ *  @note
+ *  All the expired results are wiped first
+ *
+ *  @param[in]  cache   The cache
+ *  @param[in]  digest  The digest of the ciphertext
+ *  @param[out] k_r     The key, unchanged on a miss
+ *  @param[out] status  The status of the decapsulation, unchanged on a miss
+ *  @return 1 if the result is in the cache, 0 otherwise
+ **/
+int decap_cache_lookup(decap_cache* cache,
+                       const uint8_t *digest,
+                       uint8_t *k_r,
+                       int *status);
+
+/**
+ *  Store the result of the decapsulation of a ciphertext
+ *
+ *  @note
+ *  All the expired results are wiped first, then the least recently
+ *  used result is evicted and wiped if the cache is still full
+ *
+ *  @param[in] cache   The cache
+ *  @param[in] digest  The digest of the ciphertext
+ *  @param[in] k_r     The key
+ *  @param[in] status  The status of the decapsulation
+ **/
+void decap_cache_insert(decap_cache* cache,
+                        const uint8_t *digest,
+                        const uint8_t *k_r,
+                        int status);
+
+/**
+ *  Wipe all the results and release the cache
+ *
+ *  @param[in] cache  The cache
+ **/
+void decap_cache_release(decap_cache* cache);
+
+#endif /* __NTSKEM_DECAP_CACHE_H */
@@ -154,3 +154,95 @@ void sha3_256(const unsigned char *input, unsigned int inputByteLen, unsigned ch
 {
     hash(output, 32, input, inputByteLen, 200-(256/4), 0x06);
 }
+
+#define SHA3_256_RATE   (200-(256/4))
+
+void sha3_256_init(sha3_256_state *state)
+{
+    memset(state->a, 0, Plen);
+    state->offset = 0;
+}
+
+void sha3_256_absorb(sha3_256_state *state, const unsigned char *input, size_t inputByteLen)
+{
+    size_t len;
+    
+    while (inputByteLen) {
+        len = SHA3_256_RATE - state->offset;
+        if (len > inputByteLen)
+            len = inputByteLen;
+        xorin(&state->a[state->offset], input, len);
+        state->offset += len;
+        input += len;
+        inputByteLen -= len;
+        if (state->offset == SHA3_256_RATE) {
+            P(state->a);
+            state->offset = 0;
+        }
+    }
+}
+
+void sha3_256_final(sha3_256_state *state, unsigned char *output)
+{
+    // Xor in the DS and pad frame.
+    state->a[state->offset] ^= 0x06;
+    state->a[SHA3_256_RATE - 1] ^= 0x80;
+    // Apply P
+    P(state->a);
+    setout(state->a, output, 32);
+#if defined(__STDC_WANT_LIB_EXT1__)
+    CT_memset_s(state->a, 200, 0, 200);
+#else
+    CT_memset(state->a, 0, 200);
+#endif
+    state->offset = 0;
+}
+
+#define SHAKE256_RATE   (200-(256/4))
+
+void shake256_init(shake256_state *state, const unsigned char *input, size_t inputByteLen)
+{
+    uint8_t* a = state->a;
+    size_t rate = SHAKE256_RATE;
+    
+    memset(a, 0, Plen);
+    // Absorb input.
+    foldP(input, inputByteLen, xorin);
+    // Xor in the DS and pad frame.
+    a[inputByteLen] ^= 0x1f;
+    a[rate - 1] ^= 0x80;
+    // Xor in the last block.
+    xorin(a, input, inputByteLen);
+    // Apply P
+    P(a);
+    state->offset = 0;
+}
+
+void shake256_squeeze(shake256_state *state, unsigned char *output, size_t outputByteLen)
+{
+    size_t len;
+    
+    while (outputByteLen) {
+        if (state->offset == SHAKE256_RATE) {
+            P(state->a);
+            state->offset = 0;
+        }
+        len = SHAKE256_RATE - state->offset;
+        if (len > outputByteLen)
+            len = outputByteLen;
+        setout(&state->a[state->offset], output, len);
+        state->offset += len;
+        output += len;
+        outputByteLen -= len;
+    }
+}
+
+void shake256_release(shake256_state *state)
+{
+#if defined(__STDC_WANT_LIB_EXT1__)
+    CT_memset_s(state->a, 200, 0, 200);
+#else
+    CT_memset(state->a, 0, 200);
+#endif
+    state->offset = 0;
+}
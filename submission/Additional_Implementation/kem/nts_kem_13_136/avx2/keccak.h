@@ -7,6 +7,39 @@
 #ifndef __KECCAK_H
 #define __KECCAK_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ *  SHAKE256 extendable-output function state, the output
+ *  is squeezed incrementally
+ **/
+typedef struct {
+    uint8_t a[200];             /* Keccak-f[1600] state */
+    size_t offset;              /* Bytes of the current block squeezed */
+} shake256_state;
+
+/**
+ *  SHA3-256 hash function state, the input is absorbed
+ *  incrementally
+ **/
+typedef struct {
+    uint8_t a[200];             /* Keccak-f[1600] state */
+    size_t offset;              /* Bytes of the current block absorbed */
+} sha3_256_state;
+
 void sha3_256(const unsigned char *input, unsigned int inputByteLen, unsigned char *output);
 
+void sha3_256_init(sha3_256_state *state);
+
+void sha3_256_absorb(sha3_256_state *state, const unsigned char *input, size_t inputByteLen);
+
+void sha3_256_final(sha3_256_state *state, unsigned char *output);
+
+void shake256_init(shake256_state *state, const unsigned char *input, size_t inputByteLen);
+
+void shake256_squeeze(shake256_state *state, unsigned char *output, size_t outputByteLen);
+
+void shake256_release(shake256_state *state);
+
 #endif /* __KECCAK_H */
@@ -0,0 +1,498 @@
+/**
+ *  kem_engine.c
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#if defined(__linux__)
+#define _GNU_SOURCE             /* pthread_setaffinity_np */
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#include "api.h"
+#include "kem_engine.h"
+#include "nts_kem_errors.h"
+#include "random.h"
+#include "mem.h"
+
+typedef struct {
+    NTSKEM_engine *engine;
+    int index;
+    pthread_t thread;
+} engine_worker;
+
+struct NTSKEM_engine {
+    NTSKEM_async_job *head;         /* Submitted jobs, the latest first */
+    int idle;                       /* Workers waiting for jobs */
+    uint64_t max_latency;           /* Nanoseconds */
+    uint32_t flags;
+    int stop;
+
+    pthread_mutex_t lock;           /* Held by the worker taking jobs */
+    pthread_cond_t work;
+    NTSKEM_async_job *ready;        /* Taken jobs, the oldest first */
+    size_t ready_count;
+
+    pthread_mutex_t rng_lock;       /* Serialises randombytes */
+
+    pthread_mutex_t ring_lock;
+    pthread_cond_t ring_done;
+    NTSKEM_async_job **ring;        /* Completed jobs without a callback */
+    size_t ring_size;
+    size_t ring_first;
+    size_t ring_count;
+    size_t polled;                  /* Such jobs in flight or in the ring */
+
+    uint64_t submitted;             /* Counters, updated atomically */
+    uint64_t jobs[3];
+    uint64_t batches[3];
+
+    int count;
+    int started;
+    engine_worker *workers;
+};
+
+static uint64_t engine_now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ *  Move the submitted jobs to the end of the ready list, in order
+ *  of submission. The caller holds the engine lock.
+ **/
+static void engine_take(NTSKEM_engine* engine)
+{
+    NTSKEM_async_job *list, *next, *job = NULL, **tail = &engine->ready;
+
+    list = __atomic_exchange_n(&engine->head, NULL, __ATOMIC_SEQ_CST);
+    if (!list)
+        return;
+
+    while (list) {
+        next = list->next;
+        list->next = job;
+        job = list;
+        list = next;
+        engine->ready_count++;
+    }
+    while (*tail)
+        tail = &(*tail)->next;
+    *tail = job;
+}
+
+/**
+ *  Whether two jobs can be run in the same batch
+ **/
+static int engine_compatible(const NTSKEM_async_job* a, const NTSKEM_async_job* b)
+{
+    if (a->op != b->op)
+        return 0;
+    if (a->op == NTS_KEM_JOB_ENCAPSULATE)
+        return 1;
+    if (a->op == NTS_KEM_JOB_DECAPSULATE)
+        return a->ctx && b->ctx;
+
+    return 0;
+}
+
+/**
+ *  Unlink the oldest ready job and up to NTS_KEM_ENGINE_BATCH_SIZE-1
+ *  ready jobs that are compatible with it. The caller holds the
+ *  engine lock.
+ **/
+static size_t engine_select(NTSKEM_engine* engine, NTSKEM_async_job** batch)
+{
+    size_t n = 0;
+    NTSKEM_async_job **link;
+
+    batch[n++] = engine->ready;
+    engine->ready = engine->ready->next;
+    for (link=&engine->ready; *link && n<NTS_KEM_ENGINE_BATCH_SIZE; ) {
+        if (engine_compatible(batch[0], *link)) {
+            batch[n++] = *link;
+            *link = (*link)->next;
+        }
+        else {
+            link = &(*link)->next;
+        }
+    }
+    engine->ready_count -= n;
+
+    return n;
+}
+
+/**
+ *  Draw a seed from randombytes, one worker at a time
+ **/
+static int engine_seed(NTSKEM_engine* engine, uint8_t *seed)
+{
+    int status;
+
+    pthread_mutex_lock(&engine->rng_lock);
+    status = randombytes(seed, NTS_KEM_SEED_SIZE);
+    pthread_mutex_unlock(&engine->rng_lock);
+
+    return status;
+}
+
+static void engine_keypair(NTSKEM_engine* engine, NTSKEM_async_job* job)
+{
+    NTSKEM *nts_kem = NULL;
+    uint8_t seed[NTS_KEM_SEED_SIZE];
+
+    job->status = engine_seed(engine, seed);
+    if (job->status == NTS_KEM_SUCCESS)
+        job->status = nts_kem_create_from_seed(&nts_kem, seed);
+    if (job->status == NTS_KEM_SUCCESS) {
+        memcpy(job->pk, nts_kem->public_key, CRYPTO_PUBLICKEYBYTES);
+        memcpy(job->sk, nts_kem->private_key, CRYPTO_SECRETKEYBYTES);
+        nts_kem_release(nts_kem);
+    }
+    CT_memset(seed, 0, NTS_KEM_SEED_SIZE);
+}
+
+static void engine_encapsulate(NTSKEM_engine* engine, NTSKEM_async_job** batch, size_t n)
+{
+    size_t i;
+    int status;
+    NTSKEM_encap_job jobs[NTS_KEM_ENGINE_BATCH_SIZE];
+    uint8_t seed[NTS_KEM_SEED_SIZE];
+
+    for (i=0; i<n; i++) {
+        jobs[i].pk = batch[i]->pk;
+        jobs[i].c_ast = batch[i]->ct;
+        jobs[i].k_r = batch[i]->ss;
+    }
+    status = engine_seed(engine, seed);
+    if (status == NTS_KEM_SUCCESS)
+        status = nts_kem_encapsulate_batch_from_seed(jobs, n, seed);
+    for (i=0; i<n; i++)
+        batch[i]->status = (status == NTS_KEM_SUCCESS) ? jobs[i].status : status;
+    CT_memset(seed, 0, NTS_KEM_SEED_SIZE);
+}
+
+static void engine_decapsulate(NTSKEM_async_job** batch, size_t n)
+{
+    size_t i;
+
+    if (!batch[0]->ctx) {
+        batch[0]->status = crypto_kem_dec(batch[0]->ss, batch[0]->ct, batch[0]->sk);
+        return;
+    }
+
+    for (i=0; i<n; i++)
+        batch[i]->status = nts_kem_decap_ctx_decapsulate(batch[i]->ctx, batch[i]->ct,
+                                                         batch[i]->ss);
+}
+
+/**
+ *  Run a batch of jobs and complete them
+ **/
+static void engine_run(NTSKEM_engine* engine, NTSKEM_async_job** batch, size_t n)
+{
+    size_t i;
+
+    switch (batch[0]->op) {
+        case NTS_KEM_JOB_KEYPAIR:
+            engine_keypair(engine, batch[0]);
+            break;
+        case NTS_KEM_JOB_ENCAPSULATE:
+            engine_encapsulate(engine, batch, n);
+            break;
+        default:
+            engine_decapsulate(batch, n);
+            break;
+    }
+    __atomic_add_fetch(&engine->jobs[batch[0]->op-1], n, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&engine->batches[batch[0]->op-1], 1, __ATOMIC_RELAXED);
+
+    for (i=0; i<n; i++) {
+        batch[i]->next = NULL;
+        if (batch[i]->callback) {
+            batch[i]->callback(batch[i], batch[i]->arg);
+            continue;
+        }
+        pthread_mutex_lock(&engine->ring_lock);
+        engine->ring[(engine->ring_first + engine->ring_count) % engine->ring_size] = batch[i];
+        engine->ring_count++;
+        pthread_cond_broadcast(&engine->ring_done);
+        pthread_mutex_unlock(&engine->ring_lock);
+    }
+}
+
+/**
+ *  Wait on the work condition until a job is submitted, or until
+ *  the deadline if it is non-zero. The caller holds the engine lock.
+ **/
+static void engine_wait(NTSKEM_engine* engine, uint64_t deadline)
+{
+    struct timespec ts;
+
+    __atomic_add_fetch(&engine->idle, 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&engine->head, __ATOMIC_SEQ_CST)) {
+        if (deadline) {
+            ts.tv_sec = (time_t)(deadline / 1000000000ULL);
+            ts.tv_nsec = (long)(deadline % 1000000000ULL);
+            pthread_cond_timedwait(&engine->work, &engine->lock, &ts);
+        }
+        else {
+            pthread_cond_wait(&engine->work, &engine->lock);
+        }
+    }
+    __atomic_sub_fetch(&engine->idle, 1, __ATOMIC_SEQ_CST);
+}
+
+static void *engine_main(void *ptr)
+{
+    engine_worker *w = (engine_worker *)ptr;
+    NTSKEM_engine *engine = w->engine;
+    NTSKEM_async_job *batch[NTS_KEM_ENGINE_BATCH_SIZE];
+    uint64_t deadline;
+    size_t n;
+
+#if defined(__linux__)
+    if (engine->flags & NTS_KEM_ENGINE_PIN_WORKERS) {
+        cpu_set_t cpus;
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+        CPU_ZERO(&cpus);
+        CPU_SET(w->index % (ncpu > 0 ? ncpu : 1), &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#endif
+
+    pthread_mutex_lock(&engine->lock);
+    for (;;) {
+        engine_take(engine);
+        if (engine->ready_count) {
+            /**
+             * Wait for a batch to fill for no longer than
+             * the oldest job may wait
+             **/
+            if (engine->ready_count < NTS_KEM_ENGINE_BATCH_SIZE &&
+                engine->max_latency && !engine->stop) {
+                deadline = engine->ready->submitted + engine->max_latency;
+                if (engine_now() < deadline) {
+                    engine_wait(engine, deadline);
+                    continue;
+                }
+            }
+            n = engine_select(engine, batch);
+            pthread_mutex_unlock(&engine->lock);
+            engine_run(engine, batch, n);
+            pthread_mutex_lock(&engine->lock);
+            continue;
+        }
+        if (engine->stop)
+            break;
+        engine_wait(engine, 0);
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    return NULL;
+}
+
+int nts_kem_engine_create(NTSKEM_engine** engine,
+                          int workers,
+                          uint32_t max_latency,
+                          size_t ring_size,
+                          uint32_t flags)
+{
+    int i;
+    long ncpu;
+    pthread_condattr_t attr;
+    NTSKEM_engine *engine_ptr = NULL;
+
+    if (!engine || workers < 0 || !ring_size)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    if (!workers) {
+        ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = (ncpu > 0) ? (int)ncpu : 1;
+    }
+
+    *engine = (NTSKEM_engine *)calloc(1, sizeof(NTSKEM_engine));
+    if (!(*engine))
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    engine_ptr = *engine;
+    engine_ptr->max_latency = (uint64_t)max_latency * 1000ULL;
+    engine_ptr->flags = flags;
+    engine_ptr->ring_size = ring_size;
+    engine_ptr->count = workers;
+
+    engine_ptr->ring = (NTSKEM_async_job **)calloc(ring_size, sizeof(NTSKEM_async_job *));
+    engine_ptr->workers = (engine_worker *)calloc(workers, sizeof(engine_worker));
+    if (!engine_ptr->ring || !engine_ptr->workers) {
+        free(engine_ptr->workers);
+        free(engine_ptr->ring);
+        free(engine_ptr);
+        *engine = NULL;
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    }
+
+    pthread_mutex_init(&engine_ptr->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&engine_ptr->work, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&engine_ptr->rng_lock, NULL);
+    pthread_mutex_init(&engine_ptr->ring_lock, NULL);
+    pthread_cond_init(&engine_ptr->ring_done, NULL);
+
+    for (i=0; i<workers; i++) {
+        engine_ptr->workers[i].engine = engine_ptr;
+        engine_ptr->workers[i].index = i;
+        if (0 != pthread_create(&engine_ptr->workers[i].thread, NULL,
+                                engine_main, &engine_ptr->workers[i])) {
+            nts_kem_engine_release(engine_ptr);
+            *engine = NULL;
+            return NTS_KEM_BAD_MEMORY_ALLOCATION;
+        }
+        engine_ptr->started++;
+    }
+
+    return NTS_KEM_SUCCESS;
+}
+
+int nts_kem_engine_submit(NTSKEM_engine* engine,
+                          NTSKEM_async_job* job)
+{
+    NTSKEM_async_job *head;
+
+    if (!engine || !job)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    switch (job->op) {
+        case NTS_KEM_JOB_KEYPAIR:
+            if (!job->pk || !job->sk)
+                return NTS_KEM_BAD_PARAMETERS;
+            break;
+        case NTS_KEM_JOB_ENCAPSULATE:
+            if (!job->pk || !job->ct || !job->ss)
+                return NTS_KEM_BAD_PARAMETERS;
+            break;
+        case NTS_KEM_JOB_DECAPSULATE:
+            if ((!job->ctx && !job->sk) || !job->ct || !job->ss)
+                return NTS_KEM_BAD_PARAMETERS;
+            break;
+        default:
+            return NTS_KEM_BAD_PARAMETERS;
+    }
+
+    /**
+     * A job without a callback has a place in the ring
+     * from its submission until it is polled
+     **/
+    if (!job->callback) {
+        if (__atomic_add_fetch(&engine->polled, 1, __ATOMIC_SEQ_CST) > engine->ring_size) {
+            __atomic_sub_fetch(&engine->polled, 1, __ATOMIC_SEQ_CST);
+            return NTS_KEM_BUSY;
+        }
+    }
+    job->submitted = engine_now();
+    __atomic_add_fetch(&engine->submitted, 1, __ATOMIC_RELAXED);
+
+    head = __atomic_load_n(&engine->head, __ATOMIC_RELAXED);
+    do {
+        job->next = head;
+    } while (!__atomic_compare_exchange_n(&engine->head, &head, job, 1,
+                                          __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+
+    /**
+     * The lock is only taken if a worker is waiting, it has then
+     * seen an empty queue before this job was pushed
+     **/
+    if (__atomic_load_n(&engine->idle, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&engine->lock);
+        pthread_cond_signal(&engine->work);
+        pthread_mutex_unlock(&engine->lock);
+    }
+
+    return NTS_KEM_SUCCESS;
+}
+
+size_t nts_kem_engine_poll(NTSKEM_engine* engine,
+                           NTSKEM_async_job** jobs,
+                           size_t max,
+                           int wait)
+{
+    size_t i, n;
+
+    if (!engine || !jobs || !max)
+        return 0;
+
+    pthread_mutex_lock(&engine->ring_lock);
+    while (wait && !engine->ring_count &&
+           __atomic_load_n(&engine->polled, __ATOMIC_SEQ_CST))
+        pthread_cond_wait(&engine->ring_done, &engine->ring_lock);
+    n = (engine->ring_count < max) ? engine->ring_count : max;
+    for (i=0; i<n; i++) {
+        jobs[i] = engine->ring[engine->ring_first];
+        engine->ring_first = (engine->ring_first + 1) % engine->ring_size;
+    }
+    engine->ring_count -= n;
+    __atomic_sub_fetch(&engine->polled, n, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&engine->ring_lock);
+
+    return n;
+}
+
+void nts_kem_engine_stats(NTSKEM_engine* engine,
+                          NTSKEM_engine_stats* stats)
+{
+    int i;
+    uint64_t done = 0;
+
+    if (!engine || !stats)
+        return;
+
+    for (i=0; i<3; i++) {
+        stats->jobs[i] = __atomic_load_n(&engine->jobs[i], __ATOMIC_RELAXED);
+        stats->batches[i] = __atomic_load_n(&engine->batches[i], __ATOMIC_RELAXED);
+        done += stats->jobs[i];
+    }
+    stats->pending = __atomic_load_n(&engine->submitted, __ATOMIC_RELAXED);
+    stats->pending = (stats->pending > done) ? stats->pending - done : 0;
+}
+
+void nts_kem_engine_release(NTSKEM_engine* engine)
+{
+    int i;
+
+    if (engine) {
+        pthread_mutex_lock(&engine->lock);
+        engine->stop = 1;
+        pthread_cond_broadcast(&engine->work);
+        pthread_mutex_unlock(&engine->lock);
+        for (i=0; i<engine->started; i++) {
+            pthread_join(engine->workers[i].thread, NULL);
+        }
+
+        pthread_cond_destroy(&engine->ring_done);
+        pthread_mutex_destroy(&engine->ring_lock);
+        pthread_mutex_destroy(&engine->rng_lock);
+        pthread_cond_destroy(&engine->work);
+        pthread_mutex_destroy(&engine->lock);
+        free(engine->workers);
+        free(engine->ring);
+        free(engine);
+    }
+}
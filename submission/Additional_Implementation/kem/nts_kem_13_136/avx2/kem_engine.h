@@ -0,0 +1,187 @@
+/**
+ *  kem_engine.h
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  An asynchronous engine that runs the key generations,
+ *  encapsulations and decapsulations submitted by any number
+ *  of threads on a pool of worker threads, in batches
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#ifndef __NTSKEM_KEM_ENGINE_H
+#define __NTSKEM_KEM_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "nts_kem.h"
+
+/**
+ *  Operations of an asynchronous job
+ **/
+#define NTS_KEM_JOB_KEYPAIR         1   /* As crypto_kem_keypair */
+#define NTS_KEM_JOB_ENCAPSULATE     2   /* As crypto_kem_enc */
+#define NTS_KEM_JOB_DECAPSULATE     3   /* As crypto_kem_dec */
+
+/**
+ *  Flags of nts_kem_engine_create
+ **/
+#define NTS_KEM_ENGINE_PIN_WORKERS  0x01    /* Pin worker i to CPU i */
+
+/**
+ *  The maximum number of jobs run together
+ **/
+#ifndef NTS_KEM_ENGINE_BATCH_SIZE
+#define NTS_KEM_ENGINE_BATCH_SIZE   16
+#endif
+
+typedef struct NTSKEM_engine NTSKEM_engine;
+
+/**
+ *  The counters of an asynchronous engine, indexed by
+ *  operation minus one
+ **/
+typedef struct {
+    uint64_t jobs[3];               /* Completed jobs */
+    uint64_t batches[3];            /* Batches these jobs were run in */
+    uint64_t pending;               /* Jobs submitted and not yet run */
+} NTSKEM_engine_stats;
+
+typedef struct NTSKEM_async_job NTSKEM_async_job;
+
+/**
+ *  The function called on the completion of a job
+ *
+ *  @note
+ *  It is called from a worker thread of the engine, and must not
+ *  block for long as no other job is run by that worker meanwhile
+ *
+ *  @param[in] job  The completed job
+ *  @param[in] arg  The argument given with the job
+ **/
+typedef void (*NTSKEM_async_callback)(NTSKEM_async_job *job, void *arg);
+
+/**
+ *  An asynchronous job, the buffers are those of the corresponding
+ *  function of api.h and must remain valid until the job completes
+ **/
+struct NTSKEM_async_job {
+    int op;                         /* NTS_KEM_JOB_* */
+    uint8_t *pk;                    /* The public key, output of a key
+                                       generation, input of an encapsulation */
+    uint8_t *sk;                    /* The private key, output of a key
+                                       generation, input of a decapsulation */
+    const NTSKEM_decap_ctx *ctx;    /* The decapsulation context used
+                                       instead of sk, or NULL */
+    uint8_t *ct;                    /* The ciphertext */
+    uint8_t *ss;                    /* The shared secret */
+    NTSKEM_async_callback callback; /* Called on completion, or NULL for
+                                       the completion to be polled */
+    void *arg;                      /* The argument of the callback */
+    int status;                     /* The outcome, as returned by the
+                                       corresponding function of api.h */
+
+    /* Private to the engine while the job is in flight */
+    NTSKEM_async_job *next;
+    uint64_t submitted;
+};
+
+/**
+ *  Create an asynchronous engine
+ *
+ *  @note
+ *  A worker takes the submitted jobs when it is idle, and runs up to
+ *  NTS_KEM_ENGINE_BATCH_SIZE of the same kind together: encapsulations
+ *  by {@see nts_kem_encapsulate_batch_from_seed}, and decapsulations
+ *  under a context one after another. Key generations and
+ *  decapsulations from a private key are run one at a time. If fewer jobs than a batch are waiting, a worker waits
+ *  for more until the oldest job has waited max_latency microseconds,
+ *  so batches grow with the load and the latency added at a low load
+ *  is bounded.
+ *
+ *  The randomness of the jobs is derived from seeds drawn from
+ *  randombytes by one worker at a time. The random source is shared
+ *  by the whole library, randomised functions should not be called
+ *  by other threads while the engine is running.
+ *
+ *  @param[out] engine       A pointer of NTSKEM_engine object created
+ *  @param[in]  workers      The number of worker threads, or 0 for
+ *                           one per online CPU
+ *  @param[in]  max_latency  The maximum time in microseconds a job
+ *                           waits for a batch to fill, 0 not to wait
+ *  @param[in]  ring_size    The maximum number of jobs without a
+ *                           callback in flight or awaiting a poll
+ *  @param[in]  flags        Bitwise-OR of NTS_KEM_ENGINE_* flags
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_engine_create(NTSKEM_engine** engine,
+                          int workers,
+                          uint32_t max_latency,
+                          size_t ring_size,
+                          uint32_t flags);
+
+/**
+ *  Submit a job to an asynchronous engine
+ *
+ *  @note
+ *  Jobs are submitted without taking a lock and may be submitted by
+ *  any number of threads. The job belongs to the engine until its
+ *  callback is called or it is returned by {@see nts_kem_engine_poll}.
+ *
+ *  @param[in]     engine  The asynchronous engine
+ *  @param[in,out] job     The job
+ *  @return NTS_KEM_SUCCESS on success, NTS_KEM_BUSY if the job has no
+ *          callback and ring_size such jobs are already in flight or
+ *          awaiting a poll, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_engine_submit(NTSKEM_engine* engine,
+                          NTSKEM_async_job* job);
+
+/**
+ *  Retrieve the completed jobs that have no callback
+ *
+ *  @param[in]  engine  The asynchronous engine
+ *  @param[out] jobs    The completed jobs, in order of completion
+ *  @param[in]  max     The maximum number of jobs to retrieve
+ *  @param[in]  wait    Non-zero to wait for a completion if none is
+ *                      available while such jobs are in flight
+ *  @return The number of jobs retrieved
+ **/
+size_t nts_kem_engine_poll(NTSKEM_engine* engine,
+                           NTSKEM_async_job** jobs,
+                           size_t max,
+                           int wait);
+
+/**
+ *  Read the counters of an asynchronous engine
+ *
+ *  @note
+ *  The counters are read while jobs may be running, they are
+ *  each accurate but not necessarily consistent with each other
+ *
+ *  @param[in]  engine  The asynchronous engine
+ *  @param[out] stats   The counters
+ **/
+void nts_kem_engine_stats(NTSKEM_engine* engine,
+                          NTSKEM_engine_stats* stats);
+
+/**
+ *  Complete the submitted jobs, stop the workers and release
+ *  an asynchronous engine
+ *
+ *  @note
+ *  No job may be submitted once this function is called. The
+ *  completions that have not been polled are discarded.
+ *
+ *  @param[in] engine  The asynchronous engine
+ **/
+void nts_kem_engine_release(NTSKEM_engine* engine);
+
+#endif /* __NTSKEM_KEM_ENGINE_H */
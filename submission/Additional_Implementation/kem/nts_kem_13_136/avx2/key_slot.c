@@ -0,0 +1,255 @@
+/**
+ *  key_slot.c
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#if defined(__linux__)
+#define _GNU_SOURCE             /* syscall */
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/membarrier.h>
+#endif
+#include "api.h"
+#include "key_slot.h"
+#include "nts_kem_errors.h"
+#include "bits.h"
+#include "mem.h"
+
+#define KEY_SLOT_CACHE_LINE     64
+
+/**
+ *  A reader has a cache line of its own, it is written on every
+ *  section and read by the rotations only
+ **/
+struct NTSKEM_key_reader {
+    uint64_t active;                /* The epoch of the slot on entry to
+                                       the section, 0 outside of one */
+    NTSKEM_key_slot *slot;
+    NTSKEM_key_reader *next;
+    uint8_t pad[KEY_SLOT_CACHE_LINE - sizeof(uint64_t) - 2*sizeof(void *)];
+};
+
+struct NTSKEM_key_slot {
+    NTSKEM_decap_ctx *current;
+    NTSKEM_decap_ctx *previous;
+    uint64_t epoch;                 /* Incremented on every rotation */
+    int membarrier;                 /* Whether rotations fence the readers */
+
+    pthread_mutex_t lock;           /* Serialises rotations and registrations */
+    NTSKEM_key_reader *readers;
+};
+
+/**
+ *  Order the store of the epoch of a reader before its loads of the
+ *  contexts. With membarrier, the fence is issued by the rotation on
+ *  behalf of all the readers and a reader only keeps the compiler
+ *  from reordering.
+ **/
+static inline void key_slot_reader_fence(const NTSKEM_key_slot* slot)
+{
+    if (slot->membarrier)
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    else
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static void key_slot_writer_fence(const NTSKEM_key_slot* slot)
+{
+#if defined(__linux__)
+    if (slot->membarrier &&
+        syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) == 0)
+        return;
+#endif
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/**
+ *  Whether the kernel can fence all the threads of the process
+ **/
+static int key_slot_membarrier()
+{
+#if defined(__linux__)
+    long cmds = syscall(SYS_membarrier, MEMBARRIER_CMD_QUERY, 0);
+
+    if (cmds > 0 && (cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED) &&
+        syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0)
+        return 1;
+#endif
+    return 0;
+}
+
+int nts_kem_key_slot_create(NTSKEM_key_slot** slot,
+                            NTSKEM_decap_ctx* ctx)
+{
+    if (!slot || !ctx)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    *slot = (NTSKEM_key_slot *)calloc(1, sizeof(NTSKEM_key_slot));
+    if (!(*slot))
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    (*slot)->current = ctx;
+    (*slot)->epoch = 1;
+    (*slot)->membarrier = key_slot_membarrier();
+    pthread_mutex_init(&(*slot)->lock, NULL);
+
+    return NTS_KEM_SUCCESS;
+}
+
+int nts_kem_key_slot_reader_create(NTSKEM_key_slot* slot,
+                                   NTSKEM_key_reader** reader)
+{
+    void *ptr = NULL;
+
+    if (!slot || !reader)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    if (posix_memalign(&ptr, KEY_SLOT_CACHE_LINE, sizeof(NTSKEM_key_reader)))
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    *reader = (NTSKEM_key_reader *)ptr;
+    memset(*reader, 0, sizeof(NTSKEM_key_reader));
+    (*reader)->slot = slot;
+
+    pthread_mutex_lock(&slot->lock);
+    (*reader)->next = slot->readers;
+    slot->readers = *reader;
+    pthread_mutex_unlock(&slot->lock);
+
+    return NTS_KEM_SUCCESS;
+}
+
+void nts_kem_key_slot_reader_release(NTSKEM_key_reader* reader)
+{
+    NTSKEM_key_reader **link;
+
+    if (reader) {
+        pthread_mutex_lock(&reader->slot->lock);
+        for (link=&reader->slot->readers; *link; link=&(*link)->next) {
+            if (*link == reader) {
+                *link = reader->next;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&reader->slot->lock);
+        free(reader);
+    }
+}
+
+const NTSKEM_decap_ctx* nts_kem_key_slot_enter(NTSKEM_key_reader* reader,
+                                               const NTSKEM_decap_ctx** previous)
+{
+    NTSKEM_key_slot *slot = reader->slot;
+    const NTSKEM_decap_ctx *current;
+
+    __atomic_store_n(&reader->active, __atomic_load_n(&slot->epoch, __ATOMIC_ACQUIRE),
+                     __ATOMIC_RELAXED);
+    key_slot_reader_fence(slot);
+
+    /**
+     * The previous context is published before the current one,
+     * a reader that obtains the new current context also obtains
+     * the previous context that goes with it
+     **/
+    current = __atomic_load_n(&slot->current, __ATOMIC_ACQUIRE);
+    if (previous)
+        *previous = __atomic_load_n(&slot->previous, __ATOMIC_ACQUIRE);
+
+    return current;
+}
+
+void nts_kem_key_slot_leave(NTSKEM_key_reader* reader)
+{
+    __atomic_store_n(&reader->active, 0, __ATOMIC_RELEASE);
+}
+
+int nts_kem_key_slot_decapsulate(NTSKEM_key_reader* reader,
+                                 const uint8_t *c_ast,
+                                 uint8_t *k_r)
+{
+    int i, status, status_p;
+    uint32_t use_previous;
+    uint64_t k_p[CRYPTO_BYTES/sizeof(uint64_t)], k_c[CRYPTO_BYTES/sizeof(uint64_t)];
+    const NTSKEM_decap_ctx *current, *previous = NULL;
+
+    if (!reader || !c_ast || !k_r)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    current = nts_kem_key_slot_enter(reader, &previous);
+    status = nts_kem_decap_ctx_decapsulate(current, c_ast, (uint8_t *)k_c);
+    if (previous) {
+        /**
+         * Whether the ciphertext is accepted under the current key
+         * must not show in the time taken, so it is always also
+         * decapsulated under the previous key and the result is
+         * selected without branching
+         **/
+        status_p = nts_kem_decap_ctx_decapsulate(previous, c_ast, (uint8_t *)k_p);
+        use_previous = CT_is_equal((uint32_t)status, (uint32_t)NTS_KEM_INVALID_CIPHERTEXT) &
+                       CT_is_equal((uint32_t)status_p, (uint32_t)NTS_KEM_SUCCESS);
+        status = (int)CT_mux(use_previous, (uint32_t)status_p, (uint32_t)status);
+        for (i=0; i<CRYPTO_BYTES/sizeof(uint64_t); i++)
+            k_c[i] = CT_mux64(use_previous, k_p[i], k_c[i]);
+        CT_memset(k_p, 0, CRYPTO_BYTES);
+    }
+    nts_kem_key_slot_leave(reader);
+    memcpy(k_r, k_c, CRYPTO_BYTES);
+    CT_memset(k_c, 0, CRYPTO_BYTES);
+
+    return status;
+}
+
+int nts_kem_key_slot_rotate(NTSKEM_key_slot* slot,
+                            NTSKEM_decap_ctx* ctx)
+{
+    uint64_t epoch, active;
+    NTSKEM_key_reader *reader;
+    NTSKEM_decap_ctx *retired;
+
+    if (!slot || !ctx)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    pthread_mutex_lock(&slot->lock);
+    retired = slot->previous;
+    __atomic_store_n(&slot->previous, slot->current, __ATOMIC_RELEASE);
+    __atomic_store_n(&slot->current, ctx, __ATOMIC_RELEASE);
+    epoch = __atomic_add_fetch(&slot->epoch, 1, __ATOMIC_SEQ_CST);
+    key_slot_writer_fence(slot);
+
+    /**
+     * A reader that entered at this epoch or later cannot obtain the
+     * retired context, wait for those that entered earlier to leave
+     **/
+    for (reader=slot->readers; reader; reader=reader->next) {
+        while ((active = __atomic_load_n(&reader->active, __ATOMIC_ACQUIRE)) &&
+               active < epoch)
+            sched_yield();
+    }
+    pthread_mutex_unlock(&slot->lock);
+
+    nts_kem_decap_ctx_release(retired);
+
+    return NTS_KEM_SUCCESS;
+}
+
+void nts_kem_key_slot_release(NTSKEM_key_slot* slot)
+{
+    if (slot) {
+        nts_kem_decap_ctx_release(slot->previous);
+        nts_kem_decap_ctx_release(slot->current);
+        pthread_mutex_destroy(&slot->lock);
+        free(slot);
+    }
+}
@@ -0,0 +1,141 @@
+/**
+ *  key_slot.h
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  A key slot holds the current and the previous decapsulation
+ *  contexts of a key that is rotated, and lets any number of threads
+ *  decapsulate under them while a rotation takes place
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#ifndef __NTSKEM_KEY_SLOT_H
+#define __NTSKEM_KEY_SLOT_H
+
+#include <stdint.h>
+#include "nts_kem.h"
+
+typedef struct NTSKEM_key_slot NTSKEM_key_slot;
+
+/**
+ *  The registration of a thread that reads a key slot
+ **/
+typedef struct NTSKEM_key_reader NTSKEM_key_reader;
+
+/**
+ *  Create a key slot
+ *
+ *  @note
+ *  The slot takes the ownership of the context, which is released
+ *  with the slot or once it has been rotated out.
+ *
+ *  @param[out] slot  A pointer of NTSKEM_key_slot object created
+ *  @param[in]  ctx   The decapsulation context of the current key
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_key_slot_create(NTSKEM_key_slot** slot,
+                            NTSKEM_decap_ctx* ctx);
+
+/**
+ *  Register a thread as a reader of a key slot
+ *
+ *  @note
+ *  A reader is used by one thread at a time. Registration takes
+ *  the lock of the slot and is meant to be done once per thread.
+ *
+ *  @param[in]  slot    The key slot
+ *  @param[out] reader  A pointer of NTSKEM_key_reader object created
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_key_slot_reader_create(NTSKEM_key_slot* slot,
+                                   NTSKEM_key_reader** reader);
+
+/**
+ *  Unregister and release a reader of a key slot
+ *
+ *  @param[in] reader  The reader, outside of a read-side section
+ **/
+void nts_kem_key_slot_reader_release(NTSKEM_key_reader* reader);
+
+/**
+ *  Enter a read-side section and obtain the contexts of the slot
+ *
+ *  @note
+ *  The contexts remain valid until {@see nts_kem_key_slot_leave}.
+ *  Entering costs a load of the epoch of the slot and two stores to
+ *  the reader, no lock is taken and no atomic read-modify-write is
+ *  done. Sections do not nest.
+ *
+ *  @param[in]  reader    The reader
+ *  @param[out] previous  The context of the previous key, NULL if
+ *                        there is none, or NULL not to obtain it
+ *  @return The context of the current key
+ **/
+const NTSKEM_decap_ctx* nts_kem_key_slot_enter(NTSKEM_key_reader* reader,
+                                               const NTSKEM_decap_ctx** previous);
+
+/**
+ *  Leave a read-side section
+ *
+ *  @param[in] reader  The reader
+ **/
+void nts_kem_key_slot_leave(NTSKEM_key_reader* reader);
+
+/**
+ *  NTS-KEM decapsulation under the keys of a slot
+ *
+ *  @note
+ *  The ciphertext is decapsulated under the current key and, if there
+ *  is a previous key, always also under the previous key, so that the
+ *  ciphertexts encapsulated under the public key being rotated out
+ *  remain accepted until the next rotation. The result under the
+ *  previous key is taken only if the current key rejects the
+ *  ciphertext, and it is selected in constant time. If both keys
+ *  reject it, the key of the implicit rejection under the current
+ *  key is returned.
+ *
+ *  @param[in]  reader  The reader, outside of a read-side section
+ *  @param[in]  c_ast   The pointer to the NTS-KEM ciphertext
+ *  @param[out] k_r     The pointer to the encapsulated key
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_key_slot_decapsulate(NTSKEM_key_reader* reader,
+                                 const uint8_t *c_ast,
+                                 uint8_t *k_r);
+
+/**
+ *  Rotate the key of a slot
+ *
+ *  @note
+ *  The context is published as the current key and the current key
+ *  becomes the previous key. Readers are never blocked, a reader in
+ *  a section keeps the contexts it has obtained. The context of the
+ *  key that was previous is released, and so wiped, once every reader
+ *  that could have obtained it has left its section, this function
+ *  waits for that. Rotations of a slot are serialised.
+ *
+ *  @param[in] slot  The key slot
+ *  @param[in] ctx   The decapsulation context of the new key, whose
+ *                   ownership is taken by the slot
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_key_slot_rotate(NTSKEM_key_slot* slot,
+                            NTSKEM_decap_ctx* ctx);
+
+/**
+ *  Release a key slot and its contexts
+ *
+ *  @param[in] slot  The key slot, whose readers have been released
+ **/
+void nts_kem_key_slot_release(NTSKEM_key_slot* slot);
+
+#endif /* __NTSKEM_KEY_SLOT_H */
@@ -0,0 +1,821 @@
+/**
+ *  key_store.c
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#if defined(__linux__)
+#define _GNU_SOURCE             /* O_NOFOLLOW, mkstemp */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "api.h"
+#include "key_store.h"
+#include "nts_kem_errors.h"
+#include "mem.h"
+
+#define KEY_STORE_WARM_SIZE     CRYPTO_SECRETKEYBYTES
+#define KEY_STORE_BUCKETS       64
+#define KEY_STORE_MAX_FREQ      0xFFFF
+
+typedef struct key_entry {
+    uint64_t id;
+    struct key_entry *next;         /* The next key of the bucket */
+    int tier;
+    int busy;                       /* A thread is moving the key up */
+    int heap;                       /* The heap of the key, -1 if none */
+    size_t heap_pos;
+    uint32_t refs;                  /* Accesses in progress */
+    uint32_t freq;                  /* Recent accesses, halved as they age */
+    NTSKEM_decap_ctx *ctx;          /* Hot */
+    uint8_t *sk;                    /* Warm, or hot while still in use */
+    size_t size;                    /* Bytes accounted for the key */
+    int has_seed;
+    int on_disk;
+    uint8_t seed[NTS_KEM_SEED_SIZE];
+} key_entry;
+
+/**
+ *  A min-heap by access frequency of the keys of a tier that can be
+ *  moved down, the root is the next one to be
+ **/
+typedef struct {
+    key_entry **entry;
+    size_t count;
+} key_heap;
+
+struct NTSKEM_key_store {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;           /* Signalled when a key is no longer busy */
+    key_entry **buckets;
+    size_t bucket_count;
+    size_t key_count;
+    key_heap heap[2];               /* Hot and warm keys, indexed by tier minus one */
+    size_t heap_size;               /* Room of each heap, at least key_count */
+    size_t budget;
+    size_t hot_size;                /* Bytes of a context, 0 until known */
+    uint64_t accesses;              /* Since the frequencies last aged */
+    uint32_t flags;
+    char *dir;
+    NTSKEM_key_store_stats stats;
+};
+
+static uint64_t key_store_now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static size_t key_store_hash(const NTSKEM_key_store* store, uint64_t id)
+{
+    id ^= id >> 33;
+    id *= 0xff51afd7ed558ccdULL;
+    id ^= id >> 33;
+
+    return (size_t)(id & (store->bucket_count - 1));
+}
+
+static key_entry *key_store_find(const NTSKEM_key_store* store, uint64_t id)
+{
+    key_entry *entry;
+
+    for (entry=store->buckets[key_store_hash(store, id)]; entry; entry=entry->next) {
+        if (entry->id == id)
+            return entry;
+    }
+
+    return NULL;
+}
+
+/**
+ *  Double the buckets once there are more keys than buckets
+ **/
+static void key_store_grow(NTSKEM_key_store* store)
+{
+    size_t i, old_count = store->bucket_count;
+    key_entry **old = store->buckets, *entry, *next, **buckets;
+
+    if (store->key_count <= store->bucket_count)
+        return;
+    if (!(buckets = (key_entry **)calloc(2*old_count, sizeof(key_entry *))))
+        return;
+    store->buckets = buckets;
+    store->bucket_count = 2*old_count;
+    for (i=0; i<old_count; i++) {
+        for (entry=old[i]; entry; entry=next) {
+            next = entry->next;
+            entry->next = buckets[key_store_hash(store, entry->id)];
+            buckets[key_store_hash(store, entry->id)] = entry;
+        }
+    }
+    free(old);
+}
+
+static void key_heap_set(key_heap* heap, size_t pos, key_entry* entry)
+{
+    heap->entry[pos] = entry;
+    entry->heap_pos = pos;
+}
+
+static void key_heap_sift(key_heap* heap, size_t pos)
+{
+    size_t child;
+    key_entry *entry = heap->entry[pos];
+
+    while (pos > 0 && entry->freq < heap->entry[(pos - 1) >> 1]->freq) {
+        key_heap_set(heap, pos, heap->entry[(pos - 1) >> 1]);
+        pos = (pos - 1) >> 1;
+    }
+    while ((child = 2*pos + 1) < heap->count) {
+        if (child + 1 < heap->count && heap->entry[child + 1]->freq < heap->entry[child]->freq)
+            child++;
+        if (entry->freq <= heap->entry[child]->freq)
+            break;
+        key_heap_set(heap, pos, heap->entry[child]);
+        pos = child;
+    }
+    key_heap_set(heap, pos, entry);
+}
+
+static void key_store_dequeue(NTSKEM_key_store* store, key_entry* entry)
+{
+    key_heap *h;
+
+    if (entry->heap < 0)
+        return;
+    h = &store->heap[entry->heap];
+    if (entry->heap_pos < --h->count) {
+        key_heap_set(h, entry->heap_pos, h->entry[h->count]);
+        key_heap_sift(h, entry->heap_pos);
+    }
+    entry->heap = -1;
+}
+
+/**
+ *  Keep a key in the heap of its tier if and only if it can be moved
+ *  down, that is, it is neither in use nor busy, and a warm key has
+ *  somewhere to go. The caller holds the lock and calls this whenever
+ *  any of these change. The frequency of a key only grows while it is
+ *  in use, out of the heaps, and the halving of all the frequencies
+ *  keeps the order of the heaps.
+ **/
+static void key_store_requeue(NTSKEM_key_store* store, key_entry* entry)
+{
+    int heap = -1;
+    key_heap *h;
+
+    if (!entry->refs && !entry->busy &&
+        (entry->tier == NTS_KEM_KEY_STORE_HOT ||
+         (entry->tier == NTS_KEM_KEY_STORE_WARM &&
+          (entry->has_seed || entry->on_disk || store->dir))))
+        heap = entry->tier - 1;
+    if (heap == entry->heap)
+        return;
+
+    key_store_dequeue(store, entry);
+    entry->heap = heap;
+    if (heap >= 0) {
+        h = &store->heap[heap];
+        key_heap_set(h, h->count++, entry);
+        key_heap_sift(h, entry->heap_pos);
+    }
+}
+
+static void key_store_path(const NTSKEM_key_store* store, uint64_t id, char *path, size_t size)
+{
+    snprintf(path, size, "%s/%016llx.sk", store->dir, (unsigned long long)id);
+}
+
+/**
+ *  Write the file of a key. The key is written to a new file of the
+ *  permissions of the owner only, which is then renamed over the path
+ *  of the key, so that neither a symbolic link nor an existing file at
+ *  that path is written through.
+ **/
+static int key_store_write(const NTSKEM_key_store* store, uint64_t id, const uint8_t *sk)
+{
+    int fd;
+    size_t off;
+    ssize_t n;
+    char path[4096], tmp[4096+8];
+
+    key_store_path(store, id, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path);
+    if ((fd = mkstemp(tmp)) < 0)
+        return 0;
+    for (off=0; off<KEY_STORE_WARM_SIZE; off+=(size_t)n) {
+        if ((n = write(fd, &sk[off], KEY_STORE_WARM_SIZE - off)) <= 0)
+            goto key_store_write_fail;
+    }
+    if (fsync(fd) || rename(tmp, path))
+        goto key_store_write_fail;
+    close(fd);
+
+    return 1;
+
+key_store_write_fail:
+    close(fd);
+    unlink(tmp);
+
+    return 0;
+}
+
+static int key_store_read(const NTSKEM_key_store* store, uint64_t id, uint8_t *sk)
+{
+    int fd;
+    size_t off;
+    ssize_t n;
+    char path[4096];
+
+    key_store_path(store, id, path, sizeof(path));
+    if ((fd = open(path, O_RDONLY | O_NOFOLLOW)) < 0)
+        return 0;
+    for (off=0; off<KEY_STORE_WARM_SIZE; off+=(size_t)n) {
+        if ((n = read(fd, &sk[off], KEY_STORE_WARM_SIZE - off)) <= 0) {
+            close(fd);
+            return 0;
+        }
+    }
+    close(fd);
+
+    return 1;
+}
+
+/**
+ *  Overwrite and remove the file of a key
+ **/
+static void key_store_remove_file(const NTSKEM_key_store* store, uint64_t id)
+{
+    int fd;
+    size_t off;
+    ssize_t n;
+    char path[4096];
+    uint8_t zero[4096];
+
+    key_store_path(store, id, path, sizeof(path));
+    if ((fd = open(path, O_WRONLY | O_NOFOLLOW)) >= 0) {
+        memset(zero, 0, sizeof(zero));
+        for (off=0; off<KEY_STORE_WARM_SIZE; off+=(size_t)n) {
+            n = write(fd, zero, (KEY_STORE_WARM_SIZE - off < sizeof(zero)) ?
+                                 KEY_STORE_WARM_SIZE - off : sizeof(zero));
+            if (n <= 0)
+                break;
+        }
+        fsync(fd);
+        close(fd);
+    }
+    unlink(path);
+}
+
+static void key_store_free_sk(uint8_t *sk)
+{
+    if (sk) {
+        CT_memset(sk, 0, KEY_STORE_WARM_SIZE);
+        free(sk);
+    }
+}
+
+static void key_store_set_tier(NTSKEM_key_store* store, key_entry* entry, int tier)
+{
+    store->stats.keys[entry->tier - 1]--;
+    entry->tier = tier;
+    store->stats.keys[entry->tier - 1]++;
+    key_store_requeue(store, entry);
+}
+
+/**
+ *  Move a key down a tier. The caller holds the lock and the key is
+ *  neither in use nor busy.
+ **/
+static int key_store_demote(NTSKEM_key_store* store, key_entry* entry)
+{
+    if (entry->tier == NTS_KEM_KEY_STORE_HOT) {
+        if (!entry->sk) {
+            if (!(entry->sk = (uint8_t *)malloc(KEY_STORE_WARM_SIZE)))
+                return 0;
+            memcpy(entry->sk, nts_kem_decap_ctx_private_key(entry->ctx), KEY_STORE_WARM_SIZE);
+        }
+        nts_kem_decap_ctx_release(entry->ctx);
+        entry->ctx = NULL;
+        store->stats.memory -= entry->size - KEY_STORE_WARM_SIZE;
+        entry->size = KEY_STORE_WARM_SIZE;
+        key_store_set_tier(store, entry, NTS_KEM_KEY_STORE_WARM);
+        store->stats.demotions++;
+        return 1;
+    }
+
+    if (!entry->has_seed && !entry->on_disk) {
+        if (!store->dir || !key_store_write(store, entry->id, entry->sk))
+            return 0;
+        entry->on_disk = 1;
+    }
+    key_store_free_sk(entry->sk);
+    entry->sk = NULL;
+    store->stats.memory -= entry->size;
+    entry->size = 0;
+    key_store_set_tier(store, entry, NTS_KEM_KEY_STORE_COLD);
+    store->stats.evictions++;
+
+    return 1;
+}
+
+/**
+ *  Reserve bytes of the budget, moving the least frequently accessed
+ *  keys other than `except` down a tier as needed, a hot key before a
+ *  warm key of the same frequency. The caller holds the lock. Returns
+ *  zero if the keys in memory are all in use.
+ **/
+static int key_store_reserve(NTSKEM_key_store* store, size_t size, const key_entry* except)
+{
+    key_entry *hot, *warm, *victim;
+
+    if (size + (except ? except->size : 0) > store->budget)
+        return 0;
+
+    while (store->stats.memory + size > store->budget) {
+        hot = store->heap[NTS_KEM_KEY_STORE_HOT - 1].count ?
+              store->heap[NTS_KEM_KEY_STORE_HOT - 1].entry[0] : NULL;
+        warm = store->heap[NTS_KEM_KEY_STORE_WARM - 1].count ?
+               store->heap[NTS_KEM_KEY_STORE_WARM - 1].entry[0] : NULL;
+        victim = (hot && (!warm || hot->freq <= warm->freq)) ? hot : warm;
+        if (!victim || victim == except || !key_store_demote(store, victim))
+            return 0;
+    }
+    store->stats.memory += size;
+
+    return 1;
+}
+
+/**
+ *  Count an access, the frequencies are halved every few accesses
+ *  per key so that they follow the recent accesses
+ **/
+static void key_store_touch(NTSKEM_key_store* store, key_entry* entry)
+{
+    size_t i;
+    key_entry *e;
+
+    if (entry->freq < KEY_STORE_MAX_FREQ)
+        entry->freq++;
+    if (++store->accesses < 8*store->key_count + 64)
+        return;
+    store->accesses = 0;
+    for (i=0; i<store->bucket_count; i++) {
+        for (e=store->buckets[i]; e; e=e->next)
+            e->freq >>= 1;
+    }
+}
+
+/**
+ *  Load a cold key. The caller holds the lock and has reserved
+ *  its memory, the lock is released while the key is loaded.
+ **/
+static int key_store_load(NTSKEM_key_store* store, key_entry* entry)
+{
+    int status = NTS_KEM_SUCCESS;
+    uint64_t start;
+    uint8_t *sk;
+    NTSKEM *nts_kem = NULL;
+
+    entry->busy = 1;
+    pthread_mutex_unlock(&store->lock);
+
+    start = key_store_now();
+    if (!(sk = (uint8_t *)malloc(KEY_STORE_WARM_SIZE))) {
+        status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+    }
+    else if (entry->has_seed) {
+        status = nts_kem_create_from_seed(&nts_kem, entry->seed);
+        if (status == NTS_KEM_SUCCESS)
+            memcpy(sk, nts_kem->private_key, KEY_STORE_WARM_SIZE);
+        nts_kem_release(nts_kem);
+    }
+    else if (!key_store_read(store, entry->id, sk)) {
+        status = NTS_KEM_UNEXPECTED_ERROR;
+    }
+
+    pthread_mutex_lock(&store->lock);
+    entry->busy = 0;
+    key_store_requeue(store, entry);
+    pthread_cond_broadcast(&store->ready);
+    if (status != NTS_KEM_SUCCESS) {
+        key_store_free_sk(sk);
+        store->stats.memory -= KEY_STORE_WARM_SIZE;
+        return status;
+    }
+    entry->sk = sk;
+    entry->size = KEY_STORE_WARM_SIZE;
+    key_store_set_tier(store, entry, NTS_KEM_KEY_STORE_WARM);
+    store->stats.misses++;
+    store->stats.load_time += key_store_now() - start;
+
+    return NTS_KEM_SUCCESS;
+}
+
+/**
+ *  Create the context of a warm key. The caller holds the lock and has
+ *  reserved its memory, the lock is released while the context is
+ *  created. The serialised key remains until no access uses it.
+ **/
+static void key_store_promote(NTSKEM_key_store* store, key_entry* entry, size_t reserved)
+{
+    int status;
+    uint64_t start;
+    NTSKEM_decap_ctx *ctx = NULL;
+
+    entry->busy = 1;
+    pthread_mutex_unlock(&store->lock);
+
+    start = key_store_now();
+    status = nts_kem_decap_ctx_create(&ctx, entry->sk, store->flags);
+
+    pthread_mutex_lock(&store->lock);
+    entry->busy = 0;
+    key_store_requeue(store, entry);
+    pthread_cond_broadcast(&store->ready);
+    store->stats.memory -= reserved;
+    if (status != NTS_KEM_SUCCESS)
+        return;
+    store->hot_size = nts_kem_decap_ctx_size(ctx);
+    store->stats.memory += store->hot_size;
+    entry->ctx = ctx;
+    entry->size += store->hot_size;
+    key_store_set_tier(store, entry, NTS_KEM_KEY_STORE_HOT);
+    store->stats.promotions++;
+    store->stats.expansion_time += key_store_now() - start;
+}
+
+/**
+ *  Look a key up, move it up the tiers as its accesses warrant and
+ *  take a reference to it. The representation to decapsulate with is
+ *  read under the lock, either `ctx` or `sk` is set on success.
+ **/
+static int key_store_acquire(NTSKEM_key_store* store,
+                             uint64_t id,
+                             key_entry** acquired,
+                             const NTSKEM_decap_ctx** ctx,
+                             const uint8_t** sk)
+{
+    int status = NTS_KEM_SUCCESS;
+    size_t size;
+    key_entry *entry;
+
+    pthread_mutex_lock(&store->lock);
+    if (!(entry = key_store_find(store, id))) {
+        pthread_mutex_unlock(&store->lock);
+        return NTS_KEM_KEY_NOT_FOUND;
+    }
+    entry->refs++;
+    key_store_requeue(store, entry);
+    key_store_touch(store, entry);
+
+    /* Wait for a load of the key by another thread */
+    while (entry->busy && entry->tier == NTS_KEM_KEY_STORE_COLD)
+        pthread_cond_wait(&store->ready, &store->lock);
+
+    if (entry->tier == NTS_KEM_KEY_STORE_COLD) {
+        if (!key_store_reserve(store, KEY_STORE_WARM_SIZE, entry)) {
+            status = NTS_KEM_BUSY;
+            goto key_store_acquire_fail;
+        }
+        status = key_store_load(store, entry);
+        if (status != NTS_KEM_SUCCESS)
+            goto key_store_acquire_fail;
+    }
+    else if (entry->tier == NTS_KEM_KEY_STORE_HOT) {
+        store->stats.hot_hits++;
+    }
+    else {
+        store->stats.warm_hits++;
+    }
+
+    if (entry->tier == NTS_KEM_KEY_STORE_WARM && !entry->busy &&
+        entry->freq >= NTS_KEM_KEY_STORE_HOT_ACCESSES) {
+        size = store->hot_size ? store->hot_size : KEY_STORE_WARM_SIZE + (KEY_STORE_WARM_SIZE >> 4);
+        if (key_store_reserve(store, size, entry))
+            key_store_promote(store, entry, size);
+    }
+
+    *acquired = entry;
+    *ctx = entry->ctx;
+    *sk = entry->sk;
+    pthread_mutex_unlock(&store->lock);
+
+    return NTS_KEM_SUCCESS;
+
+key_store_acquire_fail:
+    entry->refs--;
+    key_store_requeue(store, entry);
+    pthread_cond_broadcast(&store->ready);
+    pthread_mutex_unlock(&store->lock);
+
+    return status;
+}
+
+static void key_store_unacquire(NTSKEM_key_store* store, key_entry* entry)
+{
+    pthread_mutex_lock(&store->lock);
+    if (--entry->refs == 0) {
+        /* The serialised key of a key made hot */
+        if (entry->ctx && entry->sk) {
+            key_store_free_sk(entry->sk);
+            entry->sk = NULL;
+            entry->size -= KEY_STORE_WARM_SIZE;
+            store->stats.memory -= KEY_STORE_WARM_SIZE;
+        }
+        key_store_requeue(store, entry);
+        pthread_cond_broadcast(&store->ready);
+    }
+    pthread_mutex_unlock(&store->lock);
+}
+
+/**
+ *  Insert a new key, the caller holds the lock
+ **/
+static int key_store_insert(NTSKEM_key_store* store, uint64_t id, key_entry** inserted)
+{
+    int i;
+    size_t bucket, size;
+    key_entry *entry, **heap;
+
+    if (key_store_find(store, id))
+        return NTS_KEM_BAD_PARAMETERS;
+    if (store->key_count == store->heap_size) {
+        size = store->heap_size ? 2*store->heap_size : KEY_STORE_BUCKETS;
+        for (i=0; i<2; i++) {
+            if (!(heap = (key_entry **)realloc(store->heap[i].entry, size*sizeof(key_entry *))))
+                return NTS_KEM_BAD_MEMORY_ALLOCATION;
+            store->heap[i].entry = heap;
+        }
+        store->heap_size = size;
+    }
+    if (!(entry = (key_entry *)calloc(1, sizeof(key_entry))))
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    entry->id = id;
+    entry->tier = NTS_KEM_KEY_STORE_COLD;
+    entry->heap = -1;
+    bucket = key_store_hash(store, id);
+    entry->next = store->buckets[bucket];
+    store->buckets[bucket] = entry;
+    store->key_count++;
+    store->stats.keys[NTS_KEM_KEY_STORE_COLD - 1]++;
+    key_store_grow(store);
+    *inserted = entry;
+
+    return NTS_KEM_SUCCESS;
+}
+
+static void key_store_detach(NTSKEM_key_store* store, key_entry* entry)
+{
+    key_entry **link;
+
+    for (link=&store->buckets[key_store_hash(store, entry->id)]; *link!=entry; link=&(*link)->next)
+        ;
+    *link = entry->next;
+    store->key_count--;
+    store->stats.keys[entry->tier - 1]--;
+    key_store_dequeue(store, entry);
+}
+
+static void key_store_free_entry(NTSKEM_key_store* store, key_entry* entry)
+{
+    nts_kem_decap_ctx_release(entry->ctx);
+    key_store_free_sk(entry->sk);
+    if (entry->on_disk)
+        key_store_remove_file(store, entry->id);
+    CT_memset(entry, 0, sizeof(key_entry));
+    free(entry);
+}
+
+int nts_kem_key_store_create(NTSKEM_key_store** store,
+                             size_t budget,
+                             const char *dir,
+                             uint32_t flags)
+{
+    if (!store || budget < KEY_STORE_WARM_SIZE)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    *store = (NTSKEM_key_store *)calloc(1, sizeof(NTSKEM_key_store));
+    if (!(*store))
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    (*store)->bucket_count = KEY_STORE_BUCKETS;
+    (*store)->buckets = (key_entry **)calloc(KEY_STORE_BUCKETS, sizeof(key_entry *));
+    (*store)->dir = dir ? (char *)malloc(strlen(dir) + 1) : NULL;
+    if (!(*store)->buckets || (dir && !(*store)->dir)) {
+        free((*store)->dir);
+        free((*store)->buckets);
+        free(*store);
+        *store = NULL;
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    }
+    if (dir)
+        strcpy((*store)->dir, dir);
+    (*store)->budget = (*store)->stats.budget = budget;
+    (*store)->flags = flags;
+    pthread_mutex_init(&(*store)->lock, NULL);
+    pthread_cond_init(&(*store)->ready, NULL);
+
+    return NTS_KEM_SUCCESS;
+}
+
+int nts_kem_key_store_add(NTSKEM_key_store* store,
+                          uint64_t id,
+                          const uint8_t *sk)
+{
+    int status;
+    key_entry *entry = NULL;
+
+    if (!store || !sk)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    pthread_mutex_lock(&store->lock);
+    status = key_store_insert(store, id, &entry);
+    if (status != NTS_KEM_SUCCESS)
+        goto key_store_add_fail;
+
+    if (key_store_reserve(store, KEY_STORE_WARM_SIZE, entry)) {
+        if (!(entry->sk = (uint8_t *)malloc(KEY_STORE_WARM_SIZE))) {
+            store->stats.memory -= KEY_STORE_WARM_SIZE;
+            status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+            goto key_store_add_fail;
+        }
+        memcpy(entry->sk, sk, KEY_STORE_WARM_SIZE);
+        entry->size = KEY_STORE_WARM_SIZE;
+        key_store_set_tier(store, entry, NTS_KEM_KEY_STORE_WARM);
+    }
+    else if (store->dir && key_store_write(store, id, sk)) {
+        entry->on_disk = 1;
+    }
+    else {
+        status = NTS_KEM_BUSY;
+    }
+
+key_store_add_fail:
+    if (status != NTS_KEM_SUCCESS && entry) {
+        key_store_detach(store, entry);
+        key_store_free_entry(store, entry);
+    }
+    pthread_mutex_unlock(&store->lock);
+
+    return status;
+}
+
+int nts_kem_key_store_add_seed(NTSKEM_key_store* store,
+                               uint64_t id,
+                               const uint8_t *seed)
+{
+    int status;
+    key_entry *entry = NULL;
+
+    if (!store || !seed)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    pthread_mutex_lock(&store->lock);
+    status = key_store_insert(store, id, &entry);
+    if (status == NTS_KEM_SUCCESS) {
+        memcpy(entry->seed, seed, NTS_KEM_SEED_SIZE);
+        entry->has_seed = 1;
+    }
+    pthread_mutex_unlock(&store->lock);
+
+    return status;
+}
+
+int nts_kem_key_store_remove(NTSKEM_key_store* store,
+                             uint64_t id)
+{
+    key_entry *entry;
+
+    if (!store)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    pthread_mutex_lock(&store->lock);
+    for (;;) {
+        if (!(entry = key_store_find(store, id))) {
+            pthread_mutex_unlock(&store->lock);
+            return NTS_KEM_KEY_NOT_FOUND;
+        }
+        if (!entry->refs && !entry->busy)
+            break;
+        pthread_cond_wait(&store->ready, &store->lock);
+    }
+    key_store_detach(store, entry);
+    store->stats.memory -= entry->size;
+    key_store_free_entry(store, entry);
+    pthread_mutex_unlock(&store->lock);
+
+    return NTS_KEM_SUCCESS;
+}
+
+int nts_kem_key_store_decapsulate(NTSKEM_key_store* store,
+                                  uint64_t id,
+                                  const uint8_t *c_ast,
+                                  uint8_t *k_r)
+{
+    int status;
+    key_entry *entry = NULL;
+    const NTSKEM_decap_ctx *ctx = NULL;
+    const uint8_t *sk = NULL;
+
+    if (!store || !c_ast || !k_r)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    status = key_store_acquire(store, id, &entry, &ctx, &sk);
+    if (status != NTS_KEM_SUCCESS)
+        return status;
+    if (ctx)
+        status = nts_kem_decap_ctx_decapsulate(ctx, c_ast, k_r);
+    else
+        status = nts_kem_decapsulate(sk, c_ast, k_r);
+    key_store_unacquire(store, entry);
+
+    return status;
+}
+
+int nts_kem_key_store_public_key(NTSKEM_key_store* store,
+                                 uint64_t id,
+                                 uint8_t *pk)
+{
+    int status;
+    key_entry *entry = NULL;
+    const NTSKEM_decap_ctx *ctx = NULL;
+    const uint8_t *sk = NULL;
+
+    if (!store || !pk)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    status = key_store_acquire(store, id, &entry, &ctx, &sk);
+    if (status != NTS_KEM_SUCCESS)
+        return status;
+    /* The public key is at the end of the private key */
+    if (ctx)
+        sk = nts_kem_decap_ctx_private_key(ctx);
+    memcpy(pk, &sk[CRYPTO_SECRETKEYBYTES - CRYPTO_PUBLICKEYBYTES], CRYPTO_PUBLICKEYBYTES);
+    key_store_unacquire(store, entry);
+
+    return NTS_KEM_SUCCESS;
+}
+
+int nts_kem_key_store_tier(NTSKEM_key_store* store,
+                           uint64_t id)
+{
+    int tier = NTS_KEM_KEY_NOT_FOUND;
+    key_entry *entry;
+
+    if (!store)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    pthread_mutex_lock(&store->lock);
+    if ((entry = key_store_find(store, id)))
+        tier = entry->tier;
+    pthread_mutex_unlock(&store->lock);
+
+    return tier;
+}
+
+void nts_kem_key_store_stats(NTSKEM_key_store* store,
+                             NTSKEM_key_store_stats* stats)
+{
+    if (store && stats) {
+        pthread_mutex_lock(&store->lock);
+        *stats = store->stats;
+        pthread_mutex_unlock(&store->lock);
+    }
+}
+
+void nts_kem_key_store_release(NTSKEM_key_store* store)
+{
+    size_t i;
+    key_entry *entry, *next;
+
+    if (store) {
+        for (i=0; i<store->bucket_count; i++) {
+            for (entry=store->buckets[i]; entry; entry=next) {
+                next = entry->next;
+                key_store_free_entry(store, entry);
+            }
+        }
+        pthread_cond_destroy(&store->ready);
+        pthread_mutex_destroy(&store->lock);
+        free(store->heap[0].entry);
+        free(store->heap[1].entry);
+        free(store->buckets);
+        free(store->dir);
+        free(store);
+    }
+}
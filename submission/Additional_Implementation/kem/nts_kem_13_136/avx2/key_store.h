@@ -0,0 +1,201 @@
+/**
+ *  key_store.h
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  A store of many private keys, looked up by key identifier, that
+ *  keeps them within a memory budget in one of three tiers:
+ *
+ *  - hot, a decapsulation context {@see nts_kem_decap_ctx_create}
+ *  - warm, a serialised private key
+ *  - cold, out of memory, either as the seed the key is generated
+ *    from or as a serialised private key in a file
+ *
+ *  Keys move between the tiers on access, by their access frequency.
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#ifndef __NTSKEM_KEY_STORE_H
+#define __NTSKEM_KEY_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "nts_kem.h"
+
+/**
+ *  Tiers of a key
+ **/
+#define NTS_KEM_KEY_STORE_HOT       1
+#define NTS_KEM_KEY_STORE_WARM      2
+#define NTS_KEM_KEY_STORE_COLD      3
+
+/**
+ *  The number of recent accesses after which a warm key is
+ *  prepared as a decapsulation context
+ **/
+#ifndef NTS_KEM_KEY_STORE_HOT_ACCESSES
+#define NTS_KEM_KEY_STORE_HOT_ACCESSES  4
+#endif
+
+typedef struct NTSKEM_key_store NTSKEM_key_store;
+
+/**
+ *  The counters of a key store
+ **/
+typedef struct {
+    uint64_t hot_hits;          /* Accesses to hot keys */
+    uint64_t warm_hits;         /* Accesses to warm keys */
+    uint64_t misses;            /* Accesses to cold keys, which are loaded */
+    uint64_t promotions;        /* Warm keys made hot */
+    uint64_t demotions;         /* Hot keys made warm */
+    uint64_t evictions;         /* Warm keys made cold */
+    uint64_t load_time;         /* Nanoseconds spent loading cold keys */
+    uint64_t expansion_time;    /* Nanoseconds spent creating contexts */
+    size_t keys[3];             /* Keys per tier, indexed by tier minus one */
+    size_t memory;              /* Bytes held by hot and warm keys */
+    size_t budget;              /* Bytes that may be held */
+} NTSKEM_key_store_stats;
+
+/**
+ *  Create a key store
+ *
+ *  @note
+ *  Without a directory, only the keys added by their seed can be
+ *  made cold. The files of the cold keys are created with the
+ *  permissions of the owner only and renamed into place, symbolic
+ *  links in the directory are never followed.
+ *
+ *  @param[out] store   A pointer of NTSKEM_key_store object created
+ *  @param[in]  budget  The bytes that hot and warm keys may hold, at
+ *                      least one serialised private key
+ *  @param[in]  dir     The directory of the cold keys, or NULL
+ *  @param[in]  flags   Bitwise-OR of NTS_KEM_DECAP_* flags of the
+ *                      contexts of the hot keys
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_key_store_create(NTSKEM_key_store** store,
+                             size_t budget,
+                             const char *dir,
+                             uint32_t flags);
+
+/**
+ *  Add a key to a key store by its private key
+ *
+ *  @note
+ *  The key is warm, or cold if the budget is held by keys in use.
+ *
+ *  @param[in] store  The key store
+ *  @param[in] id     The key identifier
+ *  @param[in] sk     The pointer to NTS-KEM private key
+ *  @return NTS_KEM_SUCCESS on success, NTS_KEM_BAD_PARAMETERS if the
+ *          identifier is taken, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_key_store_add(NTSKEM_key_store* store,
+                          uint64_t id,
+                          const uint8_t *sk);
+
+/**
+ *  Add a key to a key store by the seed it is generated from
+ *
+ *  @note
+ *  The key is cold, only its seed is kept, and it is generated as by
+ *  {@see nts_kem_create_from_seed} whenever it is loaded.
+ *
+ *  @param[in] store  The key store
+ *  @param[in] id     The key identifier
+ *  @param[in] seed   The seed of NTS_KEM_SEED_SIZE bytes
+ *  @return NTS_KEM_SUCCESS on success, NTS_KEM_BAD_PARAMETERS if the
+ *          identifier is taken, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_key_store_add_seed(NTSKEM_key_store* store,
+                               uint64_t id,
+                               const uint8_t *seed);
+
+/**
+ *  Remove a key from a key store, its memory and file are wiped
+ *
+ *  @note
+ *  The call waits for the accesses to the key in progress.
+ *
+ *  @param[in] store  The key store
+ *  @param[in] id     The key identifier
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_key_store_remove(NTSKEM_key_store* store,
+                             uint64_t id);
+
+/**
+ *  NTS-KEM decapsulation under a key of a key store
+ *
+ *  @note
+ *  The key is loaded if it is cold and prepared as a context once it
+ *  is accessed often enough, less frequently accessed keys are moved
+ *  down a tier to stay within the budget. The decapsulation itself is
+ *  run without holding the lock of the store.
+ *
+ *  @param[in]  store  The key store
+ *  @param[in]  id     The key identifier
+ *  @param[in]  c_ast  The pointer to the NTS-KEM ciphertext
+ *  @param[out] k_r    The pointer to the encapsulated key
+ *  @return NTS_KEM_SUCCESS on success, NTS_KEM_KEY_NOT_FOUND if there
+ *          is no such key, NTS_KEM_BUSY if the key is cold and the
+ *          budget is held by keys in use, otherwise a negative error
+ *          code {@see nts_kem_errors.h}
+ **/
+int nts_kem_key_store_decapsulate(NTSKEM_key_store* store,
+                                  uint64_t id,
+                                  const uint8_t *c_ast,
+                                  uint8_t *k_r);
+
+/**
+ *  Copy the public key of a key of a key store, an access to the key
+ *  as by {@see nts_kem_key_store_decapsulate}
+ *
+ *  @param[in]  store  The key store
+ *  @param[in]  id     The key identifier
+ *  @param[out] pk     The pointer to NTS-KEM public key
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_key_store_public_key(NTSKEM_key_store* store,
+                                 uint64_t id,
+                                 uint8_t *pk);
+
+/**
+ *  Return the tier of a key of a key store
+ *
+ *  @param[in] store  The key store
+ *  @param[in] id     The key identifier
+ *  @return NTS_KEM_KEY_STORE_HOT, WARM or COLD, otherwise a negative
+ *          error code {@see nts_kem_errors.h}
+ **/
+int nts_kem_key_store_tier(NTSKEM_key_store* store,
+                           uint64_t id);
+
+/**
+ *  Read the counters of a key store
+ *
+ *  @param[in]  store  The key store
+ *  @param[out] stats  The counters
+ **/
+void nts_kem_key_store_stats(NTSKEM_key_store* store,
+                             NTSKEM_key_store_stats* stats);
+
+/**
+ *  Release a key store, the keys in memory are wiped and the
+ *  files of the cold keys are removed
+ *
+ *  @param[in] store  The key store, with no access in progress
+ **/
+void nts_kem_key_store_release(NTSKEM_key_store* store);
+
+#endif /* __NTSKEM_KEY_STORE_H */
@@ -30,11 +30,24 @@
 
 #define STRIPE_SIZE         8
 #define STRIPE_SIZE_LOG     3
-#define NUM_GRAY_TABLES     8
-#define NUM_GRAY_TABLES_LOG 3
+#define M4R_BLOCK_BYTES     1024 /* Bytes per column block */
 #define M4R_ROW(M, r)       ((uint8_t *)(M)->v + ((r) * (M)->stride))
 #define GRAY_TO_BIN(x)      ((x) ^ ((x) >> 1))
 
+#if   defined(__AVX2__)
+#define VECTOR_LOG          8
+#define VECTOR_XOR(a, b)    _mm256_xor_si256((a), (b))
+#define VECTOR_ZERO         _mm256_setzero_si256()
+#elif defined(__SSE2__)
+#define VECTOR_LOG          7
+#define VECTOR_XOR(a, b)    _mm_xor_si128((a), (b))
+#define VECTOR_ZERO         _mm_setzero_si128()
+#else
+#define VECTOR_LOG          LOG2
+#define VECTOR_XOR(a, b)    ((a) ^ (b))
+#define VECTOR_ZERO         0
+#endif
+
 const uint8_t _gray_codes_lut2[] = {
     0, 1, 0, 1
 };
@@ -73,39 +86,22 @@ const uint8_t* _gray_codes_lut[] = {
     _gray_codes_lut7, _gray_codes_lut8
 };
 
-static inline void zero_vector(uint8_t *row_ptr, uint32_t stride)
-{
-#if defined(__SSE2__) || defined(__AVX2__)
-    int32_t i;
-    vector *vec_ptr = NULL;
-#endif
-
-#if   defined(__AVX2__)
-    vec_ptr = (vector *)row_ptr;
-    for (i=0; i<stride; i+=64) {
-        *vec_ptr = _mm256_setzero_si256(); vec_ptr++;
-        *vec_ptr = _mm256_setzero_si256(); vec_ptr++;
-    }
-#elif defined(__SSE2__)
-    vec_ptr = (vector *)row_ptr;
-    for (i=0; i<stride; i+=64) {
-        *vec_ptr = _mm_setzero_si128(); vec_ptr++;
-        *vec_ptr = _mm_setzero_si128(); vec_ptr++;
-        *vec_ptr = _mm_setzero_si128(); vec_ptr++;
-        *vec_ptr = _mm_setzero_si128(); vec_ptr++;
-    }
-#else
-    CT_memset(row_ptr, 0, stride);
-#endif
-}
-
+/**
+ *  Construct the Gray-code table T of the `k` rows of B ending at
+ *  row `r_end`, over the columns [0, c_end)
+ *
+ *  @note
+ *  Each row of T is written over the vectors in use, plus one cleared
+ *  vector so that tables of adjacent stripes can be added together
+ *  over the same number of vectors
+ **/
 void _m4ri_make_table_rev(matrix_ff2* T,
                           const matrix_ff2* B,
                           uint32_t r_end,
                           uint32_t c_end,
                           uint32_t k)
 {
-    int32_t i, j, is_zero, nblocks;
+    int32_t i, j, is_zero, nblocks, ncleared;
     const uint8_t *gray_codes_lut;
 #if defined(__SSE2__) || defined(__AVX2__)
     vector *B_ptr = NULL;
@@ -174,12 +170,17 @@ void _m4ri_make_table_rev(matrix_ff2* T,
     mask = mask ^ (-is_zero & (~mask ^ mask));
 #endif
     
+    ncleared = CT_min(nblocks + 1, (int32_t)(T->stride / sizeof(vector)));
+    
     /* Note: the 0-th row of T is always 00...0 */
-    zero_vector(M4R_ROW(T, 0), T->stride);
+#if defined(__SSE2__) || defined(__AVX2__)
+    T_ptr = ((vector *)M4R_ROW(T, 0));
+#else
+    T_ptr = ((packed_t *)M4R_ROW(T, 0));
+#endif
+    for (j=0; j<ncleared; j++) T_ptr[j] = VECTOR_ZERO;
     
     /* 1-st row of T, starting at block l */
-    zero_vector(M4R_ROW(T, 1), T->stride);
-    
 #if defined(__SSE2__) || defined(__AVX2__)
     S_ptr = T_ptr = ((vector *)M4R_ROW(T, 1));
     /* r_start-th row of B, starting at block l */
@@ -200,6 +201,7 @@ void _m4ri_make_table_rev(matrix_ff2* T,
 #else
     S_ptr[nblocks-1] &= mask; /* Clear unwanted bits */
 #endif
+    for (j=nblocks; j<ncleared; j++) S_ptr[j] = VECTOR_ZERO;
     /* S_ptr is a pointer to the previous row of T */
     
     /* Subsequent rows of T */
@@ -207,7 +209,6 @@ void _m4ri_make_table_rev(matrix_ff2* T,
     for (i=2; i<(1 << k); i++) {
         /* i-th row of T, starting at block l */
         j = GRAY_TO_BIN(i);
-        zero_vector(M4R_ROW(T, j), T->stride);
 #if defined(__SSE2__) || defined(__AVX2__)
         U_ptr = T_ptr = ((vector *)M4R_ROW(T, j));
         /* (r+Gray[i])-th row of B, starting at block l */
@@ -228,6 +229,7 @@ void _m4ri_make_table_rev(matrix_ff2* T,
 #else
         U_ptr[nblocks-1] &= mask; /* Clear unwanted bits */
 #endif
+        for (j=nblocks; j<ncleared; j++) U_ptr[j] = VECTOR_ZERO;
         S_ptr = U_ptr; /* Pointer to the previous row of T */
     }
 }
@@ -360,33 +362,96 @@ static inline void _m4ri_add_rows_rev(packed_t *dst,
 #endif
 }
 
-static inline void _m4ri_add_rows_rev_from_gray_table(matrix_ff2* A,
-                                                      const matrix_ff2 *T,
-                                                      uint32_t r_start,
-                                                      uint32_t r_end,
-                                                      uint32_t c_end,
-                                                      uint32_t k)
+/**
+ *  Read `k` bits (k <= STRIPE_SIZE) of a row starting at column `col`
+ **/
+static inline uint32_t _m4ri_read_bits(const packed_t *v, uint32_t col, uint32_t k)
 {
-    int32_t i;
-    uint8_t *ptr, x, x0, x1, mask;
-    uint32_t hi, lo;
-    uint8_t mask_hi = 0, mask_lo = 0;
-    
-    hi = (c_end-1) >> 3;
-    lo = (c_end-k) >> 3;
-    mask_hi = (1 << (c_end & 7))-1;
-    mask_lo = ~((1 << ((c_end-k) & 7))-1);
-    mask = (mask_hi & mask_lo);
-    mask = CT_mux(CT_is_equal_zero(mask_hi), mask_lo, mask);
-    
-    for (i=(int32_t)r_start-1; i>=(int32_t)r_end; i--) {
-        ptr = M4R_ROW(A, i) + hi;
-        x0 = (((*ptr & mask_hi) << (STRIPE_SIZE - ((c_end-k) & 7))) |
-              ((*(ptr-1) & mask_lo) >> ((c_end-k) & 7)));
-        x1 = (*ptr & mask) >> ((c_end-k) & 7);
-        x = (uint8_t)CT_mux(CT_is_equal(hi, lo), x1, x0);
-        x &= ((1 << k)-1);
-        _m4ri_add_rows_rev((packed_t *)M4R_ROW(A, i), (const packed_t *)M4R_ROW(T, x), c_end);
+    uint32_t block = col >> LOG2, spot = col & MOD;
+    packed_t x = v[block] >> spot;
+    
+    if (spot + k > BITSIZE)
+        x |= v[block + 1] << (BITSIZE - spot);
+    
+    return (uint32_t)(x & ((ONE << k)-1));
+}
+
+/**
+ *  Add to row `dst` the rows `src[0], src[1], ..., src[n-1]` over
+ *  the vectors [start, end) and store the output at row `dst`
+ **/
+static inline void _m4ri_add_rows_multi(vector *dst,
+                                        const vector *const *src,
+                                        int32_t n,
+                                        int32_t start,
+                                        int32_t end)
+{
+    int32_t j;
+    const vector *s0 = src[0], *s1 = src[1], *s2 = src[2], *s3 = src[3];
+    
+    switch (n) {
+        case 4:
+            for (j=start; j<end; j++)
+                dst[j] = VECTOR_XOR(dst[j], VECTOR_XOR(VECTOR_XOR(s0[j], s1[j]),
+                                                       VECTOR_XOR(s2[j], s3[j])));
+            break;
+        case 3:
+            for (j=start; j<end; j++)
+                dst[j] = VECTOR_XOR(dst[j], VECTOR_XOR(VECTOR_XOR(s0[j], s1[j]), s2[j]));
+            break;
+        case 2:
+            for (j=start; j<end; j++)
+                dst[j] = VECTOR_XOR(dst[j], VECTOR_XOR(s0[j], s1[j]));
+            break;
+        default:
+            for (j=start; j<end; j++)
+                dst[j] = VECTOR_XOR(dst[j], s0[j]);
+    }
+}
+
+/**
+ *  Eliminate the columns [c_end-k, c_end) from the rows [r_end, r_start)
+ *  of A using the Gray-code tables T[0], T[1], ..., one table for every
+ *  STRIPE_SIZE columns, in a single pass over each row.
+ *
+ *  @note
+ *  The table indices of all rows are read first, then the row additions
+ *  are done in blocks of M4R_BLOCK_BYTES bytes so that the slices of the
+ *  tables in use stay in the cache while all the rows are visited.
+ **/
+static inline void _m4ri_add_rows_rev_from_gray_tables(matrix_ff2* A,
+                                                       matrix_ff2 *const *T,
+                                                       uint8_t *index,
+                                                       uint32_t r_start,
+                                                       uint32_t r_end,
+                                                       uint32_t c_end,
+                                                       uint32_t k)
+{
+    int32_t i, t, nt, start, end, nblocks, size;
+    uint32_t kt;
+    uint8_t *x = NULL;
+    const vector *src[NUM_GRAY_TABLES] = {NULL};
+    
+    nt = (int32_t)((k + STRIPE_SIZE - 1) >> STRIPE_SIZE_LOG);
+    nblocks = (int32_t)((c_end + (1 << VECTOR_LOG) - 1) >> VECTOR_LOG);
+    size = (int32_t)(M4R_BLOCK_BYTES / sizeof(vector));
+    
+    for (i=(int32_t)r_end, x=index; i<(int32_t)r_start; i++, x+=NUM_GRAY_TABLES) {
+        for (t=0; t<nt; t++) {
+            kt = CT_min(STRIPE_SIZE, k - t*STRIPE_SIZE);
+            x[t] = (uint8_t)_m4ri_read_bits((const packed_t *)M4R_ROW(A, i),
+                                            c_end - t*STRIPE_SIZE - kt, kt);
+        }
+    }
+    
+    for (start=0; start<nblocks; start+=size) {
+        end = CT_min(start + size, nblocks);
+        for (i=(int32_t)r_end, x=index; i<(int32_t)r_start; i++, x+=NUM_GRAY_TABLES) {
+            for (t=0; t<nt; t++) {
+                src[t] = (const vector *)M4R_ROW(T[t], x[t]);
+            }
+            _m4ri_add_rows_multi((vector *)M4R_ROW(A, i), src, nt, start, end);
+        }
     }
 }
 
@@ -441,36 +506,97 @@ uint32_t _m4ri_gauss_submatrix(matrix_ff2* A,
     return (uint32_t)(c-j-1);
 }
 
-uint32_t m4r_rref(matrix_ff2* A)
+int m4r_rref_init(m4r_state* state, matrix_ff2* A)
 {
-    int32_t r = 0, c = 0, rank = 0;
-    int32_t k = STRIPE_SIZE, rk;
-    matrix_ff2 *T = NULL;
+    int32_t i;
+    
+    CT_memset(state, 0, sizeof(m4r_state));
+    
+    for (i=0; i<NUM_GRAY_TABLES; i++) {
+        if (!(state->T[i] = alloc_matrix_ff2(sizeof(_gray_codes_lut8), A->ncols)))
+            goto m4r_rref_init_fail;
+    }
+    if (!(state->index = (uint8_t *)malloc(A->nrows * NUM_GRAY_TABLES)))
+        goto m4r_rref_init_fail;
     
-    if (!(T = alloc_matrix_ff2(sizeof(_gray_codes_lut8), A->ncols)))
+    state->A = A;
+    state->r = A->nrows;
+    state->c = A->ncols;
+    state->k = NUM_GRAY_TABLES * STRIPE_SIZE;
+    state->rank = 0;
+    
+    return 1;
+    
+m4r_rref_init_fail:
+    for (i=0; i<NUM_GRAY_TABLES; i++) {
+        free_matrix_ff2(state->T[i]);
+        state->T[i] = NULL;
+    }
+    
+    return 0;
+}
+
+int m4r_rref_step(m4r_state* state)
+{
+    int32_t i, kt, rk;
+    matrix_ff2 *A = state->A;
+    
+    if (state->c <= 0)
         return 0;
     
-    r = A->nrows;
-    c = A->ncols;
-    while (c > 0) {
-        if (c - k < 0) {
-            k = c;
-        }
-        rk = _m4ri_gauss_submatrix(A, r, c, 0, k);
-        if (rk > 0) {
-            _m4ri_make_table_rev(T, A, r, c, rk);
-            _m4ri_add_rows_rev_from_gray_table(A, T, r-rk, 0, c, rk);
-            _m4ri_add_rows_rev_from_gray_table(A, T, A->nrows, r, c, rk);
+    if (state->c - state->k < 0) {
+        state->k = state->c;
+    }
+    rk = _m4ri_gauss_submatrix(A, state->r, state->c, 0, state->k);
+    if (rk > 0) {
+        for (i=0; i*STRIPE_SIZE<rk; i++) {
+            kt = CT_min(STRIPE_SIZE, rk - i*STRIPE_SIZE);
+            _m4ri_make_table_rev(state->T[i], A, state->r - i*STRIPE_SIZE,
+                                 state->c - i*STRIPE_SIZE, kt);
         }
-        r -= rk;
-        c -= rk;
-        rank += rk;
-        if (rk != k)
-            --c;
+        _m4ri_add_rows_rev_from_gray_tables(A, state->T, state->index,
+                                            state->r-rk, 0, state->c, rk);
+        _m4ri_add_rows_rev_from_gray_tables(A, state->T, state->index,
+                                            A->nrows, state->r, state->c, rk);
     }
+    state->r -= rk;
+    state->c -= rk;
+    state->rank += rk;
+    if (rk != state->k)
+        --state->c;
+    
+    return (state->c > 0);
+}
+
+uint32_t m4r_rref_final(m4r_state* state)
+{
+    int32_t i;
     
-    free_matrix_ff2(T);
+    if (state->index) {
+        CT_memset(state->index, 0, state->A->nrows * NUM_GRAY_TABLES);
+        free(state->index);
+        state->index = NULL;
+    }
+    for (i=0; i<NUM_GRAY_TABLES; i++) {
+        if (state->T[i]) {
+            zero_matrix_ff2(state->T[i]);
+            free_matrix_ff2(state->T[i]);
+            state->T[i] = NULL;
+        }
+    }
+    state->A = NULL;
     
-    return (uint32_t)rank;
+    return state->rank;
+}
 
+uint32_t m4r_rref(matrix_ff2* A)
+{
+    m4r_state state;
+    
+    if (!m4r_rref_init(&state, A))
+        return 0;
+    
+    while (m4r_rref_step(&state));
+    
+    return m4r_rref_final(&state);
 }
@@ -27,6 +27,26 @@
 #include <stdint.h>
 #include "matrix_ff2.h"
 
+#define NUM_GRAY_TABLES     4
+#define NUM_GRAY_TABLES_LOG 2
+
+/**
+ *  State of an incremental reduced row echelon transformation
+ *
+ *  @note
+ *  This allows the caller to perform the transformation one
+ *  stripe of columns at a time, {@see m4r_rref_step}.
+ **/
+typedef struct {
+    matrix_ff2* A;      /* The matrix being transformed */
+    matrix_ff2* T[NUM_GRAY_TABLES]; /* The Gray-code tables, one per 8 columns */
+    uint8_t* index;     /* The table indices of every row */
+    int32_t r;          /* Rows remaining to be reduced */
+    int32_t c;          /* Columns remaining to be reduced */
+    int32_t k;          /* The stripe size */
+    uint32_t rank;      /* The rank obtained so far */
+} m4r_state;
+
 /**
  *  Transform matrix into row-reduced echelon form
  *
@@ -42,4 +62,30 @@
  **/
 uint32_t m4r_rref(matrix_ff2* A);
 
+/**
+ *  Prepare an incremental reduced row echelon transformation
+ *
+ *  @param[out]    state  The state of the transformation
+ *  @param[in,out] A      Matrix A
+ *  @return 1 on success, 0 otherwise
+ **/
+int m4r_rref_init(m4r_state* state, matrix_ff2* A);
+
+/**
+ *  Transform a stripe of columns of the matrix
+ *
+ *  @param[in,out] state  The state of the transformation
+ *  @return 1 if there are more stripes to be processed, 0 otherwise
+ **/
+int m4r_rref_step(m4r_state* state);
+
+/**
+ *  Complete an incremental reduced row echelon transformation
+ *  and release the resources held by the state
+ *
+ *  @param[in,out] state  The state of the transformation
+ *  @return The rank matrix A
+ **/
+uint32_t m4r_rref_final(m4r_state* state);
+
 #endif /* __M4R_H */
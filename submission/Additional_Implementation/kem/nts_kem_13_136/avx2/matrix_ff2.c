@@ -39,7 +39,7 @@ matrix_ff2* alloc_matrix_ff2(int nrows, int ncols)
 #if defined(_WIN32)
         if (!(M->v = _aligned_malloc(M->stride * M->rows, ALIGNMENT)))
 #else
-        if (0 != posix_memalign((void **)&M->v, ALIGNMENT, M->stride * M->nrows))
+        if (!(M->v = (uint8_t *)mem_alloc_large(M->stride * M->nrows)))
 #endif
         {
             free(M);
@@ -67,7 +67,7 @@ void free_matrix_ff2(matrix_ff2 *M)
 #if defined(_WIN32)
             _aligned_free(M->v);
 #else
-            free(M->v);
+            mem_free_large(M->v);
 #endif
             M->v = NULL;
         }
@@ -9,10 +9,111 @@
  *  Standardization Process.
  **/
 
+#if defined(__linux__)
+#define _GNU_SOURCE             /* MAP_ANONYMOUS, MAP_HUGETLB, madvise */
+#endif
+
+#include <stdlib.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
 #include "mem.h"
 
+#define MEM_HUGE_PAGE_SIZE      ((size_t)2 << 20)
+#define MEM_HEADER_SIZE         64
+
+/**
+ *  The allocations from which huge pages are used, at most half
+ *  of the last huge page of an allocation is left unused
+ **/
+#define MEM_HUGE_PAGE_THRESHOLD (MEM_HUGE_PAGE_SIZE >> 1)
+
+static int huge_pages = NTS_KEM_HUGE_PAGES;
+
 void CT_memset(void *ptr, uint8_t v, size_t len)
 {
     volatile uint8_t *p = ptr;
     while (len--) *p++ = v;
 }
+
+int mem_huge_pages(int enable)
+{
+    return __atomic_exchange_n(&huge_pages, enable ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+#if defined(__linux__)
+/**
+ *  Map len bytes, a multiple of the huge page size, in huge pages
+ *  reserved for the system if there are any, otherwise in normal pages
+ *  aligned to a huge page that the kernel is advised to back with
+ *  transparent huge pages
+ **/
+static uint8_t* mem_map_huge(size_t len)
+{
+    size_t slack;
+    uint8_t *ptr, *aligned;
+    
+    ptr = (uint8_t *)mmap(NULL, len, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED)
+        return ptr;
+    
+    /* Map a huge page more and trim the mapping to a huge page boundary */
+    ptr = (uint8_t *)mmap(NULL, len + MEM_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return NULL;
+    aligned = (uint8_t *)(((uintptr_t)ptr + MEM_HUGE_PAGE_SIZE - 1) &
+                          ~(uintptr_t)(MEM_HUGE_PAGE_SIZE - 1));
+    slack = (size_t)(aligned - ptr);
+    if (slack)
+        munmap(ptr, slack);
+    munmap(aligned + len, MEM_HUGE_PAGE_SIZE - slack);
+    if (madvise(aligned, len, MADV_HUGEPAGE)) {
+        munmap(aligned, len);
+        return NULL;
+    }
+    
+    return aligned;
+}
+#endif
+
+void* mem_alloc_large(size_t len)
+{
+    void *ptr = NULL;
+#if defined(__linux__)
+    size_t mapped;
+    uint8_t *base;
+    
+    if (__atomic_load_n(&huge_pages, __ATOMIC_RELAXED) && len >= MEM_HUGE_PAGE_THRESHOLD) {
+        mapped = (len + MEM_HEADER_SIZE + MEM_HUGE_PAGE_SIZE - 1) & ~(MEM_HUGE_PAGE_SIZE - 1);
+        if ((base = mem_map_huge(mapped))) {
+            *(size_t *)base = mapped;
+            return base + MEM_HEADER_SIZE;
+        }
+    }
+#endif
+    
+    /* The header records that the allocation is on the heap */
+    if (posix_memalign(&ptr, MEM_HEADER_SIZE, len + MEM_HEADER_SIZE))
+        return NULL;
+    *(size_t *)ptr = 0;
+    
+    return (uint8_t *)ptr + MEM_HEADER_SIZE;
+}
+
+void mem_free_large(void *ptr)
+{
+    uint8_t *base;
+    
+    if (ptr) {
+        base = (uint8_t *)ptr - MEM_HEADER_SIZE;
+#if defined(__linux__)
+        if (*(size_t *)base) {
+            munmap(base, *(size_t *)base);
+            return;
+        }
+#endif
+        free(base);
+    }
+}
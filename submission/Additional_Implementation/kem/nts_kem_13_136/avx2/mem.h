@@ -15,6 +15,45 @@
 #include <stdint.h>
 #include <stddef.h>
 
+/**
+ *  Whether the large allocations are backed by 2 MB pages by default,
+ *  {@see mem_huge_pages}
+ **/
+#ifndef NTS_KEM_HUGE_PAGES
+#define NTS_KEM_HUGE_PAGES      0
+#endif
+
 void CT_memset(void *ptr, uint8_t v, size_t len);
 
+/**
+ *  Enable or disable huge pages for the subsequent large allocations
+ *
+ *  @param[in] enable  Non-zero to enable huge pages
+ *  @return Whether huge pages were enabled
+ **/
+int mem_huge_pages(int enable);
+
+/**
+ *  Allocate a buffer of the size of a public key or larger
+ *
+ *  @note
+ *  With huge pages enabled on Linux, buffers of 1 MB or more are
+ *  mapped aligned to 2 MB pages, either reserved huge pages or
+ *  transparent huge pages through madvise(MADV_HUGEPAGE). Otherwise,
+ *  or if the mapping fails, the buffer is allocated from the heap.
+ *  The buffer is aligned to 64 bytes and is not guaranteed to be
+ *  all zeros.
+ *
+ *  @param[in] len  The size in bytes
+ *  @return Pointer to the buffer, NULL on failure
+ **/
+void* mem_alloc_large(size_t len);
+
+/**
+ *  Release a buffer of {@see mem_alloc_large}
+ *
+ *  @param[in] ptr  Pointer to the buffer, or NULL
+ **/
+void mem_free_large(void *ptr);
+
 #endif /* __NTSKEM_MEM_H */
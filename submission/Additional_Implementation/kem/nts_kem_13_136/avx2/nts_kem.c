@@ -14,10 +14,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "nts_kem.h"
+#include "benes.h"
 #include "ff.h"
+#include "vector_ff.h"
 #include "bits.h"
 #include "matrix_ff2.h"
+#include "m4r.h"
 #include "polynomial.h"
 #include "random.h"
 #include "keccak.h"
@@ -27,20 +35,84 @@
 #include "vector_utils.h"
 #include "bitslice_bma_128.h"
 #include "bitslice_fft_256.h"
-#if defined(BENCHMARK)
+#include "bitslice_patterson_256.h"
 #include "utils.h"
-#endif
+#include "worker_group.h"
+#include "decap_cache.h"
+#include "syndrome.h"
 
 typedef struct {
     uint32_t m;
-    FF2m *ff2m;
+    const FF2m *ff2m;
     ff_unit a[ NTS_KEM_PARAM_BC ];
     ff_unit h[ NTS_KEM_PARAM_BC ];
     ff_unit p[ NTS_KEM_PARAM_N ];
     uint8_t z[ NTS_KEM_KEY_SIZE ];
-    uint8_t pk[ NTS_KEM_PUBLIC_KEY_SIZE ];
+    const uint8_t *pk;          /* The public key within the private key */
 } NTSKEM_private;
 
+typedef struct {
+    vector g[NTS_KEM_PARAM_M];      /* Goppa polynomial G(z) */
+    vector sqrt_z[NTS_KEM_PARAM_M]; /* sqrt(z) mod G(z) */
+    ff_unit w[NTS_KEM_PARAM_BC];    /* w_i = G(a_i)^{-1} */
+} NTSKEM_patterson;
+
+struct NTSKEM_decap_ctx {
+    NTSKEM *nts_kem;
+    vector *syndrome_matrix;        /* Optional, 2τ·m (or τ·m) rows of (b+c) bits */
+    uint64_t *benes;                /* Optional, Beneš network of p */
+    NTSKEM_patterson *patterson;    /* Optional, Patterson decoding */
+    worker_group *workers;          /* Optional, threads sharing a decapsulation */
+    decap_cache *cache;             /* Optional, results of recent decapsulations */
+    uint8_t *segment;               /* The shared memory of an attached context */
+    size_t segment_size;
+};
+
+#define KEYGEN_RND_SIZE         64
+
+/**
+ *  Random bits taken from the SHAKE256 stream of a seed
+ **/
+typedef struct {
+    shake256_state xof;             /* SHAKE256(seed) stream */
+    int32_t bits_consumed;          /* Bits used of rnd_buffer */
+    uint8_t rnd_buffer[KEYGEN_RND_SIZE];
+} xof_source;
+
+/**
+ *  Stages of the key generation, {@see nts_kem_keygen_step}
+ **/
+enum {
+    NTS_KEM_KEYGEN_GOPPA = 0,       /* Sample a Goppa polynomial G(z) */
+    NTS_KEM_KEYGEN_PERMUTATION,     /* Sample a permutation vector p */
+    NTS_KEM_KEYGEN_PARITY_CHECK,    /* Construct the parity-check matrix H */
+    NTS_KEM_KEYGEN_ELIMINATION,     /* Reduced row echelon form of H */
+    NTS_KEM_KEYGEN_SYSTEMATIC,      /* Permute the columns of H */
+    NTS_KEM_KEYGEN_EXTRACT_Q,       /* Extract matrix Q from H */
+    NTS_KEM_KEYGEN_SERIALISE,       /* Serialise the key pair */
+    NTS_KEM_KEYGEN_DONE
+};
+
+struct NTSKEM_keygen {
+    int32_t stage;
+    int32_t status;
+    NTSKEM *nts_kem;
+    poly *Gz;
+    matrix_ff2 *H;
+    matrix_ff2 *Q;
+    m4r_state m4r;
+    int32_t row;                    /* Progress within a stage */
+    int32_t col;                    /* Column offset of the systematic stage */
+    ff_unit a[NTS_KEM_PARAM_N];
+    ff_unit h[NTS_KEM_PARAM_N];
+    int32_t seeded;                 /* Randomness is derived from a seed */
+    xof_source rng;                 /* The random bits of a seeded keygen */
+#if defined(BENCHMARK)
+    int32_t num_trials;
+    uint64_t cycles;
+#endif
+};
+
 static const int kNTSKEMKeysize = NTS_KEM_KEY_SIZE;
 
 #define NTS_KEM_PARAM_A_REM     (((NTS_KEM_PARAM_A - (NTS_KEM_KEY_SIZE << 3)) & MOD) >> 3)
@@ -51,28 +123,96 @@ static const int kNTSKEMKeysize = NTS_KEM_KEY_SIZE;
 #define NTS_KEM_PARAM_N_VEC     NTS_KEM_PARAM_N_DIV_256
 
 #define bitslice_fft    bitslice_fft13_256
+#define bitslice_fft_roots  bitslice_fft13_256_roots
 #define vector_ff_or    vector_ff_or_256
 
+#define KEYGEN_ROWS_PER_STEP    128
+#define SYNDROME_MATRIX_SIZE    (2*NTS_KEM_PARAM_T*NTS_KEM_PARAM_M*NTS_KEM_PARAM_BC_VEC)
+#define GOPPA_SYNDROME_MATRIX_SIZE  (NTS_KEM_PARAM_T*NTS_KEM_PARAM_M*NTS_KEM_PARAM_BC_VEC)
+#define SHARED_CTX_MAGIC        "NTSKEMSC"
+#define SHARED_CTX_VERSION      1
+#define SHARED_CTX_ALIGN        64
+#define MESSAGE_WORDS           ((NTS_KEM_PARAM_A >> LOG2) + 1 + (NTS_KEM_PARAM_B >> LOG2))
+
+/**
+ *  The intermediate values of a decapsulation
+ **/
+typedef struct {
+    vector error[NTS_KEM_PARAM_N_VEC];      /* The root indicators, then e' */
+    __m128i sigma[2][NTS_KEM_PARAM_M];      /* The error-locator polynomial */
+    ff_unit syndromes[2*NTS_KEM_PARAM_T];
+    int32_t extended_error;
+    uint32_t error_weight;
+} decap_state;
+
 /* Function definitions */
-poly* create_random_goppa_polynomial(const FF2m* ff2m, int degree);
-matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
+int keygen_randombytes(NTSKEM_keygen* keygen, uint8_t *buffer, size_t size);
+uint16_t keygen_random_uint16_bounded(NTSKEM_keygen* keygen, uint16_t bound);
+void xof_source_init(xof_source *rng, const uint8_t *seed);
+void xof_source_release(xof_source *rng);
+uint16_t xof_uint16_bounded(xof_source *rng, uint16_t bound);
+int sample_goppa_polynomial(NTSKEM_keygen* keygen);
+matrix_ff2* create_matrix_H(const NTSKEM* nts_kem,
                             const poly* Gz,
                             ff_unit *a,
                             ff_unit *h);
-void fisher_yates_shuffle(ff_unit *buffer);
+int32_t permute_matrix_H(const NTSKEM* nts_kem,
+                         matrix_ff2* H,
+                         ff_unit *a,
+                         ff_unit *h,
+                         int32_t row,
+                         int32_t *col,
+                         int32_t count);
+void extract_matrix_Q(matrix_ff2* Q,
+                      const matrix_ff2* H,
+                      int32_t row_start,
+                      int32_t row_end);
+int32_t keygen_advance(NTSKEM_keygen* keygen);
+void fisher_yates_shuffle(NTSKEM_keygen* keygen, ff_unit *buffer);
 int encapsulate(const uint8_t *e,
                 const uint8_t *pk,
-                uint8_t *c_ast,
-                uint8_t *k_r);
+                const NTSKEM_iovec *c_ast,
+                size_t iovcnt,
+                uint8_t *k_r,
+                worker_group *workers);
+void encode_parity(const uint8_t *pk, const uint8_t *e, const uint8_t *k_e,
+                   int32_t begin, int32_t end, vector *c_c);
+void encapsulate_output(const uint8_t *e, const uint8_t *k_e, const vector *c_c,
+                        const NTSKEM_iovec *c_ast, size_t iovcnt, uint8_t *k_r);
 void random_vector(uint32_t tau, uint32_t n, uint8_t *e);
-int compute_syndrome(const NTSKEM* nts_kem, const vector *c_ast, ff_unit* s);
+void random_vector_xof(uint32_t tau, uint32_t n, uint8_t *e, xof_source *rng);
+int decapsulate(const NTSKEM_decap_ctx* ctx, const NTSKEM_iovec *c_ast,
+                size_t iovcnt, uint8_t *k_r);
+int decap_syndromes(const NTSKEM_decap_ctx* ctx, const NTSKEM_iovec *c_ast,
+                    size_t iovcnt, decap_state *st);
+void decap_locate(const NTSKEM_decap_ctx* ctx, decap_state *st);
+void decap_roots(decap_state *st);
+int decap_verify(const NTSKEM_decap_ctx* ctx, decap_state *st,
+                 const NTSKEM_iovec *c_ast, size_t iovcnt, uint8_t *k_r);
+int compute_syndrome_blocks(const NTSKEM* nts_kem, const uint64_t *benes,
+                            const ff_unit* weight, const vector *c_ptr,
+                            ff_unit* s, int32_t count, int32_t first, int32_t stride);
+int compute_syndrome_chain(const NTSKEM* nts_kem, const ff_unit* weight,
+                           const vector *c_ptr, ff_unit* s, int32_t count);
+int create_syndrome_matrix(const NTSKEM* nts_kem, vector *H);
+int compute_syndrome_from_matrix(const vector *H, const vector *c_ptr,
+                                 ff_unit* s, int32_t count);
+int create_patterson(const NTSKEM* nts_kem, NTSKEM_patterson* pat);
+int create_goppa_syndrome_matrix(const NTSKEM* nts_kem,
+                                 const NTSKEM_patterson* pat,
+                                 vector *H);
 void permute_error(const uint8_t* e_prime, const ff_unit* p, uint8_t *e);
+void benes_scatter_planes(vector (*x)[NTS_KEM_PARAM_M], const uint64_t *masks);
 void pack_buffer(const uint8_t *src, int src_len, uint8_t *dst);
-void unpack_buffer(const uint8_t *src, ff_unit *dst, int dst_len);
 int serialise_public_key(NTSKEM* nts_kem, const matrix_ff2* SGP);
 int serialise_private_key(NTSKEM *nts_kem, const matrix_ff2* Q);
 int deserialise_private_key(NTSKEM* nts_kem, const uint8_t *buf);
-void load_input_ciphertext(vector *out, const uint8_t *in);
+void load_private_key(NTSKEM* nts_kem, NTSKEM_private* priv, const uint8_t *sk);
+int is_valid_ciphertext_iov(const NTSKEM_iovec *c_ast, size_t iovcnt);
+void hash_ciphertext(const NTSKEM_iovec *c_ast, size_t iovcnt, uint8_t *digest);
+void load_input_ciphertext(vector *out, const NTSKEM_iovec *in, size_t iovcnt);
+void store_output_ciphertext(const NTSKEM_iovec *out, size_t iovcnt, size_t offset,
+                             const uint8_t *in, const uint8_t *mask, size_t len);
 
 /**
  *  Initialise an NTS-KEM object with a given parameter
@@ -82,29 +222,69 @@ void load_input_ciphertext(vector *out, const uint8_t *in);
  *          {@see nts_kem_errors.h}
  **/
 int nts_kem_create(NTSKEM** nts_kem)
+{
+    int32_t status;
+    NTSKEM_keygen *keygen = NULL;
+    
+    status = nts_kem_keygen_begin(&keygen);
+    if (status != NTS_KEM_SUCCESS)
+        return status;
+    
+    return nts_kem_keygen_finish(keygen, nts_kem);
+}
+
+/**
+ *  Initialise an NTS-KEM object deterministically from a seed
+ *
+ *  @param[out] nts_kem A pointer of NTSKEM object created
+ *  @param[in]  seed    The seed of NTS_KEM_SEED_SIZE bytes
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_create_from_seed(NTSKEM** nts_kem, const uint8_t *seed)
+{
+    int32_t status;
+    NTSKEM_keygen *keygen = NULL;
+    
+    status = nts_kem_keygen_begin_from_seed(&keygen, seed);
+    if (status != NTS_KEM_SUCCESS)
+        return status;
+    
+    return nts_kem_keygen_finish(keygen, nts_kem);
+}
+
+/**
+ *  Begin an incremental NTS-KEM key generation
+ *
+ *  @param[out] keygen  A pointer of NTSKEM_keygen object created
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_keygen_begin(NTSKEM_keygen** keygen)
 {
     int32_t status = NTS_KEM_BAD_MEMORY_ALLOCATION;
-    int32_t i;
-    ff_unit h[NTS_KEM_PARAM_N];
-    ff_unit a[NTS_KEM_PARAM_N];
-    poly* Gz = NULL;
     NTSKEM_private *priv = NULL;
     NTSKEM *nts_kem_ptr = NULL;
-    matrix_ff2 *Q = NULL;
-#if defined(BENCHMARK)
-    uint64_t start_clock, end_clock;
-#endif
+    NTSKEM_keygen *keygen_ptr = NULL;
     
-    *nts_kem = (NTSKEM *)malloc(sizeof(NTSKEM));
-    if (!(*nts_kem))
-        goto nts_kem_create_fail;
+    *keygen = (NTSKEM_keygen *)calloc(1, sizeof(NTSKEM_keygen));
+    if (!(*keygen))
+        goto nts_kem_keygen_begin_fail;
     
-    nts_kem_ptr = *nts_kem;
+    keygen_ptr = *keygen;
+    keygen_ptr->stage = NTS_KEM_KEYGEN_GOPPA;
+    keygen_ptr->status = NTS_KEM_KEYGEN_IN_PROGRESS;
+    keygen_ptr->nts_kem = (NTSKEM *)malloc(sizeof(NTSKEM));
+    if (!keygen_ptr->nts_kem)
+        goto nts_kem_keygen_begin_fail;
+    
+    nts_kem_ptr = keygen_ptr->nts_kem;
     nts_kem_ptr->public_key = nts_kem_ptr->private_key = NULL;
     nts_kem_ptr->public_key_size = nts_kem_ptr->private_key_size = 0;
+    nts_kem_ptr->priv = NULL;
     priv = (NTSKEM_private *)malloc(sizeof(NTSKEM_private));
     if (!priv)
-        goto nts_kem_create_fail;
+        goto nts_kem_keygen_begin_fail;
     nts_kem_ptr->priv = priv;
     nts_kem_ptr->length = NTS_KEM_PARAM_N;
     nts_kem_ptr->t = NTS_KEM_PARAM_T;
@@ -113,110 +293,145 @@ int nts_kem_create(NTSKEM** nts_kem)
     /* Initialise finite-field */
     priv->ff2m = ff_create(priv->m);
     if (!priv->ff2m)
-        goto nts_kem_create_fail;
+        goto nts_kem_keygen_begin_fail;
     
-    /**
-     * NTS-KEM Key Generation procudure
-     *
-     * Step 1. Randomly generate a monic Goppa polynomial G(z) of degree τ
-     **/
-#if defined(BENCHMARK)
-    start_clock = cpucycles();
-#endif
-    Gz = create_random_goppa_polynomial(priv->ff2m, nts_kem_ptr->t);
-    if (!Gz)
-        goto nts_kem_create_fail;
-#if defined(BENCHMARK)
-    end_clock = cpucycles();
-    fprintf(stdout, "# KeyGen : (1) random_goppa_polynomial consumes %" PRId64 " cycles\n", end_clock-start_clock);
-#endif
-
-    /**
-     * Step 2. Randomly generate a permutation vector p of length n,
-     *         representing a permutation π_p on the set of n elements
-     *
-     * Let p = (p_0, p_1, ..., p_{n-1}) and let a sequence
-     * a = (a_0, a_1, ..., a_{n-1}), by applying permutation
-     * defined by p to vector a, we have the sequence a in
-     * the following order: 
-     *     a = (a_{p_0}, a_{p_1}, ..., a_{p_{n-1}})
-     *
-     * Obviously we can also define the permutation vector p
-     * as a permutation matrix P. But the vector p is 
-     * preferred for storage efficiency.
-     *
-     * Note that the permutation defined by p may need
-     * to be altered, and this is captured by permutation
-     * ρ, see create_matrix_G method.
-     **/
-#if defined(BENCHMARK)
-    start_clock = cpucycles();
-#endif
-    for (i=0; i<NTS_KEM_PARAM_N; i++) {
-        priv->p[i] = i;
+    /* Placeholder for the Goppa polynomial G(z) */
+    keygen_ptr->Gz = init_poly(1 << priv->m);
+    if (!keygen_ptr->Gz)
+        goto nts_kem_keygen_begin_fail;
+    keygen_ptr->Gz->degree = nts_kem_ptr->t;
+    
+    status = NTS_KEM_SUCCESS;
+nts_kem_keygen_begin_fail:
+    if (status != NTS_KEM_SUCCESS) {
+        nts_kem_keygen_release(keygen_ptr);
+        *keygen = NULL;
     }
-    fisher_yates_shuffle(priv->p);
-#if defined(BENCHMARK)
-    end_clock = cpucycles();
-    fprintf(stdout, "# KeyGen : (2) random_permutation consumes %" PRId64 " cycles\n", end_clock-start_clock);
-#endif
     
-    /**
-     * Step 3. Construct a generator matrix in the reduced row echelon
-     *         form G = [ I_k | Q ] of a permuted code
-     **/
+    return status;
+}
 
-#if defined(BENCHMARK)
-    start_clock = cpucycles();
-#endif
-    Q = create_matrix_G(nts_kem_ptr, Gz, a, h);
-    if (Q == NULL)
-        goto nts_kem_create_fail;
-#if defined(BENCHMARK)
-    end_clock = cpucycles();
-    fprintf(stdout, "# KeyGen : (3) create_matrix_G consumes %" PRId64 " cycles\n", end_clock-start_clock);
-#endif
+/**
+ *  Begin an incremental NTS-KEM key generation whose randomness
+ *  is derived from a seed
+ *
+ *  @param[out] keygen  A pointer of NTSKEM_keygen object created
+ *  @param[in]  seed    The seed of NTS_KEM_SEED_SIZE bytes
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_keygen_begin_from_seed(NTSKEM_keygen** keygen, const uint8_t *seed)
+{
+    int32_t status;
     
-    /**
-     * Step 4. Randomly generate vector z where |z| = ℓ
-     **/
-    randombytes(priv->z, NTS_KEM_KEY_SIZE);
+    if (!seed)
+        return NTS_KEM_BAD_PARAMETERS;
     
-    /**
-     * Step 5. Partion vectors a = (a_a | a_b | a_c) and h = (h_a | h_b | h_c)
-     *         and let a* = (a_b | a_c) and  h* = (h_b | h_c)
-     **/
-    memcpy(priv->a, &a[NTS_KEM_PARAM_A], NTS_KEM_PARAM_BC*sizeof(ff_unit));
-    memcpy(priv->h, &h[NTS_KEM_PARAM_A], NTS_KEM_PARAM_BC*sizeof(ff_unit));
+    status = nts_kem_keygen_begin(keygen);
+    if (status != NTS_KEM_SUCCESS)
+        return status;
+    
+    (*keygen)->seeded = 1;
+    xof_source_init(&(*keygen)->rng, seed);
+    
+    return NTS_KEM_SUCCESS;
+}
 
-    /**
-     * The NTS-KEM public key is (Q, τ, l), where l = kNTSKEMKeysize
-     * and NTS-KEM private key is (a*, h*, p)
-     *
-     * Serialise the public and private key pair
-     **/
-    if ((NTS_KEM_SUCCESS != serialise_public_key(nts_kem_ptr, Q)) ||
-        (NTS_KEM_SUCCESS != serialise_private_key(nts_kem_ptr, Q)))
-        goto nts_kem_create_fail;
+/**
+ *  Advance an incremental NTS-KEM key generation
+ *
+ *  @note
+ *  The key generation is broken down into a sequence of short
+ *  steps: one trial of Goppa polynomial, the permutation, the
+ *  construction of the parity-check matrix, one stripe of the
+ *  M4RI elimination and so on. Steps are executed until either
+ *  the key generation is complete or the number of CPU cycles
+ *  consumed reaches `budget_cycles`. At least one step is
+ *  executed on every call.
+ *
+ *  @param[in,out] keygen         The key generation state
+ *  @param[in]     budget_cycles  The CPU cycles budget of this call
+ *  @return NTS_KEM_KEYGEN_IN_PROGRESS if more steps are required,
+ *          NTS_KEM_SUCCESS if the key generation is complete,
+ *          otherwise a negative error code {@see nts_kem_errors.h}
+ **/
+int nts_kem_keygen_step(NTSKEM_keygen* keygen, uint64_t budget_cycles)
+{
+    uint64_t start_clock;
     
-    status = NTS_KEM_SUCCESS;
-nts_kem_create_fail:
-    if (Gz) {
-        zero_poly(Gz);
-        free_poly(Gz);
-        Gz = NULL;
+    if (!keygen)
+        return NTS_KEM_BAD_PARAMETERS;
+    
+    start_clock = cpucycles();
+    while (keygen->status == NTS_KEM_KEYGEN_IN_PROGRESS) {
+        keygen->status = keygen_advance(keygen);
+        if (cpucycles() - start_clock >= budget_cycles)
+            break;
     }
-    free_matrix_ff2(Q);
-    if (status != NTS_KEM_SUCCESS) {
-        if (nts_kem_ptr) {
-            nts_kem_release(nts_kem_ptr);
-            nts_kem_ptr = NULL;
-        }
+    
+    return keygen->status;
+}
+
+/**
+ *  Complete an incremental NTS-KEM key generation
+ *
+ *  @note
+ *  Any remaining steps of the key generation are executed
+ *  without a cycle budget. The key generation state is
+ *  released in all cases.
+ *
+ *  @param[in]  keygen   The key generation state
+ *  @param[out] nts_kem  A pointer of NTSKEM object created
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_keygen_finish(NTSKEM_keygen* keygen, NTSKEM** nts_kem)
+{
+    int32_t status;
+    
+    if (!keygen || !nts_kem)
+        return NTS_KEM_BAD_PARAMETERS;
+    
+    *nts_kem = NULL;
+    status = nts_kem_keygen_step(keygen, UINT64_MAX);
+    if (status == NTS_KEM_SUCCESS) {
+        *nts_kem = keygen->nts_kem;
+        keygen->nts_kem = NULL;
     }
+    nts_kem_keygen_release(keygen);
     
     return status;
 }
 
+/**
+ *  Release an incremental NTS-KEM key generation state
+ *
+ *  @param[in] keygen  A pointer to an NTSKEM_keygen object
+ **/
+void nts_kem_keygen_release(NTSKEM_keygen* keygen)
+{
+    if (keygen) {
+        if (keygen->m4r.A)
+            m4r_rref_final(&keygen->m4r);
+        if (keygen->H) {
+            zero_matrix_ff2(keygen->H);
+            free_matrix_ff2(keygen->H);
+        }
+        free_matrix_ff2(keygen->Q);
+        if (keygen->Gz) {
+            zero_poly(keygen->Gz);
+            free_poly(keygen->Gz);
+        }
+        if (keygen->nts_kem)
+            nts_kem_release(keygen->nts_kem);
+        CT_memset(keygen->a, 0, sizeof(keygen->a));
+        CT_memset(keygen->h, 0, sizeof(keygen->h));
+        if (keygen->seeded)
+            xof_source_release(&keygen->rng);
+        free(keygen);
+    }
+}
+
 /**
  *  Initialise an NTS-KEM object from a buffer containing the private key
  *
@@ -263,8 +478,14 @@ int nts_kem_init_from_private_key(NTSKEM** nts_kem,
     if (!priv->ff2m)
         goto nts_kem_init_fail;
     
+    /* Keep a copy of the private key blob, the public-key is read from it */
+    nts_kem_ptr->private_key = (uint8_t *)mem_alloc_large(NTS_KEM_PRIVATE_KEY_SIZE);
+    if (!nts_kem_ptr->private_key)
+        goto nts_kem_init_fail;
+    memcpy(nts_kem_ptr->private_key, ptr, NTS_KEM_PRIVATE_KEY_SIZE);
+    
     /* Deserialise the private key blob */
-    if (deserialise_private_key(nts_kem_ptr, ptr) != NTS_KEM_SUCCESS) {
+    if (deserialise_private_key(nts_kem_ptr, nts_kem_ptr->private_key) != NTS_KEM_SUCCESS) {
         goto nts_kem_init_fail;
     }
     
@@ -280,6 +501,24 @@ nts_kem_init_fail:
     return status;
 }
 
+/**
+ *  Enable or disable 2 MB pages for the keys, the matrices of the key
+ *  generation and the syndrome matrices allocated subsequently
+ *
+ *  @note
+ *  The public key is read in full by every encapsulation, and the
+ *  key generation eliminates matrices larger still. In 4 KB pages,
+ *  their accesses need hundreds of TLB entries per key.
+ *  {@see mem_alloc_large}
+ *
+ *  @param[in] enable  Non-zero to enable huge pages
+ *  @return Whether huge pages were enabled
+ **/
+int nts_kem_huge_pages(int enable)
+{
+    return mem_huge_pages(enable);
+}
+
 /**
  *  Release the NTS-KEM object
  *
@@ -304,10 +543,10 @@ void nts_kem_release(NTSKEM *nts_kem)
         nts_kem->priv = NULL;
         
         if (nts_kem->public_key)
-            free(nts_kem->public_key);
+            mem_free_large(nts_kem->public_key);
         if (nts_kem->private_key) {
             CT_memset(nts_kem->private_key, 0, NTS_KEM_PRIVATE_KEY_SIZE);
-            free(nts_kem->private_key);
+            mem_free_large(nts_kem->private_key);
         }
         nts_kem->public_key_size = 0;
         nts_kem->private_key_size = 0;
@@ -350,6 +589,26 @@ int nts_kem_ciphertext_size(const NTSKEM *nts_kem)
 int nts_kem_encapsulate(const uint8_t *pk,
                         uint8_t *c_ast,
                         uint8_t *k_r)
+{
+    NTSKEM_iovec iov = { c_ast, NTS_KEM_CIPHERTEXT_SIZE };
+    
+    return nts_kem_encapsulate_iov(pk, &iov, 1, k_r);
+}
+
+/**
+ *  NTS-KEM encapsulation to a fragmented ciphertext
+ *
+ *  @param[in]  pk      The pointer to NTS-KEM public key
+ *  @param[out] c_ast   The fragments of the NTS-KEM ciphertext
+ *  @param[in]  iovcnt  The number of fragments
+ *  @param[out] k_r     The pointer to the encapsulated key
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_encapsulate_iov(const uint8_t *pk,
+                            const NTSKEM_iovec *c_ast,
+                            size_t iovcnt,
+                            uint8_t *k_r)
 {
     int status = NTS_KEM_BAD_MEMORY_ALLOCATION;
     uint8_t e[NTS_KEM_PARAM_CEIL_N_BYTE];
@@ -363,6 +622,9 @@ int nts_kem_encapsulate(const uint8_t *pk,
         return NTS_KEM_BAD_KEY_LENGTH;
     }
     
+    if (!pk || !k_r || !is_valid_ciphertext_iov(c_ast, iovcnt))
+        return NTS_KEM_BAD_PARAMETERS;
+    
 #if defined(BENCHMARK)
     start_clock = cpucycles();
 #endif
@@ -379,7 +641,7 @@ int nts_kem_encapsulate(const uint8_t *pk,
     /**
      * Steps 3-6 are in encapsulate() method
      **/
-    status = encapsulate(e, pk, c_ast, k_r);
+    status = encapsulate(e, pk, c_ast, iovcnt, k_r, NULL);
 
 #if defined(BENCHMARK)
     end_clock = cpucycles();
@@ -391,6 +653,80 @@ int nts_kem_encapsulate(const uint8_t *pk,
     return status;
 }
 
+/**
+ *  NTS-KEM encapsulation of a batch of keys
+ *
+ *  @note
+ *  A single seed is drawn from randombytes for the whole batch,
+ *  {@see nts_kem_encapsulate_batch_from_seed}
+ *
+ *  @param[in,out] jobs   The encapsulations
+ *  @param[in]     count  The number of encapsulations
+ *  @return NTS_KEM_SUCCESS if the batch is processed, the outcome of each
+ *          encapsulation is in its status, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_encapsulate_batch(NTSKEM_encap_job* jobs,
+                              size_t count)
+{
+    int status;
+    uint8_t seed[NTS_KEM_SEED_SIZE];
+    
+    status = randombytes(seed, NTS_KEM_SEED_SIZE);
+    if (status == NTS_KEM_SUCCESS)
+        status = nts_kem_encapsulate_batch_from_seed(jobs, count, seed);
+    CT_memset(seed, 0, NTS_KEM_SEED_SIZE);
+    
+    return status;
+}
+
+/**
+ *  NTS-KEM encapsulation of a batch of keys whose randomness is
+ *  derived from a seed
+ *
+ *  @note
+ *  The error vectors of the jobs are drawn one after the other from
+ *  the SHAKE256 stream of the seed, as the random permutation of the
+ *  key generation from a seed is, {@see nts_kem_create_from_seed}.
+ *  A single call to randombytes is thus made for the whole batch,
+ *  rather than one per 128 random bits of each error vector.
+ *
+ *  @param[in,out] jobs   The encapsulations
+ *  @param[in]     count  The number of encapsulations
+ *  @param[in]     seed   The seed of NTS_KEM_SEED_SIZE bytes
+ *  @return NTS_KEM_SUCCESS if the batch is processed, the outcome of each
+ *          encapsulation is in its status, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_encapsulate_batch_from_seed(NTSKEM_encap_job* jobs,
+                                        size_t count,
+                                        const uint8_t *seed)
+{
+    size_t i;
+    uint8_t e[NTS_KEM_PARAM_CEIL_N_BYTE];
+    NTSKEM_iovec iov;
+    xof_source rng;
+    
+    if (!jobs || !seed)
+        return NTS_KEM_BAD_PARAMETERS;
+    
+    xof_source_init(&rng, seed);
+    for (i=0; i<count; i++) {
+        if (!jobs[i].pk || !jobs[i].c_ast || !jobs[i].k_r) {
+            jobs[i].status = NTS_KEM_BAD_PARAMETERS;
+            continue;
+        }
+        random_vector_xof(NTS_KEM_PARAM_T, NTS_KEM_PARAM_N, e, &rng);
+        iov.base = jobs[i].c_ast;
+        iov.len = NTS_KEM_CIPHERTEXT_SIZE;
+        jobs[i].status = encapsulate(e, jobs[i].pk, &iov, 1, jobs[i].k_r, NULL);
+    }
+    CT_memset(e, 0, NTS_KEM_PARAM_CEIL_N_BYTE);
+    xof_source_release(&rng);
+    
+    return NTS_KEM_SUCCESS;
+}
+
 /**
  *  NTS-KEM decapsulation
  *
@@ -404,934 +740,2506 @@ int nts_kem_decapsulate(const uint8_t *sk,
                         const uint8_t *c_ast,
                         uint8_t *k_r)
 {
-    int32_t i, status = NTS_KEM_BAD_MEMORY_ALLOCATION;
-    int32_t extended_error = 0;
-    uint32_t checksum = 0, error_weight = 0;
-    NTSKEM *nts_kem = NULL;
-    NTSKEM_private *priv = NULL;
-    vector in_cipher[NTS_KEM_PARAM_BC_VEC];
-    __m128i vec_syndromes[3][NTS_KEM_PARAM_M] = {{{0}}};
-    __m128i sigma[2][NTS_KEM_PARAM_M];
-    vector evals[NTS_KEM_PARAM_N_VEC][NTS_KEM_PARAM_M];
-    vector error[NTS_KEM_PARAM_N_VEC];
-    vector allones = _mm256_set1_epi64x(-1);
-    uint8_t *e_prime = NULL;
-    ff_unit syndromes[2*NTS_KEM_PARAM_T];
-    uint8_t e[NTS_KEM_PARAM_CEIL_N_BYTE];
-    uint8_t kr_a[kNTSKEMKeysize];
-    uint8_t kr_b[kNTSKEMKeysize];
-    uint8_t digest_buf[kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_N_BYTE];
-    uint8_t c_buf[NTS_KEM_PARAM_CEIL_N_BYTE];
-    uint8_t c_prime[NTS_KEM_CIPHERTEXT_SIZE] __attribute__((aligned(16)));
-    uint64_t mux_selector;
-    uint64_t *out_ptr = NULL;
-    const uint64_t *in_left_ptr = NULL;
-    const uint64_t *in_right_ptr = NULL;
-#if defined(BENCHMARK)
-    uint64_t start_clock, end_clock;
-#endif
-    
-    if (!k_r || !c_ast) {
-        status = NTS_KEM_BAD_PARAMETERS;
-        goto decapsulation_failure;
-    }
+    NTSKEM_iovec iov = { (void *)c_ast, NTS_KEM_CIPHERTEXT_SIZE };
     
-    /**
-     * Construct an NTS object from private key
-     **/
-    if (NTS_KEM_SUCCESS != nts_kem_init_from_private_key(&nts_kem, sk, NTS_KEM_PRIVATE_KEY_SIZE))
-        goto decapsulation_failure;
+    if (!c_ast)
+        return NTS_KEM_BAD_PARAMETERS;
     
-    priv = nts_kem->priv;
+    return nts_kem_decapsulate_iov(sk, &iov, 1, k_r);
+}
 
-    /**
-     * Load the full input ciphertext c' = (1_a | c_b | c_c)
-     **/
-    CT_memset(c_buf, 0xFF, NTS_KEM_PARAM_CEIL_K_BYTE - NTS_KEM_KEY_SIZE);
-    for (i=0; i<kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_R_BYTE; i++) {
-        c_buf[NTS_KEM_PARAM_CEIL_K_BYTE - kNTSKEMKeysize + i] = c_ast[i];
-    }
+/**
+ *  NTS-KEM decapsulation of a fragmented ciphertext
+ *
+ *  @param[in]  sk      The pointer to NTS-KEM private key
+ *  @param[in]  c_ast   The fragments of the NTS-KEM ciphertext
+ *  @param[in]  iovcnt  The number of fragments
+ *  @param[out] k_r     The pointer to the encapsulated key
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decapsulate_iov(const uint8_t *sk,
+                            const NTSKEM_iovec *c_ast,
+                            size_t iovcnt,
+                            uint8_t *k_r)
+{
+    int32_t status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+    NTSKEM nts_kem;
+    NTSKEM_private priv;
+    NTSKEM_decap_ctx ctx = { &nts_kem, NULL, NULL, NULL, NULL, NULL, NULL, 0 };
+    
+    if (!sk || !k_r || !is_valid_ciphertext_iov(c_ast, iovcnt))
+        return NTS_KEM_BAD_PARAMETERS;
     
     /**
-     * Load the input ciphertext c* to a vectorised array
+     * Construct an NTS object from private key, a, h, p and z are
+     * unpacked to the stack and the public key is read from sk
      **/
-    load_input_ciphertext(in_cipher, c_ast);
+    load_private_key(&nts_kem, &priv, sk);
+    
+    status = decapsulate(&ctx, c_ast, iovcnt, k_r);
+    
+    CT_memset(&priv, 0, sizeof(priv));
+    
+    return status;
+}
 
-    /**
-     * Step 1a. Rewrite the vector a = (a_b | a_c) and h = (h_b | h_c)
-     * Step 1b. Construct a truncated parity-check matrix H*_m from a and h
-     * Step 1c. Compute all 2*τ syndromes of c* as s = (c_b | c_c).(H*_m)^T,
-     *         see Algorithm 2 in the supporting document
-     */
-#if defined(BENCHMARK)
-    start_clock = cpucycles();
-#endif
-    status = compute_syndrome(nts_kem, in_cipher, syndromes);
-    if (status != NTS_KEM_SUCCESS)
-        goto decapsulation_failure;
-#if defined(BENCHMARK)
-    end_clock = cpucycles();
-    fprintf(stdout, "# Decap : (1c) compute_syndrome consumes %" PRId64 " cycles\n", end_clock-start_clock);
-#endif
-    status = NTS_KEM_BAD_MEMORY_ALLOCATION; /* Reset the status value */
-   
-    /**
-     * Step 1d. Compute the error-locator polynomial σ(x)
-     *
-     * Given the syndromes computed earlier, use Berlekamp-Massey algorithm
-     * to obtain the error-locator polynomial σ(x)
-     **/
-    vector_load_2d_128(vec_syndromes, syndromes, 2*NTS_KEM_PARAM_T);
-#if defined(BENCHMARK)
-    start_clock = cpucycles();
-#endif
-    bitslice_bma(sigma, vec_syndromes, &extended_error);
-#if defined(BENCHMARK)
-    end_clock = cpucycles();
-    fprintf(stdout, "# Decap : (1d) berlekamp_massey consumes %" PRId64 " cycles\n", end_clock-start_clock);
-#endif
+/**
+ *  Create an NTS-KEM decapsulation context from a private key
+ *
+ *  @note
+ *  With NTS_KEM_DECAP_SYNDROME_MATRIX, the 2τ·m x (b+c) binary
+ *  syndrome matrix is precomputed from a and h, which turns the
+ *  syndrome computation into a matrix-vector product over the
+ *  ciphertext bits at the cost of around 1 MB per context
+ *
+ *  With NTS_KEM_DECAP_BENES_NETWORK, the permutation p is compiled
+ *  once into the control bits of a Beneš network, around 25 KB, with
+ *  which the error vector and the inputs of the transposed FFT are
+ *  permuted in constant time, {@see benes_permute}. Compiling takes
+ *  tens of milliseconds. Without it, the syndromes are computed by a
+ *  chain of multiplications, which does not depend on p, and the error
+ *  vector is permuted as by {@see nts_kem_decapsulate}.
+ *
+ *  With NTS_KEM_DECAP_PATTERSON, the Goppa polynomial G(z) is recovered
+ *  from h, and errors are located by Patterson's algorithm from the τ
+ *  coefficients of S(z) = Σ c_i/(z - a_i) mod G(z) rather than by the
+ *  Berlekamp-Massey algorithm from 2τ syndromes. This requires G(z)
+ *  to be irreducible, which holds for few keys, otherwise the flag is
+ *  ignored and the context decodes with Berlekamp-Massey, {@see
+ *  nts_kem_decap_ctx_flags}. Combined with NTS_KEM_DECAP_SYNDROME_MATRIX,
+ *  the matrix holds the τ·m rows of S(z) only and is half the size.
+ *
+ *  With NTS_KEM_DECAP_PARALLEL, NTS_KEM_DECAP_WORKERS-1 threads are
+ *  started with the context, and the syndrome computation and the
+ *  re-encoding of each decapsulation are split between them and the
+ *  caller. Every thread has a fixed share of the work and the partial
+ *  results are combined in a fixed order, the output is identical to
+ *  that of a sequential decapsulation. Decapsulations on the same
+ *  context from several threads are serialised.
+ *
+ *  @param[out] ctx         A pointer of NTSKEM_decap_ctx object created
+ *  @param[in]  sk          The pointer to NTS-KEM private key
+ *  @param[in]  flags       Bitwise-OR of NTS_KEM_DECAP_* flags
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decap_ctx_create(NTSKEM_decap_ctx** ctx,
+                             const uint8_t *sk,
+                             uint32_t flags)
+{
+    int32_t status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+    size_t matrix_size = SYNDROME_MATRIX_SIZE;
+    NTSKEM_decap_ctx *ctx_ptr = NULL;
     
-    /**
-     * Step 1e. Compute the roots of the error-locator polynomial σ(x)
-     *
-     * The roots of the error-locating polynomial σ(x) tells us where
-     * the locations of the error are. They can be efficiently computed
-     * using additive FFT over Finite Field
-     **/
-#if defined(BENCHMARK)
-    start_clock = cpucycles();
-#endif
-    /**
-     * Convert the coefficients of the locator polynomial in bit-slice format
-     **/
-    bitslice_fft(evals, sigma);
-#if defined(BENCHMARK)
-    end_clock = cpucycles();
-    fprintf(stdout, "# Decap : (1e) roots_finding consumes %" PRId64 " cycles\n", end_clock-start_clock);
-#endif
-
-    /**
-     * Step 1f. Given Λ, obtain the error vector e_prime
-     *
-     * We know the locations of the error, it's time to correct them,
-     * in other words, we want to obtain e_prime.
-     **/
-#if defined(BENCHMARK)
-    start_clock = cpucycles();
-#endif
-    for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-        error[i] = vector_ff_or(evals[i]);
-        error[i] = _mm256_xor_si256(error[i], allones);
-        error_weight += vector_popcount(error[i]);
+    if (!ctx || !sk)
+        return NTS_KEM_BAD_PARAMETERS;
+    
+    *ctx = (NTSKEM_decap_ctx *)calloc(1, sizeof(NTSKEM_decap_ctx));
+    if (!(*ctx))
+        goto nts_kem_decap_ctx_create_fail;
+    ctx_ptr = *ctx;
+    
+    status = nts_kem_init_from_private_key(&ctx_ptr->nts_kem, sk, NTS_KEM_PRIVATE_KEY_SIZE);
+    if (status != NTS_KEM_SUCCESS) {
+        ctx_ptr->nts_kem = NULL;
+        goto nts_kem_decap_ctx_create_fail;
     }
-    e_prime = (uint8_t *)error;
-    /* Correct the error in the zero-th coordinate if necessary */
-    e_prime[0] |= ((uint8_t)extended_error);
-    error_weight += extended_error;
-#if defined(BENCHMARK)
-    end_clock = cpucycles();
-    fprintf(stdout, "# Decap : (1f) get_e_prime consumes %" PRId64 " cycles\n", end_clock-start_clock);
-#endif
-
-    /**
-     * Step 2. Permute e_prime with permutation p to obtain e
-     *
-     * A countermeasure is added to prevent potential cache timing attack
-     **/
-#if defined(BENCHMARK)
-    start_clock = cpucycles();
-#endif
-    permute_error(e_prime, priv->p, e);
-#if defined(BENCHMARK)
-    end_clock = cpucycles();
-    fprintf(stdout, "# Decap : (2) permute_e consumes %" PRId64 " cycles\n", end_clock-start_clock);
-#endif
-
-
-    /**
-     * Step 4. Encapsulate(pk, e) to produce (c', k_r)
-     **/
-#if defined(BENCHMARK)
-    start_clock = cpucycles();
-#endif
-    encapsulate(e, priv->pk, c_prime, kr_a);
-    /**
-     * Verify that c' = c* and wt(e) = τ
-     **/
-    for (checksum=0,i=0; i<NTS_KEM_CIPHERTEXT_SIZE; i++) {
-        checksum += (c_prime[i] ^ c_ast[i]);
+    
+    if (flags & NTS_KEM_DECAP_PATTERSON) {
+        status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+        if (0 != posix_memalign((void **)&ctx_ptr->patterson, sizeof(vector),
+                                sizeof(NTSKEM_patterson))) {
+            ctx_ptr->patterson = NULL;
+            goto nts_kem_decap_ctx_create_fail;
+        }
+        if (create_patterson(ctx_ptr->nts_kem, ctx_ptr->patterson) != NTS_KEM_SUCCESS) {
+            /* G(z) is reducible, errors are located by Berlekamp-Massey */
+            CT_memset(ctx_ptr->patterson, 0, sizeof(NTSKEM_patterson));
+            free(ctx_ptr->patterson);
+            ctx_ptr->patterson = NULL;
+        }
     }
-    mux_selector = CT_is_equal_zero(checksum) && CT_is_equal(error_weight, NTS_KEM_PARAM_T);
-    status = CT_mux((uint32_t)mux_selector, NTS_KEM_SUCCESS, NTS_KEM_INVALID_CIPHERTEXT);
-    /**
-     * If yes, return k_r; otherwise return SHA3_256(z | c)
-     * where z is part of the private-key and c = (1_a | c_b | c_c)
-     **/
-    memcpy(digest_buf, priv->z, NTS_KEM_KEY_SIZE);
-    memcpy(&digest_buf[NTS_KEM_KEY_SIZE], c_buf, NTS_KEM_PARAM_CEIL_N_BYTE);
-    sha3_256(digest_buf, NTS_KEM_KEY_SIZE + NTS_KEM_PARAM_CEIL_N_BYTE, kr_b);
     
-    out_ptr = (uint64_t *)k_r;
-    in_left_ptr  = (const uint64_t *)kr_a;
-    in_right_ptr = (const uint64_t *)kr_b;
-    for (i=0; i<kNTSKEMKeysize/sizeof(uint64_t); i++) {
-        *out_ptr++ = CT_mux64(mux_selector, *in_left_ptr++, *in_right_ptr++);
+    if (flags & NTS_KEM_DECAP_SYNDROME_MATRIX) {
+        status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+        if (ctx_ptr->patterson)
+            matrix_size = GOPPA_SYNDROME_MATRIX_SIZE;
+        ctx_ptr->syndrome_matrix = (vector *)mem_alloc_large(matrix_size * sizeof(vector));
+        if (!ctx_ptr->syndrome_matrix)
+            goto nts_kem_decap_ctx_create_fail;
+        if (ctx_ptr->patterson)
+            status = create_goppa_syndrome_matrix(ctx_ptr->nts_kem, ctx_ptr->patterson,
+                                                  ctx_ptr->syndrome_matrix);
+        else
+            status = create_syndrome_matrix(ctx_ptr->nts_kem, ctx_ptr->syndrome_matrix);
+        if (status != NTS_KEM_SUCCESS)
+            goto nts_kem_decap_ctx_create_fail;
+    }
+    
+    if (flags & NTS_KEM_DECAP_BENES_NETWORK) {
+        status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+        if (!(ctx_ptr->benes = (uint64_t *)malloc(BENES_SIZE*sizeof(uint64_t))))
+            goto nts_kem_decap_ctx_create_fail;
+        status = benes_compile(ctx_ptr->benes,
+                               ((NTSKEM_private *)ctx_ptr->nts_kem->priv)->p);
+        if (status != NTS_KEM_SUCCESS)
+            goto nts_kem_decap_ctx_create_fail;
+    }
+    
+    if (flags & NTS_KEM_DECAP_PARALLEL) {
+        status = worker_group_create(&ctx_ptr->workers, NTS_KEM_DECAP_WORKERS);
+        if (status != NTS_KEM_SUCCESS)
+            goto nts_kem_decap_ctx_create_fail;
+    }
+    
+    status = NTS_KEM_SUCCESS;
+nts_kem_decap_ctx_create_fail:
+    if (status != NTS_KEM_SUCCESS && ctx_ptr) {
+        nts_kem_decap_ctx_release(ctx_ptr);
+        *ctx = NULL;
     }
-#if defined(BENCHMARK)
-    end_clock = cpucycles();
-    fprintf(stdout, "# Decap : (3) re-encapsulation_and_verification consumes %" PRId64 " cycles\n",
-            end_clock-start_clock);
-#endif
-decapsulation_failure:
-    CT_memset(kr_a, 0, kNTSKEMKeysize);
-    CT_memset(kr_b, 0, kNTSKEMKeysize);
-    CT_memset(e, 0, NTS_KEM_PARAM_CEIL_N_BYTE);
-    CT_memset(e_prime, 0, NTS_KEM_PARAM_CEIL_N_BYTE);
-    CT_memset(c_prime, 0, NTS_KEM_CIPHERTEXT_SIZE);
-    CT_memset(syndromes, 0, sizeof(syndromes));
-    CT_memset(evals, 0, sizeof(evals));
-    if (nts_kem)
-        nts_kem_release(nts_kem);
     
     return status;
 }
 
-/** -------------------- Private helper methods -------------------- **/
+/**
+ *  NTS-KEM decapsulation using a decapsulation context
+ *
+ *  @param[in]  ctx     The decapsulation context
+ *  @param[in]  c_ast   The pointer to the NTS-KEM ciphertext
+ *  @param[out] k_r     The pointer to the encapsulated key
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decap_ctx_decapsulate(const NTSKEM_decap_ctx* ctx,
+                                  const uint8_t *c_ast,
+                                  uint8_t *k_r)
+{
+    NTSKEM_iovec iov = { (void *)c_ast, NTS_KEM_CIPHERTEXT_SIZE };
+    
+    if (!c_ast)
+        return NTS_KEM_BAD_PARAMETERS;
+    
+    return nts_kem_decap_ctx_decapsulate_iov(ctx, &iov, 1, k_r);
+}
 
 /**
- *  Check whether or not a Goppa polynomial is valid
+ *  NTS-KEM decapsulation of a fragmented ciphertext using
+ *  a decapsulation context
  *
  *  @note
- *  Given a Goppa polynomial G(z) over GF(2^m), it's considered
- *  a valid polynomial if it has no roots in the field GF(2^m)
- *  and that it has no repeated factors.
- *
- *  If GCD(G(z), 1+z^{2^m-1}) = 1, this means that G(z) has no
- *  roots in GF(2^m). However, this can be more efficiently done
- *  by means of additive FFT.
- *
- *  If GCD(G(z), G'(z)) = 1, where G'(z) is the formal derivate
- *  of G(z) wrt z, this means that G(z) has no repeated factors.
- *
- *  If the above two conditions are met, G(z) is a valid Goppa
- *  polynomial
+ *  The fragments are gathered into the vectorised ciphertext of the
+ *  syndrome computation, and fed to SHA3-256 one after the other for
+ *  the cache digest and the implicit rejection, without any copy of
+ *  the ciphertext to a contiguous buffer
  *
- *  @param[in] ff2m   The finite field F_{2^m}
- *  @param[in] Gz     The Goppa polynomial G(z)
- *  @return 1 if G(z) is a valid Goppa polynomial, 0 otherwise
+ *  @param[in]  ctx     The decapsulation context
+ *  @param[in]  c_ast   The fragments of the NTS-KEM ciphertext
+ *  @param[in]  iovcnt  The number of fragments
+ *  @param[out] k_r     The pointer to the encapsulated key
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
  **/
-int is_valid_goppa_polynomial(const FF2m *ff2m, const poly *Gz)
+int nts_kem_decap_ctx_decapsulate_iov(const NTSKEM_decap_ctx* ctx,
+                                      const NTSKEM_iovec *c_ast,
+                                      size_t iovcnt,
+                                      uint8_t *k_r)
 {
-    int i, status = 1;
-    __m128i g[2][NTS_KEM_PARAM_M] = {{{0}}};
-    vector v[NTS_KEM_PARAM_N_VEC];
-    vector evals[NTS_KEM_PARAM_N_VEC][NTS_KEM_PARAM_M];
-    poly* Fz = init_poly((1 << ff2m->m));
-    poly* Dz = init_poly((1 << ff2m->m));
-    if (!Fz || !Dz)
-        return 0;
-
-    vector_load_2d_128(g, Gz->coeff, (NTS_KEM_PARAM_T+1));
-    bitslice_fft(evals, g);
-    for (i=0; i<NTS_KEM_PARAM_N_VEC && status; i++) {
-        v[i] = vector_ff_or(evals[i]);
-        v[i] = ~v[i];
-        status = ((~(v[i][3] | -v[i][3]) >> 63) &
-                  (~(v[i][2] | -v[i][2]) >> 63) &
-                  (~(v[i][1] | -v[i][1]) >> 63) &
-                  (~(v[i][0] | -v[i][0]) >> 63));   /* status is 1 if v[i] is 0 */
-    }
-    if (status) {
-        /* Does it have repeated roots? */
-        /* F(z) = GCD(G(z), d/dz G(z))  */
-        status = 0;
-        if (formal_derivative_poly(Gz, Dz)) {
-            if (gcd_poly(ff2m, Gz, Dz, Fz)) {
-                status = (Fz->degree < 1);
-            }
-        }
-    }
+    int status;
+    uint8_t digest[DECAP_CACHE_DIGEST_SIZE];
     
-    zero_poly(Dz); free_poly(Dz);
-    zero_poly(Fz); free_poly(Fz);
-    CT_memset(g, 0, sizeof(g));
-    CT_memset(v, 0, sizeof(v));
-    CT_memset(evals, 0, sizeof(evals));
+    if (!ctx || !k_r || !is_valid_ciphertext_iov(c_ast, iovcnt))
+        return NTS_KEM_BAD_PARAMETERS;
+    
+    if (!ctx->cache)
+        return decapsulate(ctx, c_ast, iovcnt, k_r);
+    
+    hash_ciphertext(c_ast, iovcnt, digest);
+    if (!decap_cache_lookup(ctx->cache, digest, k_r, &status)) {
+        status = decapsulate(ctx, c_ast, iovcnt, k_r);
+        if (status == NTS_KEM_SUCCESS || status == NTS_KEM_INVALID_CIPHERTEXT)
+            decap_cache_insert(ctx->cache, digest, k_r, status);
+    }
     
     return status;
 }
 
 /**
- *  Create a random Goppa polynomial
+ *  Enable, resize or disable the cache of decapsulation results
+ *  of a decapsulation context
  *
  *  @note
- *  This function implements Step 1 of NTS-KEM
- *  Key Generation procedure as described in the
- *  submitted NIST document.
+ *  The cache maps SHA3-256 of a ciphertext to the key and status of
+ *  its decapsulation, implicitly rejected ciphertexts included, so a
+ *  ciphertext that is received again is not decapsulated again. The
+ *  results are wiped when they are evicted or expire, and the current
+ *  results are wiped by this function.
  *
- *  @note
- *  Use the method {@see is_valid_goppa_polynomial} to check 
- *  whether or not a Goppa polynomial is a valid one
+ *  @param[in,out] ctx       The decapsulation context
+ *  @param[in]     capacity  The maximum number of results, 0 to disable
+ *  @param[in]     ttl       The lifetime of a result in seconds,
+ *                           0 if results do not expire
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decap_ctx_set_cache(NTSKEM_decap_ctx* ctx,
+                                size_t capacity,
+                                uint32_t ttl)
+{
+    if (!ctx)
+        return NTS_KEM_BAD_PARAMETERS;
+    
+    decap_cache_release(ctx->cache);
+    ctx->cache = NULL;
+    if (!capacity)
+        return NTS_KEM_SUCCESS;
+    
+    return decap_cache_create(&ctx->cache, capacity, ttl);
+}
+
+/**
+ *  Return the private key of a decapsulation context
  *
- *  @param[in] ff2m   The finite field F_{2^m}
- *  @param[in] degree The degree of the Goppa polynomial
- *  @return a valid Goppa polynomial on success, NULL otherwise
+ *  @param[in] ctx  The decapsulation context
+ *  @return The serialised private key, valid as long as the context
  **/
-poly* create_random_goppa_polynomial(const FF2m *ff2m, int degree)
+const uint8_t* nts_kem_decap_ctx_private_key(const NTSKEM_decap_ctx* ctx)
 {
-#if defined(BENCHMARK)
-    int32_t count = 0;
-#endif
-    uint8_t buffer[NTS_KEM_PARAM_CEIL_R_BYTE];
-    poly *Gz = init_poly(1 << ff2m->m);
-    if (!Gz)
-        return NULL;
+    return ctx ? ctx->nts_kem->private_key : NULL;
+}
+
+/**
+ *  Return the flags in effect of a decapsulation context
+ *
+ *  @param[in] ctx  The decapsulation context
+ *  @return Bitwise-OR of NTS_KEM_DECAP_* flags
+ **/
+uint32_t nts_kem_decap_ctx_flags(const NTSKEM_decap_ctx* ctx)
+{
+    uint32_t flags = 0;
+    
+    if (ctx) {
+        if (ctx->syndrome_matrix)
+            flags |= NTS_KEM_DECAP_SYNDROME_MATRIX;
+        if (ctx->benes)
+            flags |= NTS_KEM_DECAP_BENES_NETWORK;
+        if (ctx->patterson)
+            flags |= NTS_KEM_DECAP_PATTERSON;
+        if (ctx->workers)
+            flags |= NTS_KEM_DECAP_PARALLEL;
+    }
     
-    Gz->degree = degree;
-    do {
-        /**
-         * (a) Sample uniformly at random mτ bits (or (n-k)/8 bytes) of random data
-         *     and sequentially assign m bits for g_i in g = (g_0,g_1,...,g_{τ-1})
-         **/
-        randombytes(buffer, NTS_KEM_PARAM_CEIL_R_BYTE);
-        unpack_buffer(buffer, Gz->coeff, NTS_KEM_PARAM_T);
-        
-        /**
-         * (b) Set g_τ = 1 and let G(z) = \sum_{i=0}^τ g_iz^i
-         **/
-        Gz->coeff[ Gz->degree ] = 1;
-        
-        /**
-         * (c) Restart to step (a) if the first coefficient is 0 or G(z) has roots
-         *     in F_{2^m} or G(z) has repeated roots in any extension field.
-         **/
-#if defined(BENCHMARK)
-        ++count;
-#endif
-    } while (!Gz->coeff[0] || !is_valid_goppa_polynomial(ff2m, Gz));
-    CT_memset(buffer, 0, sizeof(buffer));
-#if defined(BENCHMARK)
-    fprintf(stdout, "# num_Gz_trials %d\n", count);
-#endif
+    return flags;
+}
+
+/**
+ *  Return the memory held by a decapsulation context
+ *
+ *  @param[in] ctx  The decapsulation context
+ *  @return The size in bytes, excluding the cache of results and the
+ *          segment of an attached context
+ **/
+size_t nts_kem_decap_ctx_size(const NTSKEM_decap_ctx* ctx)
+{
+    size_t size = 0;
+    
+    if (ctx)
+        size = sizeof(NTSKEM_decap_ctx) + sizeof(NTSKEM) + sizeof(NTSKEM_private);
+    if (ctx && !ctx->segment) {
+        size += NTS_KEM_PRIVATE_KEY_SIZE;
+        if (ctx->syndrome_matrix)
+            size += (ctx->patterson ? GOPPA_SYNDROME_MATRIX_SIZE :
+                                      SYNDROME_MATRIX_SIZE) * sizeof(vector);
+        if (ctx->benes)
+            size += BENES_SIZE*sizeof(uint64_t);
+        if (ctx->patterson)
+            size += sizeof(NTSKEM_patterson);
+    }
+    
+    return size;
+}
+
+/**
+ *  The sections of a published decapsulation context, {@see
+ *  nts_kem_decap_ctx_publish}. The segment holds no pointer, every
+ *  section is located by its offset from the start of the segment.
+ **/
+typedef struct {
+    uint8_t magic[8];               /* SHARED_CTX_MAGIC, written last */
+    uint32_t version;
+    uint32_t m;                     /* The parameters of the key */
+    uint32_t t;
+    uint32_t flags;                 /* NTS_KEM_DECAP_* flags of the sections */
+    uint64_t size;                  /* The size of the segment */
+    uint64_t private_key;           /* The serialised private key */
+    uint64_t syndrome_matrix;       /* Optional, 0 if absent */
+    uint64_t benes;                 /* Optional, 0 if absent */
+    uint64_t patterson;             /* Optional, 0 if absent */
+} shared_ctx_header;
+
+/**
+ *  Lay out a section of a published context and return its offset
+ **/
+static uint64_t shared_ctx_section(shared_ctx_header* header, size_t size)
+{
+    uint64_t offset = header->size;
+    
+    header->size = (offset + size + SHARED_CTX_ALIGN - 1) & ~(uint64_t)(SHARED_CTX_ALIGN - 1);
+    
+    return offset;
+}
 
-    return Gz;
+/**
+ *  Check that a section of a published context lies within its segment
+ **/
+static int shared_ctx_valid_section(const shared_ctx_header* header, uint64_t offset, size_t size)
+{
+    return offset >= sizeof(shared_ctx_header) && !(offset & (SHARED_CTX_ALIGN - 1)) &&
+           offset <= header->size && size <= header->size - offset;
 }
 
 /**
- *  Given a Goppa polynomial, construct the reduced row echelon
- *  generator matrix G = [I | Q] of the Goppa code
+ *  Publish a decapsulation context in a named shared-memory segment
  *
  *  @note
- *  This function implements Step 3 of NTS-KEM Key Generation
- *  procedure as described in the submitted NIST document.
+ *  The segment holds the private key and the precomputed tables of
+ *  the context at fixed offsets, so it can be mapped at any address.
+ *  It is created with the permissions of the owner only and remains
+ *  until {@see nts_kem_decap_ctx_unpublish}, even after the process
+ *  exits. The worker threads and the cache of the context are not
+ *  published.
  *
- *  @param[in]  nts_kem  The pointer to an NTS-KEM object
- *  @param[in]  Gz       The Goppa polynomial G(z)
- *  @param[out] a        The vector containing all elements of
- *                       F_2^m, permuted by vector p
- *  @param[out] h        The evaluation of G(z) based on the
- *                       elements in vector a
- *  @return A pointer to matrix Q over F_2
+ *  @param[in] ctx   The decapsulation context
+ *  @param[in] name  The name of the segment, as of shm_open
+ *  @return NTS_KEM_SUCCESS on success, NTS_KEM_BAD_PARAMETERS if the
+ *          name is taken, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
  **/
-matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
-                            const poly* Gz,
-                            ff_unit *a,
-                            ff_unit *h)
+int nts_kem_decap_ctx_publish(const NTSKEM_decap_ctx* ctx,
+                              const char *name)
 {
-    NTSKEM_private* priv = (NTSKEM_private *)nts_kem->priv;
-    int32_t i, j, l, rank;
-    matrix_ff2 *H = NULL, *Q = NULL;
-    packed_t *v_ptr = NULL;
-    ff_unit f;
-    vector av0[NTS_KEM_PARAM_N_VEC][NTS_KEM_PARAM_M];
+    int fd;
+    int32_t status = NTS_KEM_UNEXPECTED_ERROR;
+    size_t matrix_size = 0;
+    uint8_t *segment = MAP_FAILED;
+    shared_ctx_header header;
+    
+    if (!ctx || !name)
+        return NTS_KEM_BAD_PARAMETERS;
+    
+    memset(&header, 0, sizeof(header));
+    header.version = SHARED_CTX_VERSION;
+    header.m = NTS_KEM_PARAM_M;
+    header.t = NTS_KEM_PARAM_T;
+    header.size = sizeof(header);
+    header.private_key = shared_ctx_section(&header, NTS_KEM_PRIVATE_KEY_SIZE);
+    if (ctx->syndrome_matrix) {
+        header.flags |= NTS_KEM_DECAP_SYNDROME_MATRIX;
+        matrix_size = (ctx->patterson ? GOPPA_SYNDROME_MATRIX_SIZE :
+                                        SYNDROME_MATRIX_SIZE) * sizeof(vector);
+        header.syndrome_matrix = shared_ctx_section(&header, matrix_size);
+    }
+    if (ctx->benes) {
+        header.flags |= NTS_KEM_DECAP_BENES_NETWORK;
+        header.benes = shared_ctx_section(&header, BENES_SIZE*sizeof(uint64_t));
+    }
+    if (ctx->patterson) {
+        header.flags |= NTS_KEM_DECAP_PATTERSON;
+        header.patterson = shared_ctx_section(&header, sizeof(NTSKEM_patterson));
+    }
+    
+    if ((fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR)) < 0)
+        return (errno == EEXIST) ? NTS_KEM_BAD_PARAMETERS : NTS_KEM_UNEXPECTED_ERROR;
+    if (ftruncate(fd, (off_t)header.size))
+        goto nts_kem_decap_ctx_publish_fail;
+    segment = (uint8_t *)mmap(NULL, header.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (segment == MAP_FAILED) {
+        status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+        goto nts_kem_decap_ctx_publish_fail;
+    }
+    
+    memcpy(segment, &header, sizeof(header));
+    memcpy(&segment[header.private_key], ctx->nts_kem->private_key, NTS_KEM_PRIVATE_KEY_SIZE);
+    if (ctx->syndrome_matrix)
+        memcpy(&segment[header.syndrome_matrix], ctx->syndrome_matrix, matrix_size);
+    if (ctx->benes)
+        memcpy(&segment[header.benes], ctx->benes, BENES_SIZE*sizeof(uint64_t));
+    if (ctx->patterson)
+        memcpy(&segment[header.patterson], ctx->patterson, sizeof(NTSKEM_patterson));
+    
+    /* A segment is valid for attaching once its magic is in place */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(segment, SHARED_CTX_MAGIC, sizeof(header.magic));
+    munmap(segment, header.size);
+    
+    status = NTS_KEM_SUCCESS;
+nts_kem_decap_ctx_publish_fail:
+    if (status != NTS_KEM_SUCCESS)
+        shm_unlink(name);
+    close(fd);
+    
+    return status;
+}
+
+/**
+ *  Attach to a decapsulation context published in a named
+ *  shared-memory segment
+ *
+ *  @note
+ *  The segment is mapped read-only and its tables are used in place,
+ *  only the unpacked private key is held by the context itself. The
+ *  tables of the published context are used whatever the flags, of
+ *  which only NTS_KEM_DECAP_PARALLEL applies, to start the threads of
+ *  this context.
+ *
+ *  @param[out] ctx    A pointer of NTSKEM_decap_ctx object created
+ *  @param[in]  name   The name of the segment, as of shm_open
+ *  @param[in]  flags  Bitwise-OR of NTS_KEM_DECAP_* flags
+ *  @return NTS_KEM_SUCCESS on success, NTS_KEM_KEY_NOT_FOUND if there
+ *          is no such segment, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decap_ctx_attach(NTSKEM_decap_ctx** ctx,
+                             const char *name,
+                             uint32_t flags)
+{
+    int fd;
+    int32_t status = NTS_KEM_BAD_PARAMETERS;
+    struct stat st;
+    uint8_t *segment = MAP_FAILED;
+    const shared_ctx_header *header = NULL;
+    NTSKEM_decap_ctx *ctx_ptr = NULL;
+    
+    if (!ctx || !name)
+        return NTS_KEM_BAD_PARAMETERS;
+    *ctx = NULL;
+    
+    if ((fd = shm_open(name, O_RDONLY, 0)) < 0)
+        return (errno == ENOENT) ? NTS_KEM_KEY_NOT_FOUND : NTS_KEM_UNEXPECTED_ERROR;
+    if (fstat(fd, &st) || st.st_size < (off_t)sizeof(shared_ctx_header)) {
+        close(fd);
+        return NTS_KEM_BAD_PARAMETERS;
+    }
+    segment = (uint8_t *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED)
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    
+    header = (const shared_ctx_header *)segment;
+    if (memcmp(header->magic, SHARED_CTX_MAGIC, sizeof(header->magic)))
+        goto nts_kem_decap_ctx_attach_fail;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (header->version != SHARED_CTX_VERSION || header->m != NTS_KEM_PARAM_M ||
+        header->t != NTS_KEM_PARAM_T || header->size != (uint64_t)st.st_size ||
+        !shared_ctx_valid_section(header, header->private_key, NTS_KEM_PRIVATE_KEY_SIZE))
+        goto nts_kem_decap_ctx_attach_fail;
+    if ((header->flags & NTS_KEM_DECAP_SYNDROME_MATRIX) &&
+        !shared_ctx_valid_section(header, header->syndrome_matrix,
+                                  ((header->flags & NTS_KEM_DECAP_PATTERSON) ?
+                                   GOPPA_SYNDROME_MATRIX_SIZE : SYNDROME_MATRIX_SIZE) * sizeof(vector)))
+        goto nts_kem_decap_ctx_attach_fail;
+    if ((header->flags & NTS_KEM_DECAP_BENES_NETWORK) &&
+        !shared_ctx_valid_section(header, header->benes, BENES_SIZE*sizeof(uint64_t)))
+        goto nts_kem_decap_ctx_attach_fail;
+    if ((header->flags & NTS_KEM_DECAP_PATTERSON) &&
+        !shared_ctx_valid_section(header, header->patterson, sizeof(NTSKEM_patterson)))
+        goto nts_kem_decap_ctx_attach_fail;
+    
+    status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+    if (!(ctx_ptr = (NTSKEM_decap_ctx *)calloc(1, sizeof(NTSKEM_decap_ctx))))
+        goto nts_kem_decap_ctx_attach_fail;
+    ctx_ptr->segment = segment;
+    ctx_ptr->segment_size = (size_t)st.st_size;
+    if (!(ctx_ptr->nts_kem = (NTSKEM *)calloc(1, sizeof(NTSKEM))) ||
+        !(ctx_ptr->nts_kem->priv = malloc(sizeof(NTSKEM_private))))
+        goto nts_kem_decap_ctx_attach_fail;
+    
+    /**
+     * Unpack a, h, p and z to the context, the public key and the
+     * tables are read from the segment
+     **/
+    load_private_key(ctx_ptr->nts_kem, ctx_ptr->nts_kem->priv, &segment[header->private_key]);
+    ctx_ptr->nts_kem->private_key = &segment[header->private_key];
+    if (header->flags & NTS_KEM_DECAP_SYNDROME_MATRIX)
+        ctx_ptr->syndrome_matrix = (vector *)&segment[header->syndrome_matrix];
+    if (header->flags & NTS_KEM_DECAP_BENES_NETWORK)
+        ctx_ptr->benes = (uint64_t *)&segment[header->benes];
+    if (header->flags & NTS_KEM_DECAP_PATTERSON)
+        ctx_ptr->patterson = (NTSKEM_patterson *)&segment[header->patterson];
+    
+    if (flags & NTS_KEM_DECAP_PARALLEL) {
+        status = worker_group_create(&ctx_ptr->workers, NTS_KEM_DECAP_WORKERS);
+        if (status != NTS_KEM_SUCCESS)
+            goto nts_kem_decap_ctx_attach_fail;
+    }
+    
+    *ctx = ctx_ptr;
+    status = NTS_KEM_SUCCESS;
+nts_kem_decap_ctx_attach_fail:
+    if (status != NTS_KEM_SUCCESS) {
+        if (ctx_ptr)
+            nts_kem_decap_ctx_release(ctx_ptr);
+        else
+            munmap(segment, (size_t)st.st_size);
+    }
+    
+    return status;
+}
+
+/**
+ *  Remove the name of a published decapsulation context
+ *
+ *  @note
+ *  The contexts attached to it remain valid, its memory is freed
+ *  once the last of them is released.
+ *
+ *  @param[in] name  The name of the segment, as of shm_open
+ *  @return NTS_KEM_SUCCESS on success, NTS_KEM_KEY_NOT_FOUND if there
+ *          is no such segment, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decap_ctx_unpublish(const char *name)
+{
+    if (!name)
+        return NTS_KEM_BAD_PARAMETERS;
+    if (shm_unlink(name))
+        return (errno == ENOENT) ? NTS_KEM_KEY_NOT_FOUND : NTS_KEM_UNEXPECTED_ERROR;
+    
+    return NTS_KEM_SUCCESS;
+}
+
+/**
+ *  Release a decapsulation context
+ *
+ *  @param[in] ctx  The decapsulation context
+ **/
+void nts_kem_decap_ctx_release(NTSKEM_decap_ctx* ctx)
+{
+    if (ctx) {
+        decap_cache_release(ctx->cache);
+        worker_group_release(ctx->workers);
+        if (ctx->segment) {
+            /* The tables and the serialised key belong to the segment */
+            if (ctx->nts_kem) {
+                if (ctx->nts_kem->priv) {
+                    CT_memset(ctx->nts_kem->priv, 0, sizeof(NTSKEM_private));
+                    free(ctx->nts_kem->priv);
+                }
+                free(ctx->nts_kem);
+            }
+            munmap(ctx->segment, ctx->segment_size);
+        }
+        else {
+            if (ctx->syndrome_matrix) {
+                CT_memset(ctx->syndrome_matrix, 0,
+                          (ctx->patterson ? GOPPA_SYNDROME_MATRIX_SIZE :
+                                            SYNDROME_MATRIX_SIZE) * sizeof(vector));
+                mem_free_large(ctx->syndrome_matrix);
+            }
+            if (ctx->benes) {
+                CT_memset(ctx->benes, 0, BENES_SIZE*sizeof(uint64_t));
+                free(ctx->benes);
+            }
+            if (ctx->patterson) {
+                CT_memset(ctx->patterson, 0, sizeof(NTSKEM_patterson));
+                free(ctx->patterson);
+            }
+            nts_kem_release(ctx->nts_kem);
+        }
+        free(ctx);
+    }
+}
+
+/** -------------------- Private helper methods -------------------- **/
+
+/**
+ *  The syndrome computation of a decapsulation shared by a worker group
+ **/
+typedef struct {
+    const NTSKEM *nts_kem;
+    const vector *H;            /* The syndrome matrix, or NULL */
+    const uint64_t *benes;      /* The Beneš network of p without H */
+    const ff_unit *weight;
+    const vector *c_ptr;
+    ff_unit *s;
+    int32_t count;
+} syndrome_job;
+
+/**
+ *  Compute a share of the syndromes, a range of the rows of the
+ *  syndrome matrix or every count-th pass of the transposed FFT
+ **/
+static void syndrome_worker(void *arg, int index, int count)
+{
+    syndrome_job *job = (syndrome_job *)arg;
+    int32_t begin, end;
+    
+    if (job->H) {
+        begin = (job->count * index) / count;
+        end = (job->count * (index + 1)) / count;
+        compute_syndrome_from_matrix(&job->H[begin*NTS_KEM_PARAM_M*NTS_KEM_PARAM_BC_VEC],
+                                     job->c_ptr, &job->s[begin], end - begin);
+    }
+    else {
+        compute_syndrome_blocks(job->nts_kem, job->benes, job->weight, job->c_ptr,
+                                job->s, job->count, index, count);
+    }
+}
+
+/**
+ *  Step 1c of the decapsulation, compute the syndromes of c*
+ *
+ *  @param[in]  ctx     The decapsulation context
+ *  @param[in]  c_ast   The fragments of the NTS-KEM ciphertext
+ *  @param[in]  iovcnt  The number of fragments
+ *  @param[out] st      The decapsulation state
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int decap_syndromes(const NTSKEM_decap_ctx* ctx,
+                    const NTSKEM_iovec *c_ast,
+                    size_t iovcnt,
+                    decap_state *st)
+{
+    int32_t status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+    const NTSKEM *nts_kem = ctx->nts_kem;
+    NTSKEM_private *priv = nts_kem->priv;
+    vector in_cipher[NTS_KEM_PARAM_BC_VEC];
+#if defined(BENCHMARK)
+    uint64_t start_clock, end_clock;
+#endif
+    
+    /**
+     * Load the input ciphertext c* to a vectorised array
+     **/
+    load_input_ciphertext(in_cipher, c_ast, iovcnt);
+
+    /**
+     * Step 1a. Rewrite the vector a = (a_b | a_c) and h = (h_b | h_c)
+     * Step 1b. Construct a truncated parity-check matrix H*_m from a and h
+     * Step 1c. Compute all 2*τ syndromes of c* as s = (c_b | c_c).(H*_m)^T,
+     *         see Algorithm 2 in the supporting document
+     */
+#if defined(BENCHMARK)
+    start_clock = cpucycles();
+#endif
+    if (ctx->workers && (ctx->syndrome_matrix || ctx->benes)) {
+        syndrome_job job;
+        
+        job.nts_kem = nts_kem;
+        job.H = ctx->syndrome_matrix;
+        job.benes = ctx->benes;
+        job.weight = ctx->patterson ? ctx->patterson->w : priv->h;
+        job.c_ptr = in_cipher;
+        job.s = st->syndromes;
+        job.count = ctx->patterson ? NTS_KEM_PARAM_T : 2*NTS_KEM_PARAM_T;
+        worker_group_run(ctx->workers, syndrome_worker, &job);
+        status = NTS_KEM_SUCCESS;
+    }
+    else if (ctx->patterson) {
+        /**
+         * Patterson decoding needs the power sums of c_i.a_i^j/G(a_i)
+         * for j < τ only, or directly S(z) from the matrix
+         **/
+        if (ctx->syndrome_matrix)
+            status = compute_syndrome_from_matrix(ctx->syndrome_matrix, in_cipher,
+                                                  st->syndromes, NTS_KEM_PARAM_T);
+        else
+            status = compute_syndrome(nts_kem, ctx->benes, ctx->patterson->w, in_cipher,
+                                      st->syndromes, NTS_KEM_PARAM_T);
+    }
+    else if (ctx->syndrome_matrix)
+        status = compute_syndrome_from_matrix(ctx->syndrome_matrix, in_cipher,
+                                              st->syndromes, 2*NTS_KEM_PARAM_T);
+    else
+        status = compute_syndrome(nts_kem, ctx->benes, priv->h, in_cipher,
+                                  st->syndromes, 2*NTS_KEM_PARAM_T);
+#if defined(BENCHMARK)
+    end_clock = cpucycles();
+    fprintf(stdout, "# Decap : (1c) compute_syndrome consumes %" PRId64 " cycles\n", end_clock-start_clock);
+#endif
+    CT_memset(in_cipher, 0, sizeof(in_cipher));
+    
+    return status;
+}
+
+/**
+ *  Step 1d of the decapsulation, compute the error-locator polynomial σ(x)
+ *
+ *  @note
+ *  The Berlekamp-Massey algorithm only depends on the syndromes,
+ *  Patterson's algorithm also depends on G(z) of the context
+ *
+ *  @param[in]     ctx  The decapsulation context
+ *  @param[in,out] st   The decapsulation state
+ **/
+void decap_locate(const NTSKEM_decap_ctx* ctx, decap_state *st)
+{
+    __m128i vec_syndromes[3][NTS_KEM_PARAM_M] = {{{0}}};
+    vector goppa_syndrome[1][NTS_KEM_PARAM_M];
+#if defined(BENCHMARK)
+    uint64_t start_clock, end_clock;
+#endif
+    
+    /**
+     * Step 1d. Compute the error-locator polynomial σ(x)
+     *
+     * Given the syndromes computed earlier, use Berlekamp-Massey algorithm
+     * to obtain the error-locator polynomial σ(x), or Patterson's algorithm
+     * on S(z) if enabled in the context. The latter gives σ(x) with a root
+     * at 0 for an error there, hence no extended error.
+     **/
+    st->extended_error = 0;
+    if (ctx->patterson) {
+        vector_load_2d_256(goppa_syndrome, st->syndromes, NTS_KEM_PARAM_T);
+#if defined(BENCHMARK)
+        start_clock = cpucycles();
+#endif
+        if (!ctx->syndrome_matrix)
+            bitslice_patterson_syndrome(goppa_syndrome[0], goppa_syndrome[0],
+                                        ctx->patterson->g);
+        bitslice_patterson(st->sigma, goppa_syndrome[0], ctx->patterson->g,
+                           ctx->patterson->sqrt_z);
+#if defined(BENCHMARK)
+        end_clock = cpucycles();
+        fprintf(stdout, "# Decap : (1d) patterson consumes %" PRId64 " cycles\n", end_clock-start_clock);
+#endif
+        CT_memset(goppa_syndrome, 0, sizeof(goppa_syndrome));
+    }
+    else {
+        vector_load_2d_128(vec_syndromes, st->syndromes, 2*NTS_KEM_PARAM_T);
+#if defined(BENCHMARK)
+        start_clock = cpucycles();
+#endif
+        bitslice_bma(st->sigma, vec_syndromes, &st->extended_error);
+#if defined(BENCHMARK)
+        end_clock = cpucycles();
+        fprintf(stdout, "# Decap : (1d) berlekamp_massey consumes %" PRId64 " cycles\n", end_clock-start_clock);
+#endif
+        CT_memset(vec_syndromes, 0, sizeof(vec_syndromes));
+    }
+}
+
+/**
+ *  Steps 1e and 1f of the decapsulation, compute the error vector e'
+ *  from the roots of σ(x). It does not depend on the private key.
+ *
+ *  @param[in,out] st   The decapsulation state
+ **/
+void decap_roots(decap_state *st)
+{
+    uint8_t *e_prime = NULL;
+#if defined(BENCHMARK)
+    uint64_t start_clock, end_clock;
+#endif
+    
+    /**
+     * Step 1e. Compute the roots of the error-locator polynomial σ(x)
+     *
+     * The roots of the error-locating polynomial σ(x) tells us where
+     * the locations of the error are. They can be efficiently computed
+     * using additive FFT over Finite Field
+     **/
+#if defined(BENCHMARK)
+    start_clock = cpucycles();
+#endif
+    /**
+     * The FFT reduces the evaluations of σ(x) to the root indicators,
+     * i.e. the error vector in inverse permuted order, together with
+     * its weight
+     **/
+    st->error_weight = bitslice_fft_roots(st->error, st->sigma);
+#if defined(BENCHMARK)
+    end_clock = cpucycles();
+    fprintf(stdout, "# Decap : (1e) roots_finding consumes %" PRId64 " cycles\n", end_clock-start_clock);
+#endif
+
+    /**
+     * Step 1f. Given Λ, obtain the error vector e_prime
+     *
+     * We know the locations of the error, it's time to correct them,
+     * in other words, we want to obtain e_prime.
+     **/
+#if defined(BENCHMARK)
+    start_clock = cpucycles();
+#endif
+    e_prime = (uint8_t *)st->error;
+    /* Correct the error in the zero-th coordinate if necessary */
+    e_prime[0] |= ((uint8_t)st->extended_error);
+    st->error_weight += st->extended_error;
+#if defined(BENCHMARK)
+    end_clock = cpucycles();
+    fprintf(stdout, "# Decap : (1f) get_e_prime consumes %" PRId64 " cycles\n", end_clock-start_clock);
+#endif
+}
+
+/**
+ *  Steps 2 to 4 of the decapsulation, permute e' to e, re-encapsulate
+ *  and output either k_r or the implicit rejection key
+ *
+ *  @param[in]  ctx     The decapsulation context
+ *  @param[in]  st      The decapsulation state
+ *  @param[in]  c_ast   The fragments of the NTS-KEM ciphertext
+ *  @param[in]  iovcnt  The number of fragments
+ *  @param[out] k_r     The pointer to the encapsulated key
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int decap_verify(const NTSKEM_decap_ctx* ctx,
+                 decap_state *st,
+                 const NTSKEM_iovec *c_ast,
+                 size_t iovcnt,
+                 uint8_t *k_r)
+{
+    int32_t i, status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+    size_t j, l, offset;
+    uint32_t checksum = 0;
+    NTSKEM_private *priv = ctx->nts_kem->priv;
+    sha3_256_state sha3;
+    const uint8_t *c_ptr = NULL;
+    uint8_t e[NTS_KEM_PARAM_CEIL_N_BYTE];
+    uint8_t kr_a[kNTSKEMKeysize];
+    uint8_t kr_b[kNTSKEMKeysize];
+    uint8_t ones[NTS_KEM_PARAM_CEIL_K_BYTE - NTS_KEM_KEY_SIZE];
+    uint8_t c_prime[NTS_KEM_CIPHERTEXT_SIZE] __attribute__((aligned(16)));
+    NTSKEM_iovec c_prime_iov = { c_prime, NTS_KEM_CIPHERTEXT_SIZE };
+    uint64_t mux_selector;
+    uint64_t *out_ptr = NULL;
+    const uint64_t *in_left_ptr = NULL;
+    const uint64_t *in_right_ptr = NULL;
+#if defined(BENCHMARK)
+    uint64_t start_clock, end_clock;
+#endif
+    
+    /**
+     * Step 2. Permute e_prime with permutation p to obtain e
+     *
+     * With the Beneš network of p in constant time, otherwise by
+     * indexing e_prime with p
+     **/
+#if defined(BENCHMARK)
+    start_clock = cpucycles();
+#endif
+    if (ctx->benes) {
+        benes_permute((uint64_t *)st->error, ctx->benes);
+        memcpy(e, st->error, NTS_KEM_PARAM_CEIL_N_BYTE);
+    }
+    else {
+        permute_error((const uint8_t *)st->error, priv->p, e);
+    }
+#if defined(BENCHMARK)
+    end_clock = cpucycles();
+    fprintf(stdout, "# Decap : (2) permute_e consumes %" PRId64 " cycles\n", end_clock-start_clock);
+#endif
+
+
+    /**
+     * Step 4. Encapsulate(pk, e) to produce (c', k_r)
+     **/
+#if defined(BENCHMARK)
+    start_clock = cpucycles();
+#endif
+    encapsulate(e, priv->pk, &c_prime_iov, 1, kr_a, ctx->workers);
+    /**
+     * Verify that c' = c* and wt(e) = τ
+     **/
+    for (checksum=0,offset=0,j=0; j<iovcnt; j++) {
+        c_ptr = (const uint8_t *)c_ast[j].base;
+        for (l=0; l<c_ast[j].len; l++) {
+            checksum += (c_prime[offset++] ^ c_ptr[l]);
+        }
+    }
+    mux_selector = CT_is_equal_zero(checksum) && CT_is_equal(st->error_weight, NTS_KEM_PARAM_T);
+    status = CT_mux((uint32_t)mux_selector, NTS_KEM_SUCCESS, NTS_KEM_INVALID_CIPHERTEXT);
+    /**
+     * If yes, return k_r; otherwise return SHA3_256(z | c)
+     * where z is part of the private-key and c = (1_a | c_b | c_c)
+     * is the full input ciphertext, absorbed fragment by fragment
+     **/
+    memset(ones, 0xFF, sizeof(ones));
+    sha3_256_init(&sha3);
+    sha3_256_absorb(&sha3, priv->z, NTS_KEM_KEY_SIZE);
+    sha3_256_absorb(&sha3, ones, sizeof(ones));
+    for (j=0; j<iovcnt; j++) {
+        sha3_256_absorb(&sha3, (const uint8_t *)c_ast[j].base, c_ast[j].len);
+    }
+    sha3_256_final(&sha3, kr_b);
+    
+    out_ptr = (uint64_t *)k_r;
+    in_left_ptr  = (const uint64_t *)kr_a;
+    in_right_ptr = (const uint64_t *)kr_b;
+    for (i=0; i<kNTSKEMKeysize/sizeof(uint64_t); i++) {
+        *out_ptr++ = CT_mux64(mux_selector, *in_left_ptr++, *in_right_ptr++);
+    }
+#if defined(BENCHMARK)
+    end_clock = cpucycles();
+    fprintf(stdout, "# Decap : (3) re-encapsulation_and_verification consumes %" PRId64 " cycles\n",
+            end_clock-start_clock);
+#endif
+    CT_memset(kr_a, 0, kNTSKEMKeysize);
+    CT_memset(kr_b, 0, kNTSKEMKeysize);
+    CT_memset(e, 0, NTS_KEM_PARAM_CEIL_N_BYTE);
+    CT_memset(c_prime, 0, NTS_KEM_CIPHERTEXT_SIZE);
+    
+    return status;
+}
+
+/**
+ *  NTS-KEM decapsulation
+ *
+ *  @note
+ *  The stages 1d to 1f do not depend on the private key with the
+ *  Berlekamp-Massey algorithm, but they are not shared between the
+ *  ciphertexts of several keys. bitslice_bma and bitslice_fft slice
+ *  one polynomial over the lanes of a vector, which one ciphertext
+ *  already fills, so that no pass could serve a second ciphertext.
+ *
+ *  @param[in]  ctx     The decapsulation context
+ *  @param[in]  c_ast   The fragments of the NTS-KEM ciphertext
+ *  @param[in]  iovcnt  The number of fragments
+ *  @param[out] k_r     The pointer to the encapsulated key
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int decapsulate(const NTSKEM_decap_ctx* ctx,
+                const NTSKEM_iovec *c_ast,
+                size_t iovcnt,
+                uint8_t *k_r)
+{
+    int32_t status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+    decap_state st;
+    
+    status = decap_syndromes(ctx, c_ast, iovcnt, &st);
+    if (status == NTS_KEM_SUCCESS) {
+        decap_locate(ctx, &st);
+        decap_roots(&st);
+        status = decap_verify(ctx, &st, c_ast, iovcnt, k_r);
+    }
+    CT_memset(&st, 0, sizeof(st));
+    
+    return status;
+}
+
+/**
+ *  Check whether or not a Goppa polynomial is valid
+ *
+ *  @note
+ *  Given a Goppa polynomial G(z) over GF(2^m), it's considered
+ *  a valid polynomial if it has no roots in the field GF(2^m)
+ *  and that it has no repeated factors.
+ *
+ *  If GCD(G(z), 1+z^{2^m-1}) = 1, this means that G(z) has no
+ *  roots in GF(2^m). However, this can be more efficiently done
+ *  by means of additive FFT.
+ *
+ *  If GCD(G(z), G'(z)) = 1, where G'(z) is the formal derivate
+ *  of G(z) wrt z, this means that G(z) has no repeated factors.
+ *
+ *  If the above two conditions are met, G(z) is a valid Goppa
+ *  polynomial
+ *
+ *  @param[in] ff2m   The finite field F_{2^m}
+ *  @param[in] Gz     The Goppa polynomial G(z)
+ *  @return 1 if G(z) is a valid Goppa polynomial, 0 otherwise
+ **/
+int is_valid_goppa_polynomial(const FF2m *ff2m, const poly *Gz)
+{
+    int status = 1;
+    __m128i g[2][NTS_KEM_PARAM_M] = {{{0}}};
+    vector v[NTS_KEM_PARAM_N_VEC];
+    poly* Fz = init_poly((1 << ff2m->m));
+    poly* Dz = init_poly((1 << ff2m->m));
+    if (!Fz || !Dz)
+        return 0;
+
+    vector_load_2d_128(g, Gz->coeff, (NTS_KEM_PARAM_T+1));
+    status = (bitslice_fft_roots(v, g) == 0);
+    if (status) {
+        /* Does it have repeated roots? */
+        /* F(z) = GCD(G(z), d/dz G(z))  */
+        status = 0;
+        if (formal_derivative_poly(Gz, Dz)) {
+            if (gcd_poly(ff2m, Gz, Dz, Fz)) {
+                status = (Fz->degree < 1);
+            }
+        }
+    }
+    
+    zero_poly(Dz); free_poly(Dz);
+    zero_poly(Fz); free_poly(Fz);
+    CT_memset(g, 0, sizeof(g));
+    CT_memset(v, 0, sizeof(v));
+    
+    return status;
+}
+
+/**
+ *  Sample a random Goppa polynomial candidate
+ *
+ *  @note
+ *  This function implements one trial of Step 1 of NTS-KEM
+ *  Key Generation procedure as described in the submitted
+ *  NIST document.
+ *
+ *  @note
+ *  Use the method {@see is_valid_goppa_polynomial} to check 
+ *  whether or not a Goppa polynomial is a valid one
+ *
+ *  @param[in,out] keygen The key generation state, the degree
+ *                        of its Goppa polynomial must have been set
+ *  @return 1 if G(z) is a valid Goppa polynomial, 0 otherwise
+ **/
+int sample_goppa_polynomial(NTSKEM_keygen* keygen)
+{
+    int status;
+    poly *Gz = keygen->Gz;
+    const FF2m *ff2m = ((NTSKEM_private *)keygen->nts_kem->priv)->ff2m;
+    uint8_t buffer[NTS_KEM_PARAM_CEIL_R_BYTE];
+    
+    /**
+     * (a) Sample uniformly at random mτ bits (or (n-k)/8 bytes) of random data
+     *     and sequentially assign m bits for g_i in g = (g_0,g_1,...,g_{τ-1})
+     **/
+    keygen_randombytes(keygen, buffer, NTS_KEM_PARAM_CEIL_R_BYTE);
+    unpack_buffer(buffer, Gz->coeff, NTS_KEM_PARAM_T);
+    
+    /**
+     * (b) Set g_τ = 1 and let G(z) = \sum_{i=0}^τ g_iz^i
+     **/
+    Gz->coeff[ Gz->degree ] = 1;
+    
+    /**
+     * (c) Reject if the first coefficient is 0 or G(z) has roots
+     *     in F_{2^m} or G(z) has repeated roots in any extension field.
+     **/
+    status = (Gz->coeff[0] && is_valid_goppa_polynomial(ff2m, Gz));
+    CT_memset(buffer, 0, sizeof(buffer));
+    
+    return status;
+}
+
+/**
+ *  Given a Goppa polynomial, construct the parity-check
+ *  matrix H of the Goppa code
+ *
+ *  @note
+ *  This function implements the first part of Step 3 of NTS-KEM
+ *  Key Generation procedure as described in the submitted NIST
+ *  document. The reduced row echelon generator matrix G = [I | Q]
+ *  is obtained by eliminating H, {@see m4r_rref}, followed by
+ *  {@see permute_matrix_H} and {@see extract_matrix_Q}.
+ *
+ *  @param[in]  nts_kem  The pointer to an NTS-KEM object
+ *  @param[in]  Gz       The Goppa polynomial G(z)
+ *  @param[out] a        The vector containing all elements of
+ *                       F_2^m, permuted by vector p
+ *  @param[out] h        The evaluation of G(z) based on the
+ *                       elements in vector a
+ *  @return A pointer to matrix H over F_2
+ **/
+matrix_ff2* create_matrix_H(const NTSKEM* nts_kem,
+                            const poly* Gz,
+                            ff_unit *a,
+                            ff_unit *h)
+{
+    NTSKEM_private* priv = (NTSKEM_private *)nts_kem->priv;
+    int32_t i, j, l;
+    matrix_ff2 *H = NULL;
+    vector av0[NTS_KEM_PARAM_N_VEC][NTS_KEM_PARAM_M];
     vector hv0[NTS_KEM_PARAM_N_VEC][NTS_KEM_PARAM_M];
     vector hv1[NTS_KEM_PARAM_N_VEC][NTS_KEM_PARAM_M];
-    uint16_t a_prime[NTS_KEM_PARAM_N];
+    uint16_t ga[NTS_KEM_PARAM_N];
     __m128i g[2][NTS_KEM_PARAM_M] = {{{0}}};
 	
     vector vh[NTS_KEM_PARAM_N_VEC][NTS_KEM_PARAM_M];
-    uint64_t v[NTS_KEM_PARAM_N_DIV_64];
 
-    /**
-     * Let a = π_p(a′) = (a_{p_0},a_{p_1},...,a_{p_{n−1}}) ∈ F^n_{2^m}
-     * be the sequence obtained by ordering the elements of
-     * a′ = (B[0], B[1], ..., B[n-1]) according to π_p.
-     **/
-    a_prime[0] = 0x00;
-    for (i=1; i<nts_kem->length; i++) {
-        a_prime[i] = 0;
-        for (j=0; j<priv->ff2m->m; j++) {
-            a_prime[i] ^= (((i & (1 << j)) >> j) * priv->ff2m->basis[j]);
-        }
-    }
+    /**
+     * Let a = π_p(a′) = (a_{p_0},a_{p_1},...,a_{p_{n−1}}) ∈ F^n_{2^m}
+     * be the sequence obtained by ordering the elements of
+     * a′ = (B[0], B[1], ..., B[n-1]) according to π_p. As B[i] is
+     * the sum of the basis elements over the bits of i, a_i is
+     * computed from the bits of p_i without a table lookup.
+     **/
+    for (i=0; i<nts_kem->length; i++) {
+        a[i] = 0;
+        for (j=0; j<priv->ff2m->m; j++) {
+            a[i] ^= (((priv->p[i] >> j) & 1) * priv->ff2m->basis[j]);
+        }
+    }
+    
+    /**
+     * Perform additive FFT on Gz to obtain an evaluation of G(z)
+     * at points B[0], B[1], B[2], ..., B[n-1]
+     **/
+    vector_load_2d_128(g, Gz->coeff, (NTS_KEM_PARAM_T+1));
+    bitslice_fft(vh, g);
+    
+    /**
+     * Permute the evaluations with p to obtain G(a_i), in constant
+     * time by sorting, {@see benes_gather_sorted}
+     **/
+    vector_store_2d_256(ga, (const __m256i (*)[])vh, NTS_KEM_PARAM_N);
+    benes_gather_sorted(ga, priv->p);
+    vector_load_2d_256(hv0, ga, NTS_KEM_PARAM_N);
+    vector_load_2d_256(av0, a, NTS_KEM_PARAM_N);
+    
+    /**
+     * Calculate G(a_i)^{-2} using vectorised implementation
+     **/
+    for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
+        vector_ff_sqr_inv_13(priv->ff2m, hv1[i], hv0[i]);
+    }
+    vector_store_2d_256(h, (const __m256i (*)[])hv1, NTS_KEM_PARAM_N);
+    
+    /* Obtain the parity-check matrix H from h */
+    if (!(H = calloc_matrix_ff2(Gz->degree * priv->ff2m->m, (1 << priv->m))))
+        goto create_matrix_H_fail;
+    /* The first batch of NTS_KEM_PARAM_M rows of parity-check matrix */
+    for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
+        for (j=0; j<NTS_KEM_PARAM_M; j++) {
+            memcpy(row_ptr_matrix_ff2(H, j) + (i*BLOCK_SIZE >> 3),
+                   &hv1[i][j],
+                   UINT64_SIZE*sizeof(uint64_t));
+        }
+    }
+    /* h_1 = h_0 * a */
+    for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
+        vector_ff_mul_13(priv->ff2m, hv0[i], hv1[i], av0[i]);
+    }
+    /* The second batch of NTS_KEM_PARAM_M rows of parity-check matrix */
+    for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
+        for (j=0; j<NTS_KEM_PARAM_M; j++) {
+            memcpy(row_ptr_matrix_ff2(H, j+NTS_KEM_PARAM_M) + (i*BLOCK_SIZE >> 3),
+                   &hv0[i][j],
+                   UINT64_SIZE*sizeof(uint64_t));
+        }
+    }
+    for (l=2; l<Gz->degree; l+=2) {
+        /* h_l = h_{l-1} * a */
+        for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
+            vector_ff_mul_13(priv->ff2m, hv1[i], hv0[i], av0[i]);
+        }
+        /* The l-th batch of NTS_KEM_PARAM_M rows of parity-check matrix */
+        for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
+            for (j=0; j<NTS_KEM_PARAM_M; j++) {
+                memcpy(row_ptr_matrix_ff2(H, j+(l*NTS_KEM_PARAM_M)) + (i*BLOCK_SIZE >> 3),
+                       &hv1[i][j],
+                       UINT64_SIZE*sizeof(uint64_t));
+            }
+        }
+        /* h_l = h_{l-1} * a */
+        for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
+            vector_ff_mul_13(priv->ff2m, hv0[i], hv1[i], av0[i]);
+        }
+        /* The (l+1)-th batch of NTS_KEM_PARAM_M rows of parity-check matrix */
+        for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
+            for (j=0; j<NTS_KEM_PARAM_M; j++) {
+                memcpy(row_ptr_matrix_ff2(H, j+((l+1)*NTS_KEM_PARAM_M)) + (i*BLOCK_SIZE >> 3),
+                       &hv0[i][j],
+                       UINT64_SIZE*sizeof(uint64_t));
+            }
+        }
+    }
+
+create_matrix_H_fail:
+    CT_memset(ga, 0, sizeof(ga));
+    
+    return H;
+}
+
+/**
+ *  Perform permutation on the columns of H such that the last (n-k)
+ *  columns of H form a (n-k)x(n-k) identity matrix
+ *
+ *  @note
+ *  Let ρ be the permutation that makes H in the form that we need.
+ *  The permutation vector p generated in Step 2 is updated with ρ
+ *  and the vectors a and h are permuted too.
+ *
+ *  @note
+ *  The rows of H are processed from the last one upwards, at most
+ *  `count` rows are processed in one call.
+ *
+ *  @param[in]     nts_kem  The pointer to an NTS-KEM object
+ *  @param[in,out] H        The parity-check matrix in reduced row
+ *                          echelon form
+ *  @param[in,out] a        The vector a
+ *  @param[in,out] h        The vector h
+ *  @param[in]     row      The row to start from
+ *  @param[in,out] col      The column offset of the pivot of `row`
+ *  @param[in]     count    The maximum number of rows to process
+ *  @return The next row to be processed, negative when complete
+ **/
+int32_t permute_matrix_H(const NTSKEM* nts_kem,
+                         matrix_ff2* H,
+                         ff_unit *a,
+                         ff_unit *h,
+                         int32_t row,
+                         int32_t *col,
+                         int32_t count)
+{
+    NTSKEM_private* priv = (NTSKEM_private *)nts_kem->priv;
+    int32_t i, j = *col;
+    packed_t *v_ptr = NULL;
+    ff_unit f;
+    
+    for (i=row; i>=0 && i>row-count; i--) {
+        v_ptr = (packed_t *)row_ptr_matrix_ff2(H, i);
+        while (!is_bit_set(v_ptr, H->ncols-j-1)) ++j;
+        
+        column_swap_matrix_ff2(H, NTS_KEM_PARAM_K + i, H->ncols-j-1);
+
+        /* Update the order of permutation p */
+        f = priv->p[ NTS_KEM_PARAM_K + i ];
+        priv->p[ NTS_KEM_PARAM_K + i ] = priv->p[ H->ncols-j-1 ];
+        priv->p[ H->ncols-j-1 ] = f;
+        
+        /* Update the order of vector a */
+        f = a[ NTS_KEM_PARAM_K + i ];
+        a[ NTS_KEM_PARAM_K + i ] = a[ H->ncols-j-1 ];
+        a[ H->ncols-j-1 ] = f;
+        
+        /* Update the order of vector a */
+        f = h[ NTS_KEM_PARAM_K + i ];
+        h[ NTS_KEM_PARAM_K + i ] = h[ H->ncols-j-1 ];
+        h[ H->ncols-j-1 ] = f;
+    }
+    *col = j;
+    
+    return i;
+}
+
+/**
+ *  Extract the rows [row_start, row_end) of H = [ Q^T | I ]
+ *  as the corresponding columns of Q
+ *
+ *  @param[out] Q          The matrix Q of dimension k x (n-k)
+ *  @param[in]  H          The parity-check matrix H = [ Q^T | I ]
+ *  @param[in]  row_start  The first row of H
+ *  @param[in]  row_end    One past the last row of H
+ **/
+void extract_matrix_Q(matrix_ff2* Q,
+                      const matrix_ff2* H,
+                      int32_t row_start,
+                      int32_t row_end)
+{
+    int32_t i, j;
+    packed_t *v_ptr = NULL;
+    
+    for (i=row_start; i<row_end; i++) {
+        v_ptr = (packed_t *)row_ptr_matrix_ff2(H, i);
+        for (j=0; j<NTS_KEM_PARAM_K; j++) {
+            bit_set_value((packed_t *)row_ptr_matrix_ff2(Q, j),
+                          i,
+                          bit_value(v_ptr, j));
+        }
+    }
+}
+
+/**
+ *  Execute one step of the NTS-KEM Key Generation procedure
+ *
+ *  @param[in,out] keygen  The key generation state
+ *  @return NTS_KEM_KEYGEN_IN_PROGRESS if more steps are required,
+ *          NTS_KEM_SUCCESS if the key generation is complete,
+ *          otherwise a negative error code {@see nts_kem_errors.h}
+ **/
+int32_t keygen_advance(NTSKEM_keygen* keygen)
+{
+    NTSKEM *nts_kem = keygen->nts_kem;
+    NTSKEM_private *priv = (NTSKEM_private *)nts_kem->priv;
+    int32_t i, rank, status = NTS_KEM_KEYGEN_IN_PROGRESS;
+#if defined(BENCHMARK)
+    int32_t stage = keygen->stage;
+    uint64_t start_clock = cpucycles();
+#endif
+    
+    switch (keygen->stage) {
+        case NTS_KEM_KEYGEN_GOPPA:
+            /**
+             * NTS-KEM Key Generation procudure
+             *
+             * Step 1. Randomly generate a monic Goppa polynomial G(z) of degree τ
+             *
+             * One candidate polynomial is sampled per step
+             **/
+#if defined(BENCHMARK)
+            ++keygen->num_trials;
+#endif
+            if (sample_goppa_polynomial(keygen))
+                keygen->stage = NTS_KEM_KEYGEN_PERMUTATION;
+            break;
+        case NTS_KEM_KEYGEN_PERMUTATION:
+            /**
+             * Step 2. Randomly generate a permutation vector p of length n,
+             *         representing a permutation π_p on the set of n elements
+             *
+             * Let p = (p_0, p_1, ..., p_{n-1}) and let a sequence
+             * a = (a_0, a_1, ..., a_{n-1}), by applying permutation
+             * defined by p to vector a, we have the sequence a in
+             * the following order: 
+             *     a = (a_{p_0}, a_{p_1}, ..., a_{p_{n-1}})
+             *
+             * Obviously we can also define the permutation vector p
+             * as a permutation matrix P. But the vector p is 
+             * preferred for storage efficiency.
+             *
+             * Note that the permutation defined by p may need
+             * to be altered, and this is captured by permutation
+             * ρ, see permute_matrix_H method.
+             **/
+            for (i=0; i<NTS_KEM_PARAM_N; i++) {
+                priv->p[i] = i;
+            }
+            fisher_yates_shuffle(keygen, priv->p);
+            keygen->stage = NTS_KEM_KEYGEN_PARITY_CHECK;
+            break;
+        case NTS_KEM_KEYGEN_PARITY_CHECK:
+            /**
+             * Step 3. Construct a generator matrix in the reduced row echelon
+             *         form G = [ I_k | Q ] of a permuted code
+             *
+             * This is done over several stages, starting with the
+             * parity-check matrix H
+             **/
+            keygen->H = create_matrix_H(nts_kem, keygen->Gz, keygen->a, keygen->h);
+            if (!keygen->H || !m4r_rref_init(&keygen->m4r, keygen->H))
+                return NTS_KEM_BAD_MEMORY_ALLOCATION;
+            keygen->stage = NTS_KEM_KEYGEN_ELIMINATION;
+            break;
+        case NTS_KEM_KEYGEN_ELIMINATION:
+            /**
+             * Perform M4RI for reduced row echelon transformation,
+             * one stripe per step
+             **/
+            if (!m4r_rref_step(&keygen->m4r)) {
+                rank = m4r_rref_final(&keygen->m4r);
+                if (NTS_KEM_PARAM_K != nts_kem->length - rank) {
+                    fprintf(stderr, "FATAL ERROR: The Goppa code is invalid, ");
+                    fprintf(stderr, "this indicates that there is bugs in the code\n\n");
+                    return NTS_KEM_UNEXPECTED_ERROR;
+                }
+                keygen->row = keygen->H->nrows-1;
+                keygen->col = 0;
+                keygen->stage = NTS_KEM_KEYGEN_SYSTEMATIC;
+            }
+            break;
+        case NTS_KEM_KEYGEN_SYSTEMATIC:
+            keygen->row = permute_matrix_H(nts_kem, keygen->H,
+                                           keygen->a, keygen->h,
+                                           keygen->row, &keygen->col,
+                                           KEYGEN_ROWS_PER_STEP);
+            if (keygen->row < 0) {
+                if (!(keygen->Q = calloc_matrix_ff2(NTS_KEM_PARAM_K, NTS_KEM_PARAM_C)))
+                    return NTS_KEM_BAD_MEMORY_ALLOCATION;
+                keygen->row = 0;
+                keygen->stage = NTS_KEM_KEYGEN_EXTRACT_Q;
+            }
+            break;
+        case NTS_KEM_KEYGEN_EXTRACT_Q:
+            i = CT_min(keygen->row + KEYGEN_ROWS_PER_STEP, NTS_KEM_PARAM_C);
+            extract_matrix_Q(keygen->Q, keygen->H, keygen->row, i);
+            keygen->row = i;
+            if (keygen->row == NTS_KEM_PARAM_C) {
+                zero_matrix_ff2(keygen->H);
+                free_matrix_ff2(keygen->H);
+                keygen->H = NULL;
+                keygen->stage = NTS_KEM_KEYGEN_SERIALISE;
+            }
+            break;
+        case NTS_KEM_KEYGEN_SERIALISE:
+            /**
+             * Step 4. Randomly generate vector z where |z| = ℓ
+             **/
+            keygen_randombytes(keygen, priv->z, NTS_KEM_KEY_SIZE);
+            
+            /**
+             * Step 5. Partion vectors a = (a_a | a_b | a_c) and h = (h_a | h_b | h_c)
+             *         and let a* = (a_b | a_c) and  h* = (h_b | h_c)
+             **/
+            memcpy(priv->a, &keygen->a[NTS_KEM_PARAM_A], NTS_KEM_PARAM_BC*sizeof(ff_unit));
+            memcpy(priv->h, &keygen->h[NTS_KEM_PARAM_A], NTS_KEM_PARAM_BC*sizeof(ff_unit));
+            
+            /**
+             * The NTS-KEM public key is (Q, τ, l), where l = kNTSKEMKeysize
+             * and NTS-KEM private key is (a*, h*, p)
+             *
+             * Serialise the public and private key pair
+             **/
+            if ((NTS_KEM_SUCCESS != serialise_public_key(nts_kem, keygen->Q)) ||
+                (NTS_KEM_SUCCESS != serialise_private_key(nts_kem, keygen->Q)))
+                return NTS_KEM_BAD_MEMORY_ALLOCATION;
+            free_matrix_ff2(keygen->Q);
+            keygen->Q = NULL;
+            keygen->stage = NTS_KEM_KEYGEN_DONE;
+            status = NTS_KEM_SUCCESS;
+            break;
+        default:
+            return NTS_KEM_BAD_PARAMETERS;
+    }
+    
+#if defined(BENCHMARK)
+    keygen->cycles += (cpucycles() - start_clock);
+    if (stage == NTS_KEM_KEYGEN_GOPPA && keygen->stage != stage) {
+        fprintf(stdout, "# num_Gz_trials %d\n", keygen->num_trials);
+        fprintf(stdout, "# KeyGen : (1) random_goppa_polynomial consumes %" PRId64 " cycles\n", keygen->cycles);
+        keygen->cycles = 0;
+    }
+    else if (stage == NTS_KEM_KEYGEN_PERMUTATION) {
+        fprintf(stdout, "# KeyGen : (2) random_permutation consumes %" PRId64 " cycles\n", keygen->cycles);
+        keygen->cycles = 0;
+    }
+    else if (stage == NTS_KEM_KEYGEN_EXTRACT_Q && keygen->stage != stage) {
+        fprintf(stdout, "# KeyGen : (3) create_matrix_G consumes %" PRId64 " cycles\n", keygen->cycles);
+        keygen->cycles = 0;
+    }
+#endif
+    
+    return status;
+}
+
+/**
+ *  Pack 8 units of 13 bits into 13 bytes, using two 64-bit words
+ **/
+static inline void pack_13x8(const ff_unit *src, uint8_t *dst)
+{
+    int32_t i;
+    uint64_t w0, w1;
+    
+    w0 = ((uint64_t)(src[0] & 0x1FFF)      ) | ((uint64_t)(src[1] & 0x1FFF) << 13) |
+         ((uint64_t)(src[2] & 0x1FFF) << 26) | ((uint64_t)(src[3] & 0x1FFF) << 39) |
+         ((uint64_t)(src[4] & 0x1FFF) << 52);
+    w1 = ((uint64_t)(src[4] & 0x1FFF) >> 12) | ((uint64_t)(src[5] & 0x1FFF) <<  1) |
+         ((uint64_t)(src[6] & 0x1FFF) << 14) | ((uint64_t)(src[7] & 0x1FFF) << 27);
+    for (i=0; i<8; i++) dst[i]   = (uint8_t)(w0 >> (i << 3));
+    for (i=0; i<5; i++) dst[8+i] = (uint8_t)(w1 >> (i << 3));
+}
+
+/**
+ *  Unpack 13 bytes into 8 units of 13 bits, using two 64-bit words
+ **/
+static inline void unpack_13x8(const uint8_t *src, ff_unit *dst)
+{
+    int32_t i;
+    uint64_t w0 = 0, w1 = 0;
+    
+    for (i=0; i<8; i++) w0 |= ((uint64_t)src[i]   << (i << 3));
+    for (i=0; i<5; i++) w1 |= ((uint64_t)src[8+i] << (i << 3));
+    dst[0] = (ff_unit)( w0        & 0x1FFF);
+    dst[1] = (ff_unit)((w0 >> 13) & 0x1FFF);
+    dst[2] = (ff_unit)((w0 >> 26) & 0x1FFF);
+    dst[3] = (ff_unit)((w0 >> 39) & 0x1FFF);
+    dst[4] = (ff_unit)(((w0 >> 52) | (w1 << 12)) & 0x1FFF);
+    dst[5] = (ff_unit)((w1 >>  1) & 0x1FFF);
+    dst[6] = (ff_unit)((w1 >> 14) & 0x1FFF);
+    dst[7] = (ff_unit)((w1 >> 27) & 0x1FFF);
+}
+
+/**
+ *  Pack 16 units of 13 bits into 26 bytes
+ *
+ *  @note
+ *  Each unit is widened to 32 bits and shifted to its bit offset
+ *  within the 13-byte group of its 128-bit lane, the bytes are then
+ *  moved in place with shuffles. Units 0, 2, ... and 1, 3, ... do
+ *  not share bytes so they can be shuffled separately and combined.
+ *  32 bytes are written at `dst`.
+ **/
+static inline void pack_13x16_avx2(const ff_unit *src, uint8_t *dst)
+{
+    __m256i v, lo, hi, out;
+    const __m256i zero = _mm256_setzero_si256();
+    
+    v  = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)src), _mm256_set1_epi16(0x1FFF));
+    lo = _mm256_sllv_epi32(_mm256_unpacklo_epi16(v, zero), _mm256_setr_epi32(0, 5, 2, 7, 0, 5, 2, 7));
+    hi = _mm256_sllv_epi32(_mm256_unpackhi_epi16(v, zero), _mm256_setr_epi32(4, 1, 6, 3, 4, 1, 6, 3));
+    out = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_shuffle_epi8(lo, _mm256_setr_epi8( 0,  1, -1,  8,  9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                          0,  1, -1,  8,  9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm256_shuffle_epi8(lo, _mm256_setr_epi8(-1,  4,  5,  6, 12, 13, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                         -1,  4,  5,  6, 12, 13, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1))),
+            _mm256_or_si256(
+                _mm256_shuffle_epi8(hi, _mm256_setr_epi8(-1, -1, -1, -1, -1, -1,  0,  1,  2,  8,  9, 10, -1, -1, -1, -1,
+                                                         -1, -1, -1, -1, -1, -1,  0,  1,  2,  8,  9, 10, -1, -1, -1, -1)),
+                _mm256_shuffle_epi8(hi, _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1,  4,  5, -1, 12, 13, -1, -1, -1,
+                                                         -1, -1, -1, -1, -1, -1, -1, -1,  4,  5, -1, 12, 13, -1, -1, -1))));
+    _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(out));
+    _mm_storeu_si128((__m128i *)(dst + 13), _mm256_extracti128_si256(out, 1));
+}
+
+/**
+ *  Unpack 26 bytes into 16 units of 13 bits
+ *
+ *  @note
+ *  The 4 bytes holding each unit are gathered into a 32-bit lane
+ *  with shuffles, shifted down by the bit offset of the unit and
+ *  narrowed back to 16 bits. 29 bytes are read from `src`.
+ **/
+static inline void unpack_13x16_avx2(const uint8_t *src, ff_unit *dst)
+{
+    __m256i v, lo, hi;
+    const __m256i mask = _mm256_set1_epi32(0x1FFF);
+    
+    v  = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)src)),
+                                 _mm_loadu_si128((const __m128i *)(src + 13)), 1);
+    lo = _mm256_shuffle_epi8(v, _mm256_setr_epi8(0, 1, 2, 3, 1, 2,  3,  4, 3,  4,  5,  6,  4,  5,  6,  7,
+                                                 0, 1, 2, 3, 1, 2,  3,  4, 3,  4,  5,  6,  4,  5,  6,  7));
+    hi = _mm256_shuffle_epi8(v, _mm256_setr_epi8(6, 7, 8, 9, 8, 9, 10, 11, 9, 10, 11, 12, 11, 12, 13, 14,
+                                                 6, 7, 8, 9, 8, 9, 10, 11, 9, 10, 11, 12, 11, 12, 13, 14));
+    lo = _mm256_and_si256(_mm256_srlv_epi32(lo, _mm256_setr_epi32(0, 5, 2, 7, 0, 5, 2, 7)), mask);
+    hi = _mm256_and_si256(_mm256_srlv_epi32(hi, _mm256_setr_epi32(4, 1, 6, 3, 4, 1, 6, 3)), mask);
+    _mm256_storeu_si256((__m256i *)dst, _mm256_packus_epi32(lo, hi));
+}
+
+/**
+ *  Pack buffer of 2*src_len bytes into a buffer of
+ *  size src_len*13/8.
+ *
+ *  @param[in]  src     Pointer to the input buffer
+ *  @param[in]  src_len Length of src in 2-byte (word) unit
+ *  @param[out] dst     Pointer to the output buffer
+ **/
+void pack_buffer(const uint8_t *src, int src_len, uint8_t *dst)
+{
+    int32_t i = 0;
+    const ff_unit *src_ptr = (const ff_unit *)src;
+    
+    /* The vector stores write past the group, keep them within dst */
+    for (; i+24<=src_len; i+=16) {
+        pack_13x16_avx2(&src_ptr[i], &dst[((i*13) >> 3)]);
+    }
+    for (; i+8<=src_len; i+=8) {
+        pack_13x8(&src_ptr[i], &dst[((i*13) >> 3)]);
+    }
+}
+
+/**
+ *  Unpack a buffer to a word buffer of length dst_len
+ *
+ *  @param[in]  src     Pointer to the input buffer
+ *  @param[out] dst     Pointer to the output buffer (in words)
+ *  @param[in]  dst_len Length of dst in 2-byte (word) unit
+ **/
+void unpack_buffer(const uint8_t *src, ff_unit *dst, int dst_len)
+{
+    int32_t i = 0;
+    
+    /* The vector loads read past the group, keep them within src */
+    for (; i+24<=dst_len; i+=16) {
+        unpack_13x16_avx2(&src[((i*13) >> 3)], &dst[i]);
+    }
+    for (; i+8<=dst_len; i+=8) {
+        unpack_13x8(&src[((i*13) >> 3)], &dst[i]);
+    }
+}
+
+/**
+ *  Serialise NTS public key
+ *
+ *  @param[in] nts_kem    The pointer to NTS-KEM object
+ *  @param[in] Q          The pointer to matrix Q
+ *  @return NTS_KEM_SUCCESS on success, a negative integer otherwise
+ **/
+int serialise_public_key(NTSKEM* nts_kem,
+                         const matrix_ff2* Q)
+{
+    NTSKEM_private* priv = (NTSKEM_private *)nts_kem->priv;
+    int i, j, s;
+    const int32_t b = NTS_KEM_PARAM_CEIL_R_BYTE;
+    uint8_t *key_ptr = NULL;
+    packed_t bit_value, *v_ptr = NULL;
+    
+    nts_kem->public_key_size = NTS_KEM_PUBLIC_KEY_SIZE;
+    nts_kem->public_key = (uint8_t *)mem_alloc_large(nts_kem->public_key_size);
+    if (!nts_kem->public_key)
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    memset(nts_kem->public_key, 0, nts_kem->public_key_size);
+    priv->m = NTS_KEM_PARAM_M;
+    key_ptr = nts_kem->public_key;
+    for (i=0; i<NTS_KEM_PARAM_K; i++) {
+        v_ptr = (packed_t *)row_ptr_matrix_ff2(Q, i);
+        for (j=0; j<NTS_KEM_PARAM_C; j++) {
+            bit_value = bit_value(v_ptr, j);
+            s = j >> 3;
+            key_ptr[(i * b) + s] |= ((uint8_t)(bit_value << (j - (s << 3))));
+        }
+    }
+    
+    return NTS_KEM_SUCCESS;
+}
+
+/**
+ *  Serialise NTS private key
+ *
+ *  @param[in] nts_kem    The pointer to NTS-KEM object
+ *  @param[in] Q          The pointer to matrix Q
+ *  @return NTS_KEM_SUCCESS on success, a negative integer otherwise
+ **/
+int serialise_private_key(NTSKEM *nts_kem, const matrix_ff2* Q)
+{
+    int i, j, s;
+    const int32_t b = NTS_KEM_PARAM_CEIL_R_BYTE;
+    uint8_t *key_ptr = NULL;
+    packed_t bit_value, *v_ptr = NULL;
+    NTSKEM_private* priv = (NTSKEM_private *)nts_kem->priv;
+    
+    nts_kem->private_key_size = NTS_KEM_PRIVATE_KEY_SIZE;
+    nts_kem->private_key = (uint8_t *)mem_alloc_large(nts_kem->private_key_size);
+    if (!nts_kem->private_key)
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    memset(nts_kem->private_key, 0, nts_kem->private_key_size);
+    key_ptr = nts_kem->private_key;
+    
+    pack_buffer((const uint8_t *)priv->a, NTS_KEM_PARAM_BC, key_ptr);
+    key_ptr += (NTS_KEM_PARAM_BC * 13/8);
+    
+    pack_buffer((const uint8_t *)priv->h, NTS_KEM_PARAM_BC, key_ptr);
+    key_ptr += (NTS_KEM_PARAM_BC * 13/8);
+    
+    pack_buffer((const uint8_t *)priv->p, NTS_KEM_PARAM_N, key_ptr);
+    key_ptr += (NTS_KEM_PARAM_N * 13/8);
+    
+    memcpy(key_ptr, priv->z, NTS_KEM_KEY_SIZE);
+    key_ptr += NTS_KEM_KEY_SIZE;
+    priv->pk = key_ptr;
+    
+    for (i=0; i<NTS_KEM_PARAM_K; i++) {
+        v_ptr = (packed_t *)row_ptr_matrix_ff2(Q, i);
+        for (j=0; j<NTS_KEM_PARAM_C; j++) {
+            bit_value = bit_value(v_ptr, j);
+            s = j >> 3;
+            key_ptr[(i * b) + s] |= ((uint8_t)(bit_value << (j - (s << 3))));
+        }
+    }
+
+    return NTS_KEM_SUCCESS;
+}
+
+/**
+ *  Initialise an NTS-KEM object in place from a private key,
+ *  without any memory allocation
+ *
+ *  @note
+ *  The public key is not copied, it is read from the private key
+ *  buffer, which has to outlive the object. The object must not
+ *  be released with {@see nts_kem_release}.
+ *
+ *  @param[out] nts_kem  The NTS-KEM object
+ *  @param[out] priv     The private component of the object
+ *  @param[in]  sk       The pointer to NTS-KEM private key
+ **/
+void load_private_key(NTSKEM* nts_kem, NTSKEM_private* priv, const uint8_t *sk)
+{
+    nts_kem->length = NTS_KEM_PARAM_N;
+    nts_kem->t = NTS_KEM_PARAM_T;
+    nts_kem->public_key = nts_kem->private_key = NULL;
+    nts_kem->public_key_size = 0;
+    nts_kem->private_key_size = NTS_KEM_PRIVATE_KEY_SIZE;
+    nts_kem->priv = priv;
+    priv->m = NTS_KEM_PARAM_M;
+    priv->ff2m = ff_create(priv->m);
+    deserialise_private_key(nts_kem, sk);
+}
+
+/**
+ *  Deserialise NTS-KEM private key
+ *
+ *  @param[out] nts_kem    The pointer to NTS-KEM object
+ *  @param[in]  buf        Pointer to buffer containing private key blob
+ *  @return NTS_KEM_SUCCESS on success, a negative integer otherwise
+ **/
+int deserialise_private_key(NTSKEM* nts_kem, const uint8_t *buf)
+{
+    NTSKEM_private* priv = (NTSKEM_private *)nts_kem->priv;
+    
+    /* Deserialise vector a */
+    unpack_buffer(buf, priv->a, NTS_KEM_PARAM_BC);
+    buf += (NTS_KEM_PARAM_BC * 13/8);
+    
+    /* Deserialise vector h */
+    unpack_buffer(buf, priv->h, NTS_KEM_PARAM_BC);
+    buf += (NTS_KEM_PARAM_BC * 13/8);
+    
+    /* Deserialise vector p */
+    unpack_buffer(buf, priv->p, NTS_KEM_PARAM_N);
+    buf += (NTS_KEM_PARAM_N * 13/8);
+    
+    /* Deserialise vector z */
+    memcpy(priv->z, buf, NTS_KEM_KEY_SIZE);
+    buf += NTS_KEM_KEY_SIZE;
+    
+    /* The public-key is used in place */
+    priv->pk = buf;
+
+    return NTS_KEM_SUCCESS;
+}
+
+/**
+ *  Generate random data for the key generation
+ *
+ *  @note
+ *  The data is taken from the SHAKE256 stream of the seed
+ *  for a seeded key generation, otherwise from randombytes
+ *
+ *  @param[in,out] keygen  The key generation state
+ *  @param[out]    buffer  The output buffer holding the random data
+ *  @param[in]     size    The length of the random data
+ *  @return an integer status value {@see nts_kem_errors.h}
+ **/
+int keygen_randombytes(NTSKEM_keygen* keygen, uint8_t *buffer, size_t size)
+{
+    if (!keygen->seeded)
+        return randombytes(buffer, size);
+    
+    shake256_squeeze(&keygen->rng.xof, buffer, size);
+    
+    return NTS_KEM_SUCCESS;
+}
+
+/**
+ *  Generate a 16-bit random number between 0 and `bound-1`
+ *  for the key generation
+ *
+ *  @note
+ *  Identical to {@see random_uint16_bounded}, but the random
+ *  bits are taken from the SHAKE256 stream of the seed for a
+ *  seeded key generation
+ *
+ *  @param[in,out] keygen  The key generation state
+ *  @param[in]     bound   The limit of the number to be generated
+ *  @return a 16-bit random number
+ **/
+uint16_t keygen_random_uint16_bounded(NTSKEM_keygen* keygen, uint16_t bound)
+{
+    if (!keygen->seeded)
+        return random_uint16_bounded(bound);
+    
+    return xof_uint16_bounded(&keygen->rng, bound);
+}
+
+/**
+ *  Start taking random bits from the SHAKE256 stream of a seed
+ *
+ *  @param[out] rng   The source of random bits
+ *  @param[in]  seed  The seed of NTS_KEM_SEED_SIZE bytes
+ **/
+void xof_source_init(xof_source *rng, const uint8_t *seed)
+{
+    shake256_init(&rng->xof, seed, NTS_KEM_SEED_SIZE);
+    rng->bits_consumed = KEYGEN_RND_SIZE << 3;
+}
+
+/**
+ *  Wipe a source of random bits
+ *
+ *  @param[in,out] rng  The source of random bits
+ **/
+void xof_source_release(xof_source *rng)
+{
+    shake256_release(&rng->xof);
+    CT_memset(rng->rnd_buffer, 0, sizeof(rng->rnd_buffer));
+    rng->bits_consumed = KEYGEN_RND_SIZE << 3;
+}
+
+/**
+ *  Generate a 16-bit random number between 0 and `bound-1`
+ *  from the SHAKE256 stream of a seed
+ *
+ *  @note
+ *  Identical to {@see random_uint16_bounded}, the bits are
+ *  consumed in the same order
+ *
+ *  @param[in,out] rng    The source of random bits
+ *  @param[in]     bound  The limit of the number to be generated
+ *  @return a 16-bit random number
+ **/
+uint16_t xof_uint16_bounded(xof_source *rng, uint16_t bound)
+{
+    uint16_t d, u, x;
+    int32_t b;
+    
+    /* Knuth-Yao DDG */
+    d = 0; u = 1; x = 0;
+    do {
+        while (u < bound) {
+            if (rng->bits_consumed >= (KEYGEN_RND_SIZE << 3)) {
+                shake256_squeeze(&rng->xof, rng->rnd_buffer, KEYGEN_RND_SIZE);
+                rng->bits_consumed = 0;
+            }
+            b = rng->bits_consumed++;
+            u = 2*u;
+            x = 2*x + ((rng->rnd_buffer[b >> 3] >> (b & 7)) & 1);
+        }
+        d = u - bound;
+        u = d;
+    } while (x < d);
+    
+    return x - d;
+}
+
+/**
+ *  Fisher-Yates-Knuth-Yao shuffle on a sequence (in-place)
+ *
+ *  @note
+ *  Fisher-Yates shuffle requires the generation of uniform
+ *  random number between a certain range. Knuth-Yao method
+ *  may be used to generate such numbers uniformly.
+ *
+ *  @param[in,out] keygen      The key generation state
+ *  @param[in,out] buffer      The input/output sequence
+ **/
+void fisher_yates_shuffle(NTSKEM_keygen* keygen, ff_unit *buffer)
+{
+    ff_unit index, swap;
+    int i = NTS_KEM_PARAM_N - 1;
+    while (i > 0) {
+        index = keygen_random_uint16_bounded(keygen, i+1);
+        swap = buffer[index];
+        buffer[index] = buffer[i];
+        buffer[i] = swap;
+        --i;
+    }
+}
+
+/**
+ *  The re-encoding of a decapsulation shared by a worker group
+ **/
+typedef struct {
+    const uint8_t *pk;
+    const uint8_t *e;
+    const uint8_t *k_e;
+    vector c_c[NTS_KEM_DECAP_WORKERS][NTS_KEM_PARAM_R_VEC];
+} encode_job;
+
+static void encode_worker(void *arg, int index, int count)
+{
+    encode_job *job = (encode_job *)arg;
+    
+    encode_parity(job->pk, job->e, job->k_e,
+                  (MESSAGE_WORDS * index) / count,
+                  (MESSAGE_WORDS * (index + 1)) / count,
+                  job->c_c[index]);
+}
+
+/**
+ * Core encapsulation routine
+ *
+ *  @param[in]  e       The pointer to input error pattern
+ *  @param[in]  pk      The pointer to NTS-KEM public key
+ *  @param[out] c_ast   The fragments of the NTS-KEM ciphertext
+ *  @param[in]  iovcnt  The number of fragments
+ *  @param[out] k_r     The pointer to the encapsulated key
+ *  @param[in]  workers The worker group sharing the encoding, or NULL
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int encapsulate(const uint8_t *e,
+                const uint8_t *pk,
+                const NTSKEM_iovec *c_ast,
+                size_t iovcnt,
+                uint8_t *k_r,
+                worker_group *workers)
+{
+    int status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+    int32_t i, j;
+    vector c_c[NTS_KEM_PARAM_R_VEC];
+    encode_job job;
+    uint8_t k_e[kNTSKEMKeysize];
     
     /**
-     * Perform additive FFT on Gz to obtain an evaluation of G(z)
-     * at points B[0], B[1], B[2], ..., B[n-1]
+     * Step 3. Compute SHA3_256(e) to produce k_e
      **/
-    vector_load_2d_128(g, Gz->coeff, (NTS_KEM_PARAM_T+1));
-    bitslice_fft(vh, g);
+    sha3_256(e, NTS_KEM_PARAM_CEIL_N_BYTE, k_e);
     
     /**
-     * Permute the bit-slice output of the FFT with permutation p
+     * Step 4. Construct a length k message vector m = (e_a | k_e)
+     * Step 5. Perform systematic encoding with matrix Q,
+     *         i.e. c = ( m | mQ ) + e
+     *                = ( c_a | c_b | c_c )
+     *                = ( 0_a | c_b | c_c )
+     *          c_ast = ( c_b | c_c )
+     *
+     * The c_c (or parity block) is basically section c of the
+     * ciphertext. It's basically c_c = (e_a | k_e)*Q where Q
+     * is the last n-k bits of the generator matrix in reduced
+     * echelon form G = [ I | Q ].
+     *
+     * With a worker group, each member adds up the rows of its
+     * share of m, and the partial sums are added in index order.
      **/
-    for (j=0; j<NTS_KEM_PARAM_M; j++) {
-        CT_memset(v, 0, sizeof(v));
-        for (i=0; i<NTS_KEM_PARAM_N; i++) {
-            l = priv->p[i];
-			switch ((l & 255) >> 6) {
-				case 3:
-					v[i >> 6] |= (((_mm256_extract_epi64(vh[l >> 8][j], 3) & (1ULL << (l & 63))) >> (l & 63)) << (i & 63));
-					break;
-				case 2:
-					v[i >> 6] |= (((_mm256_extract_epi64(vh[l >> 8][j], 2) & (1ULL << (l & 63))) >> (l & 63)) << (i & 63));
-					break;
-				case 1:
-					v[i >> 6] |= (((_mm256_extract_epi64(vh[l >> 8][j], 1) & (1ULL << (l & 63))) >> (l & 63)) << (i & 63));
-					break;
-				default:
-					v[i >> 6] |= (((_mm256_extract_epi64(vh[l >> 8][j], 0) & (1ULL << (l & 63))) >> (l & 63)) << (i & 63));
-			}
-        }
-        for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-            hv0[i][j] = _mm256_set_epi64x(v[4*i + 3], v[4*i + 2], v[4*i + 1], v[4*i]);
+    for (i=0; i<NTS_KEM_PARAM_R_VEC; i++)
+        c_c[i] = _mm256_setzero_si256();
+    if (workers) {
+        job.pk = pk;
+        job.e = e;
+        job.k_e = k_e;
+        memset(job.c_c, 0, sizeof(job.c_c));
+        worker_group_run(workers, encode_worker, &job);
+        for (j=0; j<worker_group_size(workers); j++) {
+            for (i=0; i<NTS_KEM_PARAM_R_VEC; i++)
+                c_c[i] ^= job.c_c[j][i];
         }
+        CT_memset(job.c_c, 0, sizeof(job.c_c));
     }
-
-    /**
-     * Permute the sequences a' with permutation p
-     **/
-    for (i=0; i<NTS_KEM_PARAM_N; i++) {
-        a[i] = a_prime[priv->p[i]];
+    else {
+        encode_parity(pk, e, k_e, 0, MESSAGE_WORDS, c_c);
     }
     
-    /**
-     * Calculate G(a_i)^{-2} using vectorised implementation
-     **/
-    for (i=0,j=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-        priv->ff2m->vector_ff_sqr_inv(priv->ff2m, hv1[i], hv0[i]);
-    }
-    vector_store_2d_256(h, (const __m256i (*)[])hv1, NTS_KEM_PARAM_N);
+    encapsulate_output(e, k_e, c_c, c_ast, iovcnt, k_r);
     
-    /* Prepare vector a for vectorised multiplication */
-    vector_load_2d_256(av0, a, NTS_KEM_PARAM_N);
+    status = NTS_KEM_SUCCESS;
+    CT_memset(k_e, 0, kNTSKEMKeysize);
+    CT_memset(c_c, 0, sizeof(c_c));
     
-    /* Obtain the parity-check matrix H from h */
-    if (!(H = calloc_matrix_ff2(Gz->degree * priv->ff2m->m, (1 << priv->m))))
-        return NULL;
-    /* The first batch of NTS_KEM_PARAM_M rows of parity-check matrix */
-    for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-        for (j=0; j<NTS_KEM_PARAM_M; j++) {
-            memcpy(row_ptr_matrix_ff2(H, j) + (i*BLOCK_SIZE >> 3),
-                   &hv1[i][j],
-                   UINT64_SIZE*sizeof(uint64_t));
-        }
-    }
-    /* h_1 = h_0 * a */
-    for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-        priv->ff2m->vector_ff_mul(priv->ff2m, hv0[i], hv1[i], av0[i]);
-    }
-    /* The second batch of NTS_KEM_PARAM_M rows of parity-check matrix */
-    for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-        for (j=0; j<NTS_KEM_PARAM_M; j++) {
-            memcpy(row_ptr_matrix_ff2(H, j+NTS_KEM_PARAM_M) + (i*BLOCK_SIZE >> 3),
-                   &hv0[i][j],
-                   UINT64_SIZE*sizeof(uint64_t));
-        }
-    }
-    for (l=2; l<Gz->degree; l+=2) {
-        /* h_l = h_{l-1} * a */
-        for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-            priv->ff2m->vector_ff_mul(priv->ff2m, hv1[i], hv0[i], av0[i]);
-        }
-        /* The l-th batch of NTS_KEM_PARAM_M rows of parity-check matrix */
-        for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-            for (j=0; j<NTS_KEM_PARAM_M; j++) {
-                memcpy(row_ptr_matrix_ff2(H, j+(l*NTS_KEM_PARAM_M)) + (i*BLOCK_SIZE >> 3),
-                       &hv1[i][j],
-                       UINT64_SIZE*sizeof(uint64_t));
-            }
-        }
-        /* h_l = h_{l-1} * a */
-        for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-            priv->ff2m->vector_ff_mul(priv->ff2m, hv0[i], hv1[i], av0[i]);
-        }
-        /* The (l+1)-th batch of NTS_KEM_PARAM_M rows of parity-check matrix */
-        for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-            for (j=0; j<NTS_KEM_PARAM_M; j++) {
-                memcpy(row_ptr_matrix_ff2(H, j+((l+1)*NTS_KEM_PARAM_M)) + (i*BLOCK_SIZE >> 3),
-                       &hv0[i][j],
-                       UINT64_SIZE*sizeof(uint64_t));
-            }
-        }
-    }
+    return status;
+}
+
+/**
+ *  Output the ciphertext and the key of an encapsulation
+ *
+ *  @param[in]  e       The pointer to input error pattern
+ *  @param[in]  k_e     The key k_e = SHA3_256(e)
+ *  @param[in]  c_c     The parity c_c = (e_a | k_e)*Q
+ *  @param[out] c_ast   The fragments of the NTS-KEM ciphertext
+ *  @param[in]  iovcnt  The number of fragments
+ *  @param[out] k_r     The pointer to the encapsulated key
+ **/
+void encapsulate_output(const uint8_t *e,
+                        const uint8_t *k_e,
+                        const vector *c_c,
+                        const NTSKEM_iovec *c_ast,
+                        size_t iovcnt,
+                        uint8_t *k_r)
+{
+    sha3_256_state sha3;
     
     /**
-     * Perform M4RI for reduced row echelon transformation
+     * The output is ciphertext containing the following section:
+     *
+     *     c = ( c_a | c_b | c_c )
+     *
+     * By construction, c_b = k_e and its length is kNTSKEMKeysize bytes,
+     * the length of c_a is (k/8 - kNTSKEMKeysize) bytes and the length of
+     * c_c is (n-k)/8 bytes.
+     *
+     * The error pattern e = ( e_a | e_b | e_c ), therefore, after
+     * adding e to c, c_a = 0, and we have
+     *
+     *     c_ast = ( k_e + e_b | c_c + e_c )
+     *
+     * There is no need to perturb section a with the error pattern
+     * as we know it will result to 0 and we are going to drop this
+     * section anyway. Both sections are written to the fragments
+     * of c_ast as they are perturbed.
      **/
-    rank = reduce_row_echelon_matrix_ff2(H);
-    if (NTS_KEM_PARAM_K != nts_kem->length - rank) {
-        fprintf(stderr, "FATAL ERROR: The Goppa code is invalid, ");
-        fprintf(stderr, "this indicates that there is bugs in the code\n\n");
-        return NULL;
-    }
-
+    store_output_ciphertext(c_ast, iovcnt, 0, k_e,
+                            &e[NTS_KEM_PARAM_A>>3], kNTSKEMKeysize);            /* c_b = k_e + e_b */
+    store_output_ciphertext(c_ast, iovcnt, kNTSKEMKeysize, (const uint8_t *)c_c,
+                            &e[(NTS_KEM_PARAM_A>>3) + kNTSKEMKeysize],
+                            NTS_KEM_PARAM_CEIL_R_BYTE);                         /* c_c = c_c + e_c */
+    
     /**
-     * Perform permutation on the columns of H such that the last (n-k)
-     * columns of H form a (n-k)x(n-k) identity matrix. Let ρ be the
-     * permutation that makes H in the form that we need. Update the
-     * permutation matrix generated in Step 2 with ρ. The vectors
-     * a and h have to be permuted too.
+     * Step 6. Output the pair (k_r, c_ast) where k_r = SHA3_256(k_e | e)
+     *
+     * Absorb k_e then e to obtain k_r = SHA3_256(k_e | e)
      **/
-    for (j=0,i=H->nrows-1; i>=0; i--) {
-        v_ptr = (packed_t *)row_ptr_matrix_ff2(H, i);
-        while (!is_bit_set(v_ptr, H->ncols-j-1)) ++j;
-        
-        column_swap_matrix_ff2(H, NTS_KEM_PARAM_K + i, H->ncols-j-1);
-
-        /* Update the order of permutation p */
-        f = priv->p[ NTS_KEM_PARAM_K + i ];
-        priv->p[ NTS_KEM_PARAM_K + i ] = priv->p[ H->ncols-j-1 ];
-        priv->p[ H->ncols-j-1 ] = f;
-        
-        /* Update the order of vector a */
-        f = a[ NTS_KEM_PARAM_K + i ];
-        a[ NTS_KEM_PARAM_K + i ] = a[ H->ncols-j-1 ];
-        a[ H->ncols-j-1 ] = f;
-        
-        /* Update the order of vector a */
-        f = h[ NTS_KEM_PARAM_K + i ];
-        h[ NTS_KEM_PARAM_K + i ] = h[ H->ncols-j-1 ];
-        h[ H->ncols-j-1 ] = f;
-    }
-    
-    if (!(Q = calloc_matrix_ff2(NTS_KEM_PARAM_K, NTS_KEM_PARAM_C)))
-        return NULL;
-    for (i=0; i<NTS_KEM_PARAM_C; i++) {
-        v_ptr = (packed_t *)row_ptr_matrix_ff2(H, i);
-        for (j=0; j<NTS_KEM_PARAM_K; j++) {
-            bit_set_value((packed_t *)row_ptr_matrix_ff2(Q, j),
-                          i,
-                          bit_value(v_ptr, j));
-        }
-    }
-
-    zero_matrix_ff2(H);
-    free_matrix_ff2(H);
-    
-    return Q;
+    sha3_256_init(&sha3);
+    sha3_256_absorb(&sha3, k_e, kNTSKEMKeysize);
+    sha3_256_absorb(&sha3, e, NTS_KEM_PARAM_CEIL_N_BYTE);
+    sha3_256_final(&sha3, k_r);
 }
 
 /**
- *  Pack buffer of 2*src_len bytes into a buffer of
- *  size src_len*13/8.
+ *  Add the rows of Q selected by the message m = (e_a | k_e)
  *
- *  @param[in]  src     Pointer to the input buffer
- *  @param[in]  src_len Length of src in 2-byte (word) unit
- *  @param[out] dst     Pointer to the output buffer
+ *  @note
+ *  The message is taken in words of BITSIZE bits, the words of e_a
+ *  followed by those of k_e, and the rows are read from the public
+ *  key as they are needed. Only the rows of words [begin, end) are
+ *  added, so that the encoding can be split into independent parts.
+ *
+ *  @param[in]     pk     The pointer to NTS-KEM public key
+ *  @param[in]     e      The error pattern, e_a are its first a bits
+ *  @param[in]     k_e    The key k_e
+ *  @param[in]     begin  The first word of m
+ *  @param[in]     end    The word after the last word of m
+ *  @param[in,out] c_c    The parity to add the rows to
  **/
-void pack_buffer(const uint8_t *src, int src_len, uint8_t *dst)
+void encode_parity(const uint8_t *pk,
+                   const uint8_t *e,
+                   const uint8_t *k_e,
+                   int32_t begin,
+                   int32_t end,
+                   vector *c_c)
 {
-    int32_t i;
-    const uint8_t* src_ptr = src;
-    uint8_t *dst_ptr = dst;
-    for (i=0; i<src_len; i+=8) {
-        *dst_ptr  = *src_ptr++; dst_ptr++;
-        *dst_ptr  = *src_ptr++;
-        *dst_ptr |= ((*src_ptr   & 0x07) << 5); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xF8) >> 3);
-        *dst_ptr |= ((*src_ptr   & 0x07) << 5); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0x18) >> 3);
-        *dst_ptr |= ((*src_ptr   & 0x3F) << 2); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xC0) >> 6);
-        *dst_ptr |= ((*src_ptr++ & 0x1F) << 2);
-        *dst_ptr |= ((*src_ptr   & 0x01) << 7); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xFE) >> 1);
-        *dst_ptr |= ((*src_ptr   & 0x01) << 7); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0x1E) >> 1);
-        *dst_ptr |= ((*src_ptr   & 0x0F) << 4); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xF0) >> 4);
-        *dst_ptr |= ((*src_ptr   & 0x0F) << 4); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0x10) >> 4);
-        *dst_ptr |= ((*src_ptr   & 0x7F) << 1); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0x80) >> 7);
-        *dst_ptr |= ((*src_ptr++ & 0x1F) << 1);
-        *dst_ptr |= ((*src_ptr   & 0x03) << 6); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xFC) >> 2);
-        *dst_ptr |= ((*src_ptr   & 0x03) << 6); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0x1C) >> 2);
-        *dst_ptr |= ((*src_ptr   & 0x1F) << 3); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xE0) >> 5);
-        *dst_ptr |= ((*src_ptr++ & 0x1F) << 3); dst_ptr++;
+    int32_t i, j, l, b;
+    packed_t v;
+    vector q[NTS_KEM_PARAM_R_VEC];
+    
+    q[NTS_KEM_PARAM_R_VEC-1] = _mm256_setzero_si256();
+    for (i=begin; i<end; i++) {
+        v = 0x0ULL;
+        if (i < (NTS_KEM_PARAM_A >> LOG2)) {
+            memcpy(&v, &e[i*sizeof(v)], sizeof(v));
+            l = BITSIZE*i;
+        }
+        else if (i == (NTS_KEM_PARAM_A >> LOG2)) {
+            memcpy(&v, &e[i*sizeof(v)], NTS_KEM_PARAM_A_REM);
+            l = BITSIZE*i;
+        }
+        else {
+            j = i - (NTS_KEM_PARAM_A >> LOG2) - 1;
+            memcpy(&v, &k_e[j*sizeof(v)], sizeof(v));
+            l = (BITSIZE*j) + NTS_KEM_PARAM_A;
+        }
+        while (v) {
+            b = (int32_t)lowest_bit_idx(v);
+            v ^= (ONE << b);
+            memcpy(q, &pk[(l + b)*NTS_KEM_PARAM_CEIL_R_BYTE], NTS_KEM_PARAM_CEIL_R_BYTE);
+            for (j=0; j<NTS_KEM_PARAM_R_VEC; j++) {
+                c_c[j] ^= q[j];
+            }
+        }
     }
+    CT_memset(q, 0, sizeof(q));
 }
 
 /**
- *  Unpack a buffer to a word buffer of length dst_len
+ *  Compute the syndrome vectors
  *
- *  @param[in]  src     Pointer to the input buffer
- *  @param[out] dst     Pointer to the output buffer (in words)
- *  @param[in]  dst_len Length of dst in 2-byte (word) unit
+ *  @note
+ *  This function implements Step 3 of NTS-KEM Decapsulation 
+ *  procedure as described in the submitted NIST document.
+ *
+ *  @note
+ *  Given the data and parity-check vectors, both of which have 
+ *  been corrupted with errors, compute the syndrome vector.
+ *
+ *  @note
+ *  The syndromes s_j = sum_i c_i.h_i.a_i^j are power sums over
+ *  the support. With the Beneš network of p, they are computed
+ *  with the transposed additive FFT, {@see compute_syndrome_blocks},
+ *  otherwise with a chain of multiplications by a_i,
+ *  {@see compute_syndrome_chain}. Neither accesses memory at an
+ *  address that depends on p.
+ *
+ *  @param[in]  nts_kem   The pointer to NTS-KEM object
+ *  @param[in]  benes     The Beneš network of p, or NULL
+ *  @param[in]  weight    The weights h_i, or w_i for Patterson decoding
+ *  @param[in]  c_ptr     The pointer to the inpute ciphertext
+ *  @param[out] s         The computed syndromes
+ *  @param[in]  count     The number of syndromes, 2τ or τ
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative status
+ *  {@see nts_kem_errors.h}
  **/
-void unpack_buffer(const uint8_t *src, ff_unit *dst, int dst_len)
+int compute_syndrome(const NTSKEM* nts_kem,
+                     const uint64_t *benes,
+                     const ff_unit* weight,
+                     const vector *c_ptr,
+                     ff_unit* s,
+                     int32_t count)
 {
-    int32_t i, value;
-    const uint8_t *src_ptr = src;
-
-    /* Read 13 bytes in ago and assign them to 8 2-byte dst array */
-    for (i=0; i<dst_len; i+=8) {
-        value = (*(src_ptr+2) << 16) | (*(src_ptr+1) << 8) | *src_ptr;
-        dst[i]    =  (value & 0x00001FFF);
-        dst[i+1]  = ((value & 0x00FFE000) >> 13);
-        src_ptr += 3;
-        value = (*(src_ptr+2) << 16) | (*(src_ptr+1) << 8) | *src_ptr;
-        dst[i+1] |= ((value & 0x00000003) << 11);
-        dst[i+2]  = ((value & 0x00007FFC) >>  2);
-        dst[i+3]  = ((value & 0x00FF8000) >> 15);
-        src_ptr += 3;
-        value = (*(src_ptr+2) << 16) | (*(src_ptr+1) << 8) | *src_ptr;
-        dst[i+3] |= ((value & 0x0000000F) <<  9);
-        dst[i+4]  = ((value & 0x0001FFF0) >>  4);
-        dst[i+5]  = ((value & 0x00FE0000) >> 17);
-        src_ptr += 3;
-        value = (*(src_ptr+3) << 24) | (*(src_ptr+2) << 16) | (*(src_ptr+1) << 8) | *src_ptr;
-        dst[i+5] |= ((value & 0x0000003F) <<  7);
-        dst[i+6]  = ((value & 0x0007FFC0) >>  6);
-        dst[i+7]  = ((value & 0xFFF80000) >> 19);
-        src_ptr += 4;
-    }
+    if (!benes)
+        return compute_syndrome_chain(nts_kem, weight, c_ptr, s, count);
+    
+    return compute_syndrome_blocks(nts_kem, benes, weight, c_ptr, s, count, 0, 1);
 }
 
 /**
- *  Serialise NTS public key
+ *  Compute the syndromes as power sums, multiplying c_i.h_i by a_i
+ *  once per syndrome
  *
- *  @param[in] nts_kem    The pointer to NTS-KEM object
- *  @param[in] Q          The pointer to matrix Q
- *  @return NTS_KEM_SUCCESS on success, a negative integer otherwise
+ *  @param[in]  nts_kem   The pointer to NTS-KEM object
+ *  @param[in]  weight    The weights h_i, or w_i for Patterson decoding
+ *  @param[in]  c_ptr     The pointer to the inpute ciphertext
+ *  @param[out] s         The computed syndromes
+ *  @param[in]  count     The number of syndromes, 2τ or τ
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative status
+ *  {@see nts_kem_errors.h}
  **/
-int serialise_public_key(NTSKEM* nts_kem,
-                         const matrix_ff2* Q)
+int compute_syndrome_chain(const NTSKEM* nts_kem,
+                           const ff_unit* weight,
+                           const vector *c_ptr,
+                           ff_unit* s,
+                           int32_t count)
 {
-    NTSKEM_private* priv = (NTSKEM_private *)nts_kem->priv;
-    int i, j, s;
-    const int32_t b = NTS_KEM_PARAM_CEIL_R_BYTE;
-    uint8_t *key_ptr = NULL;
-    packed_t bit_value, *v_ptr = NULL;
+    int32_t i, j;
+    const FF2m *ff2m = NULL;
+    NTSKEM_private *priv = NULL;
+    vector a[NTS_KEM_PARAM_M];
+    vector g[NTS_KEM_PARAM_M];
+    vector h[NTS_KEM_PARAM_M];
     
-    nts_kem->public_key_size = NTS_KEM_PUBLIC_KEY_SIZE;
-    nts_kem->public_key = (uint8_t *)calloc(nts_kem->public_key_size, sizeof(uint8_t));
-    if (!nts_kem->public_key)
-        return NTS_KEM_BAD_MEMORY_ALLOCATION;
-    priv->m = NTS_KEM_PARAM_M;
-    key_ptr = nts_kem->public_key;
-    for (i=0; i<NTS_KEM_PARAM_K; i++) {
-        v_ptr = (packed_t *)row_ptr_matrix_ff2(Q, i);
-        for (j=0; j<NTS_KEM_PARAM_C; j++) {
-            bit_value = bit_value(v_ptr, j);
-            s = j >> 3;
-            key_ptr[(i * b) + s] |= ((uint8_t)(bit_value << (j - (s << 3))));
+    if (!nts_kem || !nts_kem->priv)
+        return NTS_KEM_BAD_PARAMETERS;
+    
+    priv = (NTSKEM_private *)nts_kem->priv;
+    ff2m = priv->ff2m;
+    
+    CT_memset(s, 0, count*sizeof(ff_unit));
+    for (i=0; i<NTS_KEM_PARAM_BC_VEC; i++) {
+        vector_load_2d_256((__m256i (*)[NTS_KEM_PARAM_M])a, &priv->a[i*BLOCK_SIZE],
+                           (i < NTS_KEM_PARAM_BC_VEC-1) ? BLOCK_SIZE : NTS_KEM_PARAM_BC - i*BLOCK_SIZE);
+        vector_load_2d_256((__m256i (*)[NTS_KEM_PARAM_M])g, &weight[i*BLOCK_SIZE],
+                           (i < NTS_KEM_PARAM_BC_VEC-1) ? BLOCK_SIZE : NTS_KEM_PARAM_BC - i*BLOCK_SIZE);
+        for (j=0; j<NTS_KEM_PARAM_M; j++)
+            g[j] &= c_ptr[i];
+        s[0] ^= vector_ff_transpose_xor_13(ff2m, g);
+        for (j=1; j+1<count; j+=2) {
+            vector_ff_mul_13(ff2m, h, a, g);
+            s[j] ^= vector_ff_transpose_xor_13(ff2m, h);
+            vector_ff_mul_13(ff2m, g, a, h);
+            s[j+1] ^= vector_ff_transpose_xor_13(ff2m, g);
+        }
+        if (j < count) {
+            vector_ff_mul_13(ff2m, h, a, g);
+            s[j] ^= vector_ff_transpose_xor_13(ff2m, h);
         }
     }
     
+    CT_memset(a, 0, sizeof(a));
+    CT_memset(g, 0, sizeof(g));
+    CT_memset(h, 0, sizeof(h));
+    
     return NTS_KEM_SUCCESS;
 }
 
 /**
- *  Serialise NTS private key
+ *  Compute the syndromes of every stride-th pass of the transposed
+ *  additive FFT, starting from pass first
  *
- *  @param[in] nts_kem    The pointer to NTS-KEM object
- *  @param[in] Q          The pointer to matrix Q
- *  @return NTS_KEM_SUCCESS on success, a negative integer otherwise
+ *  @note
+ *  As a_i is the field point at index p_i of the additive FFT,
+ *  placing c_i.h_i at index p_i turns s_j into the output of the
+ *  transposed FFT, which gives 256 syndromes per pass. The next
+ *  pass starts from c_i.h_i.a_i^256. The values are placed at
+ *  p_i by the inverse Beneš network, applied to each bit-plane.
+ *
+ *  @note
+ *  Only the passes given are computed and only their syndromes are
+ *  written to s, the passes are independent apart from the update
+ *  of c_i.h_i.a_i^{256k} which is done for all of them.
+ *
+ *  @param[in]  nts_kem   The pointer to NTS-KEM object
+ *  @param[in]  benes     The Beneš network of p, {@see benes_compile}
+ *  @param[in]  weight    The weights h_i, or w_i for Patterson decoding
+ *  @param[in]  c_ptr     The pointer to the inpute ciphertext
+ *  @param[out] s         The computed syndromes
+ *  @param[in]  count     The number of syndromes, 2τ or τ
+ *  @param[in]  first     The first pass
+ *  @param[in]  stride    The distance between the passes computed
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative status
+ *  {@see nts_kem_errors.h}
  **/
-int serialise_private_key(NTSKEM *nts_kem, const matrix_ff2* Q)
+int compute_syndrome_blocks(const NTSKEM* nts_kem,
+                            const uint64_t *benes,
+                            const ff_unit* weight,
+                            const vector *c_ptr,
+                            ff_unit* s,
+                            int32_t count,
+                            int32_t first,
+                            int32_t stride)
 {
-    int i, j, s;
-    const int32_t b = NTS_KEM_PARAM_CEIL_R_BYTE;
-    uint8_t *key_ptr = NULL;
-    packed_t bit_value, *v_ptr = NULL;
-    NTSKEM_private* priv = (NTSKEM_private *)nts_kem->priv;
-    
-    nts_kem->private_key_size = NTS_KEM_PRIVATE_KEY_SIZE;
-    nts_kem->private_key = (uint8_t *)calloc(nts_kem->private_key_size, sizeof(uint8_t));
-    if (!nts_kem->private_key)
-        return NTS_KEM_BAD_MEMORY_ALLOCATION;
-    key_ptr = nts_kem->private_key;
+    int32_t i, j, k;
+    const FF2m *ff2m = NULL;
+    NTSKEM_private *priv = NULL;
+    vector a[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
+    vector g[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
+    vector h[NTS_KEM_PARAM_M];
+    vector evals[NTS_KEM_PARAM_N_VEC][NTS_KEM_PARAM_M];
+    __m128i sums[2][NTS_KEM_PARAM_M];
+    ff_unit v[NTS_KEM_PARAM_N];
+    ff_unit t[BLOCK_SIZE];
     
-    pack_buffer((const uint8_t *)priv->a, NTS_KEM_PARAM_BC, key_ptr);
-    key_ptr += (NTS_KEM_PARAM_BC * 13/8);
+    if (!nts_kem || !nts_kem->priv || !benes)
+        return NTS_KEM_BAD_PARAMETERS;
     
-    pack_buffer((const uint8_t *)priv->h, NTS_KEM_PARAM_BC, key_ptr);
-    key_ptr += (NTS_KEM_PARAM_BC * 13/8);
+    priv = (NTSKEM_private *)nts_kem->priv;
+    ff2m = priv->ff2m;
     
-    pack_buffer((const uint8_t *)priv->p, NTS_KEM_PARAM_N, key_ptr);
-    key_ptr += (NTS_KEM_PARAM_N * 13/8);
+    vector_load_2d_256(a, priv->a, NTS_KEM_PARAM_BC);
+    vector_load_2d_256(g, weight, NTS_KEM_PARAM_BC);
     
-    memcpy(key_ptr, priv->z, NTS_KEM_KEY_SIZE);
-    key_ptr += NTS_KEM_KEY_SIZE;
+    for (i=0; i<NTS_KEM_PARAM_BC_VEC; i++) {
+        for (j=0; j<NTS_KEM_PARAM_M; j++)
+            g[i][j] &= c_ptr[i];
+    }
     
-    for (i=0; i<NTS_KEM_PARAM_K; i++) {
-        v_ptr = (packed_t *)row_ptr_matrix_ff2(Q, i);
-        for (j=0; j<NTS_KEM_PARAM_C; j++) {
-            bit_value = bit_value(v_ptr, j);
-            s = j >> 3;
-            key_ptr[(i * b) + s] |= ((uint8_t)(bit_value << (j - (s << 3))));
+    /* The positions a of the permuted sequence are always zero */
+    CT_memset(v, 0, sizeof(v));
+    for (k=0; k<count; k+=BLOCK_SIZE) {
+        if (k > 0) {
+            /* g_i = g_i.a_i^256 */
+            for (i=0; i<NTS_KEM_PARAM_BC_VEC; i++) {
+                for (j=0; j<8; j+=2) {
+                    vector_ff_sqr_13(ff2m, h, a[i]);
+                    vector_ff_sqr_13(ff2m, a[i], h);
+                }
+                vector_ff_mul_13(ff2m, h, g[i], a[i]);
+                memcpy(g[i], h, sizeof(h));
+            }
+        }
+        if ((k / BLOCK_SIZE) % stride != first)
+            continue;
+        
+        vector_store_2d_256(&v[NTS_KEM_PARAM_A], (const __m256i (*)[])g, NTS_KEM_PARAM_BC);
+        vector_load_2d_256(evals, v, NTS_KEM_PARAM_N);
+        benes_scatter_planes(evals, benes);
+        bitslice_fft13_256_tr(sums, evals);
+        vector_store_2d_128(t, (const __m128i (*)[])sums, BLOCK_SIZE);
+        for (i=0; i<BLOCK_SIZE && k+i<count; i++) {
+            s[k+i] = t[i];
         }
     }
+    
+    CT_memset(a, 0, sizeof(a));
+    CT_memset(g, 0, sizeof(g));
+    CT_memset(h, 0, sizeof(h));
+    CT_memset(evals, 0, sizeof(evals));
+    CT_memset(v, 0, sizeof(v));
+    CT_memset(t, 0, sizeof(t));
 
     return NTS_KEM_SUCCESS;
 }
 
 /**
- *  Deserialise NTS-KEM private key
+ *  Precompute the binary syndrome matrix of the private key
  *
- *  @param[out] nts_kem    The pointer to NTS-KEM object
- *  @param[in]  buf        Pointer to buffer containing private key blob
+ *  @note
+ *  Row j·m + l of the matrix holds bit l of a_i^j·h_i for all
+ *  the (b+c) positions i, stored in NTS_KEM_PARAM_BC_VEC vectors
+ *
+ *  @param[in]  nts_kem  The pointer to NTS-KEM object
+ *  @param[out] H        The syndrome matrix of SYNDROME_MATRIX_SIZE vectors
  *  @return NTS_KEM_SUCCESS on success, a negative integer otherwise
  **/
-int deserialise_private_key(NTSKEM* nts_kem, const uint8_t *buf)
+int create_syndrome_matrix(const NTSKEM* nts_kem, vector *H)
 {
-    NTSKEM_private* priv = (NTSKEM_private *)nts_kem->priv;
+    int32_t i, j, l;
+    const FF2m *ff2m = NULL;
+    NTSKEM_private *priv = NULL;
+    vector a[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
+    vector g[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
+    vector h[NTS_KEM_PARAM_M];
     
-    /* Deserialise vector a */
-    unpack_buffer(buf, priv->a, NTS_KEM_PARAM_BC);
-    buf += (NTS_KEM_PARAM_BC * 13/8);
+    if (!nts_kem || !nts_kem->priv)
+        return NTS_KEM_BAD_PARAMETERS;
     
-    /* Deserialise vector h */
-    unpack_buffer(buf, priv->h, NTS_KEM_PARAM_BC);
-    buf += (NTS_KEM_PARAM_BC * 13/8);
+    priv = (NTSKEM_private *)nts_kem->priv;
+    ff2m = priv->ff2m;
     
-    /* Deserialise vector p */
-    unpack_buffer(buf, priv->p, NTS_KEM_PARAM_N);
-    buf += (NTS_KEM_PARAM_N * 13/8);
+    vector_load_2d_256(a, priv->a, NTS_KEM_PARAM_BC);
+    vector_load_2d_256(g, priv->h, NTS_KEM_PARAM_BC);
     
-    /* Deserialise vector z */
-    memcpy(priv->z, buf, NTS_KEM_KEY_SIZE);
-    buf += NTS_KEM_KEY_SIZE;
+    for (i=0; i<NTS_KEM_PARAM_BC_VEC; i++) {
+        for (j=0; j<2*NTS_KEM_PARAM_T; j+=2) {
+            for (l=0; l<NTS_KEM_PARAM_M; l++)
+                H[((j*NTS_KEM_PARAM_M) + l)*NTS_KEM_PARAM_BC_VEC + i] = g[i][l];
+            vector_ff_mul_13(ff2m, h, a[i], g[i]);
+            for (l=0; l<NTS_KEM_PARAM_M; l++)
+                H[(((j+1)*NTS_KEM_PARAM_M) + l)*NTS_KEM_PARAM_BC_VEC + i] = h[l];
+            vector_ff_mul_13(ff2m, g[i], a[i], h);
+        }
+    }
+    
+    CT_memset(a, 0, sizeof(a));
+    CT_memset(g, 0, sizeof(g));
+    CT_memset(h, 0, sizeof(h));
     
-    /* Deserialise public-key */
-    memcpy(priv->pk, buf, NTS_KEM_PUBLIC_KEY_SIZE);
-
     return NTS_KEM_SUCCESS;
 }
 
 /**
- *  Fisher-Yates-Knuth-Yao shuffle on a sequence (in-place)
- *
- *  @note
- *  Fisher-Yates shuffle requires the generation of uniform
- *  random number between a certain range. Knuth-Yao method
- *  may be used to generate such numbers uniformly.
+ *  Compute the syndromes as a product of the precomputed syndrome
+ *  matrix and the ciphertext bits, {@see create_syndrome_matrix}
  *
- *  @param[in,out] buffer      The input/output sequence
+ *  @param[in]  H      The syndrome matrix
+ *  @param[in]  c_ptr  The vectorised ciphertext (c_b | c_c)
+ *  @param[out] s      The syndromes
+ *  @param[in]  count  The number of syndromes, i.e. rows of m bits
+ *  @return NTS_KEM_SUCCESS on success, a negative integer otherwise
  **/
-void fisher_yates_shuffle(ff_unit *buffer)
+int compute_syndrome_from_matrix(const vector *H,
+                                 const vector *c_ptr,
+                                 ff_unit* s,
+                                 int32_t count)
 {
-    ff_unit index, swap;
-    int i = NTS_KEM_PARAM_N - 1;
-    while (i > 0) {
-        index = random_uint16_bounded(i+1);
-        swap = buffer[index];
-        buffer[index] = buffer[i];
-        buffer[i] = swap;
-        --i;
+    int32_t i, j, l;
+    uint64_t x;
+    vector acc;
+    
+    for (j=0; j<count; j++) {
+        s[j] = 0;
+        for (l=0; l<NTS_KEM_PARAM_M; l++) {
+            acc = _mm256_and_si256(H[0], c_ptr[0]);
+            for (i=1; i<NTS_KEM_PARAM_BC_VEC; i++)
+                acc = _mm256_xor_si256(acc, _mm256_and_si256(H[i], c_ptr[i]));
+            H += NTS_KEM_PARAM_BC_VEC;
+            x = _mm256_extract_epi64(acc, 0) ^ _mm256_extract_epi64(acc, 1) ^
+                _mm256_extract_epi64(acc, 2) ^ _mm256_extract_epi64(acc, 3);
+            s[j] |= (ff_unit)((popcount(x) & 1) << l);
+        }
     }
+    
+    return NTS_KEM_SUCCESS;
 }
 
 /**
- * Core encapsulation routine
+ *  Recover the Goppa polynomial G(z) from the private key and
+ *  prepare it for Patterson decoding
  *
- *  @param[in]  e       The pointer to input error pattern
- *  @param[in]  pk      The pointer to NTS-KEM public key
- *  @param[out] c_ast   The pointer to the NTS-KEM ciphertext
- *  @param[out] k_r     The pointer to the encapsulated key
- *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
- *          {@see nts_kem_errors.h}
+ *  @note
+ *  The private key only holds h_i = G(a_i)^{-2}, so G(z) of degree τ
+ *  is interpolated from G(a_i) = w_i^{-1} at τ+1 of the points, where
+ *  w_i = sqrt(h_i), and then checked against all the (b+c) points
+ *
+ *  @param[in]  nts_kem  The pointer to NTS-KEM object
+ *  @param[out] pat      The Patterson decoding data
+ *  @return NTS_KEM_SUCCESS on success, NTS_KEM_BAD_PARAMETERS if G(z)
+ *          is inconsistent with h or it is not irreducible
  **/
-int encapsulate(const uint8_t *e,
-                const uint8_t *pk,
-                uint8_t *c_ast,
-                uint8_t *k_r)
+int create_patterson(const NTSKEM* nts_kem, NTSKEM_patterson* pat)
 {
-    int status = NTS_KEM_BAD_MEMORY_ALLOCATION;
-    int32_t i, j, l;
-    packed_t v;
-    const uint8_t *pk_ptr = pk;
-    vector c_c[NTS_KEM_PARAM_R_VEC];
-    vector Q[NTS_KEM_PARAM_K][NTS_KEM_PARAM_R_VEC];
-    uint8_t kr_in_buf[kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_N_BYTE];
-    uint8_t k_e[kNTSKEMKeysize];
+    int32_t i, j, k, status = NTS_KEM_BAD_PARAMETERS;
+    ff_unit a, x, y, check = 0;
+    const FF2m *ff2m = NULL;
+    NTSKEM_private *priv = NULL;
+    vector w[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
+    vector t[NTS_KEM_PARAM_M];
+    ff_unit P[NTS_KEM_PARAM_T+2], Q[NTS_KEM_PARAM_T+1], g[NTS_KEM_PARAM_T+1];
     
-    /**
-     * Populate the generator matrix, but only the parity section
-     **/
-    for (i=0; i<NTS_KEM_PARAM_K; i++) {
-        Q[i][NTS_KEM_PARAM_R_VEC-1] = _mm256_setzero_si256();
-        memcpy(Q[i], pk_ptr, NTS_KEM_PARAM_CEIL_R_BYTE);
-        pk_ptr += NTS_KEM_PARAM_CEIL_R_BYTE;
-    }
+    if (!nts_kem || !nts_kem->priv)
+        return NTS_KEM_BAD_PARAMETERS;
     
-    /**
-     * Step 3. Compute SHA3_256(e) to produce k_e
-     **/
-    sha3_256(e, NTS_KEM_PARAM_CEIL_N_BYTE, k_e);
+    priv = (NTSKEM_private *)nts_kem->priv;
+    ff2m = priv->ff2m;
     
-    /**
-     * Step 4. Construct a length k message vector m = (e_a | k_e)
-     * Step 5. Perform systematic encoding with matrix Q,
-     *         i.e. c = ( m | mQ ) + e
-     *                = ( c_a | c_b | c_c )
-     *                = ( 0_a | c_b | c_c )
-     *          c_ast = ( c_b | c_c )
-     *
-     * The c_c (or parity block) is basically section c of the
-     * ciphertext. It's basically c_c = (e_a | k_e)*Q where Q
-     * is the last n-k bits of the generator matrix in reduced
-     * echelon form G = [ I | Q ].
-     *
-     * Instead of doing matrix multiplication, we use vectorised
-     * XOR operations.
-     **/
-    for (i=0; i<NTS_KEM_PARAM_R_VEC; i++)
-        c_c[i] = _mm256_setzero_si256();
-    for (i=0; i<NTS_KEM_PARAM_A >> LOG2; i++) {
-        memcpy(&v, &e[i*sizeof(v)], sizeof(v));
-        while (v) {
-            l = (int32_t)lowest_bit_idx(v);
-            v ^= (ONE << l);
-            l += (BITSIZE*i);
-            for (j=0; j<NTS_KEM_PARAM_R_VEC; j++) {
-                c_c[j] ^= Q[l][j];
-            }
-        }
-    }
-    v = 0x0ULL;
-    memcpy(&v,  &e[i*sizeof(v)], NTS_KEM_PARAM_A_REM);
-    while (v) {
-        l = (int32_t)lowest_bit_idx(v);
-        v ^= (ONE << l);
-        l += (BITSIZE*i);
-        for (j=0; j<NTS_KEM_PARAM_R_VEC; j++) {
-            c_c[j] ^= Q[l][j];
+    /* w_i = h_i^{2^12} */
+    vector_load_2d_256(w, priv->h, NTS_KEM_PARAM_BC);
+    for (i=0; i<NTS_KEM_PARAM_BC_VEC; i++) {
+        for (j=0; j<NTS_KEM_PARAM_M-1; j+=2) {
+            vector_ff_sqr_13(ff2m, t, w[i]);
+            vector_ff_sqr_13(ff2m, w[i], t);
         }
     }
-    for (i=0; i<NTS_KEM_PARAM_B >> LOG2; i++) {
-        memcpy(&v, &k_e[i*sizeof(v)], sizeof(v));
-        while (v) {
-            l = (int32_t)lowest_bit_idx(v);
-            v ^= (ONE << l);
-            l += ((BITSIZE*i) + NTS_KEM_PARAM_A);
-            for (j=0; j<NTS_KEM_PARAM_R_VEC; j++) {
-                c_c[j] ^= Q[l][j];
-            }
-        }
+    vector_store_2d_256(pat->w, (const __m256i (*)[])w, NTS_KEM_PARAM_BC);
+    
+    /* P(z) = Π (z - a_i) over the first τ+1 points */
+    CT_memset(P, 0, sizeof(P));
+    P[0] = 1;
+    for (i=0; i<=NTS_KEM_PARAM_T; i++) {
+        for (k=i+1; k>0; k--)
+            P[k] = P[k-1] ^ ff2m->ff_mul(ff2m, P[k], priv->a[i]);
+        P[0] = ff2m->ff_mul(ff2m, P[0], priv->a[i]);
     }
     
-    /**
-     * The output is ciphertext containing the following section:
-     *
-     *     c = ( c_a | c_b | c_c )
-     *
-     * By construction, c_b = k_e and its length is kNTSKEMKeysize bytes,
-     * the length of c_a is (k/8 - kNTSKEMKeysize) bytes and the length of
-     * c_c is (n-k)/8 bytes.
-     *
-     * The error pattern e = ( e_a | e_b | e_c ), therefore, after
-     * adding e to c, c_a = 0, and we have
-     *
-     *     c_ast = ( k_e + e_b | c_c + e_c )
-     **/
-    memcpy(c_ast, k_e, kNTSKEMKeysize);                             /* k_e */
-    memcpy(&c_ast[kNTSKEMKeysize], c_c, NTS_KEM_PARAM_CEIL_R_BYTE); /* c_c */
+    /* G(z) = Σ G(a_i).Q_i(z)/Q_i(a_i), where Q_i(z) = P(z)/(z - a_i) */
+    CT_memset(g, 0, sizeof(g));
+    for (i=0; i<=NTS_KEM_PARAM_T; i++) {
+        a = priv->a[i];
+        Q[NTS_KEM_PARAM_T] = P[NTS_KEM_PARAM_T+1];
+        for (k=NTS_KEM_PARAM_T; k>0; k--)
+            Q[k-1] = P[k] ^ ff2m->ff_mul(ff2m, a, Q[k]);
+        for (x=0, k=NTS_KEM_PARAM_T; k>=0; k--)
+            x = ff2m->ff_mul(ff2m, x, a) ^ Q[k];
+        y = ff2m->ff_mul(ff2m, ff2m->ff_inv(ff2m, pat->w[i]), ff2m->ff_inv(ff2m, x));
+        for (k=0; k<=NTS_KEM_PARAM_T; k++)
+            g[k] ^= ff2m->ff_mul(ff2m, y, Q[k]);
+    }
     
-    /**
-     * Perturb the NTS ciphertext with error pattern in section b and c.
-     *
-     * There is no need to perturb section a as we know it will result
-     * to 0 and we are going to drop this section anyway.
-     */
-    for (i=0; i<NTS_KEM_CIPHERTEXT_SIZE; i++) {
-        c_ast[i] ^= e[(NTS_KEM_PARAM_A>>3) + i];    /* c_b = k_e + e_b, c_c = c_c + e_c */
+    /* Check that G(z) is monic and G(a_i).w_i = 1 for all points */
+    check = g[NTS_KEM_PARAM_T] ^ 1;
+    for (i=0; i<NTS_KEM_PARAM_BC; i++) {
+        for (x=0, k=NTS_KEM_PARAM_T; k>=0; k--)
+            x = ff2m->ff_mul(ff2m, x, priv->a[i]) ^ g[k];
+        check |= ff2m->ff_mul(ff2m, x, pat->w[i]) ^ 1;
     }
+    if (check)
+        goto create_patterson_fail;
     
-    /**
-     * Step 6. Output the pair (k_r, c_ast) where k_r = SHA3_256(k_e | e)
-     *
-     * Construct (k_e | e) and obtain k_r = SHA3_256(k_e | e)
-     **/
-    memcpy(kr_in_buf, k_e, kNTSKEMKeysize);
-    memcpy(&kr_in_buf[kNTSKEMKeysize], e, NTS_KEM_PARAM_CEIL_N_BYTE);
-    sha3_256(kr_in_buf, kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_N_BYTE, k_r);
+    vector_load_2d_256((__m256i (*)[NTS_KEM_PARAM_M])pat->g, g, NTS_KEM_PARAM_T+1);
+    if (bitslice_patterson_setup(pat->sqrt_z, pat->g))
+        goto create_patterson_fail;
     
     status = NTS_KEM_SUCCESS;
-    CT_memset(kr_in_buf, 0, kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_N_BYTE);
+create_patterson_fail:
+    CT_memset(w, 0, sizeof(w));
+    CT_memset(t, 0, sizeof(t));
+    CT_memset(P, 0, sizeof(P));
+    CT_memset(Q, 0, sizeof(Q));
+    CT_memset(g, 0, sizeof(g));
     
     return status;
 }
 
 /**
- *  Compute the syndrome vectors
- *
- *  @note
- *  This function implements Step 3 of NTS-KEM Decapsulation 
- *  procedure as described in the submitted NIST document.
+ *  Precompute the binary matrix of S(z) = Σ c_i/(z - a_i) mod G(z)
  *
  *  @note
- *  Given the data and parity-check vectors, both of which have 
- *  been corrupted with errors, compute the syndrome vector.
+ *  As G(z) - G(a) = (z - a).Σ_l q_l(a).z^l, where q_{τ-1} = 1 and
+ *  q_{l-1} = g_l + a.q_l, 1/(z - a_i) = w_i.Σ_l q_l(a_i).z^l mod G(z).
+ *  Row l·m + j of the matrix holds bit j of w_i.q_l(a_i) for all
+ *  the (b+c) positions i, stored in NTS_KEM_PARAM_BC_VEC vectors
  *
- *  @param[in]  nts_kem   The pointer to NTS-KEM object
- *  @param[in]  c_ptr     The pointer to the inpute ciphertext
- *  @param[out] s         The computed 2*t syndromes
- *  @return NTS_KEM_SUCCESS on success, otherwise a negative status
- *  {@see nts_kem_errors.h}
+ *  @param[in]  nts_kem  The pointer to NTS-KEM object
+ *  @param[in]  pat      The Patterson decoding data
+ *  @param[out] H        The matrix of GOPPA_SYNDROME_MATRIX_SIZE vectors
+ *  @return NTS_KEM_SUCCESS on success, a negative integer otherwise
  **/
-int compute_syndrome(const NTSKEM* nts_kem,
-                     const vector *c_ptr,
-                     ff_unit* s)
+int create_goppa_syndrome_matrix(const NTSKEM* nts_kem,
+                                 const NTSKEM_patterson* pat,
+                                 vector *H)
 {
-    int32_t i, j;
-    FF2m *ff2m = NULL;
+    int32_t i, j, l;
+    const FF2m *ff2m = NULL;
     NTSKEM_private *priv = NULL;
     vector a[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
-    vector g[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
-    vector h[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
+    vector w[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
+    vector q[NTS_KEM_PARAM_M], t[NTS_KEM_PARAM_M];
     
-    if (!nts_kem || !nts_kem->priv)
+    if (!nts_kem || !nts_kem->priv || !pat)
         return NTS_KEM_BAD_PARAMETERS;
     
     priv = (NTSKEM_private *)nts_kem->priv;
     ff2m = priv->ff2m;
     
     vector_load_2d_256(a, priv->a, NTS_KEM_PARAM_BC);
-    vector_load_2d_256(g, priv->h, NTS_KEM_PARAM_BC);
+    vector_load_2d_256(w, pat->w, NTS_KEM_PARAM_BC);
     
-    CT_memset(s, 0, 2*NTS_KEM_PARAM_T*sizeof(ff_unit));
-    CT_memset(h, 0, NTS_KEM_PARAM_BC_VEC*NTS_KEM_PARAM_M*sizeof(vector));
     for (i=0; i<NTS_KEM_PARAM_BC_VEC; i++) {
         for (j=0; j<NTS_KEM_PARAM_M; j++)
-            g[i][j] &= *c_ptr;
-        c_ptr++;
-        s[0] ^= ff2m->vector_ff_transpose_xor(ff2m, g[i]);
-        for (j=1; j<=2*NTS_KEM_PARAM_T-2; j+=2) {
-            ff2m->vector_ff_mul(ff2m, h[i], a[i], g[i]);
-            s[j]   ^= ff2m->vector_ff_transpose_xor(ff2m, h[i]);
-            ff2m->vector_ff_mul(ff2m, g[i], a[i], h[i]);
-            s[j+1] ^= ff2m->vector_ff_transpose_xor(ff2m, g[i]);
+            q[j] = _mm256_setzero_si256();
+        q[0] = _mm256_set1_epi64x(-1LL);
+        for (l=NTS_KEM_PARAM_T-1; l>=0; l--) {
+            vector_ff_mul_13(ff2m, t, w[i], q);
+            for (j=0; j<NTS_KEM_PARAM_M; j++)
+                H[((l*NTS_KEM_PARAM_M) + j)*NTS_KEM_PARAM_BC_VEC + i] = t[j];
+            /* q = g_l + a.q, g_l is bit l of the bit-sliced G(z) */
+            vector_ff_mul_13(ff2m, t, a[i], q);
+            for (j=0; j<NTS_KEM_PARAM_M; j++)
+                q[j] = _mm256_xor_si256(t[j], _mm256_set1_epi64x(
+                            -(long long)(((uint64_t)pat->g[j][l >> 6] >> (l & 63)) & 1ULL)));
         }
-        ff2m->vector_ff_mul(ff2m, h[i], a[i], g[i]);
-        s[j] ^= ff2m->vector_ff_transpose_xor(ff2m, h[i]);
     }
     
     CT_memset(a, 0, sizeof(a));
-    CT_memset(g, 0, sizeof(g));
-    CT_memset(h, 0, sizeof(h));
-
+    CT_memset(w, 0, sizeof(w));
+    CT_memset(q, 0, sizeof(q));
+    CT_memset(t, 0, sizeof(t));
+    
     return NTS_KEM_SUCCESS;
 }
 
 /**
  *  Permute the error vector
  *
+ *  @note
+ *  The bits of e_prime are read at the positions p_i, which depend
+ *  on the private key, {@see benes_permute} for a permutation in
+ *  constant time
+ *
  *  @param[in]      e_prime Error vector in inverse permuted order
  *  @param[in]      p       Permutation vector p
  *  @param[out]     e       Error vector
@@ -1364,6 +3272,28 @@ void permute_error(const uint8_t* e_prime,
     }
 }
 
+/**
+ *  Scatter the m bit-planes of a bit-sliced sequence of n
+ *  elements of F_{2^m} in place, x_{p_i} <- x_i
+ *
+ *  @param[in,out] x       The bit-sliced sequence
+ *  @param[in]     masks   The Beneš network of p, {@see benes_compile}
+ **/
+void benes_scatter_planes(vector (*x)[NTS_KEM_PARAM_M], const uint64_t *masks)
+{
+    int32_t i, j;
+    vector v[NTS_KEM_PARAM_N_VEC];
+    
+    for (j=0; j<NTS_KEM_PARAM_M; j++) {
+        for (i=0; i<NTS_KEM_PARAM_N_VEC; i++)
+            v[i] = x[i][j];
+        benes_permute_inverse((uint64_t *)v, masks);
+        for (i=0; i<NTS_KEM_PARAM_N_VEC; i++)
+            x[i][j] = v[i];
+    }
+    CT_memset(v, 0, sizeof(v));
+}
+
 /**
  *  Create a random vector `e` of length `n` bits with
  *  Hamming weight `tau`
@@ -1373,6 +3303,21 @@ void permute_error(const uint8_t* e_prime,
  *  @param[out] e    The output vector
  **/
 void random_vector(uint32_t tau, uint32_t n, uint8_t *e)
+{
+    random_vector_xof(tau, n, e, NULL);
+}
+
+/**
+ *  Create a random vector `e` of length `n` bits with
+ *  Hamming weight `tau` from a given source of random bits
+ *
+ *  @param[in]     tau  The desired Hamming weight
+ *  @param[in]     n    The length of the sequence in bits
+ *  @param[out]    e    The output vector
+ *  @param[in,out] rng  The source of random bits, or NULL
+ *                      for {@see random_uint16_bounded}
+ **/
+void random_vector_xof(uint32_t tau, uint32_t n, uint8_t *e, xof_source *rng)
 {
     int32_t i;
     uint8_t a, b;
@@ -1392,7 +3337,7 @@ void random_vector(uint32_t tau, uint32_t n, uint8_t *e)
      **/
     i = NTS_KEM_PARAM_N-1;
     while (i >= NTS_KEM_PARAM_N-NTS_KEM_PARAM_T) {
-        index = random_uint16_bounded(i+1);
+        index = rng ? xof_uint16_bounded(rng, i+1) : random_uint16_bounded(i+1);
         a = (e[index >> 3] & (1 << (index & 7))) >> (index & 7);
         b = (e[i >> 3] & (1 << (i & 7))) >> (i & 7);
         e[index >> 3] &= ~(1 << (index & 7));
@@ -1404,26 +3349,97 @@ void random_vector(uint32_t tau, uint32_t n, uint8_t *e)
 }
 
 /**
- *  Load an input byte array of the ciphertext onto a
- *  vectorised array.
- *
- *  @note
- *  It performs unaligned SIMD load
+ *  Check the fragments of a ciphertext
  *
- *  @param[out] out  The vectorised array
- *  @param[in]  in   The pointer to input ciphertext
+ *  @param[in] c_ast   The fragments of the NTS-KEM ciphertext
+ *  @param[in] iovcnt  The number of fragments
+ *  @return 1 if the lengths of the fragments add up to the ciphertext
+ *          size and none of them is missing, 0 otherwise
  **/
-void load_input_ciphertext(vector *out, const uint8_t *in)
+int is_valid_ciphertext_iov(const NTSKEM_iovec *c_ast, size_t iovcnt)
 {
-    int32_t i;
-    const uint8_t *ptr = in;
-    uint8_t last_buf[ BLOCK_SIZE ] = { 0 };
+    size_t i, len = 0;
+    
+    if (!c_ast)
+        return 0;
+    for (i=0; i<iovcnt; i++) {
+        if ((!c_ast[i].base && c_ast[i].len) ||
+            c_ast[i].len > NTS_KEM_CIPHERTEXT_SIZE - len)
+            return 0;
+        len += c_ast[i].len;
+    }
+    
+    return (len == NTS_KEM_CIPHERTEXT_SIZE);
+}
 
-    for (i=0; i<NTS_KEM_PARAM_BC_VEC-1; i++) {
-        out[i] = _mm256_loadu_si256((const __m256i *)ptr);
-        ptr += (UINT64_SIZE*sizeof(uint64_t));
+/**
+ *  Compute SHA3-256 of a fragmented ciphertext
+ *
+ *  @param[in]  c_ast   The fragments of the NTS-KEM ciphertext
+ *  @param[in]  iovcnt  The number of fragments
+ *  @param[out] digest  The digest of the ciphertext
+ **/
+void hash_ciphertext(const NTSKEM_iovec *c_ast, size_t iovcnt, uint8_t *digest)
+{
+    size_t i;
+    sha3_256_state sha3;
+    
+    sha3_256_init(&sha3);
+    for (i=0; i<iovcnt; i++) {
+        sha3_256_absorb(&sha3, (const uint8_t *)c_ast[i].base, c_ast[i].len);
     }
-    memcpy(last_buf, ptr, NTS_KEM_CIPHERTEXT_SIZE - ((NTS_KEM_PARAM_BC_VEC-1)*BLOCK_SIZE/8));
+    sha3_256_final(&sha3, digest);
+}
+
+/**
+ *  Gather the fragments of an input ciphertext to a vectorised array
+ *
+ *  @param[out] out     The vectorised array
+ *  @param[in]  in      The fragments of the input ciphertext
+ *  @param[in]  iovcnt  The number of fragments
+ **/
+void load_input_ciphertext(vector *out, const NTSKEM_iovec *in, size_t iovcnt)
+{
+    size_t i, offset = 0;
+    
     out[NTS_KEM_PARAM_BC_VEC-1] = _mm256_setzero_si256();
-    out[NTS_KEM_PARAM_BC_VEC-1] = _mm256_loadu_si256((const __m256i *)last_buf);
+    for (i=0; i<iovcnt; i++) {
+        if (in[i].len)
+            memcpy((uint8_t *)out + offset, in[i].base, in[i].len);
+        offset += in[i].len;
+    }
+}
+
+/**
+ *  Write len bytes of an output ciphertext, in[i] + mask[i], to its
+ *  fragments from a given offset
+ *
+ *  @param[in] out     The fragments of the output ciphertext
+ *  @param[in] iovcnt  The number of fragments
+ *  @param[in] offset  The offset of the bytes in the ciphertext
+ *  @param[in] in      The bytes to write
+ *  @param[in] mask    The bytes added to them
+ *  @param[in] len     The number of bytes
+ **/
+void store_output_ciphertext(const NTSKEM_iovec *out, size_t iovcnt, size_t offset,
+                             const uint8_t *in, const uint8_t *mask, size_t len)
+{
+    size_t i, j, n;
+    uint8_t *ptr = NULL;
+    
+    for (i=0; i<iovcnt && len; i++) {
+        if (offset >= out[i].len) {
+            offset -= out[i].len;
+            continue;
+        }
+        ptr = (uint8_t *)out[i].base + offset;
+        n = (out[i].len - offset < len) ? out[i].len - offset : len;
+        for (j=0; j<n; j++) {
+            ptr[j] = in[j] ^ mask[j];
+        }
+        in += n;
+        mask += n;
+        len -= n;
+        offset = 0;
+    }
 }
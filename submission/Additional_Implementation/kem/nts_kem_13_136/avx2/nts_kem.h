@@ -13,8 +13,14 @@
 #ifndef __NTS_KEM_H
 #define __NTS_KEM_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+/**
+ *  The size of the seed of a deterministic key generation
+ **/
+#define NTS_KEM_SEED_SIZE   32
+
 /**
  *  NTS data structure
  **/
@@ -37,6 +43,84 @@ typedef struct {
  **/
 int nts_kem_create(NTSKEM** nts_kem);
 
+/**
+ *  Initialise an NTS-KEM object deterministically from a seed
+ *
+ *  @note
+ *  All the randomness of the key generation is taken from
+ *  SHAKE256(seed), the same seed always results in the same
+ *  key pair. The seed is all that needs to be stored.
+ *
+ *  @param[out] nts_kem A pointer of NTSKEM object created
+ *  @param[in]  seed    The seed of NTS_KEM_SEED_SIZE bytes
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_create_from_seed(NTSKEM** nts_kem, const uint8_t *seed);
+
+/**
+ *  Opaque state of a resumable NTS-KEM key generation
+ **/
+typedef struct NTSKEM_keygen NTSKEM_keygen;
+
+/**
+ *  Start a resumable NTS-KEM key generation
+ *
+ *  @note
+ *  The key generation is performed by calling {@see nts_kem_keygen_step}
+ *  repeatedly, each call does a bounded amount of work, until it returns
+ *  NTS_KEM_SUCCESS. The keys are identical to those of {@see nts_kem_create}
+ *  given the same random source.
+ *
+ *  @param[out] keygen  A pointer of NTSKEM_keygen object created
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_keygen_begin(NTSKEM_keygen** keygen);
+
+/**
+ *  Start a resumable NTS-KEM key generation from a seed,
+ *  {@see nts_kem_create_from_seed}
+ *
+ *  @param[out] keygen  A pointer of NTSKEM_keygen object created
+ *  @param[in]  seed    The seed of NTS_KEM_SEED_SIZE bytes
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_keygen_begin_from_seed(NTSKEM_keygen** keygen, const uint8_t *seed);
+
+/**
+ *  Perform key generation work for roughly the given number of cycles
+ *
+ *  @note
+ *  At least one step is always performed, the budget is checked
+ *  between steps so a call may overrun it by at most one step.
+ *
+ *  @param[in,out] keygen         The pointer to an NTSKEM_keygen object
+ *  @param[in]     budget_cycles  The cycle budget of this call
+ *  @return NTS_KEM_KEYGEN_IN_PROGRESS if more work is required,
+ *          NTS_KEM_SUCCESS if the key generation is complete,
+ *          otherwise a negative error code {@see nts_kem_errors.h}
+ **/
+int nts_kem_keygen_step(NTSKEM_keygen* keygen, uint64_t budget_cycles);
+
+/**
+ *  Complete the key generation and release the key generation state
+ *
+ *  @param[in]  keygen   The pointer to an NTSKEM_keygen object
+ *  @param[out] nts_kem  A pointer of NTSKEM object created
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_keygen_finish(NTSKEM_keygen* keygen, NTSKEM** nts_kem);
+
+/**
+ *  Abandon a key generation and release its state
+ *
+ *  @param[in] keygen  The pointer to an NTSKEM_keygen object
+ **/
+void nts_kem_keygen_release(NTSKEM_keygen* keygen);
+
 /**
  *  Initialise an NTS-KEM object from a buffer containing the private key
  *
@@ -57,6 +141,20 @@ int nts_kem_init_from_private_key(NTSKEM** nts_kem,
  **/
 void nts_kem_release(NTSKEM *nts_kem);
 
+/**
+ *  Enable or disable 2 MB pages for the keys, the matrices of the key
+ *  generation and the syndrome matrices allocated subsequently
+ *
+ *  @note
+ *  Huge pages are used on Linux only, and the allocations fall back
+ *  to normal pages if none can be mapped. The default is given by
+ *  NTS_KEM_HUGE_PAGES.
+ *
+ *  @param[in] enable  Non-zero to enable huge pages
+ *  @return Whether huge pages were enabled
+ **/
+int nts_kem_huge_pages(int enable);
+
 /**
  *  Return the key size in bytes of NTS-KEM
  
@@ -85,9 +183,67 @@ int nts_kem_encapsulate(const uint8_t *pk,
                         uint8_t *c_ast,
                         uint8_t *k_r);
 
+/**
+ *  An encapsulation of a batch, {@see nts_kem_encapsulate_batch}
+ **/
+typedef struct {
+    const uint8_t *pk;              /* The pointer to NTS-KEM public key */
+    uint8_t *c_ast;                 /* The pointer to the NTS-KEM ciphertext */
+    uint8_t *k_r;                   /* The pointer to the encapsulated key */
+    int status;                     /* The outcome, as returned by
+                                       nts_kem_encapsulate */
+} NTSKEM_encap_job;
+
+/**
+ *  NTS-KEM encapsulation of a batch of keys, possibly under
+ *  different public keys
+ *
+ *  @note
+ *  Each job is encapsulated as by {@see nts_kem_encapsulate} and its
+ *  outcome is stored in its status. The error vectors of the batch
+ *  are expanded from a single random seed rather than drawn from
+ *  randombytes 128 bits at a time.
+ *
+ *  @param[in,out] jobs   The encapsulations
+ *  @param[in]     count  The number of encapsulations
+ *  @return NTS_KEM_SUCCESS if the batch is processed, otherwise a
+ *          negative error code {@see nts_kem_errors.h}
+ **/
+int nts_kem_encapsulate_batch(NTSKEM_encap_job* jobs,
+                              size_t count);
+
+/**
+ *  NTS-KEM encapsulation of a batch of keys whose randomness is
+ *  derived from a seed
+ *
+ *  @note
+ *  The same seed and jobs always produce the same ciphertexts and
+ *  keys. Only callers that manage their own random source, and never
+ *  use a seed twice, should call this function.
+ *
+ *  @param[in,out] jobs   The encapsulations
+ *  @param[in]     count  The number of encapsulations
+ *  @param[in]     seed   The seed of NTS_KEM_SEED_SIZE bytes
+ *  @return NTS_KEM_SUCCESS if the batch is processed, otherwise a
+ *          negative error code {@see nts_kem_errors.h}
+ **/
+int nts_kem_encapsulate_batch_from_seed(NTSKEM_encap_job* jobs,
+                                        size_t count,
+                                        const uint8_t *seed);
+
 /**
  *  NTS-KEM decapsulation
  *
+ *  @note
+ *  No memory is allocated, the private key is unpacked to the stack
+ *  and the public key within it is used in place
+ *
+ *  @note
+ *  The syndromes are computed by a chain of multiplications, which
+ *  does not depend on the permutation p, but the error vector is
+ *  permuted by indexing it with p. A decapsulation context created
+ *  with NTS_KEM_DECAP_BENES_NETWORK permutes it in constant time.
+ *
  *  @param[in]  sk      The pointer to NTS-KEM private key
  *  @param[in]  c_ast   The pointer to the NTS-KEM ciphertext
  *  @param[out] k_r     The pointer to the encapsulated key
@@ -98,4 +254,224 @@ int nts_kem_decapsulate(const uint8_t *sk,
                         const uint8_t *c_ast,
                         uint8_t *k_r);
 
+/**
+ *  A fragment of a ciphertext held in non-contiguous buffers,
+ *  the fragments of a ciphertext are taken in order and their
+ *  lengths add up to the ciphertext size
+ **/
+typedef struct {
+    void *base;                 /* The pointer to the fragment */
+    size_t len;                 /* The length of the fragment in bytes */
+} NTSKEM_iovec;
+
+/**
+ *  NTS-KEM encapsulation to a fragmented ciphertext
+ *
+ *  @note
+ *  The ciphertext is written straight to the fragments, the output
+ *  is identical to that of {@see nts_kem_encapsulate}
+ *
+ *  @param[in]  pk      The pointer to NTS-KEM public key
+ *  @param[out] c_ast   The fragments of the NTS-KEM ciphertext
+ *  @param[in]  iovcnt  The number of fragments
+ *  @param[out] k_r     The pointer to the encapsulated key
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_encapsulate_iov(const uint8_t *pk,
+                            const NTSKEM_iovec *c_ast,
+                            size_t iovcnt,
+                            uint8_t *k_r);
+
+/**
+ *  NTS-KEM decapsulation of a fragmented ciphertext
+ *
+ *  @note
+ *  The fragments are read in place, they are neither modified
+ *  nor copied to a contiguous buffer
+ *
+ *  @param[in]  sk      The pointer to NTS-KEM private key
+ *  @param[in]  c_ast   The fragments of the NTS-KEM ciphertext
+ *  @param[in]  iovcnt  The number of fragments
+ *  @param[out] k_r     The pointer to the encapsulated key
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decapsulate_iov(const uint8_t *sk,
+                            const NTSKEM_iovec *c_ast,
+                            size_t iovcnt,
+                            uint8_t *k_r);
+
+/**
+ *  NTS-KEM decapsulation context
+ *
+ *  A private key kept in its expanded form, together with
+ *  optional precomputed data, for repeated decapsulations
+ **/
+typedef struct NTSKEM_decap_ctx NTSKEM_decap_ctx;
+
+/**
+ *  Flags of nts_kem_decap_ctx_create
+ **/
+#define NTS_KEM_DECAP_SYNDROME_MATRIX   0x01    /* Precompute the syndrome matrix */
+#define NTS_KEM_DECAP_BENES_NETWORK     0x02    /* Permute with a Beneš network */
+#define NTS_KEM_DECAP_PATTERSON         0x04    /* Decode with Patterson's algorithm, if G(z) is irreducible */
+#define NTS_KEM_DECAP_PARALLEL          0x08    /* Split each decapsulation across threads */
+
+/**
+ *  The number of threads, including the caller, that share
+ *  a decapsulation with NTS_KEM_DECAP_PARALLEL
+ **/
+#ifndef NTS_KEM_DECAP_WORKERS
+#define NTS_KEM_DECAP_WORKERS           2
+#endif
+
+/**
+ *  Create an NTS-KEM decapsulation context from a private key
+ *
+ *  @param[out] ctx         A pointer of NTSKEM_decap_ctx object created
+ *  @param[in]  sk          The pointer to NTS-KEM private key
+ *  @param[in]  flags       Bitwise-OR of NTS_KEM_DECAP_* flags
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decap_ctx_create(NTSKEM_decap_ctx** ctx,
+                             const uint8_t *sk,
+                             uint32_t flags);
+
+/**
+ *  NTS-KEM decapsulation using a decapsulation context
+ *
+ *  @param[in]  ctx     The decapsulation context
+ *  @param[in]  c_ast   The pointer to the NTS-KEM ciphertext
+ *  @param[out] k_r     The pointer to the encapsulated key
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decap_ctx_decapsulate(const NTSKEM_decap_ctx* ctx,
+                                  const uint8_t *c_ast,
+                                  uint8_t *k_r);
+
+/**
+ *  NTS-KEM decapsulation of a fragmented ciphertext using
+ *  a decapsulation context
+ *
+ *  @param[in]  ctx     The decapsulation context
+ *  @param[in]  c_ast   The fragments of the NTS-KEM ciphertext
+ *  @param[in]  iovcnt  The number of fragments
+ *  @param[out] k_r     The pointer to the encapsulated key
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decap_ctx_decapsulate_iov(const NTSKEM_decap_ctx* ctx,
+                                      const NTSKEM_iovec *c_ast,
+                                      size_t iovcnt,
+                                      uint8_t *k_r);
+
+/**
+ *  Enable, resize or disable the cache of decapsulation results
+ *  of a decapsulation context
+ *
+ *  @note
+ *  A ciphertext found in the cache is not decapsulated again, its key
+ *  and status are returned from the cache. Both valid and implicitly
+ *  rejected ciphertexts are cached and the results are wiped when they
+ *  are evicted or expire. This function must not be called while the
+ *  context is in use by another thread.
+ *
+ *  @param[in,out] ctx       The decapsulation context
+ *  @param[in]     capacity  The maximum number of results, 0 to disable
+ *  @param[in]     ttl       The lifetime of a result in seconds,
+ *                           0 if results do not expire
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decap_ctx_set_cache(NTSKEM_decap_ctx* ctx,
+                                size_t capacity,
+                                uint32_t ttl);
+
+/**
+ *  Return the private key of a decapsulation context
+ *
+ *  @param[in] ctx  The decapsulation context
+ *  @return The serialised private key, valid as long as the context
+ **/
+const uint8_t* nts_kem_decap_ctx_private_key(const NTSKEM_decap_ctx* ctx);
+
+/**
+ *  Return the flags in effect of a decapsulation context
+ *
+ *  @note
+ *  NTS_KEM_DECAP_PATTERSON is dropped when the Goppa polynomial of
+ *  the key is reducible
+ *
+ *  @param[in] ctx  The decapsulation context
+ *  @return Bitwise-OR of NTS_KEM_DECAP_* flags
+ **/
+uint32_t nts_kem_decap_ctx_flags(const NTSKEM_decap_ctx* ctx);
+
+/**
+ *  Return the memory held by a decapsulation context
+ *
+ *  @param[in] ctx  The decapsulation context
+ *  @return The size in bytes, excluding the cache of results and the
+ *          segment of an attached context
+ **/
+size_t nts_kem_decap_ctx_size(const NTSKEM_decap_ctx* ctx);
+
+/**
+ *  Publish a decapsulation context in a named shared-memory segment
+ *  that other processes attach to, {@see nts_kem_decap_ctx_attach}
+ *
+ *  @note
+ *  The segment holds the private key and the precomputed tables of
+ *  the context. It is readable by the owner only and remains until
+ *  it is unpublished.
+ *
+ *  @param[in] ctx   The decapsulation context
+ *  @param[in] name  The name of the segment, as of shm_open
+ *  @return NTS_KEM_SUCCESS on success, NTS_KEM_BAD_PARAMETERS if the
+ *          name is taken, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decap_ctx_publish(const NTSKEM_decap_ctx* ctx,
+                              const char *name);
+
+/**
+ *  Create a decapsulation context attached to a published context
+ *
+ *  @note
+ *  The segment is mapped read-only and shared by all the contexts
+ *  attached to it, only the unpacked private key is held by each of
+ *  them. Of the flags, only NTS_KEM_DECAP_PARALLEL applies.
+ *
+ *  @param[out] ctx    A pointer of NTSKEM_decap_ctx object created
+ *  @param[in]  name   The name of the segment, as of shm_open
+ *  @param[in]  flags  Bitwise-OR of NTS_KEM_DECAP_* flags
+ *  @return NTS_KEM_SUCCESS on success, NTS_KEM_KEY_NOT_FOUND if there
+ *          is no such segment, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decap_ctx_attach(NTSKEM_decap_ctx** ctx,
+                             const char *name,
+                             uint32_t flags);
+
+/**
+ *  Remove the name of a published decapsulation context, the
+ *  contexts attached to it remain valid
+ *
+ *  @param[in] name  The name of the segment, as of shm_open
+ *  @return NTS_KEM_SUCCESS on success, NTS_KEM_KEY_NOT_FOUND if there
+ *          is no such segment, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_decap_ctx_unpublish(const char *name);
+
+/**
+ *  Release a decapsulation context
+ *
+ *  @param[in] ctx  The decapsulation context
+ **/
+void nts_kem_decap_ctx_release(NTSKEM_decap_ctx* ctx);
+
 #endif /* __NTS_KEM_H */
@@ -14,6 +14,7 @@
 #define __NTS_KEM_ERRORS_H
 
 #define NTS_KEM_SUCCESS                            0
+#define NTS_KEM_KEYGEN_IN_PROGRESS                 1
 
 #define NTS_KEM_RNG_BAD_MAX_LENGTH                -1
 #define NTS_KEM_RNG_INVALID_OUTPUT_BUFFER         -2
@@ -24,6 +25,8 @@
 #define NTS_KEM_BAD_KEY_LENGTH                  -101
 #define NTS_KEM_BAD_PARAMETERS                  -102
 #define NTS_KEM_INVALID_CIPHERTEXT              -103
+#define NTS_KEM_BUSY                            -104
+#define NTS_KEM_KEY_NOT_FOUND                   -105
 
 #define NTS_KEM_UNEXPECTED_ERROR                -200
 
@@ -13,11 +13,15 @@
 #include <stdio.h>
 #include <string.h>
 #include "random.h"
+#include "mem.h"
 #include "nts_kem_errors.h"
 
 #define PARAM_RND_SIZE      16
 #define PARAM_RND_BIT_SIZE  128
 
+static int32_t bits_consumed = PARAM_RND_BIT_SIZE;
+static uint8_t rnd_buffer[PARAM_RND_SIZE];
+
 #if defined(NIST_DRBG_AES)
 
 #include "aes_drbg.h"
@@ -103,8 +107,6 @@ uint16_t random_uint16_bounded(uint16_t bound)
     
 uint8_t randombit()
 {
-    static int32_t bits_consumed = PARAM_RND_BIT_SIZE;
-    static uint8_t rnd_buffer[PARAM_RND_SIZE];
     uint8_t b = 0;
     
     /**
@@ -124,3 +126,9 @@ uint8_t randombit()
     
     return b;
 }
+
+void randombit_reset()
+{
+    CT_memset(rnd_buffer, 0, sizeof(rnd_buffer));
+    bits_consumed = PARAM_RND_BIT_SIZE;
+}
@@ -66,4 +66,13 @@ uint16_t random_uint16_bounded(uint16_t bound);
  **/
 uint8_t randombit();
 
+/**
+ *  Discard the random bits buffered by {@see randombit}
+ *
+ *  @note
+ *  The bits that follow are taken afresh from randombytes, so that
+ *  after randombytes_init they only depend on the new input entropy
+ **/
+void randombit_reset();
+
 #endif /* __NTSKEM_RANDOM_H */
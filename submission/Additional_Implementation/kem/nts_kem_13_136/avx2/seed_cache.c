@@ -0,0 +1,165 @@
+/**
+ *  seed_cache.c
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include "seed_cache.h"
+#include "nts_kem_errors.h"
+#include "mem.h"
+
+typedef struct {
+    uint8_t seed[NTS_KEM_SEED_SIZE];
+    NTSKEM *nts_kem;            /* The expanded key, if complete */
+    NTSKEM_keygen *keygen;      /* The expansion, if in progress */
+    uint64_t last_used;
+} seed_cache_entry;
+
+struct NTSKEM_seed_cache {
+    size_t capacity;
+    uint64_t budget_cycles;
+    uint64_t clock;             /* Logical time of the last access */
+    seed_cache_entry *entry;
+};
+
+/**
+ *  Compare two seeds in constant time
+ *
+ *  @return 1 if the seeds are equal, 0 otherwise
+ **/
+static int seed_equal(const uint8_t *a, const uint8_t *b)
+{
+    int i;
+    uint8_t d = 0;
+    
+    for (i=0; i<NTS_KEM_SEED_SIZE; i++) {
+        d |= a[i] ^ b[i];
+    }
+    
+    return (int)((((uint32_t)d) - 1) >> 31);
+}
+
+static void seed_cache_evict(seed_cache_entry *entry)
+{
+    nts_kem_keygen_release(entry->keygen);
+    nts_kem_release(entry->nts_kem);
+    CT_memset(entry, 0, sizeof(seed_cache_entry));
+}
+
+int nts_kem_seed_cache_create(NTSKEM_seed_cache** cache,
+                              size_t capacity,
+                              uint64_t budget_cycles)
+{
+    if (!cache || !capacity)
+        return NTS_KEM_BAD_PARAMETERS;
+    
+    *cache = (NTSKEM_seed_cache *)calloc(1, sizeof(NTSKEM_seed_cache));
+    if (!(*cache))
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    
+    (*cache)->entry = (seed_cache_entry *)calloc(capacity, sizeof(seed_cache_entry));
+    if (!(*cache)->entry) {
+        free(*cache);
+        *cache = NULL;
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    }
+    (*cache)->capacity = capacity;
+    (*cache)->budget_cycles = budget_cycles;
+    
+    return NTS_KEM_SUCCESS;
+}
+
+int nts_kem_seed_cache_get(NTSKEM_seed_cache* cache,
+                           const uint8_t *seed,
+                           const NTSKEM** nts_kem)
+{
+    int32_t status;
+    size_t i, match = 0;
+    uint64_t found = 0, mask;
+    seed_cache_entry *entry = NULL, *victim = NULL;
+    
+    if (!cache || !seed || !nts_kem)
+        return NTS_KEM_BAD_PARAMETERS;
+    *nts_kem = NULL;
+    
+    /**
+     * Every slot is compared and the match is selected without
+     * branching, so that the time taken does not depend on where
+     * the seed is nor on how much of it matches another seed
+     **/
+    for (i=0; i<cache->capacity; i++) {
+        mask = -(uint64_t)((cache->entry[i].nts_kem || cache->entry[i].keygen) &
+                           seed_equal(cache->entry[i].seed, seed));
+        match = (size_t)((match & ~mask) | (i & mask));
+        found |= mask;
+    }
+    
+    if (found) {
+        entry = &cache->entry[match];
+    }
+    else {
+        /**
+         * Cache miss, the seed takes an unused slot, or else the least
+         * recently used complete key. Expansions in progress are never
+         * evicted, so that each of them completes however many seeds
+         * are requested. If all the slots hold one, the seed has to
+         * wait for one of them to complete.
+         **/
+        for (i=0; i<cache->capacity; i++) {
+            if (cache->entry[i].keygen)
+                continue;
+            if (!cache->entry[i].nts_kem) {
+                victim = &cache->entry[i];
+                break;
+            }
+            if (!victim || cache->entry[i].last_used < victim->last_used)
+                victim = &cache->entry[i];
+        }
+        if (!victim)
+            return NTS_KEM_BUSY;
+        entry = victim;
+        seed_cache_evict(entry);
+        status = nts_kem_keygen_begin_from_seed(&entry->keygen, seed);
+        if (status != NTS_KEM_SUCCESS)
+            return status;
+        memcpy(entry->seed, seed, NTS_KEM_SEED_SIZE);
+    }
+    entry->last_used = ++cache->clock;
+    
+    if (entry->keygen) {
+        status = nts_kem_keygen_step(entry->keygen, cache->budget_cycles);
+        if (status == NTS_KEM_SUCCESS) {
+            status = nts_kem_keygen_finish(entry->keygen, &entry->nts_kem);
+            entry->keygen = NULL;
+        }
+        if (status != NTS_KEM_SUCCESS) {
+            if (status != NTS_KEM_KEYGEN_IN_PROGRESS)
+                seed_cache_evict(entry);
+            return status;
+        }
+    }
+    *nts_kem = entry->nts_kem;
+    
+    return NTS_KEM_SUCCESS;
+}
+
+void nts_kem_seed_cache_release(NTSKEM_seed_cache* cache)
+{
+    size_t i;
+    
+    if (cache) {
+        for (i=0; i<cache->capacity; i++) {
+            seed_cache_evict(&cache->entry[i]);
+        }
+        free(cache->entry);
+        free(cache);
+    }
+}
@@ -0,0 +1,80 @@
+/**
+ *  seed_cache.h
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  Cache of NTS-KEM keys stored as seeds, {@see nts_kem_create_from_seed}.
+ *  A key is expanded from its seed on demand and kept in the cache until
+ *  it is evicted by a more recently used one.
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#ifndef __NTSKEM_SEED_CACHE_H
+#define __NTSKEM_SEED_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "nts_kem.h"
+
+typedef struct NTSKEM_seed_cache NTSKEM_seed_cache;
+
+/**
+ *  Create a cache of expanded NTS-KEM keys
+ *
+ *  @param[out] cache          A pointer of NTSKEM_seed_cache object created
+ *  @param[in]  capacity       The maximum number of expanded keys
+ *  @param[in]  budget_cycles  The CPU cycles budget of the expansion
+ *                             on each call to {@see nts_kem_seed_cache_get}
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int nts_kem_seed_cache_create(NTSKEM_seed_cache** cache,
+                              size_t capacity,
+                              uint64_t budget_cycles);
+
+/**
+ *  Return the expanded NTS-KEM key of a seed
+ *
+ *  @note
+ *  On a cache miss, the least recently used expanded key is evicted
+ *  and the expansion of the seed is started. The expansion stops once
+ *  the cycles budget of the cache is used up and
+ *  NTS_KEM_KEYGEN_IN_PROGRESS is returned, the expansion resumes when
+ *  the same seed is requested again. An expansion in progress is never
+ *  evicted, if every slot holds one, NTS_KEM_BUSY is returned for a
+ *  new seed until one of them completes.
+ *
+ *  @note
+ *  The seed is compared with those of all the slots in constant time.
+ *
+ *  @note
+ *  The returned object belongs to the cache, it remains valid until
+ *  the next call to {@see nts_kem_seed_cache_get} or
+ *  {@see nts_kem_seed_cache_release}.
+ *
+ *  @param[in]  cache    The pointer to an NTSKEM_seed_cache object
+ *  @param[in]  seed     The seed of NTS_KEM_SEED_SIZE bytes
+ *  @param[out] nts_kem  The expanded NTS-KEM object, NULL while
+ *                       the expansion is in progress
+ *  @return NTS_KEM_SUCCESS if the key is available,
+ *          NTS_KEM_KEYGEN_IN_PROGRESS if the expansion is in progress,
+ *          NTS_KEM_BUSY if all the slots hold expansions in progress,
+ *          otherwise a negative error code {@see nts_kem_errors.h}
+ **/
+int nts_kem_seed_cache_get(NTSKEM_seed_cache* cache,
+                           const uint8_t *seed,
+                           const NTSKEM** nts_kem);
+
+/**
+ *  Release the cache and all the expanded keys
+ *
+ *  @param[in] cache  The pointer to an NTSKEM_seed_cache object
+ **/
+void nts_kem_seed_cache_release(NTSKEM_seed_cache* cache);
+
+#endif /* __NTSKEM_SEED_CACHE_H */
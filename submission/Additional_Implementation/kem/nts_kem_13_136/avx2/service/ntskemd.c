@@ -0,0 +1,915 @@
+/**
+ *  ntskemd.c
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  A service daemon that holds NTS-KEM private keys in decapsulation
+ *  contexts and serves key generations, encapsulations and
+ *  decapsulations over a Unix domain socket {@see ntskemd.h}
+ *
+ *  The sockets are served by a single thread, the requests are run
+ *  in batches by an asynchronous engine {@see kem_engine.h} and the
+ *  private keys never leave the daemon.
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "api.h"
+#include "nts_kem.h"
+#include "nts_kem_errors.h"
+#include "kem_engine.h"
+#include "random.h"
+#include "mem.h"
+#include "ntskemd.h"
+
+#define NTSKEMD_MAX_KEYS            1024
+#define NTSKEMD_MAX_CONNS           256
+#define NTSKEMD_MAX_INFLIGHT        256     /* Requests of a connection */
+#define NTSKEMD_MAX_OUTPUT          (4*NTSKEMD_MAX_RESPONSE)
+#define NTSKEMD_STATS_SIZE          2048
+
+typedef struct {
+    uint32_t id;                    /* 0 if the key is destroyed or unused */
+    uint16_t generation;
+    NTSKEM_decap_ctx *ctx;
+    uint8_t *pk;
+    uint32_t refs;                  /* Requests in flight using the key */
+} daemon_key;
+
+typedef struct {
+    int fd;
+    uint8_t in[NTSKEMD_HEADER_SIZE + NTSKEMD_MAX_REQUEST];
+    size_t in_len;
+    uint8_t *out;
+    size_t out_off, out_len, out_cap;
+    uint32_t inflight;
+    int closed;
+} daemon_conn;
+
+typedef struct daemon_request {
+    NTSKEM_async_job job;
+    struct daemon_request *next;
+    daemon_conn *conn;
+    daemon_key *key;
+    NTSKEMD_header header;
+    uint64_t received;
+    uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+    uint8_t ss[CRYPTO_BYTES];
+} daemon_request;
+
+typedef struct {
+    uint64_t requests;
+    uint64_t errors;
+    uint64_t latency;               /* Nanoseconds, summed */
+    uint64_t max_latency;
+} daemon_op_stats;
+
+typedef struct {
+    int listen_fd;
+    int wake[2];                    /* Written to on completions and signals */
+    uint32_t ctx_flags;
+    NTSKEM_engine *engine;
+    FILE *trace;
+    uint64_t started;
+
+    daemon_key keys[NTSKEMD_MAX_KEYS];
+    size_t key_count;
+    daemon_conn *conns[NTSKEMD_MAX_CONNS];
+    size_t conn_count;
+    uint64_t accepted;
+
+    pthread_mutex_t done_lock;
+    daemon_request *done;           /* Completed requests, the latest first */
+
+    daemon_op_stats stats[NTSKEMD_OP_COUNT];
+    uint64_t protocol_errors;
+} daemon_state;
+
+static daemon_state server;
+static volatile sig_atomic_t daemon_stop = 0;
+
+static const char *op_names[NTSKEMD_OP_COUNT] = {
+    "keygen", "public_key", "encapsulate", "decapsulate", "destroy", "stats"
+};
+
+static uint64_t daemon_now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void daemon_signal(int sig)
+{
+    int saved = errno;
+
+    daemon_stop = 1;
+    if (write(server.wake[1], "s", 1) < 0) {
+        /* The loop is woken by the interrupted poll regardless */
+    }
+    errno = saved;
+}
+
+static void daemon_set_nonblocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+/**
+ *  Key table, a key identifier holds the slot index in its lower
+ *  16 bits and the generation of the slot in its upper 16 bits
+ **/
+static daemon_key *key_lookup(uint32_t id)
+{
+    uint32_t slot = (id & 0xFFFF) - 1;
+
+    if (slot >= NTSKEMD_MAX_KEYS || !server.keys[slot].id ||
+        server.keys[slot].id != id)
+        return NULL;
+
+    return &server.keys[slot];
+}
+
+static void key_free(daemon_key *key)
+{
+    nts_kem_decap_ctx_release(key->ctx);
+    free(key->pk);
+    key->ctx = NULL;
+    key->pk = NULL;
+}
+
+/**
+ *  Add a key to the table, taking the ownership of pk
+ **/
+static int key_add(const uint8_t *sk, uint8_t *pk, uint32_t *id)
+{
+    int status;
+    size_t slot;
+    daemon_key *key = NULL;
+
+    for (slot=0; slot<NTSKEMD_MAX_KEYS; slot++) {
+        key = &server.keys[slot];
+        if (!key->id && !key->ctx)
+            break;
+    }
+    if (slot == NTSKEMD_MAX_KEYS)
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+
+    status = nts_kem_decap_ctx_create(&key->ctx, sk, server.ctx_flags);
+    if (status != NTS_KEM_SUCCESS)
+        return status;
+    key->pk = pk;
+    key->refs = 0;
+    key->generation++;
+    key->id = ((uint32_t)key->generation << 16) | (uint32_t)(slot + 1);
+    server.key_count++;
+    *id = key->id;
+
+    return NTS_KEM_SUCCESS;
+}
+
+static void key_destroy(daemon_key *key)
+{
+    key->id = 0;
+    server.key_count--;
+    if (!key->refs)
+        key_free(key);
+}
+
+static void key_unref(daemon_key *key)
+{
+    if (key && --key->refs == 0 && !key->id)
+        key_free(key);
+}
+
+/**
+ *  Load a private key from a file and add it to the key table.
+ *  The public key is the last CRYPTO_PUBLICKEYBYTES bytes of the
+ *  private key.
+ **/
+static int key_load(const char *path, uint32_t *id)
+{
+    int status = NTS_KEM_BAD_PARAMETERS;
+    FILE *fp;
+    uint8_t *sk = NULL, *pk = NULL;
+
+    sk = (uint8_t *)malloc(CRYPTO_SECRETKEYBYTES);
+    pk = (uint8_t *)malloc(CRYPTO_PUBLICKEYBYTES);
+    if (!sk || !pk) {
+        status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+        goto key_load_fail;
+    }
+    if (!(fp = fopen(path, "rb")))
+        goto key_load_fail;
+    if (fread(sk, 1, CRYPTO_SECRETKEYBYTES, fp) != CRYPTO_SECRETKEYBYTES) {
+        fclose(fp);
+        goto key_load_fail;
+    }
+    fclose(fp);
+
+    memcpy(pk, &sk[CRYPTO_SECRETKEYBYTES - CRYPTO_PUBLICKEYBYTES], CRYPTO_PUBLICKEYBYTES);
+    status = key_add(sk, pk, id);
+    if (status == NTS_KEM_SUCCESS)
+        pk = NULL;
+
+key_load_fail:
+    if (sk) {
+        CT_memset(sk, 0, CRYPTO_SECRETKEYBYTES);
+        free(sk);
+    }
+    free(pk);
+
+    return status;
+}
+
+/**
+ *  Connections
+ **/
+static int conn_reserve(daemon_conn *conn, size_t len)
+{
+    size_t cap;
+    uint8_t *out;
+
+    if (conn->out_off && conn->out_off == conn->out_len)
+        conn->out_off = conn->out_len = 0;
+    if (conn->out_len + len <= conn->out_cap)
+        return 1;
+    if (conn->out_off) {
+        memmove(conn->out, &conn->out[conn->out_off], conn->out_len - conn->out_off);
+        conn->out_len -= conn->out_off;
+        conn->out_off = 0;
+        if (conn->out_len + len <= conn->out_cap)
+            return 1;
+    }
+    cap = conn->out_cap ? conn->out_cap : 4096;
+    while (cap < conn->out_len + len)
+        cap *= 2;
+    if (!(out = (uint8_t *)realloc(conn->out, cap)))
+        return 0;
+    conn->out = out;
+    conn->out_cap = cap;
+
+    return 1;
+}
+
+static void conn_flush(daemon_conn *conn)
+{
+    ssize_t n;
+
+    while (!conn->closed && conn->out_off < conn->out_len) {
+        n = write(conn->fd, &conn->out[conn->out_off], conn->out_len - conn->out_off);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                conn->closed = 1;
+            break;
+        }
+        conn->out_off += (size_t)n;
+    }
+}
+
+/**
+ *  Queue a response made of a header and up to two parts of payload
+ **/
+static void conn_reply(daemon_conn *conn, const NTSKEMD_header *request, int status,
+                       uint32_t key_id, const uint8_t *a, size_t a_len,
+                       const uint8_t *b, size_t b_len)
+{
+    NTSKEMD_header header;
+
+    if (conn->closed)
+        return;
+    if (!conn_reserve(conn, NTSKEMD_HEADER_SIZE + a_len + b_len)) {
+        conn->closed = 1;
+        return;
+    }
+
+    header.version = NTSKEMD_VERSION;
+    header.op = request->op;
+    header.status = (int16_t)status;
+    header.key_id = key_id;
+    header.tag = request->tag;
+    header.length = (uint32_t)(a_len + b_len);
+    ntskemd_put_header(&conn->out[conn->out_len], &header);
+    conn->out_len += NTSKEMD_HEADER_SIZE;
+    if (a_len) {
+        memcpy(&conn->out[conn->out_len], a, a_len);
+        conn->out_len += a_len;
+    }
+    if (b_len) {
+        memcpy(&conn->out[conn->out_len], b, b_len);
+        conn->out_len += b_len;
+    }
+}
+
+static void conn_free(daemon_conn *conn)
+{
+    if (conn->out) {
+        CT_memset(conn->out, 0, conn->out_cap);
+        free(conn->out);
+    }
+    CT_memset(conn->in, 0, sizeof(conn->in));
+    free(conn);
+}
+
+/**
+ *  Statistics
+ **/
+static void stats_record(const NTSKEMD_header *request, int status, uint64_t received)
+{
+    uint64_t latency = daemon_now() - received;
+    daemon_op_stats *stats;
+
+    if (request->op < 1 || request->op > NTSKEMD_OP_COUNT)
+        return;
+    stats = &server.stats[request->op - 1];
+    stats->requests++;
+    if (status != NTS_KEM_SUCCESS)
+        stats->errors++;
+    stats->latency += latency;
+    if (latency > stats->max_latency)
+        stats->max_latency = latency;
+}
+
+static size_t stats_format(char *buf, size_t size)
+{
+    int i;
+    size_t len = 0;
+    NTSKEM_engine_stats engine;
+    static const char *job_names[3] = { "keygen", "encapsulate", "decapsulate" };
+
+#define STATS_PRINT(...)                                                    \
+    do {                                                                    \
+        int n_ = snprintf(&buf[len], size - len, __VA_ARGS__);              \
+        if (n_ > 0) len += ((size_t)n_ < size - len) ? (size_t)n_ : size - len - 1; \
+    } while (0)
+
+    STATS_PRINT("algorithm %s\n", CRYPTO_ALGNAME);
+    STATS_PRINT("uptime_ms %llu\n",
+                (unsigned long long)((daemon_now() - server.started) / 1000000ULL));
+    STATS_PRINT("keys %lu\n", (unsigned long)server.key_count);
+    STATS_PRINT("connections %lu\n", (unsigned long)server.conn_count);
+    STATS_PRINT("connections_accepted %llu\n", (unsigned long long)server.accepted);
+    STATS_PRINT("protocol_errors %llu\n", (unsigned long long)server.protocol_errors);
+    for (i=0; i<NTSKEMD_OP_COUNT; i++) {
+        if (!server.stats[i].requests)
+            continue;
+        STATS_PRINT("%s_requests %llu\n", op_names[i],
+                    (unsigned long long)server.stats[i].requests);
+        STATS_PRINT("%s_errors %llu\n", op_names[i],
+                    (unsigned long long)server.stats[i].errors);
+        STATS_PRINT("%s_latency_avg_us %llu\n", op_names[i],
+                    (unsigned long long)(server.stats[i].latency / server.stats[i].requests / 1000ULL));
+        STATS_PRINT("%s_latency_max_us %llu\n", op_names[i],
+                    (unsigned long long)(server.stats[i].max_latency / 1000ULL));
+    }
+    nts_kem_engine_stats(server.engine, &engine);
+    STATS_PRINT("engine_pending %llu\n", (unsigned long long)engine.pending);
+    for (i=0; i<3; i++) {
+        if (!engine.batches[i])
+            continue;
+        STATS_PRINT("engine_%s_jobs %llu\n", job_names[i],
+                    (unsigned long long)engine.jobs[i]);
+        STATS_PRINT("engine_%s_batches %llu\n", job_names[i],
+                    (unsigned long long)engine.batches[i]);
+    }
+#undef STATS_PRINT
+
+    return len;
+}
+
+/**
+ *  Requests
+ **/
+static void request_done(NTSKEM_async_job *job, void *arg)
+{
+    daemon_request *request = (daemon_request *)arg;
+    int wake;
+
+    pthread_mutex_lock(&server.done_lock);
+    wake = (server.done == NULL);
+    request->next = server.done;
+    server.done = request;
+    pthread_mutex_unlock(&server.done_lock);
+
+    if (wake && write(server.wake[1], "c", 1) < 0) {
+        /* The pipe is full, a wake-up is already pending */
+    }
+}
+
+static void request_free(daemon_request *request)
+{
+    if (request->job.sk) {
+        CT_memset(request->job.sk, 0, CRYPTO_SECRETKEYBYTES);
+        free(request->job.sk);
+    }
+    if (request->job.op == NTS_KEM_JOB_KEYPAIR)
+        free(request->job.pk);
+    CT_memset(request, 0, sizeof(daemon_request));
+    free(request);
+}
+
+/**
+ *  Answer a request run by the engine
+ **/
+static void request_complete(daemon_request *request)
+{
+    int status = request->job.status;
+    uint32_t id = request->header.key_id;
+    daemon_conn *conn = request->conn;
+
+    switch (request->header.op) {
+        case NTSKEMD_OP_KEYGEN:
+            if (status == NTS_KEM_SUCCESS)
+                status = key_add(request->job.sk, request->job.pk, &id);
+            if (status == NTS_KEM_SUCCESS) {
+                conn_reply(conn, &request->header, status, id,
+                           request->job.pk, CRYPTO_PUBLICKEYBYTES, NULL, 0);
+                request->job.pk = NULL;
+            }
+            else {
+                conn_reply(conn, &request->header, status, 0, NULL, 0, NULL, 0);
+            }
+            break;
+        case NTSKEMD_OP_ENCAPSULATE:
+            if (status == NTS_KEM_SUCCESS)
+                conn_reply(conn, &request->header, status, id,
+                           request->ct, CRYPTO_CIPHERTEXTBYTES, request->ss, CRYPTO_BYTES);
+            else
+                conn_reply(conn, &request->header, status, id, NULL, 0, NULL, 0);
+            break;
+        default:
+            /**
+             * The key of an implicitly rejected ciphertext
+             * is returned with the status, as by crypto_kem_dec
+             **/
+            conn_reply(conn, &request->header, status, id,
+                       request->ss, CRYPTO_BYTES, NULL, 0);
+            break;
+    }
+    stats_record(&request->header, status, request->received);
+
+    key_unref(request->key);
+    conn->inflight--;
+    if (conn->closed && conn->fd < 0 && !conn->inflight)
+        conn_free(conn);
+    request_free(request);
+}
+
+/**
+ *  Handle a request, either answering it at once or submitting
+ *  it to the engine
+ **/
+static void request_handle(daemon_conn *conn, const NTSKEMD_header *header,
+                           const uint8_t *payload)
+{
+    int status = NTS_KEM_BAD_PARAMETERS;
+    size_t len;
+    daemon_key *key = NULL;
+    daemon_request *request = NULL;
+    uint64_t received = daemon_now();
+    char text[NTSKEMD_STATS_SIZE];
+
+    if (server.trace && header->op >= 1 && header->op <= NTSKEMD_OP_COUNT)
+        fprintf(server.trace, "%llu %s\n",
+                (unsigned long long)((received - server.started) / 1000ULL),
+                op_names[header->op - 1]);
+
+    switch (header->op) {
+        case NTSKEMD_OP_PUBLIC_KEY:
+            if (!(key = key_lookup(header->key_id))) {
+                status = NTS_KEM_KEY_NOT_FOUND;
+                break;
+            }
+            conn_reply(conn, header, NTS_KEM_SUCCESS, header->key_id,
+                       key->pk, CRYPTO_PUBLICKEYBYTES, NULL, 0);
+            stats_record(header, NTS_KEM_SUCCESS, received);
+            return;
+        case NTSKEMD_OP_DESTROY:
+            if (!(key = key_lookup(header->key_id))) {
+                status = NTS_KEM_KEY_NOT_FOUND;
+                break;
+            }
+            key_destroy(key);
+            status = NTS_KEM_SUCCESS;
+            break;
+        case NTSKEMD_OP_STATS:
+            len = stats_format(text, sizeof(text));
+            conn_reply(conn, header, NTS_KEM_SUCCESS, 0, (const uint8_t *)text, len, NULL, 0);
+            stats_record(header, NTS_KEM_SUCCESS, received);
+            return;
+        case NTSKEMD_OP_KEYGEN:
+        case NTSKEMD_OP_ENCAPSULATE:
+        case NTSKEMD_OP_DECAPSULATE:
+            if (header->op != NTSKEMD_OP_KEYGEN &&
+                !(key = key_lookup(header->key_id))) {
+                status = NTS_KEM_KEY_NOT_FOUND;
+                break;
+            }
+            if (header->op == NTSKEMD_OP_DECAPSULATE &&
+                header->length != CRYPTO_CIPHERTEXTBYTES) {
+                status = NTS_KEM_INVALID_CIPHERTEXT;
+                break;
+            }
+            if (!(request = (daemon_request *)calloc(1, sizeof(daemon_request)))) {
+                status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+                break;
+            }
+            request->conn = conn;
+            request->header = *header;
+            request->received = received;
+            request->job.ct = request->ct;
+            request->job.ss = request->ss;
+            request->job.callback = request_done;
+            request->job.arg = request;
+            if (header->op == NTSKEMD_OP_KEYGEN) {
+                request->job.op = NTS_KEM_JOB_KEYPAIR;
+                request->job.pk = (uint8_t *)malloc(CRYPTO_PUBLICKEYBYTES);
+                request->job.sk = (uint8_t *)malloc(CRYPTO_SECRETKEYBYTES);
+                if (!request->job.pk || !request->job.sk) {
+                    request_free(request);
+                    status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+                    break;
+                }
+            }
+            else if (header->op == NTSKEMD_OP_ENCAPSULATE) {
+                request->job.op = NTS_KEM_JOB_ENCAPSULATE;
+                request->job.pk = key->pk;
+            }
+            else {
+                request->job.op = NTS_KEM_JOB_DECAPSULATE;
+                request->job.ctx = key->ctx;
+                memcpy(request->ct, payload, CRYPTO_CIPHERTEXTBYTES);
+            }
+            request->key = key;
+            status = nts_kem_engine_submit(server.engine, &request->job);
+            if (status != NTS_KEM_SUCCESS) {
+                request_free(request);
+                break;
+            }
+            if (key)
+                key->refs++;
+            conn->inflight++;
+            return;
+        default:
+            server.protocol_errors++;
+            break;
+    }
+
+    conn_reply(conn, header, status, header->key_id, NULL, 0, NULL, 0);
+    stats_record(header, status, received);
+}
+
+/**
+ *  Handle the complete requests read from a connection, while
+ *  it has fewer than NTSKEMD_MAX_INFLIGHT requests in flight.
+ *  Returns zero if the connection is to be closed.
+ **/
+static int conn_parse(daemon_conn *conn)
+{
+    size_t off = 0;
+    NTSKEMD_header header;
+
+    while (conn->in_len - off >= NTSKEMD_HEADER_SIZE &&
+           conn->inflight < NTSKEMD_MAX_INFLIGHT && !conn->closed) {
+        ntskemd_get_header(&header, &conn->in[off]);
+        if (header.version != NTSKEMD_VERSION || header.length > NTSKEMD_MAX_REQUEST) {
+            server.protocol_errors++;
+            return 0;
+        }
+        if (conn->in_len - off < NTSKEMD_HEADER_SIZE + header.length)
+            break;
+        request_handle(conn, &header, &conn->in[off + NTSKEMD_HEADER_SIZE]);
+        off += NTSKEMD_HEADER_SIZE + header.length;
+    }
+    if (off) {
+        memmove(conn->in, &conn->in[off], conn->in_len - off);
+        conn->in_len -= off;
+    }
+
+    return !conn->closed;
+}
+
+/**
+ *  Read from a connection. Returns zero if the connection
+ *  is to be closed.
+ **/
+static int conn_read(daemon_conn *conn)
+{
+    ssize_t n;
+
+    if (conn->in_len == sizeof(conn->in))
+        return 1;
+    n = read(conn->fd, &conn->in[conn->in_len], sizeof(conn->in) - conn->in_len);
+    if (n == 0)
+        return 0;
+    if (n < 0)
+        return (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK);
+    conn->in_len += (size_t)n;
+
+    return 1;
+}
+
+static void conn_close(size_t index)
+{
+    daemon_conn *conn = server.conns[index];
+
+    close(conn->fd);
+    conn->fd = -1;
+    conn->closed = 1;
+    server.conns[index] = server.conns[--server.conn_count];
+    if (!conn->inflight)
+        conn_free(conn);
+}
+
+static void daemon_accept()
+{
+    int fd;
+    daemon_conn *conn;
+
+    while ((fd = accept(server.listen_fd, NULL, NULL)) >= 0) {
+        if (server.conn_count == NTSKEMD_MAX_CONNS ||
+            !(conn = (daemon_conn *)calloc(1, sizeof(daemon_conn)))) {
+            close(fd);
+            continue;
+        }
+        daemon_set_nonblocking(fd);
+        conn->fd = fd;
+        server.conns[server.conn_count++] = conn;
+        server.accepted++;
+    }
+}
+
+static void daemon_complete()
+{
+    char buf[64];
+    daemon_request *list, *next, *order = NULL;
+
+    while (read(server.wake[0], buf, sizeof(buf)) > 0)
+        ;
+
+    pthread_mutex_lock(&server.done_lock);
+    list = server.done;
+    server.done = NULL;
+    pthread_mutex_unlock(&server.done_lock);
+
+    /* Answer in the order of completion */
+    while (list) {
+        next = list->next;
+        list->next = order;
+        order = list;
+        list = next;
+    }
+    while (order) {
+        next = order->next;
+        request_complete(order);
+        order = next;
+    }
+}
+
+static int daemon_listen(const char *path)
+{
+    struct sockaddr_un addr;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "ntskemd: socket path too long\n");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    if ((server.listen_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        perror("ntskemd: socket");
+        return -1;
+    }
+    unlink(path);
+    if (bind(server.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        chmod(path, S_IRUSR | S_IWUSR) < 0 ||
+        listen(server.listen_fd, 64) < 0) {
+        perror("ntskemd: bind");
+        return -1;
+    }
+    daemon_set_nonblocking(server.listen_fd);
+
+    return 0;
+}
+
+/**
+ *  Seed the random source of the library from the system
+ **/
+static int daemon_seed()
+{
+    int ok;
+    FILE *fp;
+    unsigned char entropy[48];
+
+    if (!(fp = fopen("/dev/urandom", "rb")))
+        return 0;
+    ok = (fread(entropy, 1, sizeof(entropy), fp) == sizeof(entropy));
+    fclose(fp);
+    if (ok)
+        randombytes_init(entropy, NULL, 256);
+    CT_memset(entropy, 0, sizeof(entropy));
+
+    return ok;
+}
+
+static void daemon_loop()
+{
+    size_t i, nfds;
+    struct pollfd fds[NTSKEMD_MAX_CONNS + 2];
+
+    while (!daemon_stop) {
+        fds[0].fd = server.listen_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = server.wake[0];
+        fds[1].events = POLLIN;
+        nfds = 2;
+        for (i=0; i<server.conn_count; i++) {
+            daemon_conn *conn = server.conns[i];
+
+            fds[nfds].fd = conn->fd;
+            fds[nfds].events = 0;
+            /* Stop reading while the connection is saturated */
+            if (conn->inflight < NTSKEMD_MAX_INFLIGHT &&
+                conn->out_len - conn->out_off < NTSKEMD_MAX_OUTPUT)
+                fds[nfds].events |= POLLIN;
+            if (conn->out_off < conn->out_len)
+                fds[nfds].events |= POLLOUT;
+            nfds++;
+        }
+
+        if (poll(fds, nfds, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("ntskemd: poll");
+            break;
+        }
+
+        if (fds[1].revents)
+            daemon_complete();
+        /* Connections past conn_count were accepted in this iteration */
+        for (i=server.conn_count; i-- > 0; ) {
+            daemon_conn *conn = server.conns[i];
+            short revents = fds[i + 2].revents;
+
+            if ((revents & (POLLIN | POLLHUP | POLLERR)) && !conn_read(conn))
+                conn->closed = 1;
+            /* Also resumes the requests held back while saturated */
+            if (!conn->closed && !conn_parse(conn))
+                conn->closed = 1;
+            if (!conn->closed)
+                conn_flush(conn);
+            if (conn->closed)
+                conn_close(i);
+        }
+        if (fds[0].revents)
+            daemon_accept();
+    }
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-s socket] [-w workers] [-l max_latency_us] [-x ctx_flags]\n"
+            "          [-c cache_size] [-t trace_file] [-k private_key_file]...\n"
+            "  -s  the Unix domain socket, default %s\n"
+            "  -w  the number of worker threads, 0 for one per CPU (default)\n"
+            "  -l  the time a request may wait for a batch to fill, default 100\n"
+            "  -x  NTS_KEM_DECAP_* flags of the decapsulation contexts\n"
+            "  -c  the number of decapsulation results cached per key, default 0\n"
+            "  -t  record the time and operation of every request, for replay\n"
+            "  -k  load a private key, its key identifier is printed\n",
+            name, NTSKEMD_SOCKET);
+}
+
+int main(int argc, char *argv[])
+{
+    int opt, workers = 0, status = EXIT_FAILURE;
+    size_t i, cache = 0, nkeys = 0;
+    uint32_t max_latency = 100, id;
+    const char *path = NTSKEMD_SOCKET;
+    const char *key_files[NTSKEMD_MAX_KEYS];
+    struct sigaction sa;
+
+    server.listen_fd = -1;
+    server.wake[0] = server.wake[1] = -1;
+    while ((opt = getopt(argc, argv, "s:w:l:x:c:t:k:h")) != -1) {
+        switch (opt) {
+            case 's': path = optarg; break;
+            case 'w': workers = atoi(optarg); break;
+            case 'l': max_latency = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'x': server.ctx_flags = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'c': cache = (size_t)strtoul(optarg, NULL, 10); break;
+            case 't':
+                if (!(server.trace = fopen(optarg, "w"))) {
+                    perror("ntskemd: trace");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'k':
+                if (nkeys < NTSKEMD_MAX_KEYS)
+                    key_files[nkeys++] = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if (!daemon_seed()) {
+        fprintf(stderr, "ntskemd: unable to seed the random source\n");
+        return EXIT_FAILURE;
+    }
+    pthread_mutex_init(&server.done_lock, NULL);
+    server.started = daemon_now();
+
+    for (i=0; i<nkeys; i++) {
+        if (key_load(key_files[i], &id) != NTS_KEM_SUCCESS) {
+            fprintf(stderr, "ntskemd: unable to load %s\n", key_files[i]);
+            goto main_fail;
+        }
+        printf("%s %u\n", key_files[i], id);
+    }
+    if (cache) {
+        for (i=0; i<NTSKEMD_MAX_KEYS; i++) {
+            if (server.keys[i].ctx)
+                nts_kem_decap_ctx_set_cache(server.keys[i].ctx, cache, 0);
+        }
+    }
+
+    if (pipe(server.wake) < 0) {
+        perror("ntskemd: pipe");
+        goto main_fail;
+    }
+    daemon_set_nonblocking(server.wake[0]);
+    daemon_set_nonblocking(server.wake[1]);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = daemon_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sa, NULL);
+
+    if (nts_kem_engine_create(&server.engine, workers, max_latency,
+                              1, 0) != NTS_KEM_SUCCESS) {
+        fprintf(stderr, "ntskemd: unable to start the engine\n");
+        goto main_fail;
+    }
+    if (daemon_listen(path) < 0)
+        goto main_fail;
+    printf("ntskemd: %s listening on %s\n", CRYPTO_ALGNAME, path);
+    fflush(stdout);
+
+    daemon_loop();
+    status = EXIT_SUCCESS;
+
+main_fail:
+    /* The engine completes the requests in flight before it stops */
+    if (server.engine) {
+        nts_kem_engine_release(server.engine);
+        daemon_complete();
+    }
+    while (server.conn_count)
+        conn_close(server.conn_count - 1);
+    for (i=0; i<NTSKEMD_MAX_KEYS; i++) {
+        if (server.keys[i].ctx)
+            key_free(&server.keys[i]);
+    }
+    if (server.listen_fd >= 0) {
+        close(server.listen_fd);
+        unlink(path);
+    }
+    if (server.wake[0] >= 0) {
+        close(server.wake[0]);
+        close(server.wake[1]);
+    }
+    if (server.trace)
+        fclose(server.trace);
+    pthread_mutex_destroy(&server.done_lock);
+
+    return status;
+}
@@ -0,0 +1,117 @@
+/**
+ *  ntskemd.h
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  The framing of the requests and responses of the NTS-KEM
+ *  service daemon, ntskemd, over a Unix domain socket
+ *
+ *  A frame is a header of NTSKEMD_HEADER_SIZE bytes followed by
+ *  `length` bytes of payload, the integers are little-endian:
+ *
+ *      offset  size  field
+ *           0     1  version, NTSKEMD_VERSION
+ *           1     1  op, NTSKEMD_OP_*
+ *           2     2  status, signed, {@see nts_kem_errors.h}
+ *           4     4  key_id
+ *           8     4  tag, chosen by the client and echoed
+ *          12     4  length of the payload
+ *
+ *  Requests are answered in the order they complete, which need not
+ *  be the order they are sent in, and are matched by their tag.
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#ifndef __NTSKEM_NTSKEMD_H
+#define __NTSKEM_NTSKEMD_H
+
+#include <stdint.h>
+
+#define NTSKEMD_VERSION             1
+#define NTSKEMD_HEADER_SIZE         16
+#define NTSKEMD_SOCKET              "/tmp/ntskemd.sock"
+
+/**
+ *  Operations, with their request and response payloads
+ **/
+#define NTSKEMD_OP_KEYGEN           1   /* -> key_id, public key */
+#define NTSKEMD_OP_PUBLIC_KEY       2   /* key_id -> public key */
+#define NTSKEMD_OP_ENCAPSULATE      3   /* key_id -> ciphertext || shared secret */
+#define NTSKEMD_OP_DECAPSULATE      4   /* key_id, ciphertext -> shared secret */
+#define NTSKEMD_OP_DESTROY          5   /* key_id -> */
+#define NTSKEMD_OP_STATS            6   /* -> text, a counter per line */
+
+#define NTSKEMD_OP_COUNT            6
+
+/**
+ *  The largest payload of a request, a ciphertext
+ **/
+#define NTSKEMD_MAX_REQUEST         CRYPTO_CIPHERTEXTBYTES
+
+/**
+ *  The largest payload of a response, a public key
+ **/
+#define NTSKEMD_MAX_RESPONSE        CRYPTO_PUBLICKEYBYTES
+
+typedef struct {
+    uint8_t version;
+    uint8_t op;
+    int16_t status;
+    uint32_t key_id;
+    uint32_t tag;
+    uint32_t length;
+} NTSKEMD_header;
+
+static inline void ntskemd_put32(uint8_t *buf, uint32_t x)
+{
+    buf[0] = (uint8_t)x;
+    buf[1] = (uint8_t)(x >> 8);
+    buf[2] = (uint8_t)(x >> 16);
+    buf[3] = (uint8_t)(x >> 24);
+}
+
+static inline uint32_t ntskemd_get32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+           ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/**
+ *  Serialise a frame header
+ *
+ *  @param[out] buf     The NTSKEMD_HEADER_SIZE bytes of the header
+ *  @param[in]  header  The header
+ **/
+static inline void ntskemd_put_header(uint8_t *buf, const NTSKEMD_header *header)
+{
+    buf[0] = header->version;
+    buf[1] = header->op;
+    buf[2] = (uint8_t)((uint16_t)header->status);
+    buf[3] = (uint8_t)((uint16_t)header->status >> 8);
+    ntskemd_put32(&buf[4], header->key_id);
+    ntskemd_put32(&buf[8], header->tag);
+    ntskemd_put32(&buf[12], header->length);
+}
+
+/**
+ *  Parse a frame header
+ *
+ *  @param[out] header  The header
+ *  @param[in]  buf     The NTSKEMD_HEADER_SIZE bytes of the header
+ **/
+static inline void ntskemd_get_header(NTSKEMD_header *header, const uint8_t *buf)
+{
+    header->version = buf[0];
+    header->op = buf[1];
+    header->status = (int16_t)((uint16_t)buf[2] | ((uint16_t)buf[3] << 8));
+    header->key_id = ntskemd_get32(&buf[4]);
+    header->tag = ntskemd_get32(&buf[8]);
+    header->length = ntskemd_get32(&buf[12]);
+}
+
+#endif /* __NTSKEM_NTSKEMD_H */
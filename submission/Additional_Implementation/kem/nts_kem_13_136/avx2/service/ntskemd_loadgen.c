@@ -0,0 +1,554 @@
+/**
+ *  ntskemd_loadgen.c
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  A load generator for the NTS-KEM service daemon, ntskemd. It keeps
+ *  a number of requests in flight on each of a number of connections,
+ *  either drawing the operations from a synthetic mix or replaying
+ *  a trace recorded by `ntskemd -t`, and reports the throughput and
+ *  the latency percentiles of every operation.
+ *
+ *  A replayed request is due at its recorded time and its latency is
+ *  counted from that time, so that a slow response does not hide the
+ *  delay of the requests queued behind it.
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "api.h"
+#include "nts_kem_errors.h"
+#include "ntskemd.h"
+
+#define LOADGEN_MAX_CONNS           256
+#define LOADGEN_MAX_DEPTH           256
+#define LOADGEN_POOL_SIZE           64      /* Ciphertexts to decapsulate */
+#define LOADGEN_TAG_DESTROY         0xFFFFFFFFU
+
+typedef struct {
+    int fd;
+    uint8_t *in;
+    size_t in_len;
+    uint8_t out[2 * LOADGEN_MAX_DEPTH * (NTSKEMD_HEADER_SIZE + NTSKEMD_MAX_REQUEST)];
+    size_t out_off, out_len;
+    int inflight;
+    int free_count;
+    uint32_t free_slots[LOADGEN_MAX_DEPTH];
+    uint64_t due[LOADGEN_MAX_DEPTH];        /* Nanoseconds */
+    uint8_t op[LOADGEN_MAX_DEPTH];
+    uint32_t pool[LOADGEN_MAX_DEPTH];
+} loadgen_conn;
+
+typedef struct {
+    uint64_t *latency;                      /* Nanoseconds */
+    size_t count;
+    size_t errors;
+} loadgen_op;
+
+typedef struct {
+    uint64_t time;                          /* Microseconds */
+    uint8_t op;
+} loadgen_event;
+
+static const char *op_names[NTSKEMD_OP_COUNT] = {
+    "keygen", "public_key", "encapsulate", "decapsulate", "destroy", "stats"
+};
+
+static uint8_t pool_ct[LOADGEN_POOL_SIZE][CRYPTO_CIPHERTEXTBYTES];
+static uint8_t pool_ss[LOADGEN_POOL_SIZE][CRYPTO_BYTES];
+static loadgen_op ops[NTSKEMD_OP_COUNT];
+static size_t mismatches = 0;
+
+static uint64_t loadgen_now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int loadgen_connect(const char *path)
+{
+    int fd;
+    struct sockaddr_un addr;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static size_t put_request(uint8_t *buf, uint8_t op, uint32_t key_id, uint32_t tag,
+                          const uint8_t *payload, size_t len)
+{
+    NTSKEMD_header header;
+
+    header.version = NTSKEMD_VERSION;
+    header.op = op;
+    header.status = 0;
+    header.key_id = key_id;
+    header.tag = tag;
+    header.length = (uint32_t)len;
+    ntskemd_put_header(buf, &header);
+    if (len)
+        memcpy(&buf[NTSKEMD_HEADER_SIZE], payload, len);
+
+    return NTSKEMD_HEADER_SIZE + len;
+}
+
+/**
+ *  A request and its response on a blocking connection
+ **/
+static int call(int fd, uint8_t op, uint32_t key_id, const uint8_t *payload, size_t len,
+                NTSKEMD_header *header, uint8_t *response, size_t size)
+{
+    uint8_t buf[NTSKEMD_HEADER_SIZE + NTSKEMD_MAX_REQUEST];
+    size_t off, total;
+    ssize_t n;
+
+    total = put_request(buf, op, key_id, 0, payload, len);
+    for (off=0; off<total; off+=(size_t)n) {
+        if ((n = write(fd, &buf[off], total - off)) <= 0)
+            return 0;
+    }
+    for (off=0; off<NTSKEMD_HEADER_SIZE; off+=(size_t)n) {
+        if ((n = read(fd, &buf[off], NTSKEMD_HEADER_SIZE - off)) <= 0)
+            return 0;
+    }
+    ntskemd_get_header(header, buf);
+    if (header->length > size)
+        return 0;
+    for (off=0; off<header->length; off+=(size_t)n) {
+        if ((n = read(fd, &response[off], header->length - off)) <= 0)
+            return 0;
+    }
+
+    return 1;
+}
+
+static int op_from_name(const char *name)
+{
+    int i;
+
+    for (i=0; i<NTSKEMD_OP_COUNT; i++) {
+        if (!strcmp(name, op_names[i]))
+            return i + 1;
+    }
+
+    return 0;
+}
+
+/**
+ *  Read a trace of lines "<time in microseconds> <operation>"
+ **/
+static loadgen_event *read_trace(const char *path, size_t *count)
+{
+    FILE *fp;
+    char name[32];
+    unsigned long long time;
+    size_t cap = 1024;
+    int op;
+    loadgen_event *events, *grown;
+
+    if (!(fp = fopen(path, "r")))
+        return NULL;
+    if (!(events = (loadgen_event *)malloc(cap * sizeof(loadgen_event)))) {
+        fclose(fp);
+        return NULL;
+    }
+    *count = 0;
+    while (fscanf(fp, "%llu %31s", &time, name) == 2) {
+        op = op_from_name(name);
+        if (op != NTSKEMD_OP_KEYGEN && op != NTSKEMD_OP_PUBLIC_KEY &&
+            op != NTSKEMD_OP_ENCAPSULATE && op != NTSKEMD_OP_DECAPSULATE)
+            continue;
+        if (*count == cap) {
+            cap *= 2;
+            if (!(grown = (loadgen_event *)realloc(events, cap * sizeof(loadgen_event)))) {
+                free(events);
+                fclose(fp);
+                return NULL;
+            }
+            events = grown;
+        }
+        events[*count].time = (uint64_t)time;
+        events[*count].op = (uint8_t)op;
+        (*count)++;
+    }
+    fclose(fp);
+
+    return events;
+}
+
+/**
+ *  Make room for a request at the end of the output of a connection
+ **/
+static int reserve(loadgen_conn *conn)
+{
+    if (conn->out_off) {
+        memmove(conn->out, &conn->out[conn->out_off], conn->out_len - conn->out_off);
+        conn->out_len -= conn->out_off;
+        conn->out_off = 0;
+    }
+
+    return (sizeof(conn->out) - conn->out_len >= NTSKEMD_HEADER_SIZE + NTSKEMD_MAX_REQUEST);
+}
+
+/**
+ *  Queue a request on a connection
+ **/
+static void submit(loadgen_conn *conn, uint8_t op, uint32_t key_id, uint64_t due,
+                   uint32_t *rnd)
+{
+    uint32_t slot = conn->free_slots[--conn->free_count];
+    const uint8_t *payload = NULL;
+    size_t len = 0;
+
+    conn->due[slot] = due;
+    conn->op[slot] = op;
+    if (op == NTSKEMD_OP_DECAPSULATE) {
+        *rnd ^= *rnd << 13; *rnd ^= *rnd >> 17; *rnd ^= *rnd << 5;
+        conn->pool[slot] = *rnd % LOADGEN_POOL_SIZE;
+        payload = pool_ct[conn->pool[slot]];
+        len = CRYPTO_CIPHERTEXTBYTES;
+    }
+    conn->out_len += put_request(&conn->out[conn->out_len], op, key_id, slot, payload, len);
+    conn->inflight++;
+}
+
+/**
+ *  Handle the complete responses read on a connection
+ **/
+static int receive(loadgen_conn *conn, uint64_t now)
+{
+    size_t off = 0;
+    uint32_t slot;
+    NTSKEMD_header header;
+    loadgen_op *op;
+
+    while (conn->in_len - off >= NTSKEMD_HEADER_SIZE) {
+        ntskemd_get_header(&header, &conn->in[off]);
+        if (header.length > NTSKEMD_MAX_RESPONSE)
+            return 0;
+        if (conn->in_len - off < NTSKEMD_HEADER_SIZE + header.length)
+            break;
+        slot = header.tag;
+        if (slot != LOADGEN_TAG_DESTROY) {
+            if (slot >= LOADGEN_MAX_DEPTH || header.op != conn->op[slot])
+                return 0;
+            op = &ops[header.op - 1];
+            op->latency[op->count++] = now - conn->due[slot];
+            if (header.status != NTS_KEM_SUCCESS)
+                op->errors++;
+            else if (header.op == NTSKEMD_OP_DECAPSULATE &&
+                     (header.length != CRYPTO_BYTES ||
+                      memcmp(&conn->in[off + NTSKEMD_HEADER_SIZE],
+                             pool_ss[conn->pool[slot]], CRYPTO_BYTES)))
+                mismatches++;
+            /* The keys generated under load are not kept */
+            if (header.op == NTSKEMD_OP_KEYGEN && header.status == NTS_KEM_SUCCESS &&
+                reserve(conn))
+                conn->out_len += put_request(&conn->out[conn->out_len], NTSKEMD_OP_DESTROY,
+                                             header.key_id, LOADGEN_TAG_DESTROY, NULL, 0);
+            conn->free_slots[conn->free_count++] = slot;
+            conn->inflight--;
+        }
+        off += NTSKEMD_HEADER_SIZE + header.length;
+    }
+    if (off) {
+        memmove(conn->in, &conn->in[off], conn->in_len - off);
+        conn->in_len -= off;
+    }
+
+    return 1;
+}
+
+static int cmp_uint64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void report_line(const char *name, uint64_t *latency, size_t count, size_t errors)
+{
+    static const double q[5] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+    size_t i, k;
+
+    if (!count)
+        return;
+    qsort(latency, count, sizeof(uint64_t), cmp_uint64);
+    printf("  %-12s %8lu %7lu", name, (unsigned long)count, (unsigned long)errors);
+    for (i=0; i<5; i++) {
+        k = (size_t)(q[i] * (double)count);
+        k = (k >= count) ? count - 1 : k;
+        printf(" %9.1f", (double)latency[k] / 1000.0);
+    }
+    printf("\n");
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-s socket] [-c connections] [-d depth] [-n requests]\n"
+            "          [-m keygen:encapsulate:decapsulate] [-r trace_file] [-k key_id]\n"
+            "  -s  the Unix domain socket of ntskemd, default %s\n"
+            "  -c  the number of connections, default 4\n"
+            "  -d  the requests in flight per connection, default 16\n"
+            "  -n  the number of requests of a synthetic mix, default 10000\n"
+            "  -m  the weights of the operations of a synthetic mix, default 0:1:1\n"
+            "  -r  replay a trace recorded by ntskemd -t instead of a synthetic mix\n"
+            "  -k  the key to use, by default a key is generated\n",
+            name, NTSKEMD_SOCKET);
+}
+
+int main(int argc, char *argv[])
+{
+    int opt, nconns = 4, depth = 16, status = EXIT_FAILURE, fd;
+    unsigned int w_keygen = 0, w_encap = 1, w_decap = 1;
+    size_t i, requests = 10000, issued = 0, completed, nevents = 0;
+    uint32_t key_id = 0, rnd = 0x2545F491U, pick;
+    uint64_t start, end, now, due, wait;
+    const char *path = NTSKEMD_SOCKET, *trace = NULL;
+    loadgen_event *events = NULL;
+    loadgen_conn *conns[LOADGEN_MAX_CONNS];
+    struct pollfd fds[LOADGEN_MAX_CONNS];
+    NTSKEMD_header header;
+    uint8_t *response = NULL, op;
+    uint64_t *all = NULL;
+    ssize_t n;
+    int j, timeout;
+
+    while ((opt = getopt(argc, argv, "s:c:d:n:m:r:k:h")) != -1) {
+        switch (opt) {
+            case 's': path = optarg; break;
+            case 'c': nconns = atoi(optarg); break;
+            case 'd': depth = atoi(optarg); break;
+            case 'n': requests = (size_t)strtoul(optarg, NULL, 10); break;
+            case 'm':
+                if (sscanf(optarg, "%u:%u:%u", &w_keygen, &w_encap, &w_decap) != 3 ||
+                    !(w_keygen + w_encap + w_decap)) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'r': trace = optarg; break;
+            case 'k': key_id = (uint32_t)strtoul(optarg, NULL, 10); break;
+            default:
+                usage(argv[0]);
+                return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (nconns < 1 || nconns > LOADGEN_MAX_CONNS || depth < 1 || depth > LOADGEN_MAX_DEPTH) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (trace) {
+        if (!(events = read_trace(trace, &nevents)) || !nevents) {
+            fprintf(stderr, "ntskemd-loadgen: unable to read %s\n", trace);
+            return EXIT_FAILURE;
+        }
+        requests = nevents;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    memset(conns, 0, sizeof(conns));
+    response = (uint8_t *)malloc(NTSKEMD_MAX_RESPONSE);
+    all = (uint64_t *)malloc((requests + 1) * sizeof(uint64_t));
+    for (j=0; j<NTSKEMD_OP_COUNT; j++) {
+        if (!(ops[j].latency = (uint64_t *)malloc((requests + 1) * sizeof(uint64_t))))
+            goto main_fail;
+    }
+    if (!response || !all)
+        goto main_fail;
+
+    /* Set up a key and ciphertexts to decapsulate */
+    if ((fd = loadgen_connect(path)) < 0) {
+        fprintf(stderr, "ntskemd-loadgen: unable to connect to %s\n", path);
+        goto main_fail;
+    }
+    if (!key_id) {
+        start = loadgen_now();
+        if (!call(fd, NTSKEMD_OP_KEYGEN, 0, NULL, 0, &header, response, NTSKEMD_MAX_RESPONSE) ||
+            header.status != NTS_KEM_SUCCESS) {
+            fprintf(stderr, "ntskemd-loadgen: key generation failed\n");
+            close(fd);
+            goto main_fail;
+        }
+        key_id = header.key_id;
+        printf("ntskemd-loadgen: generated key %u in %.1f ms\n", key_id,
+               (double)(loadgen_now() - start) / 1000000.0);
+    }
+    for (i=0; i<LOADGEN_POOL_SIZE; i++) {
+        if (!call(fd, NTSKEMD_OP_ENCAPSULATE, key_id, NULL, 0, &header, response,
+                  NTSKEMD_MAX_RESPONSE) || header.status != NTS_KEM_SUCCESS ||
+            header.length != CRYPTO_CIPHERTEXTBYTES + CRYPTO_BYTES) {
+            fprintf(stderr, "ntskemd-loadgen: encapsulation under key %u failed\n", key_id);
+            close(fd);
+            goto main_fail;
+        }
+        memcpy(pool_ct[i], response, CRYPTO_CIPHERTEXTBYTES);
+        memcpy(pool_ss[i], &response[CRYPTO_CIPHERTEXTBYTES], CRYPTO_BYTES);
+    }
+    close(fd);
+
+    for (j=0; j<nconns; j++) {
+        if (!(conns[j] = (loadgen_conn *)calloc(1, sizeof(loadgen_conn))) ||
+            !(conns[j]->in = (uint8_t *)malloc(NTSKEMD_HEADER_SIZE + NTSKEMD_MAX_RESPONSE)) ||
+            (conns[j]->fd = loadgen_connect(path)) < 0) {
+            fprintf(stderr, "ntskemd-loadgen: unable to connect to %s\n", path);
+            if (conns[j])
+                conns[j]->fd = -1;
+            goto main_fail;
+        }
+        fcntl(conns[j]->fd, F_SETFL, fcntl(conns[j]->fd, F_GETFL) | O_NONBLOCK);
+        for (i=0; i<(size_t)depth; i++)
+            conns[j]->free_slots[conns[j]->free_count++] = (uint32_t)(depth - 1 - i);
+    }
+
+    /* Run the load */
+    start = loadgen_now();
+    completed = 0;
+    while (completed < requests) {
+        now = loadgen_now();
+        wait = 0;
+        for (j=0; j<nconns && issued<requests; j++) {
+            while (conns[j]->free_count && issued < requests && reserve(conns[j])) {
+                if (events) {
+                    due = start + events[issued].time * 1000ULL;
+                    if (due > now) {
+                        wait = due - now;
+                        break;
+                    }
+                    op = events[issued].op;
+                }
+                else {
+                    due = now;
+                    rnd ^= rnd << 13; rnd ^= rnd >> 17; rnd ^= rnd << 5;
+                    pick = rnd % (w_keygen + w_encap + w_decap);
+                    op = (pick < w_keygen) ? NTSKEMD_OP_KEYGEN :
+                         (pick < w_keygen + w_encap) ? NTSKEMD_OP_ENCAPSULATE :
+                         NTSKEMD_OP_DECAPSULATE;
+                }
+                submit(conns[j], op, key_id, due, &rnd);
+                issued++;
+            }
+        }
+
+        for (j=0; j<nconns; j++) {
+            fds[j].fd = conns[j]->fd;
+            fds[j].events = POLLIN;
+            if (conns[j]->out_off < conns[j]->out_len)
+                fds[j].events |= POLLOUT;
+        }
+        timeout = wait ? (int)(wait / 1000000ULL) + 1 : -1;
+        if (poll(fds, (nfds_t)nconns, timeout) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("ntskemd-loadgen: poll");
+            goto main_fail;
+        }
+
+        now = loadgen_now();
+        for (j=0; j<nconns; j++) {
+            loadgen_conn *conn = conns[j];
+
+            if (fds[j].revents & POLLOUT) {
+                n = write(conn->fd, &conn->out[conn->out_off], conn->out_len - conn->out_off);
+                if (n > 0)
+                    conn->out_off += (size_t)n;
+                if (conn->out_off == conn->out_len)
+                    conn->out_off = conn->out_len = 0;
+            }
+            if (fds[j].revents & (POLLIN | POLLHUP | POLLERR)) {
+                n = read(conn->fd, &conn->in[conn->in_len],
+                         NTSKEMD_HEADER_SIZE + NTSKEMD_MAX_RESPONSE - conn->in_len);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+                    fprintf(stderr, "ntskemd-loadgen: connection closed by ntskemd\n");
+                    goto main_fail;
+                }
+                if (n > 0) {
+                    conn->in_len += (size_t)n;
+                    i = (size_t)conn->inflight;
+                    if (!receive(conn, now)) {
+                        fprintf(stderr, "ntskemd-loadgen: bad response\n");
+                        goto main_fail;
+                    }
+                    completed += i - (size_t)conn->inflight;
+                }
+            }
+        }
+    }
+    end = loadgen_now();
+
+    /* Report */
+    printf("ntskemd-loadgen: %lu requests over %d connections of depth %d%s%s\n",
+           (unsigned long)requests, nconns, depth, trace ? ", replaying " : "",
+           trace ? trace : "");
+    printf("  elapsed %.3f s, %.1f requests/s\n", (double)(end - start) / 1e9,
+           (double)requests * 1e9 / (double)(end - start));
+    printf("  %-12s %8s %7s %9s %9s %9s %9s %9s\n", "latency(us)", "count", "errors",
+           "p50", "p90", "p99", "p99.9", "max");
+    completed = 0;
+    i = 0;
+    for (j=0; j<NTSKEMD_OP_COUNT; j++) {
+        memcpy(&all[completed], ops[j].latency, ops[j].count * sizeof(uint64_t));
+        completed += ops[j].count;
+        i += ops[j].errors;
+        report_line(op_names[j], ops[j].latency, ops[j].count, ops[j].errors);
+    }
+    report_line("all", all, completed, i);
+    printf("  decapsulation mismatches %lu\n", (unsigned long)mismatches);
+
+    if ((fd = loadgen_connect(path)) >= 0) {
+        if (call(fd, NTSKEMD_OP_STATS, 0, NULL, 0, &header, response, NTSKEMD_MAX_RESPONSE)) {
+            printf("ntskemd:\n");
+            fwrite(response, 1, header.length, stdout);
+        }
+        close(fd);
+    }
+    status = (mismatches || i) ? EXIT_FAILURE : EXIT_SUCCESS;
+
+main_fail:
+    for (j=0; j<nconns; j++) {
+        if (conns[j]) {
+            if (conns[j]->fd >= 0)
+                close(conns[j]->fd);
+            free(conns[j]->in);
+            free(conns[j]);
+        }
+    }
+    for (j=0; j<NTSKEMD_OP_COUNT; j++)
+        free(ops[j].latency);
+    free(all);
+    free(response);
+    free(events);
+
+    return status;
+}
@@ -0,0 +1,57 @@
+/**
+ *  syndrome.h
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  The syndrome computation of the decapsulation and the unpacking
+ *  of the fields of the private key it is computed from
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#ifndef __NTSKEM_SYNDROME_H
+#define __NTSKEM_SYNDROME_H
+
+#include <stdint.h>
+#include "nts_kem.h"
+#include "ff.h"
+#include "bits.h"
+
+/**
+ *  Compute the syndromes s_j = Σ c_i.h_i.a_i^j of a ciphertext
+ *
+ *  @note
+ *  With the Beneš network of p, the syndromes are computed with the
+ *  transposed additive FFT, otherwise with a multiplication chain.
+ *  Neither accesses memory at an address that depends on p.
+ *
+ *  @param[in]  nts_kem   The pointer to NTS-KEM object
+ *  @param[in]  benes     The Beneš network of p, or NULL
+ *  @param[in]  weight    The weights h_i, or w_i for Patterson decoding
+ *  @param[in]  c_ptr     The pointer to the inpute ciphertext
+ *  @param[out] s         The computed syndromes
+ *  @param[in]  count     The number of syndromes, 2τ or τ
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative status
+ *  {@see nts_kem_errors.h}
+ **/
+int compute_syndrome(const NTSKEM* nts_kem,
+                     const uint64_t *benes,
+                     const ff_unit* weight,
+                     const vector *c_ptr,
+                     ff_unit* s,
+                     int32_t count);
+
+/**
+ *  Unpack 13-bit fields, as a_i, h_i and p_i are in the private key
+ *
+ *  @param[in]  src     Pointer to the input buffer
+ *  @param[out] dst     Pointer to the output buffer (in words)
+ *  @param[in]  dst_len Length of dst in 2-byte (word) unit
+ **/
+void unpack_buffer(const uint8_t *src, ff_unit *dst, int dst_len);
+
+#endif /* __NTSKEM_SYNDROME_H */
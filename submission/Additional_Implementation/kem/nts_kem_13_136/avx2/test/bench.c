@@ -0,0 +1,330 @@
+/**
+ *  bench.c
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  A benchmark of the key generation, encapsulation and decapsulation
+ *  with the keys and matrices in normal pages and in huge pages. The
+ *  operations go round-robin over a number of keys, so that the keys
+ *  together span more pages than the TLB holds. The two modes are run
+ *  a number of times in alternating order, so that neither is favoured
+ *  by running first, and the spread of the runs is reported.
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#if defined(__linux__)
+#define _GNU_SOURCE             /* syscall */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "api.h"
+#include "nts_kem.h"
+#include "nts_kem_errors.h"
+#include "random.h"
+
+#define BENCH_MAX_KEYS          64
+#define BENCH_MAX_RUNS          32
+#define BENCH_OPS               4
+
+static const char *bench_op[BENCH_OPS] = { "keygen", "encap", "decap", "decap (ctx)" };
+static const char *bench_mode[2] = { "normal", "huge" };
+
+static const unsigned char entropy_input[48] = {
+    0x2d, 0x4c, 0x9f, 0x46, 0xb9, 0x81, 0xc6, 0xa0,
+    0xb2, 0xb5, 0xd8, 0xc6, 0x93, 0x91, 0xe5, 0x69,
+    0xff, 0x13, 0x85, 0x14, 0x37, 0xeb, 0xc0, 0xfc,
+    0x00, 0xd6, 0x16, 0x34, 0x02, 0x52, 0xfe, 0xd5,
+    0x8e, 0x39, 0xb2, 0x27, 0x12, 0x92, 0x0e, 0xfd,
+    0xda, 0xe0, 0x2c, 0x6f, 0xdc, 0xa5, 0x97, 0x8c
+};
+static const char* nonce = "0bf814b411f65ec4866be1abb59d3c32a57b9037e01f429c";
+
+/**
+ *  A measurement of a number of operations
+ **/
+typedef struct {
+    int fd;                         /* The counter of data TLB misses, -1 if none */
+    uint64_t start_ns;
+    uint64_t start_misses;
+} bench_span;
+
+/**
+ *  The results of the runs of an operation in a mode, per operation
+ **/
+typedef struct {
+    int runs;
+    double us[BENCH_MAX_RUNS];
+    double misses[BENCH_MAX_RUNS];
+} bench_result;
+
+static uint64_t bench_now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ *  Open a counter of the data TLB load misses of this thread in user
+ *  space, -1 if the kernel or the CPU do not provide one
+ **/
+static int bench_tlb_counter()
+{
+#if defined(__linux__)
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static uint64_t bench_tlb_misses(int fd)
+{
+    uint64_t count = 0;
+
+    if (fd < 0 || read(fd, &count, sizeof(count)) != sizeof(count))
+        return 0;
+
+    return count;
+}
+
+static void bench_begin(bench_span* span, int fd)
+{
+    span->fd = fd;
+    span->start_misses = bench_tlb_misses(fd);
+    span->start_ns = bench_now();
+}
+
+static void bench_end(const bench_span* span, bench_result* result, int count)
+{
+    uint64_t ns = bench_now() - span->start_ns;
+    uint64_t misses = bench_tlb_misses(span->fd) - span->start_misses;
+
+    result->us[result->runs] = (double)ns/count/1000.0;
+    result->misses[result->runs] = (double)misses/count;
+    result->runs++;
+}
+
+/**
+ *  The sum of the values in KB of the lines of a file of the proc
+ *  filesystem that start with one of the keys, -1 if it cannot be read
+ **/
+static long bench_proc_kb(const char *file, const char **keys, int count)
+{
+    int i;
+    long kb = 0;
+    char line[256];
+    FILE *f = fopen(file, "r");
+
+    if (!f)
+        return -1;
+    while (fgets(line, sizeof(line), f)) {
+        for (i=0; i<count; i++) {
+            if (!strncmp(line, keys[i], strlen(keys[i])))
+                kb += atol(&line[strlen(keys[i])]);
+        }
+    }
+    fclose(f);
+
+    return kb;
+}
+
+/**
+ *  Report the memory of the process in transparent huge pages and in
+ *  huge pages of hugetlbfs, and the huge pages of hugetlbfs in use in
+ *  the system
+ **/
+static void bench_memory(const char *mode)
+{
+    const char *thp[] = { "AnonHugePages:" };
+    const char *hugetlb[] = { "Private_Hugetlb:", "Shared_Hugetlb:" };
+    const char *total[] = { "HugePages_Total:" }, *avail[] = { "HugePages_Free:" };
+    const char *size[] = { "Hugepagesize:" };
+    long pages = bench_proc_kb("/proc/meminfo", total, 1) - bench_proc_kb("/proc/meminfo", avail, 1);
+
+    fprintf(stdout, "%-6s %-12s %8ld KB THP, %8ld KB hugetlb, %8ld KB hugetlb in the system\n",
+            mode, "memory", bench_proc_kb("/proc/self/smaps_rollup", thp, 1),
+            bench_proc_kb("/proc/self/smaps_rollup", hugetlb, 2),
+            pages*bench_proc_kb("/proc/meminfo", size, 1));
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ *  Report the minimum, the median and the maximum of the runs
+ **/
+static void bench_report(const char *mode, const char *op, const bench_result* result, int fd)
+{
+    double us[BENCH_MAX_RUNS], misses[BENCH_MAX_RUNS];
+    int n = result->runs;
+
+    if (!n)
+        return;
+    memcpy(us, result->us, n*sizeof(double));
+    memcpy(misses, result->misses, n*sizeof(double));
+    qsort(us, n, sizeof(double), bench_compare);
+    qsort(misses, n, sizeof(double), bench_compare);
+
+    fprintf(stdout, "%-6s %-12s %10.1f %10.1f %10.1f us/op", mode, op, us[0], us[n/2], us[n-1]);
+    if (fd < 0)
+        fprintf(stdout, " %14s\n", "n/a");
+    else
+        fprintf(stdout, " %10.1f %10.1f %10.1f dTLB misses/op\n",
+                misses[0], misses[n/2], misses[n-1]);
+}
+
+static int bench_run(int huge, int keys, int iterations, int fd, bench_result* result)
+{
+    int i, status = NTS_KEM_SUCCESS;
+    const char *mode = bench_mode[huge];
+    NTSKEM *nts_kem[BENCH_MAX_KEYS];
+    NTSKEM_decap_ctx *ctx[BENCH_MAX_KEYS];
+    uint8_t (*ciphertext)[CRYPTO_CIPHERTEXTBYTES] = NULL;
+    uint8_t (*encap_key)[CRYPTO_BYTES] = NULL;
+    uint8_t decap_key[CRYPTO_BYTES];
+    bench_span span;
+
+    memset(nts_kem, 0, sizeof(nts_kem));
+    memset(ctx, 0, sizeof(ctx));
+    nts_kem_huge_pages(huge);
+    ciphertext = malloc(keys * sizeof(*ciphertext));
+    encap_key = malloc(keys * sizeof(*encap_key));
+    if (!ciphertext || !encap_key) {
+        status = NTS_KEM_BAD_MEMORY_ALLOCATION;
+        goto bench_run_fail;
+    }
+
+    bench_begin(&span, fd);
+    for (i=0; i<keys; i++) {
+        if ((status = nts_kem_create(&nts_kem[i])) != NTS_KEM_SUCCESS)
+            goto bench_run_fail;
+    }
+    bench_end(&span, &result[0], keys);
+
+    for (i=0; i<keys; i++) {
+        status = nts_kem_decap_ctx_create(&ctx[i], nts_kem[i]->private_key,
+                                          NTS_KEM_DECAP_SYNDROME_MATRIX);
+        if (status != NTS_KEM_SUCCESS)
+            goto bench_run_fail;
+    }
+
+    bench_begin(&span, fd);
+    for (i=0; i<iterations; i++) {
+        status = nts_kem_encapsulate(nts_kem[i % keys]->public_key,
+                                     ciphertext[i % keys], encap_key[i % keys]);
+        if (status != NTS_KEM_SUCCESS)
+            goto bench_run_fail;
+    }
+    bench_end(&span, &result[1], iterations);
+
+    bench_begin(&span, fd);
+    for (i=0; i<iterations; i++) {
+        status = nts_kem_decapsulate(nts_kem[i % keys]->private_key, ciphertext[i % keys], decap_key);
+        if (status != NTS_KEM_SUCCESS)
+            goto bench_run_fail;
+    }
+    bench_end(&span, &result[2], iterations);
+
+    bench_begin(&span, fd);
+    for (i=0; i<iterations; i++) {
+        status = nts_kem_decap_ctx_decapsulate(ctx[i % keys], ciphertext[i % keys], decap_key);
+        if (status == NTS_KEM_SUCCESS && memcmp(decap_key, encap_key[i % keys], CRYPTO_BYTES))
+            status = NTS_KEM_UNEXPECTED_ERROR;
+        if (status != NTS_KEM_SUCCESS)
+            goto bench_run_fail;
+    }
+    bench_end(&span, &result[3], iterations);
+
+    bench_memory(mode);
+
+bench_run_fail:
+    for (i=0; i<keys; i++) {
+        nts_kem_decap_ctx_release(ctx[i]);
+        nts_kem_release(nts_kem[i]);
+    }
+    free(encap_key);
+    free(ciphertext);
+
+    return status;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-k keys] [-n iterations] [-r runs]\n", name);
+    fprintf(stderr, "  -k  keys the operations go round-robin over (default 8, at most %d)\n",
+            BENCH_MAX_KEYS);
+    fprintf(stderr, "  -n  encapsulations and decapsulations per run (default 200)\n");
+    fprintf(stderr, "  -r  runs of each mode, in alternating order (default 5, at most %d)\n",
+            BENCH_MAX_RUNS);
+}
+
+int main(int argc, char *argv[])
+{
+    int i, j, opt, fd, status = NTS_KEM_SUCCESS, keys = 8, iterations = 200, runs = 5;
+    bench_result result[2][BENCH_OPS];
+
+    while ((opt = getopt(argc, argv, "k:n:r:h")) != -1) {
+        switch (opt) {
+            case 'k': keys = atoi(optarg); break;
+            case 'n': iterations = atoi(optarg); break;
+            case 'r': runs = atoi(optarg); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (keys < 1 || keys > BENCH_MAX_KEYS || iterations < 1 ||
+        runs < 1 || runs > BENCH_MAX_RUNS) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    randombytes_init(entropy_input, (const unsigned char *)nonce, 256);
+    memset(result, 0, sizeof(result));
+    fd = bench_tlb_counter();
+    /* Normal pages first in the even runs, huge pages first in the odd runs */
+    for (i=0; status == NTS_KEM_SUCCESS && i<2*runs; i++) {
+        j = (i & 1) ^ ((i >> 1) & 1);
+        status = bench_run(j, keys, iterations, fd, result[j]);
+    }
+    if (status == NTS_KEM_SUCCESS) {
+        fprintf(stdout, "%-6s %-12s %10s %10s %10s\n", "", "", "min", "median", "max");
+        for (j=0; j<2; j++) {
+            for (i=0; i<BENCH_OPS; i++)
+                bench_report(bench_mode[j], bench_op[i], &result[j][i], fd);
+        }
+    }
+    if (fd >= 0)
+        close(fd);
+    if (status != NTS_KEM_SUCCESS)
+        fprintf(stderr, "benchmark failed: %d\n", status);
+
+    return status == NTS_KEM_SUCCESS ? 0 : 1;
+}
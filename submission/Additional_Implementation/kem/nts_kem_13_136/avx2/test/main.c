@@ -37,6 +37,19 @@ int main(int argc, char *argv[])
     
     randombytes_init(entropy_input, (const unsigned char *)nonce, 256);
     status = testkem_nts(iterations);
+    status &= testkem_ff_mul();
+    status &= testkem_nts_keygen_steps(1000000);
+    status &= testkem_nts_seed(10000000);
+    status &= testkem_nts_decap_ctx(iterations);
+    status &= testkem_nts_decap_cache(iterations);
+    status &= testkem_nts_iovec(iterations);
+    status &= testkem_nts_engine(iterations);
+    status &= testkem_nts_key_slot(iterations);
+    status &= testkem_nts_key_store(iterations);
+    status &= testkem_nts_shared_ctx(iterations);
+    status &= testkem_nts_huge_pages(iterations);
+    status &= testkem_nts_patterson(iterations);
+    status &= testkem_nts_syndromes(iterations);
     printf("NTS-KEM(%d, %d) test: %s\n", NTSKEM_M, NTSKEM_T, status ? "PASS" : "FAIL");
 
     return 0;
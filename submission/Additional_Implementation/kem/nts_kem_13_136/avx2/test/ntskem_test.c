@@ -14,8 +14,25 @@
 #include <stdlib.h>
 #include <string.h>
 #include "api.h"
+#include "nts_kem.h"
+#include "nts_kem_errors.h"
+#include "ff.h"
+#include "vector_ff.h"
+#include "seed_cache.h"
 #include "ntskem_test.h"
 #include "random.h"
+#include "kem_engine.h"
+#include "key_slot.h"
+#include "key_store.h"
+#include "decap_cache.h"
+#include "benes.h"
+#include "syndrome.h"
+#include "nts_kem_params.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/wait.h>
 
 uint8_t* hexstr_to_char(const char* hexstr, int32_t *size)
 {
@@ -117,3 +134,988 @@ int testkem_nts(int iterations)
 
     return status;
 }
+
+int testkem_nts_keygen_steps(uint64_t budget_cycles)
+{
+    int i, status = 1, steps = 0, rc;
+    NTSKEM *nts_kem = NULL, *reference = NULL;
+    NTSKEM_keygen *keygen = NULL;
+    unsigned char entropy_input[48];
+    uint8_t encap_key[CRYPTO_BYTES], decap_key[CRYPTO_BYTES];
+    uint8_t ciphertext[CRYPTO_CIPHERTEXTBYTES];
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Resumable KeyGen Test\n", NTSKEM_M, NTSKEM_T);
+    
+    for (i=0; i<(int)sizeof(entropy_input); i++) entropy_input[i] = (unsigned char)(3*i + 1);
+    
+    /* The key pair of nts_kem_create from the same DRBG state */
+    randombytes_init(entropy_input, NULL, 256);
+    randombit_reset();
+    if (nts_kem_create(&reference) != NTS_KEM_SUCCESS)
+        return 0;
+    
+    randombytes_init(entropy_input, NULL, 256);
+    randombit_reset();
+    if (nts_kem_keygen_begin(&keygen) != NTS_KEM_SUCCESS) {
+        nts_kem_release(reference);
+        return 0;
+    }
+    do {
+        rc = nts_kem_keygen_step(keygen, budget_cycles);
+        ++steps;
+    } while (rc == NTS_KEM_KEYGEN_IN_PROGRESS);
+    fprintf(stdout, "KeyGen completed in %d steps\n", steps);
+    
+    status &= (rc == NTS_KEM_SUCCESS);
+    status &= (nts_kem_keygen_finish(keygen, &nts_kem) == NTS_KEM_SUCCESS);
+    if (status) {
+        status &= (0 == memcmp(reference->public_key, nts_kem->public_key, CRYPTO_PUBLICKEYBYTES));
+        status &= (0 == memcmp(reference->private_key, nts_kem->private_key, CRYPTO_SECRETKEYBYTES));
+        status &= (0 == crypto_kem_enc(ciphertext, encap_key, nts_kem->public_key));
+        status &= (0 == crypto_kem_dec(decap_key, ciphertext, nts_kem->private_key));
+        status &= (0 == memcmp(encap_key, decap_key, CRYPTO_BYTES));
+    }
+    nts_kem_release(nts_kem);
+    nts_kem_release(reference);
+    
+    return status;
+}
+
+int testkem_nts_seed(uint64_t budget_cycles)
+{
+    int i, status = 1, steps = 0, rc;
+    NTSKEM *nts_kem[2] = {NULL, NULL};
+    const NTSKEM *cached = NULL, *cached_again = NULL;
+    NTSKEM_seed_cache *cache = NULL;
+    uint8_t seed[NTS_KEM_SEED_SIZE];
+    uint8_t encap_key[CRYPTO_BYTES], decap_key[CRYPTO_BYTES];
+    uint8_t ciphertext[CRYPTO_CIPHERTEXTBYTES];
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Seed KeyGen Test\n", NTSKEM_M, NTSKEM_T);
+    
+    for (i=0; i<NTS_KEM_SEED_SIZE; i++) seed[i] = (uint8_t)i;
+    
+    /* The same seed always gives the same key pair */
+    for (i=0; i<2; i++) {
+        if (nts_kem_create_from_seed(&nts_kem[i], seed) != NTS_KEM_SUCCESS)
+            status = 0;
+    }
+    if (status) {
+        status &= (0 == memcmp(nts_kem[0]->public_key, nts_kem[1]->public_key, CRYPTO_PUBLICKEYBYTES));
+        status &= (0 == memcmp(nts_kem[0]->private_key, nts_kem[1]->private_key, CRYPTO_SECRETKEYBYTES));
+    }
+    
+    /* Expand the seed through the cache within a cycles budget */
+    if (status && nts_kem_seed_cache_create(&cache, 1, budget_cycles) == NTS_KEM_SUCCESS) {
+        do {
+            rc = nts_kem_seed_cache_get(cache, seed, &cached);
+            ++steps;
+        } while (rc == NTS_KEM_KEYGEN_IN_PROGRESS);
+        fprintf(stdout, "Seed expanded in %d calls\n", steps);
+        
+        status &= (rc == NTS_KEM_SUCCESS);
+        status &= (nts_kem_seed_cache_get(cache, seed, &cached_again) == NTS_KEM_SUCCESS);
+        status &= (cached && cached == cached_again);
+        if (status) {
+            status &= (0 == memcmp(nts_kem[0]->private_key, cached->private_key, CRYPTO_SECRETKEYBYTES));
+            status &= (0 == crypto_kem_enc(ciphertext, encap_key, cached->public_key));
+            status &= (0 == crypto_kem_dec(decap_key, ciphertext, cached->private_key));
+            status &= (0 == memcmp(encap_key, decap_key, CRYPTO_BYTES));
+        }
+        
+        /* A different seed evicts the key and gives a different key pair */
+        seed[0] ^= 1;
+        status &= (nts_kem_seed_cache_get(cache, seed, &cached) == NTS_KEM_KEYGEN_IN_PROGRESS);
+        status &= (cached == NULL);
+        
+        /* The expansion in progress is not evicted for another seed */
+        seed[1] ^= 1;
+        status &= (nts_kem_seed_cache_get(cache, seed, &cached) == NTS_KEM_BUSY);
+        status &= (cached == NULL);
+        seed[1] ^= 1;
+        nts_kem_seed_cache_release(cache);
+        
+        nts_kem_release(nts_kem[1]);
+        status &= (nts_kem_create_from_seed(&nts_kem[1], seed) == NTS_KEM_SUCCESS);
+        if (status)
+            status &= (0 != memcmp(nts_kem[0]->public_key, nts_kem[1]->public_key, CRYPTO_PUBLICKEYBYTES));
+    }
+    else {
+        status = 0;
+    }
+    
+    nts_kem_release(nts_kem[1]);
+    nts_kem_release(nts_kem[0]);
+    
+    return status;
+}
+
+int testkem_nts_decap_ctx(int iterations)
+{
+    int i, j, rc, status = 1;
+    NTSKEM *nts_kem = NULL;
+    NTSKEM_decap_ctx *ctx[5] = {NULL, NULL, NULL, NULL, NULL};
+    uint32_t flags[5] = {0, NTS_KEM_DECAP_SYNDROME_MATRIX,
+        NTS_KEM_DECAP_SYNDROME_MATRIX | NTS_KEM_DECAP_BENES_NETWORK,
+        NTS_KEM_DECAP_PARALLEL,
+        NTS_KEM_DECAP_PARALLEL | NTS_KEM_DECAP_SYNDROME_MATRIX};
+    uint8_t encap_key[CRYPTO_BYTES], decap_key[CRYPTO_BYTES], ctx_key[CRYPTO_BYTES];
+    uint8_t ciphertext[CRYPTO_CIPHERTEXTBYTES];
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Decapsulation Context Test\n", NTSKEM_M, NTSKEM_T);
+    
+    if (nts_kem_create(&nts_kem) != NTS_KEM_SUCCESS)
+        return 0;
+    for (j=0; j<5; j++) {
+        if (nts_kem_decap_ctx_create(&ctx[j], nts_kem->private_key, flags[j]) != NTS_KEM_SUCCESS ||
+            nts_kem_decap_ctx_flags(ctx[j]) != flags[j])
+            status = 0;
+    }
+    
+    for (i=0; status && i<iterations; i++) {
+        status &= (0 == crypto_kem_enc(ciphertext, encap_key, nts_kem->public_key));
+        /* Every other ciphertext is corrupted and must be implicitly rejected */
+        if (i & 1)
+            ciphertext[i % CRYPTO_CIPHERTEXTBYTES] ^= 0x01;
+        rc = crypto_kem_dec(decap_key, ciphertext, nts_kem->private_key);
+        status &= (rc == ((i & 1) ? NTS_KEM_INVALID_CIPHERTEXT : NTS_KEM_SUCCESS));
+        status &= (((i & 1) == 0) == (0 == memcmp(encap_key, decap_key, CRYPTO_BYTES)));
+        for (j=0; j<5; j++) {
+            status &= (rc == nts_kem_decap_ctx_decapsulate(ctx[j], ciphertext, ctx_key));
+            status &= (0 == memcmp(decap_key, ctx_key, CRYPTO_BYTES));
+        }
+    }
+    
+    for (j=4; j>=0; j--) {
+        nts_kem_decap_ctx_release(ctx[j]);
+    }
+    nts_kem_release(nts_kem);
+    
+    return status;
+}
+
+int testkem_nts_decap_cache(int iterations)
+{
+    int i, j, rc, status = 1;
+    NTSKEM *nts_kem = NULL;
+    NTSKEM_decap_ctx *ctx = NULL;
+    NTSKEM_iovec iov;
+    decap_cache *cache = NULL;
+    uint8_t digest[DECAP_CACHE_DIGEST_SIZE];
+    uint8_t encap_key[CRYPTO_BYTES], decap_key[CRYPTO_BYTES], ctx_key[CRYPTO_BYTES];
+    uint8_t ciphertext[3][CRYPTO_CIPHERTEXTBYTES];
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Decapsulation Cache Test\n", NTSKEM_M, NTSKEM_T);
+    
+    if (nts_kem_create(&nts_kem) != NTS_KEM_SUCCESS)
+        return 0;
+    status &= (nts_kem_decap_ctx_create(&ctx, nts_kem->private_key, 0) == NTS_KEM_SUCCESS);
+    status &= (nts_kem_decap_ctx_set_cache(ctx, 2, 60) == NTS_KEM_SUCCESS);
+    
+    /* Three ciphertexts, the second one is corrupted, in a cache of two */
+    for (j=0; status && j<3; j++) {
+        status &= (0 == crypto_kem_enc(ciphertext[j], encap_key, nts_kem->public_key));
+    }
+    ciphertext[1][0] ^= 0x01;
+    
+    for (i=0; status && i<iterations; i++) {
+        j = (i * 7) % 3;
+        rc = crypto_kem_dec(decap_key, ciphertext[j], nts_kem->private_key);
+        if (i & 1) {
+            status &= (rc == nts_kem_decap_ctx_decapsulate(ctx, ciphertext[j], ctx_key));
+        }
+        else {
+            iov.base = ciphertext[j];
+            iov.len = CRYPTO_CIPHERTEXTBYTES;
+            status &= (rc == nts_kem_decap_ctx_decapsulate_iov(ctx, &iov, 1, ctx_key));
+        }
+        status &= (rc == ((j == 1) ? NTS_KEM_INVALID_CIPHERTEXT : NTS_KEM_SUCCESS));
+        status &= (0 == memcmp(decap_key, ctx_key, CRYPTO_BYTES));
+    }
+    
+    status &= (nts_kem_decap_ctx_set_cache(ctx, 0, 0) == NTS_KEM_SUCCESS);
+    status &= (NTS_KEM_INVALID_CIPHERTEXT == nts_kem_decap_ctx_decapsulate(ctx, ciphertext[1], ctx_key));
+    
+    /**
+     * The cache alone, with digests of which a third share their home
+     * slot, only the four most recent results remain
+     **/
+    status &= (decap_cache_create(&cache, 4, 0) == NTS_KEM_SUCCESS);
+    for (i=0; status && i<64; i++) {
+        memset(digest, 0, sizeof(digest));
+        digest[0] = (uint8_t)(i % 3);
+        digest[DECAP_CACHE_DIGEST_SIZE-1] = (uint8_t)i;
+        memset(encap_key, i, CRYPTO_BYTES);
+        decap_cache_insert(cache, digest, encap_key, -i);
+        for (j=i-4; j<=i; j++) {
+            digest[0] = (uint8_t)(((j % 3) + 3) % 3);
+            digest[DECAP_CACHE_DIGEST_SIZE-1] = (uint8_t)j;
+            memset(encap_key, j, CRYPTO_BYTES);
+            if (j == i-4 || j < 0) {
+                status &= !decap_cache_lookup(cache, digest, ctx_key, &rc);
+            }
+            else {
+                status &= decap_cache_lookup(cache, digest, ctx_key, &rc);
+                status &= (rc == -j && 0 == memcmp(encap_key, ctx_key, CRYPTO_BYTES));
+            }
+        }
+    }
+    decap_cache_release(cache);
+    
+    nts_kem_decap_ctx_release(ctx);
+    nts_kem_release(nts_kem);
+    
+    return status;
+}
+
+int testkem_nts_iovec(int iterations)
+{
+    int i, j, rc, status = 1;
+    size_t offset;
+    NTSKEM *nts_kem = NULL;
+    NTSKEM_decap_ctx *ctx = NULL;
+    NTSKEM_iovec iov[4];
+    uint8_t encap_key[CRYPTO_BYTES], decap_key[CRYPTO_BYTES], iov_key[CRYPTO_BYTES];
+    uint8_t ciphertext[CRYPTO_CIPHERTEXTBYTES];
+    uint8_t fragments[4][CRYPTO_CIPHERTEXTBYTES];
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Scatter/Gather Test\n", NTSKEM_M, NTSKEM_T);
+    
+    if (nts_kem_create(&nts_kem) != NTS_KEM_SUCCESS)
+        return 0;
+    status &= (nts_kem_decap_ctx_create(&ctx, nts_kem->private_key, 0) == NTS_KEM_SUCCESS);
+    
+    for (i=0; status && i<iterations; i++) {
+        /* Four fragments in separate buffers, the first one may be empty */
+        iov[0].len = i % 33;
+        iov[1].len = 1;
+        iov[2].len = (i * 101) % (CRYPTO_CIPHERTEXTBYTES - iov[0].len - 1);
+        iov[3].len = CRYPTO_CIPHERTEXTBYTES - iov[0].len - iov[1].len - iov[2].len;
+        for (j=0; j<4; j++)
+            iov[j].base = &fragments[j][i % 7];
+        
+        status &= (NTS_KEM_SUCCESS == nts_kem_encapsulate_iov(nts_kem->public_key, iov, 4, encap_key));
+        for (offset=0, j=0; j<4; j++) {
+            memcpy(&ciphertext[offset], iov[j].base, iov[j].len);
+            offset += iov[j].len;
+        }
+        /* Every other ciphertext is corrupted and must be implicitly rejected */
+        if (i & 1) {
+            ciphertext[CRYPTO_CIPHERTEXTBYTES-1] ^= 0x01;
+            ((uint8_t *)iov[3].base)[iov[3].len-1] ^= 0x01;
+        }
+        
+        rc = crypto_kem_dec(decap_key, ciphertext, nts_kem->private_key);
+        status &= (rc == ((i & 1) ? NTS_KEM_INVALID_CIPHERTEXT : NTS_KEM_SUCCESS));
+        if (!(i & 1))
+            status &= (0 == memcmp(encap_key, decap_key, CRYPTO_BYTES));
+        
+        status &= (rc == nts_kem_decapsulate_iov(nts_kem->private_key, iov, 4, iov_key));
+        status &= (0 == memcmp(decap_key, iov_key, CRYPTO_BYTES));
+        status &= (rc == nts_kem_decap_ctx_decapsulate_iov(ctx, iov, 4, iov_key));
+        status &= (0 == memcmp(decap_key, iov_key, CRYPTO_BYTES));
+    }
+    
+    /* The fragments must add up to the ciphertext size */
+    iov[3].len--;
+    status &= (NTS_KEM_BAD_PARAMETERS == nts_kem_encapsulate_iov(nts_kem->public_key, iov, 4, encap_key));
+    status &= (NTS_KEM_BAD_PARAMETERS == nts_kem_decap_ctx_decapsulate_iov(ctx, iov, 4, iov_key));
+    iov[3].len += 2;
+    status &= (NTS_KEM_BAD_PARAMETERS == nts_kem_decapsulate_iov(nts_kem->private_key, iov, 4, iov_key));
+    
+    nts_kem_decap_ctx_release(ctx);
+    nts_kem_release(nts_kem);
+    
+    return status;
+}
+
+static void engine_callback(NTSKEM_async_job *job, void *arg)
+{
+    *(int *)arg = 1;
+}
+
+int testkem_nts_engine(int iterations)
+{
+    int i, rc, status = 1;
+    size_t j, n, inflight;
+    NTSKEM_engine *engine = NULL;
+    NTSKEM_engine_stats stats;
+    NTSKEM_decap_ctx *ctx = NULL;
+    NTSKEM_async_job *polled[8];
+    NTSKEM_async_job keypair, *encap = NULL, *decap = NULL;
+    uint8_t *pk = NULL, *sk = NULL, *ciphertext = NULL, *encap_key = NULL, *decap_key = NULL;
+    uint8_t ref_key[CRYPTO_BYTES];
+    int *completed = NULL;
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Asynchronous Engine Test\n", NTSKEM_M, NTSKEM_T);
+    
+    pk = (uint8_t *)malloc(CRYPTO_PUBLICKEYBYTES);
+    sk = (uint8_t *)malloc(CRYPTO_SECRETKEYBYTES);
+    ciphertext = (uint8_t *)calloc(2*iterations, CRYPTO_CIPHERTEXTBYTES);
+    encap_key = (uint8_t *)calloc(2*iterations, CRYPTO_BYTES);
+    decap_key = (uint8_t *)calloc(2*iterations, CRYPTO_BYTES);
+    encap = (NTSKEM_async_job *)calloc(2*iterations, sizeof(NTSKEM_async_job));
+    decap = (NTSKEM_async_job *)calloc(2*iterations, sizeof(NTSKEM_async_job));
+    completed = (int *)calloc(2*iterations, sizeof(int));
+    if (!pk || !sk || !ciphertext || !encap_key || !decap_key || !encap || !decap || !completed) {
+        status = 0;
+        goto test_fail;
+    }
+    
+    if (nts_kem_engine_create(&engine, 2, 1000, 8, 0) != NTS_KEM_SUCCESS) {
+        status = 0;
+        goto test_fail;
+    }
+    
+    /* A key generation whose completion is polled */
+    memset(&keypair, 0, sizeof(keypair));
+    keypair.op = NTS_KEM_JOB_KEYPAIR;
+    keypair.pk = pk;
+    keypair.sk = sk;
+    status &= (nts_kem_engine_submit(engine, &keypair) == NTS_KEM_SUCCESS);
+    status &= (nts_kem_engine_poll(engine, polled, 8, 1) == 1);
+    status &= (polled[0] == &keypair && keypair.status == NTS_KEM_SUCCESS);
+    status &= (nts_kem_decap_ctx_create(&ctx, sk, 0) == NTS_KEM_SUCCESS);
+    if (!status)
+        goto test_fail;
+    
+    /* Encapsulations whose completions are polled, the ring holds 8 of them */
+    for (i=0, inflight=0; status && i<2*iterations; i++) {
+        encap[i].op = NTS_KEM_JOB_ENCAPSULATE;
+        encap[i].pk = pk;
+        encap[i].ct = &ciphertext[i*CRYPTO_CIPHERTEXTBYTES];
+        encap[i].ss = &encap_key[i*CRYPTO_BYTES];
+        while ((rc = nts_kem_engine_submit(engine, &encap[i])) == NTS_KEM_BUSY) {
+            status &= (inflight == 8);
+            n = nts_kem_engine_poll(engine, polled, 8, 1);
+            for (j=0; j<n; j++)
+                status &= (polled[j]->status == NTS_KEM_SUCCESS);
+            inflight -= n;
+        }
+        status &= (rc == NTS_KEM_SUCCESS);
+        inflight++;
+    }
+    while (status && inflight) {
+        n = nts_kem_engine_poll(engine, polled, 8, 1);
+        for (j=0; j<n; j++)
+            status &= (polled[j]->status == NTS_KEM_SUCCESS);
+        inflight -= n;
+    }
+    for (i=0; status && i<2*iterations; i++) {
+        status &= (NTS_KEM_SUCCESS == crypto_kem_dec(ref_key, &ciphertext[i*CRYPTO_CIPHERTEXTBYTES], sk));
+        status &= (0 == memcmp(ref_key, &encap_key[i*CRYPTO_BYTES], CRYPTO_BYTES));
+    }
+    nts_kem_engine_stats(engine, &stats);
+    status &= (stats.jobs[0] == 1 && stats.batches[0] == 1);
+    status &= (stats.jobs[1] == (uint64_t)(2*iterations));
+    status &= (stats.batches[1] >= 1 && stats.batches[1] <= stats.jobs[1]);
+    status &= (stats.jobs[2] == 0 && stats.pending == 0);
+    
+    /**
+     * Decapsulations with a callback, under the context or from the
+     * private key, every third ciphertext is corrupted
+     **/
+    for (i=0; status && i<2*iterations; i++) {
+        if (i % 3 == 1)
+            ciphertext[i*CRYPTO_CIPHERTEXTBYTES] ^= 0x01;
+        decap[i].op = NTS_KEM_JOB_DECAPSULATE;
+        decap[i].ctx = (i & 1) ? NULL : ctx;
+        decap[i].sk = sk;
+        decap[i].ct = &ciphertext[i*CRYPTO_CIPHERTEXTBYTES];
+        decap[i].ss = &decap_key[i*CRYPTO_BYTES];
+        decap[i].callback = engine_callback;
+        decap[i].arg = &completed[i];
+        status &= (nts_kem_engine_submit(engine, &decap[i]) == NTS_KEM_SUCCESS);
+    }
+    /* The submitted jobs are completed before the engine is released */
+    nts_kem_engine_release(engine);
+    engine = NULL;
+    for (i=0; status && i<2*iterations; i++) {
+        rc = crypto_kem_dec(ref_key, &ciphertext[i*CRYPTO_CIPHERTEXTBYTES], sk);
+        status &= (rc == ((i % 3 == 1) ? NTS_KEM_INVALID_CIPHERTEXT : NTS_KEM_SUCCESS));
+        status &= (completed[i] && decap[i].status == rc);
+        status &= (0 == memcmp(ref_key, &decap_key[i*CRYPTO_BYTES], CRYPTO_BYTES));
+    }
+    
+test_fail:
+    nts_kem_engine_release(engine);
+    nts_kem_decap_ctx_release(ctx);
+    free(completed);
+    free(decap);
+    free(encap);
+    free(decap_key);
+    free(encap_key);
+    free(ciphertext);
+    free(sk);
+    free(pk);
+    
+    return status;
+}
+
+typedef struct {
+    NTSKEM_key_slot *slot;
+    const uint8_t *ciphertext;
+    const uint8_t *key;
+    int iterations;
+    int status;
+} key_slot_test_arg;
+
+static void *key_slot_test_reader(void *ptr)
+{
+    int i;
+    key_slot_test_arg *arg = (key_slot_test_arg *)ptr;
+    NTSKEM_key_reader *reader = NULL;
+    uint8_t decap_key[CRYPTO_BYTES];
+    
+    arg->status = (nts_kem_key_slot_reader_create(arg->slot, &reader) == NTS_KEM_SUCCESS);
+    for (i=0; arg->status && i<arg->iterations; i++) {
+        arg->status &= (NTS_KEM_SUCCESS == nts_kem_key_slot_decapsulate(reader, arg->ciphertext, decap_key));
+        arg->status &= (0 == memcmp(decap_key, arg->key, CRYPTO_BYTES));
+    }
+    nts_kem_key_slot_reader_release(reader);
+    
+    return NULL;
+}
+
+static int key_slot_test_rotate(NTSKEM_key_slot *slot, const uint8_t *sk)
+{
+    NTSKEM_decap_ctx *ctx = NULL;
+    
+    if (nts_kem_decap_ctx_create(&ctx, sk, 0) != NTS_KEM_SUCCESS)
+        return 0;
+    if (nts_kem_key_slot_rotate(slot, ctx) != NTS_KEM_SUCCESS) {
+        nts_kem_decap_ctx_release(ctx);
+        return 0;
+    }
+    
+    return 1;
+}
+
+int testkem_nts_key_slot(int iterations)
+{
+    int i, status = 1, started = 0;
+    NTSKEM *nts_kem[3] = {NULL, NULL, NULL};
+    NTSKEM_decap_ctx *ctx = NULL;
+    NTSKEM_key_slot *slot = NULL;
+    NTSKEM_key_reader *reader = NULL;
+    const NTSKEM_decap_ctx *current = NULL, *previous = NULL;
+    key_slot_test_arg arg[2];
+    pthread_t thread[2];
+    uint8_t seed[NTS_KEM_SEED_SIZE];
+    uint8_t encap_key[3][CRYPTO_BYTES], decap_key[CRYPTO_BYTES];
+    uint8_t ciphertext[3][CRYPTO_CIPHERTEXTBYTES];
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Key Slot Rotation Test\n", NTSKEM_M, NTSKEM_T);
+    
+    for (i=0; i<NTS_KEM_SEED_SIZE; i++) seed[i] = (uint8_t)(i + 3);
+    for (i=0; status && i<3; i++) {
+        seed[0] = (uint8_t)i;
+        if (nts_kem_create_from_seed(&nts_kem[i], seed) != NTS_KEM_SUCCESS) {
+            status = 0;
+            break;
+        }
+        status &= (0 == crypto_kem_enc(ciphertext[i], encap_key[i], nts_kem[i]->public_key));
+    }
+    if (!status ||
+        nts_kem_decap_ctx_create(&ctx, nts_kem[0]->private_key, 0) != NTS_KEM_SUCCESS ||
+        nts_kem_key_slot_create(&slot, ctx) != NTS_KEM_SUCCESS) {
+        status = 0;
+        goto test_fail;
+    }
+    ctx = NULL;
+    status &= (nts_kem_key_slot_reader_create(slot, &reader) == NTS_KEM_SUCCESS);
+    
+    /* A single key, the ciphertexts of the other keys are rejected */
+    current = nts_kem_key_slot_enter(reader, &previous);
+    status &= (current != NULL && previous == NULL);
+    nts_kem_key_slot_leave(reader);
+    status &= (NTS_KEM_SUCCESS == nts_kem_key_slot_decapsulate(reader, ciphertext[0], decap_key));
+    status &= (0 == memcmp(decap_key, encap_key[0], CRYPTO_BYTES));
+    status &= (NTS_KEM_INVALID_CIPHERTEXT == nts_kem_key_slot_decapsulate(reader, ciphertext[1], decap_key));
+    
+    /**
+     * Rotate to the second key, then alternate between the third and
+     * the second key while other threads decapsulate a ciphertext of
+     * the second key, which remains either current or previous
+     **/
+    status &= key_slot_test_rotate(slot, nts_kem[1]->private_key);
+    status &= (NTS_KEM_SUCCESS == nts_kem_key_slot_decapsulate(reader, ciphertext[0], decap_key));
+    status &= (0 == memcmp(decap_key, encap_key[0], CRYPTO_BYTES));
+    for (started=0; status && started<2; started++) {
+        arg[started].slot = slot;
+        arg[started].ciphertext = ciphertext[1];
+        arg[started].key = encap_key[1];
+        arg[started].iterations = 4*iterations;
+        if (pthread_create(&thread[started], NULL, key_slot_test_reader, &arg[started]))
+            break;
+    }
+    status &= (started == 2);
+    for (i=0; status && i<2*iterations; i++)
+        status &= key_slot_test_rotate(slot, nts_kem[2 - (i & 1)]->private_key);
+    for (i=0; i<started; i++) {
+        pthread_join(thread[i], NULL);
+        status &= arg[i].status;
+    }
+    
+    /**
+     * The first key has been rotated out, the second key is current
+     * and the rejection key is the one under the second key
+     **/
+    status &= (NTS_KEM_INVALID_CIPHERTEXT == nts_kem_key_slot_decapsulate(reader, ciphertext[0], decap_key));
+    status &= (NTS_KEM_INVALID_CIPHERTEXT == nts_kem_decapsulate(nts_kem[1]->private_key, ciphertext[0], encap_key[0]));
+    status &= (0 == memcmp(decap_key, encap_key[0], CRYPTO_BYTES));
+    for (i=1; status && i<3; i++) {
+        status &= (NTS_KEM_SUCCESS == nts_kem_key_slot_decapsulate(reader, ciphertext[i], decap_key));
+        status &= (0 == memcmp(decap_key, encap_key[i], CRYPTO_BYTES));
+    }
+    
+test_fail:
+    nts_kem_key_slot_reader_release(reader);
+    nts_kem_key_slot_release(slot);
+    nts_kem_decap_ctx_release(ctx);
+    for (i=0; i<3; i++)
+        nts_kem_release(nts_kem[i]);
+    
+    return status;
+}
+
+int testkem_nts_key_store(int iterations)
+{
+    int i, j, tier, status = 1;
+    uint64_t id[3] = {10, 11, 12};
+    NTSKEM *nts_kem[3] = {NULL, NULL, NULL};
+    NTSKEM_key_store *store = NULL;
+    NTSKEM_key_store_stats stats;
+    char dir[64], path[2][96], target[96];
+    struct stat st;
+    uint8_t seed[3][NTS_KEM_SEED_SIZE];
+    uint8_t encap_key[3][CRYPTO_BYTES], decap_key[CRYPTO_BYTES];
+    uint8_t ciphertext[3][CRYPTO_CIPHERTEXTBYTES];
+    uint8_t *pk = NULL;
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Key Store Test\n", NTSKEM_M, NTSKEM_T);
+    
+    for (i=0; i<3; i++) {
+        for (j=0; j<NTS_KEM_SEED_SIZE; j++) seed[i][j] = (uint8_t)(i + j + 7);
+        if (nts_kem_create_from_seed(&nts_kem[i], seed[i]) != NTS_KEM_SUCCESS) {
+            status = 0;
+            goto test_fail;
+        }
+        status &= (0 == crypto_kem_enc(ciphertext[i], encap_key[i], nts_kem[i]->public_key));
+    }
+    
+    /* Room for two warm keys, or a hot key and a warm key */
+    snprintf(dir, sizeof(dir), "/tmp/ntskem-key-store-%d", (int)getpid());
+    if (!(pk = (uint8_t *)malloc(CRYPTO_PUBLICKEYBYTES)) || mkdir(dir, 0700) ||
+        nts_kem_key_store_create(&store, 2*CRYPTO_SECRETKEYBYTES + (CRYPTO_SECRETKEYBYTES >> 2),
+                                 dir, 0) != NTS_KEM_SUCCESS) {
+        status = 0;
+        goto test_fail;
+    }
+    /* Links at the paths of the keys, the files must not be written through them */
+    snprintf(target, sizeof(target), "%s/target", dir);
+    status &= (0 == close(open(target, O_WRONLY | O_CREAT | O_EXCL, 0600)));
+    for (i=0; i<2; i++) {
+        snprintf(path[i], sizeof(path[i]), "%s/%016llx.sk", dir, (unsigned long long)id[i+1]);
+        status &= (0 == symlink(target, path[i]));
+    }
+    status &= (NTS_KEM_SUCCESS == nts_kem_key_store_add_seed(store, id[0], seed[0]));
+    status &= (NTS_KEM_SUCCESS == nts_kem_key_store_add(store, id[1], nts_kem[1]->private_key));
+    status &= (NTS_KEM_SUCCESS == nts_kem_key_store_add(store, id[2], nts_kem[2]->private_key));
+    status &= (NTS_KEM_BAD_PARAMETERS == nts_kem_key_store_add(store, id[1], nts_kem[1]->private_key));
+    status &= (NTS_KEM_KEY_STORE_COLD == nts_kem_key_store_tier(store, id[0]));
+    status &= (NTS_KEM_KEY_STORE_WARM == nts_kem_key_store_tier(store, id[1]));
+    
+    /* Loading the key of the seed pages one of the others out to a file */
+    status &= (NTS_KEM_SUCCESS == nts_kem_key_store_decapsulate(store, id[0], ciphertext[0], decap_key));
+    status &= (0 == memcmp(decap_key, encap_key[0], CRYPTO_BYTES));
+    status &= (NTS_KEM_KEY_STORE_WARM == nts_kem_key_store_tier(store, id[0]));
+    nts_kem_key_store_stats(store, &stats);
+    status &= (stats.misses == 1 && stats.evictions == 1 && stats.keys[2] == 1);
+    for (j=0, i=0; i<2; i++)
+        j += (0 == lstat(path[i], &st) && S_ISREG(st.st_mode) && (st.st_mode & 0077) == 0);
+    status &= (j == 1 && 0 == stat(target, &st) && st.st_size == 0);
+    
+    /* A frequently accessed key is made hot */
+    for (i=0; status && i<NTS_KEM_KEY_STORE_HOT_ACCESSES; i++) {
+        status &= (NTS_KEM_SUCCESS == nts_kem_key_store_decapsulate(store, id[0], ciphertext[0], decap_key));
+        status &= (0 == memcmp(decap_key, encap_key[0], CRYPTO_BYTES));
+    }
+    status &= (NTS_KEM_KEY_STORE_HOT == nts_kem_key_store_tier(store, id[0]));
+    
+    /* The keys move between the tiers and their results do not change */
+    for (i=0; status && i<3*iterations; i++) {
+        j = (i % 5) ? 0 : 1 + ((i / 5) & 1);
+        status &= (NTS_KEM_SUCCESS == nts_kem_key_store_decapsulate(store, id[j], ciphertext[j], decap_key));
+        status &= (0 == memcmp(decap_key, encap_key[j], CRYPTO_BYTES));
+        status &= (NTS_KEM_INVALID_CIPHERTEXT ==
+                   nts_kem_key_store_decapsulate(store, id[j], ciphertext[(j + 1) % 3], decap_key));
+        nts_kem_key_store_stats(store, &stats);
+        status &= (stats.memory <= stats.budget);
+    }
+    for (i=0; status && i<3; i++) {
+        tier = nts_kem_key_store_tier(store, id[i]);
+        status &= (tier >= NTS_KEM_KEY_STORE_HOT && tier <= NTS_KEM_KEY_STORE_COLD);
+        status &= (NTS_KEM_SUCCESS == nts_kem_key_store_public_key(store, id[i], pk));
+        status &= (0 == memcmp(pk, nts_kem[i]->public_key, CRYPTO_PUBLICKEYBYTES));
+    }
+    nts_kem_key_store_stats(store, &stats);
+    status &= (stats.promotions >= 1 && stats.hot_hits >= 1 && stats.warm_hits >= 1);
+    status &= (stats.keys[0] + stats.keys[1] + stats.keys[2] == 3);
+    
+    status &= (NTS_KEM_SUCCESS == nts_kem_key_store_remove(store, id[1]));
+    status &= (NTS_KEM_KEY_NOT_FOUND == nts_kem_key_store_remove(store, id[1]));
+    status &= (NTS_KEM_KEY_NOT_FOUND == nts_kem_key_store_decapsulate(store, id[1], ciphertext[1], decap_key));
+    
+test_fail:
+    nts_kem_key_store_release(store);
+    if (store) {
+        for (i=0; i<2; i++)
+            unlink(path[i]);
+        unlink(target);
+        status &= (0 == rmdir(dir));
+    }
+    free(pk);
+    for (i=0; i<3; i++)
+        nts_kem_release(nts_kem[i]);
+    
+    return status;
+}
+
+int testkem_nts_shared_ctx(int iterations)
+{
+    int i, rc, status = 1, child_status = 0;
+    pid_t child;
+    NTSKEM *nts_kem = NULL;
+    NTSKEM_decap_ctx *ctx = NULL, *attached = NULL, *other = NULL, *child_ctx = NULL;
+    char name[64];
+    uint8_t seed[NTS_KEM_SEED_SIZE];
+    uint8_t encap_key[CRYPTO_BYTES], decap_key[CRYPTO_BYTES], attached_key[CRYPTO_BYTES];
+    uint8_t ciphertext[CRYPTO_CIPHERTEXTBYTES];
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Shared Context Test\n", NTSKEM_M, NTSKEM_T);
+    
+    /* The Goppa polynomial of this seed is irreducible */
+    for (i=0; i<NTS_KEM_SEED_SIZE; i++) seed[i] = (uint8_t)i;
+    seed[0] = 26; seed[1] = 0;
+    snprintf(name, sizeof(name), "/ntskem-test-%d", (int)getpid());
+    if (nts_kem_create_from_seed(&nts_kem, seed) != NTS_KEM_SUCCESS ||
+        nts_kem_decap_ctx_create(&ctx, nts_kem->private_key,
+                                 NTS_KEM_DECAP_SYNDROME_MATRIX | NTS_KEM_DECAP_BENES_NETWORK |
+                                 NTS_KEM_DECAP_PATTERSON) != NTS_KEM_SUCCESS) {
+        status = 0;
+        goto test_fail;
+    }
+    status &= (NTS_KEM_KEY_NOT_FOUND == nts_kem_decap_ctx_attach(&attached, name, 0));
+    status &= (NTS_KEM_SUCCESS == nts_kem_decap_ctx_publish(ctx, name));
+    status &= (NTS_KEM_BAD_PARAMETERS == nts_kem_decap_ctx_publish(ctx, name));
+    status &= (NTS_KEM_SUCCESS == nts_kem_decap_ctx_attach(&attached, name, 0));
+    status &= (NTS_KEM_SUCCESS == nts_kem_decap_ctx_attach(&other, name, NTS_KEM_DECAP_PARALLEL));
+    if (!status)
+        goto test_fail;
+    
+    /* The tables are shared, only the unpacked key is held per context */
+    status &= (nts_kem_decap_ctx_size(attached) < nts_kem_decap_ctx_size(ctx)/32);
+    status &= (0 == memcmp(nts_kem_decap_ctx_private_key(attached), nts_kem->private_key,
+                           CRYPTO_SECRETKEYBYTES));
+    
+    for (i=0; status && i<iterations; i++) {
+        status &= (0 == crypto_kem_enc(ciphertext, encap_key, nts_kem->public_key));
+        /* Every other ciphertext is corrupted and must be implicitly rejected */
+        if (i & 1)
+            ciphertext[i % CRYPTO_CIPHERTEXTBYTES] ^= 0x01;
+        rc = nts_kem_decap_ctx_decapsulate(ctx, ciphertext, decap_key);
+        status &= (rc == ((i & 1) ? NTS_KEM_INVALID_CIPHERTEXT : NTS_KEM_SUCCESS));
+        status &= (rc == nts_kem_decap_ctx_decapsulate(attached, ciphertext, attached_key));
+        status &= (0 == memcmp(decap_key, attached_key, CRYPTO_BYTES));
+        status &= (rc == nts_kem_decap_ctx_decapsulate(other, ciphertext, attached_key));
+        status &= (0 == memcmp(decap_key, attached_key, CRYPTO_BYTES));
+    }
+    
+    /* Another process attaches to the same segment */
+    status &= (0 == crypto_kem_enc(ciphertext, encap_key, nts_kem->public_key));
+    if ((child = fork()) == 0) {
+        rc = nts_kem_decap_ctx_attach(&child_ctx, name, 0);
+        if (rc == NTS_KEM_SUCCESS)
+            rc = nts_kem_decap_ctx_decapsulate(child_ctx, ciphertext, decap_key);
+        _exit((rc == NTS_KEM_SUCCESS && 0 == memcmp(decap_key, encap_key, CRYPTO_BYTES)) ? 0 : 1);
+    }
+    status &= (child > 0 && waitpid(child, &child_status, 0) == child &&
+               WIFEXITED(child_status) && WEXITSTATUS(child_status) == 0);
+    
+    /* The attached contexts outlive the name */
+    status &= (NTS_KEM_SUCCESS == nts_kem_decap_ctx_unpublish(name));
+    status &= (NTS_KEM_KEY_NOT_FOUND == nts_kem_decap_ctx_unpublish(name));
+    nts_kem_decap_ctx_release(other);
+    status &= (NTS_KEM_KEY_NOT_FOUND == nts_kem_decap_ctx_attach(&other, name, 0));
+    status &= (NTS_KEM_SUCCESS == nts_kem_decap_ctx_decapsulate(attached, ciphertext, decap_key));
+    status &= (0 == memcmp(decap_key, encap_key, CRYPTO_BYTES));
+    
+test_fail:
+    nts_kem_decap_ctx_unpublish(name);
+    nts_kem_decap_ctx_release(other);
+    nts_kem_decap_ctx_release(attached);
+    nts_kem_decap_ctx_release(ctx);
+    nts_kem_release(nts_kem);
+    
+    return status;
+}
+
+int testkem_nts_huge_pages(int iterations)
+{
+    int i, enabled, status = 1;
+    NTSKEM *nts_kem[2] = {NULL, NULL};
+    NTSKEM_decap_ctx *ctx = NULL;
+    uint8_t seed[NTS_KEM_SEED_SIZE];
+    uint8_t encap_key[CRYPTO_BYTES], decap_key[CRYPTO_BYTES];
+    uint8_t ciphertext[CRYPTO_CIPHERTEXTBYTES];
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Huge Pages Test\n", NTSKEM_M, NTSKEM_T);
+    
+    /* The same key in normal pages and, where available, in huge pages */
+    for (i=0; i<NTS_KEM_SEED_SIZE; i++) seed[i] = (uint8_t)(i + 11);
+    enabled = nts_kem_huge_pages(0);
+    if (nts_kem_create_from_seed(&nts_kem[0], seed) != NTS_KEM_SUCCESS)
+        status = 0;
+    nts_kem_huge_pages(1);
+    if (status && (nts_kem_create_from_seed(&nts_kem[1], seed) != NTS_KEM_SUCCESS ||
+                   nts_kem_decap_ctx_create(&ctx, nts_kem[1]->private_key,
+                                            NTS_KEM_DECAP_SYNDROME_MATRIX) != NTS_KEM_SUCCESS))
+        status = 0;
+    nts_kem_huge_pages(enabled);
+    if (!status)
+        goto test_fail;
+    status &= (0 == memcmp(nts_kem[0]->public_key, nts_kem[1]->public_key, CRYPTO_PUBLICKEYBYTES));
+    status &= (0 == memcmp(nts_kem[0]->private_key, nts_kem[1]->private_key, CRYPTO_SECRETKEYBYTES));
+    
+    for (i=0; status && i<iterations; i++) {
+        status &= (0 == crypto_kem_enc(ciphertext, encap_key, nts_kem[1]->public_key));
+        status &= (NTS_KEM_SUCCESS == nts_kem_decap_ctx_decapsulate(ctx, ciphertext, decap_key));
+        status &= (0 == memcmp(decap_key, encap_key, CRYPTO_BYTES));
+    }
+    
+test_fail:
+    nts_kem_decap_ctx_release(ctx);
+    nts_kem_release(nts_kem[1]);
+    nts_kem_release(nts_kem[0]);
+    
+    return status;
+}
+
+int testkem_nts_patterson(int iterations)
+{
+    int i, j, rc, status = 1;
+    NTSKEM *nts_kem = NULL;
+    NTSKEM_decap_ctx *ctx[3] = {NULL, NULL, NULL};
+    uint32_t flags[3] = {NTS_KEM_DECAP_PATTERSON,
+        NTS_KEM_DECAP_PATTERSON | NTS_KEM_DECAP_SYNDROME_MATRIX,
+        NTS_KEM_DECAP_PATTERSON | NTS_KEM_DECAP_SYNDROME_MATRIX | NTS_KEM_DECAP_PARALLEL};
+    uint8_t seed[NTS_KEM_SEED_SIZE];
+    uint8_t encap_key[CRYPTO_BYTES], decap_key[CRYPTO_BYTES], ctx_key[CRYPTO_BYTES];
+    uint8_t ciphertext[CRYPTO_CIPHERTEXTBYTES];
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Patterson Decoding Test\n", NTSKEM_M, NTSKEM_T);
+    
+    /* The Goppa polynomial of this seed is reducible, Berlekamp-Massey is used */
+    for (i=0; i<NTS_KEM_SEED_SIZE; i++) seed[i] = (uint8_t)i;
+    if (nts_kem_create_from_seed(&nts_kem, seed) != NTS_KEM_SUCCESS)
+        return 0;
+    if (nts_kem_decap_ctx_create(&ctx[0], nts_kem->private_key, flags[1]) != NTS_KEM_SUCCESS) {
+        status = 0;
+    }
+    else {
+        status &= (nts_kem_decap_ctx_flags(ctx[0]) == NTS_KEM_DECAP_SYNDROME_MATRIX);
+        status &= (0 == crypto_kem_enc(ciphertext, encap_key, nts_kem->public_key));
+        status &= (NTS_KEM_SUCCESS == nts_kem_decap_ctx_decapsulate(ctx[0], ciphertext, ctx_key));
+        status &= (0 == memcmp(encap_key, ctx_key, CRYPTO_BYTES));
+    }
+    nts_kem_decap_ctx_release(ctx[0]);
+    ctx[0] = NULL;
+    nts_kem_release(nts_kem);
+    
+    /* The Goppa polynomial of this seed is irreducible */
+    seed[0] = 26; seed[1] = 0;
+    if (nts_kem_create_from_seed(&nts_kem, seed) != NTS_KEM_SUCCESS)
+        return 0;
+    for (j=0; j<3; j++) {
+        if (nts_kem_decap_ctx_create(&ctx[j], nts_kem->private_key, flags[j]) != NTS_KEM_SUCCESS ||
+            nts_kem_decap_ctx_flags(ctx[j]) != flags[j])
+            status = 0;
+    }
+    
+    for (i=0; status && i<iterations; i++) {
+        status &= (0 == crypto_kem_enc(ciphertext, encap_key, nts_kem->public_key));
+        /* Every other ciphertext is corrupted and must be implicitly rejected */
+        if (i & 1)
+            ciphertext[i % CRYPTO_CIPHERTEXTBYTES] ^= 0x01;
+        rc = crypto_kem_dec(decap_key, ciphertext, nts_kem->private_key);
+        status &= (rc == ((i & 1) ? NTS_KEM_INVALID_CIPHERTEXT : NTS_KEM_SUCCESS));
+        for (j=0; j<3; j++) {
+            status &= (rc == nts_kem_decap_ctx_decapsulate(ctx[j], ciphertext, ctx_key));
+            status &= (0 == memcmp(decap_key, ctx_key, CRYPTO_BYTES));
+        }
+    }
+    
+    nts_kem_decap_ctx_release(ctx[2]);
+    nts_kem_decap_ctx_release(ctx[1]);
+    nts_kem_decap_ctx_release(ctx[0]);
+    nts_kem_release(nts_kem);
+    
+    return status;
+}
+
+/**
+ *  Check the syndromes of the transposed FFT, with the inputs placed
+ *  by the Beneš network, and of the multiplication chain against
+ *  s_j = Σ c_i.h_i.a_i^j computed with ff_mul
+ **/
+int testkem_nts_syndromes(int iterations)
+{
+    int i, j, k, status = 1;
+    NTSKEM *nts_kem = NULL;
+    const FF2m *ff2m = NULL;
+    uint64_t *benes = NULL;
+    ff_unit a[NTS_KEM_PARAM_BC], h[NTS_KEM_PARAM_BC], p[NTS_KEM_PARAM_N];
+    ff_unit x, ref[2*NTS_KEM_PARAM_T], s[2*NTS_KEM_PARAM_T];
+    vector c[NTS_KEM_PARAM_BC_DIV_256];
+    const uint8_t *sk_ptr = NULL;
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Syndrome Test\n", NTSKEM_M, NTSKEM_T);
+    
+    if (!(ff2m = ff_create()) || nts_kem_create(&nts_kem) != NTS_KEM_SUCCESS) {
+        status = 0;
+        goto test_fail;
+    }
+    sk_ptr = nts_kem->private_key;
+    unpack_buffer(sk_ptr, a, NTS_KEM_PARAM_BC);
+    sk_ptr += (NTS_KEM_PARAM_BC * 13/8);
+    unpack_buffer(sk_ptr, h, NTS_KEM_PARAM_BC);
+    sk_ptr += (NTS_KEM_PARAM_BC * 13/8);
+    unpack_buffer(sk_ptr, p, NTS_KEM_PARAM_N);
+    if (!(benes = (uint64_t *)malloc(BENES_SIZE*sizeof(uint64_t))) ||
+        benes_compile(benes, p) != NTS_KEM_SUCCESS)
+        status = 0;
+    
+    for (i=0; status && i<iterations; i++) {
+        randombytes((uint8_t *)c, sizeof(c));
+        memset(ref, 0, sizeof(ref));
+        for (k=0; k<NTS_KEM_PARAM_BC; k++) {
+            if (!((((const uint64_t *)c)[k >> 6] >> (k & 63)) & 1))
+                continue;
+            for (x=h[k], j=0; j<2*NTS_KEM_PARAM_T; j++) {
+                ref[j] ^= x;
+                x = ff2m->ff_mul(ff2m, x, a[k]);
+            }
+        }
+        
+        status &= (NTS_KEM_SUCCESS == compute_syndrome(nts_kem, benes, h, c, s, 2*NTS_KEM_PARAM_T));
+        status &= (0 == memcmp(ref, s, sizeof(s)));
+        status &= (NTS_KEM_SUCCESS == compute_syndrome(nts_kem, NULL, h, c, s, 2*NTS_KEM_PARAM_T));
+        status &= (0 == memcmp(ref, s, sizeof(s)));
+        /* An odd number of syndromes, as for Patterson decoding */
+        memset(s, 0, sizeof(s));
+        status &= (NTS_KEM_SUCCESS == compute_syndrome(nts_kem, benes, h, c, s, NTS_KEM_PARAM_T+1));
+        status &= (0 == memcmp(ref, s, (NTS_KEM_PARAM_T+1)*sizeof(ff_unit)));
+        memset(s, 0, sizeof(s));
+        status &= (NTS_KEM_SUCCESS == compute_syndrome(nts_kem, NULL, h, c, s, NTS_KEM_PARAM_T+1));
+        status &= (0 == memcmp(ref, s, (NTS_KEM_PARAM_T+1)*sizeof(ff_unit)));
+    }
+    
+test_fail:
+    free(benes);
+    nts_kem_release(nts_kem);
+    ff_release(ff2m);
+    
+    return status;
+}
+
+void bitslice_mul13_64(uint64_t* c, const uint64_t* a, const uint64_t* b);
+void bitslice_mul13_128(__m128i* c, const __m128i* a, const __m128i* b);
+void bitslice_mul13_256(__m256i* c, const __m256i* a, const __m256i* b);
+
+static void mul_64(const FF2m* ff2m, uint64_t* c, const uint64_t* a, const uint64_t* b)
+{
+    bitslice_mul13_64(c, a, b);
+}
+
+static void mul_128(const FF2m* ff2m, uint64_t* c, const uint64_t* a, const uint64_t* b)
+{
+    bitslice_mul13_128((__m128i *)c, (const __m128i *)a, (const __m128i *)b);
+}
+
+static void mul_256(const FF2m* ff2m, uint64_t* c, const uint64_t* a, const uint64_t* b)
+{
+    bitslice_mul13_256((__m256i *)c, (const __m256i *)a, (const __m256i *)b);
+}
+
+static void mul_vector(const FF2m* ff2m, uint64_t* c, const uint64_t* a, const uint64_t* b)
+{
+    ff2m->vector_ff_mul(ff2m, (vector *)c, (const vector *)a, (const vector *)b);
+}
+
+/**
+ *  Check the bit-sliced field multipliers against ff_mul on all
+ *  the pairs of field elements, 256 pairs at a time. A multiplier
+ *  of 64.w lanes handles these in slices of w words per bit plane.
+ **/
+int testkem_ff_mul()
+{
+    int i, j, k, l, s, status = 1;
+    uint32_t x, y;
+    ff_unit z;
+    const FF2m *ff2m = NULL;
+    uint64_t a[NTSKEM_M*4] __attribute__((aligned(32)));
+    uint64_t b[NTSKEM_M*4] __attribute__((aligned(32)));
+    uint64_t c[NTSKEM_M*4] __attribute__((aligned(32)));
+    uint64_t d[NTSKEM_M*4] __attribute__((aligned(32)));
+    uint64_t e[NTSKEM_M*4] __attribute__((aligned(32)));
+    uint64_t f[NTSKEM_M*4] __attribute__((aligned(32)));
+    struct {
+        void (*mul)(const FF2m*, uint64_t*, const uint64_t*, const uint64_t*);
+        int words;
+    } muls[] = {
+        { mul_64, 1 },
+        { mul_128, 2 },
+        { mul_256, 4 },
+        { mul_vector, sizeof(vector)/sizeof(uint64_t) }
+    };
+    
+    fprintf(stdout, "NTS-KEM(%d, %d) Field Multiplication Test\n", NTSKEM_M, NTSKEM_T);
+    
+    if (!(ff2m = ff_create()))
+        return 0;
+    
+    for (x=0; x<(1 << NTSKEM_M); x++) {
+        for (y=0; y<(1 << NTSKEM_M); y+=256) {
+            memset(b, 0, sizeof(b));
+            memset(d, 0, sizeof(d));
+            for (i=0; i<256; i++) {
+                z = ff2m->ff_mul(ff2m, (ff_unit)x, (ff_unit)(y + i));
+                for (j=0; j<NTSKEM_M; j++) {
+                    b[j*4 + (i >> 6)] |= (uint64_t)(((y + i) >> j) & 1) << (i & 63);
+                    d[j*4 + (i >> 6)] |= (uint64_t)((z >> j) & 1) << (i & 63);
+                }
+            }
+            for (k=0; k<sizeof(muls)/sizeof(muls[0]); k++) {
+                for (s=0; s<4; s+=muls[k].words) {
+                    for (j=0; j<NTSKEM_M; j++) {
+                        for (l=0; l<muls[k].words; l++) {
+                            a[j*muls[k].words + l] = -(uint64_t)((x >> j) & 1);
+                            e[j*muls[k].words + l] = b[j*4 + s + l];
+                        }
+                    }
+                    muls[k].mul(ff2m, c, a, e);
+                    for (j=0; j<NTSKEM_M; j++) {
+                        for (l=0; l<muls[k].words; l++)
+                            f[j*4 + s + l] = c[j*muls[k].words + l];
+                    }
+                }
+                status &= (0 == memcmp(d, f, sizeof(f)));
+            }
+        }
+    }
+    
+    ff_release(ff2m);
+    
+    return status;
+}
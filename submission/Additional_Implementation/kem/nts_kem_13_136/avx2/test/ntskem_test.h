@@ -13,6 +13,34 @@
 #ifndef _NTSKEM_TEST_H
 #define _NTSKEM_TEST_H
 
+#include <stdint.h>
+
 int testkem_nts(int iterations);
 
+int testkem_nts_keygen_steps(uint64_t budget_cycles);
+
+int testkem_nts_seed(uint64_t budget_cycles);
+
+int testkem_nts_decap_ctx(int iterations);
+
+int testkem_nts_decap_cache(int iterations);
+
+int testkem_nts_iovec(int iterations);
+
+int testkem_nts_engine(int iterations);
+
+int testkem_nts_key_slot(int iterations);
+
+int testkem_nts_key_store(int iterations);
+
+int testkem_nts_shared_ctx(int iterations);
+
+int testkem_nts_huge_pages(int iterations);
+
+int testkem_nts_patterson(int iterations);
+
+int testkem_nts_syndromes(int iterations);
+
+int testkem_ff_mul();
+
 #endif /* _NTSKEM_TEST_H */
@@ -0,0 +1,158 @@
+/**
+ *  worker_group.c
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "worker_group.h"
+#include "nts_kem_errors.h"
+
+typedef struct {
+    worker_group *wg;
+    int index;
+    pthread_t thread;
+} worker;
+
+struct worker_group {
+    int count;
+    int started;                /* The number of threads running */
+    int stop;
+    uint64_t generation;        /* Incremented on every run */
+    int pending;                /* The threads yet to finish the run */
+    worker_group_fn fn;
+    void *arg;
+    pthread_mutex_t run_lock;   /* Serialises worker_group_run */
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    worker *workers;
+};
+
+static void *worker_main(void *ptr)
+{
+    worker *w = (worker *)ptr;
+    worker_group *wg = w->wg;
+    uint64_t generation = 0;
+    worker_group_fn fn;
+    void *arg;
+
+    pthread_mutex_lock(&wg->lock);
+    for (;;) {
+        while (!wg->stop && wg->generation == generation)
+            pthread_cond_wait(&wg->start, &wg->lock);
+        if (wg->stop)
+            break;
+        generation = wg->generation;
+        fn = wg->fn;
+        arg = wg->arg;
+        pthread_mutex_unlock(&wg->lock);
+
+        fn(arg, w->index, wg->count);
+
+        pthread_mutex_lock(&wg->lock);
+        if (--wg->pending == 0)
+            pthread_cond_signal(&wg->done);
+    }
+    pthread_mutex_unlock(&wg->lock);
+
+    return NULL;
+}
+
+int worker_group_create(worker_group** wg, int count)
+{
+    int i;
+    worker_group *wg_ptr = NULL;
+
+    if (!wg || count < 1)
+        return NTS_KEM_BAD_PARAMETERS;
+
+    *wg = (worker_group *)calloc(1, sizeof(worker_group));
+    if (!(*wg))
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    wg_ptr = *wg;
+    wg_ptr->count = count;
+
+    wg_ptr->workers = (worker *)calloc(count, sizeof(worker));
+    if (!wg_ptr->workers) {
+        free(wg_ptr);
+        *wg = NULL;
+        return NTS_KEM_BAD_MEMORY_ALLOCATION;
+    }
+
+    pthread_mutex_init(&wg_ptr->run_lock, NULL);
+    pthread_mutex_init(&wg_ptr->lock, NULL);
+    pthread_cond_init(&wg_ptr->start, NULL);
+    pthread_cond_init(&wg_ptr->done, NULL);
+
+    for (i=1; i<count; i++) {
+        wg_ptr->workers[i].wg = wg_ptr;
+        wg_ptr->workers[i].index = i;
+        if (0 != pthread_create(&wg_ptr->workers[i].thread, NULL,
+                                worker_main, &wg_ptr->workers[i])) {
+            worker_group_release(wg_ptr);
+            *wg = NULL;
+            return NTS_KEM_BAD_MEMORY_ALLOCATION;
+        }
+        wg_ptr->started++;
+    }
+
+    return NTS_KEM_SUCCESS;
+}
+
+void worker_group_run(worker_group* wg, worker_group_fn fn, void *arg)
+{
+    pthread_mutex_lock(&wg->run_lock);
+
+    pthread_mutex_lock(&wg->lock);
+    wg->fn = fn;
+    wg->arg = arg;
+    wg->pending = wg->count - 1;
+    wg->generation++;
+    pthread_cond_broadcast(&wg->start);
+    pthread_mutex_unlock(&wg->lock);
+
+    fn(arg, 0, wg->count);
+
+    pthread_mutex_lock(&wg->lock);
+    while (wg->pending > 0)
+        pthread_cond_wait(&wg->done, &wg->lock);
+    pthread_mutex_unlock(&wg->lock);
+
+    pthread_mutex_unlock(&wg->run_lock);
+}
+
+int worker_group_size(const worker_group* wg)
+{
+    return wg->count;
+}
+
+void worker_group_release(worker_group* wg)
+{
+    int i;
+
+    if (wg) {
+        pthread_mutex_lock(&wg->lock);
+        wg->stop = 1;
+        pthread_cond_broadcast(&wg->start);
+        pthread_mutex_unlock(&wg->lock);
+        for (i=1; i<=wg->started; i++) {
+            pthread_join(wg->workers[i].thread, NULL);
+        }
+
+        pthread_cond_destroy(&wg->done);
+        pthread_cond_destroy(&wg->start);
+        pthread_mutex_destroy(&wg->lock);
+        pthread_mutex_destroy(&wg->run_lock);
+        free(wg->workers);
+        free(wg);
+    }
+}
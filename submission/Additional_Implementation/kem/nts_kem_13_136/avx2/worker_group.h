@@ -0,0 +1,75 @@
+/**
+ *  worker_group.h
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: AVX2
+ *
+ *  A small group of threads that run a function jointly, used to
+ *  split a single decapsulation across several cores
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#ifndef __NTSKEM_WORKER_GROUP_H
+#define __NTSKEM_WORKER_GROUP_H
+
+/**
+ *  The function run by every member of a worker group
+ *
+ *  @param[in] arg    The argument of {@see worker_group_run}
+ *  @param[in] index  The index of the member, 0 for the caller
+ *  @param[in] count  The number of members of the group
+ **/
+typedef void (*worker_group_fn)(void *arg, int index, int count);
+
+typedef struct worker_group worker_group;
+
+/**
+ *  Create a worker group
+ *
+ *  @note
+ *  The caller of {@see worker_group_run} is member 0 of the group,
+ *  hence only count-1 threads are started. They are blocked while
+ *  the group is idle.
+ *
+ *  @param[out] wg     A pointer of worker_group object created
+ *  @param[in]  count  The number of members of the group
+ *  @return NTS_KEM_SUCCESS on success, otherwise a negative error code
+ *          {@see nts_kem_errors.h}
+ **/
+int worker_group_create(worker_group** wg, int count);
+
+/**
+ *  Run fn(arg, index, count) on every member of the group and wait
+ *  for all of them to return
+ *
+ *  @note
+ *  Concurrent calls on the same group are serialised. The members
+ *  are told apart by their index only, the work of each index is
+ *  fixed so the result does not depend on the thread scheduling.
+ *
+ *  @param[in] wg   The worker group
+ *  @param[in] fn   The function to run
+ *  @param[in] arg  The argument of the function
+ **/
+void worker_group_run(worker_group* wg, worker_group_fn fn, void *arg);
+
+/**
+ *  Return the number of members of a worker group
+ *
+ *  @param[in] wg  The worker group
+ *  @return The number of members
+ **/
+int worker_group_size(const worker_group* wg);
+
+/**
+ *  Stop the threads of a worker group and release it
+ *
+ *  @param[in] wg  The worker group
+ **/
+void worker_group_release(worker_group* wg);
+
+#endif /* __NTSKEM_WORKER_GROUP_H */
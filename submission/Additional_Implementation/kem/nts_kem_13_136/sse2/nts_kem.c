@@ -16,6 +16,7 @@
 #include <inttypes.h>
 #include "nts_kem.h"
 #include "ff.h"
+#include "vector_ff.h"
 #include "bits.h"
 #include "matrix_ff2.h"
 #include "polynomial.h"
@@ -33,12 +34,12 @@
 
 typedef struct {
     uint32_t m;
-    FF2m *ff2m;
+    const FF2m *ff2m;
     ff_unit a[ NTS_KEM_PARAM_BC ];
     ff_unit h[ NTS_KEM_PARAM_BC ];
     ff_unit p[ NTS_KEM_PARAM_N ];
     uint8_t z[ NTS_KEM_KEY_SIZE ];
-    uint8_t pk[ NTS_KEM_PUBLIC_KEY_SIZE ];
+    const uint8_t *pk;          /* The public key within the private key */
 } NTSKEM_private;
 
 static const int kNTSKEMKeysize = NTS_KEM_KEY_SIZE;
@@ -72,6 +73,7 @@ void unpack_buffer(const uint8_t *src, ff_unit *dst, int dst_len);
 int serialise_public_key(NTSKEM* nts_kem, const matrix_ff2* SGP);
 int serialise_private_key(NTSKEM *nts_kem, const matrix_ff2* Q);
 int deserialise_private_key(NTSKEM* nts_kem, const uint8_t *buf);
+void load_private_key(NTSKEM* nts_kem, NTSKEM_private* priv, const uint8_t *sk);
 void load_input_ciphertext(vector *out, const uint8_t *in);
 
 /**
@@ -263,8 +265,14 @@ int nts_kem_init_from_private_key(NTSKEM** nts_kem,
     if (!priv->ff2m)
         goto nts_kem_init_fail;
     
+    /* Keep a copy of the private key blob, the public-key is read from it */
+    nts_kem_ptr->private_key = (uint8_t *)malloc(NTS_KEM_PRIVATE_KEY_SIZE);
+    if (!nts_kem_ptr->private_key)
+        goto nts_kem_init_fail;
+    memcpy(nts_kem_ptr->private_key, ptr, NTS_KEM_PRIVATE_KEY_SIZE);
+    
     /* Deserialise the private key blob */
-    if (deserialise_private_key(nts_kem_ptr, ptr) != NTS_KEM_SUCCESS) {
+    if (deserialise_private_key(nts_kem_ptr, nts_kem_ptr->private_key) != NTS_KEM_SUCCESS) {
         goto nts_kem_init_fail;
     }
     
@@ -406,7 +414,8 @@ int nts_kem_decapsulate(const uint8_t *sk,
     int32_t i, status = NTS_KEM_BAD_MEMORY_ALLOCATION;
     int32_t extended_error = 0;
     uint32_t checksum = 0, error_weight = 0;
-    NTSKEM *nts_kem = NULL;
+    NTSKEM nts_kem_sk, *nts_kem = &nts_kem_sk;
+    NTSKEM_private priv_sk;
     NTSKEM_private *priv = NULL;
     vector in_cipher[NTS_KEM_PARAM_BC_VEC];
     __m128i vec_syndromes[3][NTS_KEM_PARAM_M] = {{{0}}};
@@ -430,17 +439,16 @@ int nts_kem_decapsulate(const uint8_t *sk,
     uint64_t start_clock, end_clock;
 #endif
     
-    if (!k_r || !c_ast) {
+    if (!sk || !k_r || !c_ast) {
         status = NTS_KEM_BAD_PARAMETERS;
         goto decapsulation_failure;
     }
     
     /**
-     * Construct an NTS object from private key
+     * Construct an NTS object from private key, a, h, p and z are
+     * unpacked to the stack and the public key is read from sk
      **/
-    if (NTS_KEM_SUCCESS != nts_kem_init_from_private_key(&nts_kem, sk, NTS_KEM_PRIVATE_KEY_SIZE))
-        goto decapsulation_failure;
-    
+    load_private_key(nts_kem, &priv_sk, sk);
     priv = nts_kem->priv;
 
     /**
@@ -588,8 +596,7 @@ decapsulation_failure:
     CT_memset(syndromes, 0, sizeof(syndromes));
     CT_memset(c_prime, 0, NTS_KEM_CIPHERTEXT_SIZE);
     CT_memset(evals, 0, sizeof(evals));
-    if (nts_kem)
-        nts_kem_release(nts_kem);
+    CT_memset(&priv_sk, 0, sizeof(priv_sk));
     
     return status;
 }
@@ -799,7 +806,7 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
      * Calculate G(a_i)^{-2} using vectorised implementation
      **/
     for (i=0,j=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-        priv->ff2m->vector_ff_sqr_inv(priv->ff2m, hv1[i], hv0[i]);
+        vector_ff_sqr_inv_13(priv->ff2m, hv1[i], hv0[i]);
     }
     vector_store_2d_128(h, (const __m128i (*)[])hv1, NTS_KEM_PARAM_N);
     
@@ -819,7 +826,7 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
     }
     /* h_1 = h_0 * a */
     for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-        priv->ff2m->vector_ff_mul(priv->ff2m, hv0[i], hv1[i], av0[i]);
+        vector_ff_mul_13(priv->ff2m, hv0[i], hv1[i], av0[i]);
     }
     /* The second batch of NTS_KEM_PARAM_M rows of parity-check matrix */
     for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
@@ -832,7 +839,7 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
     for (l=2; l<Gz->degree; l+=2) {
         /* h_l = h_{l-1} * a */
         for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-            priv->ff2m->vector_ff_mul(priv->ff2m, hv1[i], hv0[i], av0[i]);
+            vector_ff_mul_13(priv->ff2m, hv1[i], hv0[i], av0[i]);
         }
         /* The l-th batch of NTS_KEM_PARAM_M rows of parity-check matrix */
         for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
@@ -844,7 +851,7 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
         }
         /* h_l = h_{l-1} * a */
         for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-            priv->ff2m->vector_ff_mul(priv->ff2m, hv0[i], hv1[i], av0[i]);
+            vector_ff_mul_13(priv->ff2m, hv0[i], hv1[i], av0[i]);
         }
         /* The (l+1)-th batch of NTS_KEM_PARAM_M rows of parity-check matrix */
         for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
@@ -912,6 +919,93 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
     return Q;
 }
 
+/**
+ *  Pack 8 units of 13 bits into 13 bytes, using two 64-bit words
+ **/
+static inline void pack_13x8(const ff_unit *src, uint8_t *dst)
+{
+    int32_t i;
+    uint64_t w0, w1;
+    
+    w0 = ((uint64_t)(src[0] & 0x1FFF)      ) | ((uint64_t)(src[1] & 0x1FFF) << 13) |
+         ((uint64_t)(src[2] & 0x1FFF) << 26) | ((uint64_t)(src[3] & 0x1FFF) << 39) |
+         ((uint64_t)(src[4] & 0x1FFF) << 52);
+    w1 = ((uint64_t)(src[4] & 0x1FFF) >> 12) | ((uint64_t)(src[5] & 0x1FFF) <<  1) |
+         ((uint64_t)(src[6] & 0x1FFF) << 14) | ((uint64_t)(src[7] & 0x1FFF) << 27);
+    for (i=0; i<8; i++) dst[i]   = (uint8_t)(w0 >> (i << 3));
+    for (i=0; i<5; i++) dst[8+i] = (uint8_t)(w1 >> (i << 3));
+}
+
+/**
+ *  Unpack 13 bytes into 8 units of 13 bits, using two 64-bit words
+ **/
+static inline void unpack_13x8(const uint8_t *src, ff_unit *dst)
+{
+    int32_t i;
+    uint64_t w0 = 0, w1 = 0;
+    
+    for (i=0; i<8; i++) w0 |= ((uint64_t)src[i]   << (i << 3));
+    for (i=0; i<5; i++) w1 |= ((uint64_t)src[8+i] << (i << 3));
+    dst[0] = (ff_unit)( w0        & 0x1FFF);
+    dst[1] = (ff_unit)((w0 >> 13) & 0x1FFF);
+    dst[2] = (ff_unit)((w0 >> 26) & 0x1FFF);
+    dst[3] = (ff_unit)((w0 >> 39) & 0x1FFF);
+    dst[4] = (ff_unit)(((w0 >> 52) | (w1 << 12)) & 0x1FFF);
+    dst[5] = (ff_unit)((w1 >>  1) & 0x1FFF);
+    dst[6] = (ff_unit)((w1 >> 14) & 0x1FFF);
+    dst[7] = (ff_unit)((w1 >> 27) & 0x1FFF);
+}
+
+/**
+ *  Pack 8 units of 13 bits into 13 bytes
+ *
+ *  @note
+ *  Each unit is widened to 32 bits and shifted to its bit offset,
+ *  by a multiplication, the bytes are then moved in place with
+ *  shuffles. Units 0, 2, ... and 1, 3, ... do not share bytes so
+ *  they can be shuffled separately and combined. 16 bytes are
+ *  written at `dst`.
+ **/
+static inline void pack_13x8_sse(const ff_unit *src, uint8_t *dst)
+{
+    __m128i v, lo, hi, out;
+    const __m128i zero = _mm_setzero_si128();
+    
+    v  = _mm_and_si128(_mm_loadu_si128((const __m128i *)src), _mm_set1_epi16(0x1FFF));
+    lo = _mm_mullo_epi32(_mm_unpacklo_epi16(v, zero), _mm_setr_epi32(1, 32, 4, 128));
+    hi = _mm_mullo_epi32(_mm_unpackhi_epi16(v, zero), _mm_setr_epi32(16, 2, 64, 8));
+    out = _mm_or_si128(
+            _mm_or_si128(
+                _mm_shuffle_epi8(lo, _mm_setr_epi8( 0,  1, -1,  8,  9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(lo, _mm_setr_epi8(-1,  4,  5,  6, 12, 13, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1))),
+            _mm_or_si128(
+                _mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, -1, -1, -1, -1,  0,  1,  2,  8,  9, 10, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1,  4,  5, -1, 12, 13, -1, -1, -1))));
+    _mm_storeu_si128((__m128i *)dst, out);
+}
+
+/**
+ *  Unpack 13 bytes into 8 units of 13 bits
+ *
+ *  @note
+ *  The 3 bytes holding each unit are gathered into a 32-bit lane
+ *  with shuffles. The lane is shifted up to a common bit offset by
+ *  a multiplication, shifted down by 8 and narrowed back to 16 bits.
+ *  16 bytes are read from `src`.
+ **/
+static inline void unpack_13x8_sse(const uint8_t *src, ff_unit *dst)
+{
+    __m128i v, lo, hi;
+    const __m128i mask = _mm_set1_epi32(0x1FFF);
+    
+    v  = _mm_loadu_si128((const __m128i *)src);
+    lo = _mm_shuffle_epi8(v, _mm_setr_epi8(0, 1, 2, -1, 1, 2,  3, -1, 3,  4,  5, -1,  4,  5,  6, -1));
+    hi = _mm_shuffle_epi8(v, _mm_setr_epi8(6, 7, 8, -1, 8, 9, 10, -1, 9, 10, 11, -1, 11, 12, 13, -1));
+    lo = _mm_and_si128(_mm_srli_epi32(_mm_mullo_epi32(lo, _mm_setr_epi32(256, 8, 64, 2)), 8), mask);
+    hi = _mm_and_si128(_mm_srli_epi32(_mm_mullo_epi32(hi, _mm_setr_epi32(16, 128, 4, 32)), 8), mask);
+    _mm_storeu_si128((__m128i *)dst, _mm_packus_epi32(lo, hi));
+}
+
 /**
  *  Pack buffer of 2*src_len bytes into a buffer of
  *  size src_len*13/8.
@@ -922,38 +1016,15 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
  **/
 void pack_buffer(const uint8_t *src, int src_len, uint8_t *dst)
 {
-    int32_t i;
-    const uint8_t* src_ptr = src;
-    uint8_t *dst_ptr = dst;
-
-    for (i=0; i<src_len; i+=8) {
-        *dst_ptr  = *src_ptr++; dst_ptr++;
-        *dst_ptr  = *src_ptr++;
-        *dst_ptr |= ((*src_ptr   & 0x07) << 5); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xF8) >> 3);
-        *dst_ptr |= ((*src_ptr   & 0x07) << 5); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0x18) >> 3);
-        *dst_ptr |= ((*src_ptr   & 0x3F) << 2); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xC0) >> 6);
-        *dst_ptr |= ((*src_ptr++ & 0x1F) << 2);
-        *dst_ptr |= ((*src_ptr   & 0x01) << 7); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xFE) >> 1);
-        *dst_ptr |= ((*src_ptr   & 0x01) << 7); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0x1E) >> 1);
-        *dst_ptr |= ((*src_ptr   & 0x0F) << 4); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xF0) >> 4);
-        *dst_ptr |= ((*src_ptr   & 0x0F) << 4); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0x10) >> 4);
-        *dst_ptr |= ((*src_ptr   & 0x7F) << 1); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0x80) >> 7);
-        *dst_ptr |= ((*src_ptr++ & 0x1F) << 1);
-        *dst_ptr |= ((*src_ptr   & 0x03) << 6); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xFC) >> 2);
-        *dst_ptr |= ((*src_ptr   & 0x03) << 6); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0x1C) >> 2);
-        *dst_ptr |= ((*src_ptr   & 0x1F) << 3); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xE0) >> 5);
-        *dst_ptr |= ((*src_ptr++ & 0x1F) << 3); dst_ptr++;
+    int32_t i = 0;
+    const ff_unit *src_ptr = (const ff_unit *)src;
+    
+    /* The vector stores write past the group, keep them within dst */
+    for (; i+16<=src_len; i+=8) {
+        pack_13x8_sse(&src_ptr[i], &dst[((i*13) >> 3)]);
+    }
+    for (; i+8<=src_len; i+=8) {
+        pack_13x8(&src_ptr[i], &dst[((i*13) >> 3)]);
     }
 }
 
@@ -966,30 +1037,14 @@ void pack_buffer(const uint8_t *src, int src_len, uint8_t *dst)
  **/
 void unpack_buffer(const uint8_t *src, ff_unit *dst, int dst_len)
 {
-    int32_t i, value;
-    const uint8_t *src_ptr = src;
-
-    /* Read 13 bytes in ago and assign them to 8 2-byte dst array */
-    for (i=0; i<dst_len; i+=8) {
-        value = (*(src_ptr+2) << 16) | (*(src_ptr+1) << 8) | *src_ptr;
-        dst[i]    =  (value & 0x00001FFF);
-        dst[i+1]  = ((value & 0x00FFE000) >> 13);
-        src_ptr += 3;
-        value = (*(src_ptr+2) << 16) | (*(src_ptr+1) << 8) | *src_ptr;
-        dst[i+1] |= ((value & 0x00000003) << 11);
-        dst[i+2]  = ((value & 0x00007FFC) >>  2);
-        dst[i+3]  = ((value & 0x00FF8000) >> 15);
-        src_ptr += 3;
-        value = (*(src_ptr+2) << 16) | (*(src_ptr+1) << 8) | *src_ptr;
-        dst[i+3] |= ((value & 0x0000000F) <<  9);
-        dst[i+4]  = ((value & 0x0001FFF0) >>  4);
-        dst[i+5]  = ((value & 0x00FE0000) >> 17);
-        src_ptr += 3;
-        value = (*(src_ptr+3) << 24) | (*(src_ptr+2) << 16) | (*(src_ptr+1) << 8) | *src_ptr;
-        dst[i+5] |= ((value & 0x0000003F) <<  7);
-        dst[i+6]  = ((value & 0x0007FFC0) >>  6);
-        dst[i+7]  = ((value & 0xFFF80000) >> 19);
-        src_ptr += 4;
+    int32_t i = 0;
+    
+    /* The vector loads read past the group, keep them within src */
+    for (; i+16<=dst_len; i+=8) {
+        unpack_13x8_sse(&src[((i*13) >> 3)], &dst[i]);
+    }
+    for (; i+8<=dst_len; i+=8) {
+        unpack_13x8(&src[((i*13) >> 3)], &dst[i]);
     }
 }
 
@@ -1058,6 +1113,7 @@ int serialise_private_key(NTSKEM *nts_kem, const matrix_ff2* Q)
     
     memcpy(key_ptr, priv->z, NTS_KEM_KEY_SIZE);
     key_ptr += NTS_KEM_KEY_SIZE;
+    priv->pk = key_ptr;
     
     for (i=0; i<NTS_KEM_PARAM_K; i++) {
         v_ptr = (packed_t *)row_ptr_matrix_ff2(Q, i);
@@ -1071,6 +1127,32 @@ int serialise_private_key(NTSKEM *nts_kem, const matrix_ff2* Q)
     return NTS_KEM_SUCCESS;
 }
 
+/**
+ *  Initialise an NTS-KEM object in place from a private key,
+ *  without any memory allocation
+ *
+ *  @note
+ *  The public key is not copied, it is read from the private key
+ *  buffer, which has to outlive the object. The object must not
+ *  be released with {@see nts_kem_release}.
+ *
+ *  @param[out] nts_kem  The NTS-KEM object
+ *  @param[out] priv     The private component of the object
+ *  @param[in]  sk       The pointer to NTS-KEM private key
+ **/
+void load_private_key(NTSKEM* nts_kem, NTSKEM_private* priv, const uint8_t *sk)
+{
+    nts_kem->length = NTS_KEM_PARAM_N;
+    nts_kem->t = NTS_KEM_PARAM_T;
+    nts_kem->public_key = nts_kem->private_key = NULL;
+    nts_kem->public_key_size = 0;
+    nts_kem->private_key_size = NTS_KEM_PRIVATE_KEY_SIZE;
+    nts_kem->priv = priv;
+    priv->m = NTS_KEM_PARAM_M;
+    priv->ff2m = ff_create(priv->m);
+    deserialise_private_key(nts_kem, sk);
+}
+
 /**
  *  Deserialise NTS-KEM private key
  *
@@ -1098,8 +1180,8 @@ int deserialise_private_key(NTSKEM* nts_kem, const uint8_t *buf)
     memcpy(priv->z, buf, NTS_KEM_KEY_SIZE);
     buf += NTS_KEM_KEY_SIZE;
     
-    /* Deserialise public-key */
-    memcpy(priv->pk, buf, NTS_KEM_PUBLIC_KEY_SIZE);
+    /* The public-key is used in place */
+    priv->pk = buf;
 
     return NTS_KEM_SUCCESS;
 }
@@ -1145,20 +1227,16 @@ int encapsulate(const uint8_t *e,
     int status = NTS_KEM_BAD_MEMORY_ALLOCATION;
     int32_t i, j, l;
     packed_t v;
-    const uint8_t *pk_ptr = pk;
     vector c_c[NTS_KEM_PARAM_R_VEC];
-    vector Q[NTS_KEM_PARAM_K][NTS_KEM_PARAM_R_VEC];
+    vector q[NTS_KEM_PARAM_R_VEC];
     uint8_t kr_in_buf[kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_N_BYTE];
     uint8_t k_e[kNTSKEMKeysize];
     
     /**
-     * Populate the generator matrix, but only the parity section
+     * The rows of the parity section Q of the generator matrix
+     * are read from the public key as they are needed
      **/
-    for (i=0; i<NTS_KEM_PARAM_K; i++) {
-        Q[i][NTS_KEM_PARAM_R_VEC-1] = _mm_setzero_si128();
-        memcpy(Q[i], pk_ptr, NTS_KEM_PARAM_CEIL_R_BYTE);
-        pk_ptr += NTS_KEM_PARAM_CEIL_R_BYTE;
-    }
+    q[NTS_KEM_PARAM_R_VEC-1] = _mm_setzero_si128();
     
     /**
      * Step 3. Compute SHA3_256(e) to produce k_e
@@ -1189,8 +1267,9 @@ int encapsulate(const uint8_t *e,
             l = (int32_t)lowest_bit_idx(v);
             v ^= (ONE << l);
             l += (BITSIZE*i);
+            memcpy(q, &pk[l*NTS_KEM_PARAM_CEIL_R_BYTE], NTS_KEM_PARAM_CEIL_R_BYTE);
             for (j=0; j<NTS_KEM_PARAM_R_VEC; j++) {
-                c_c[j] ^= Q[l][j];
+                c_c[j] ^= q[j];
             }
         }
     }
@@ -1200,8 +1279,9 @@ int encapsulate(const uint8_t *e,
         l = (int32_t)lowest_bit_idx(v);
         v ^= (ONE << l);
         l += (BITSIZE*i);
+        memcpy(q, &pk[l*NTS_KEM_PARAM_CEIL_R_BYTE], NTS_KEM_PARAM_CEIL_R_BYTE);
         for (j=0; j<NTS_KEM_PARAM_R_VEC; j++) {
-            c_c[j] ^= Q[l][j];
+            c_c[j] ^= q[j];
         }
     }
     for (i=0; i<NTS_KEM_PARAM_B >> LOG2; i++) {
@@ -1210,8 +1290,9 @@ int encapsulate(const uint8_t *e,
             l = (int32_t)lowest_bit_idx(v);
             v ^= (ONE << l);
             l += ((BITSIZE*i) + NTS_KEM_PARAM_A);
+            memcpy(q, &pk[l*NTS_KEM_PARAM_CEIL_R_BYTE], NTS_KEM_PARAM_CEIL_R_BYTE);
             for (j=0; j<NTS_KEM_PARAM_R_VEC; j++) {
-                c_c[j] ^= Q[l][j];
+                c_c[j] ^= q[j];
             }
         }
     }
@@ -1253,6 +1334,7 @@ int encapsulate(const uint8_t *e,
     sha3_256(kr_in_buf, kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_N_BYTE, k_r);
     
     status = NTS_KEM_SUCCESS;
+    CT_memset(q, 0, sizeof(q));
     CT_memset(kr_in_buf, 0, kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_N_BYTE);
     
     return status;
@@ -1280,7 +1362,7 @@ int compute_syndrome(const NTSKEM* nts_kem,
                      ff_unit* s)
 {
     int32_t i, j;
-    FF2m *ff2m = NULL;
+    const FF2m *ff2m = NULL;
     NTSKEM_private *priv = NULL;
     vector a[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
     vector g[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
@@ -1301,15 +1383,15 @@ int compute_syndrome(const NTSKEM* nts_kem,
         for (j=0; j<NTS_KEM_PARAM_M; j++)
             g[i][j] &= *c_ptr;
         c_ptr++;
-        s[0] ^= ff2m->vector_ff_transpose_xor(ff2m, g[i]);
+        s[0] ^= vector_ff_transpose_xor_13(ff2m, g[i]);
         for (j=1; j<=2*NTS_KEM_PARAM_T-2; j+=2) {
-            ff2m->vector_ff_mul(ff2m, h[i], a[i], g[i]);
-            s[j]   ^= ff2m->vector_ff_transpose_xor(ff2m, h[i]);
-            ff2m->vector_ff_mul(ff2m, g[i], a[i], h[i]);
-            s[j+1] ^= ff2m->vector_ff_transpose_xor(ff2m, g[i]);
+            vector_ff_mul_13(ff2m, h[i], a[i], g[i]);
+            s[j]   ^= vector_ff_transpose_xor_13(ff2m, h[i]);
+            vector_ff_mul_13(ff2m, g[i], a[i], h[i]);
+            s[j+1] ^= vector_ff_transpose_xor_13(ff2m, g[i]);
         }
-        ff2m->vector_ff_mul(ff2m, h[i], a[i], g[i]);
-        s[j] ^= ff2m->vector_ff_transpose_xor(ff2m, h[i]);
+        vector_ff_mul_13(ff2m, h[i], a[i], g[i]);
+        s[j] ^= vector_ff_transpose_xor_13(ff2m, h[i]);
     }
     
     CT_memset(a, 0, sizeof(a));
@@ -0,0 +1,420 @@
+/**
+ *  vector_ff.h
+ *  NTS-KEM
+ *
+ *  Parameter: NTS-KEM(13, 136)
+ *  Platform: SSE2
+ *
+ *  Vectorised arithmetic over F_{2^13}. The functions used in
+ *  the hot loops are defined here so that they can be called
+ *  directly and inlined, rather than through an FF2m instance.
+ *
+ *  This file is part of the additional implemention of NTS-KEM
+ *  submitted as part of NIST Post-Quantum Cryptography
+ *  Standardization Process.
+ **/
+
+#ifndef __NTSKEM_VECTOR_FF_H
+#define __NTSKEM_VECTOR_FF_H
+
+#include "ff.h"
+
+/**
+ *  Vectorised multiplication, {@see FF2m}
+ *
+ *  @param[in]  ff2m  Unused, may be NULL
+ *  @param[out] c     Pointer to an output array
+ *  @param[in]  a     Pointer to an input array
+ *  @param[in]  b     Pointer to another input array
+ **/
+static inline void vector_ff_mul_13(const FF2m* ff2m, vector* c, const vector* a, const vector* b)
+{
+    vector t[13];
+    
+    /**
+     * These sequences of & and ^ are obtained from here:
+     * http://www.cs.yale.edu/homes/peralta/CircuitStuff/binary_pol_mult/B13size255depth8
+     *
+     * Circuit Minimization Work
+     *
+     * The gates, including those of the modulo reduction, are listed
+     * in an order which keeps few values live, to avoid register spills
+     **/
+    vector y1 = a[12] & b[0];
+    vector y2 = a[12] & b[1];
+    vector y3 = a[12] & b[2];
+    vector y4 = a[12] & b[3];
+    vector y5 = a[12] & b[4];
+    vector y6 = a[12] & b[5];
+    vector y7 = a[12] & b[6];
+    vector y8 = a[12] & b[7];
+    vector y9 = a[12] & b[8];
+    vector y10 = a[12] & b[9];
+    vector y11 = a[12] & b[10];
+    vector y12 = a[12] & b[11];
+    vector y13 = a[0] & b[12];
+    vector y14 = a[1] & b[12];
+    vector y15 = a[2] & b[12];
+    vector y16 = a[3] & b[12];
+    vector y17 = a[4] & b[12];
+    vector y18 = a[5] & b[12];
+    vector y19 = a[6] & b[12];
+    vector y160 = y7 ^ y19;
+    vector y20 = a[7] & b[12];
+    vector y21 = a[8] & b[12];
+    vector y239 = y9 ^ y21;
+    vector y22 = a[9] & b[12];
+    vector y23 = a[10] & b[12];
+    vector y24 = a[11] & b[12];
+    vector h23 = y12 ^ y24;
+    vector y26 = a[11] & b[11];
+    vector y213 = y11 ^ y26;
+    vector h22 = y23 ^ y213;
+    vector y27 = a[11] & b[9];
+    vector y28 = a[11] & b[10];
+    vector y29 = a[9] & b[11];
+    vector y30 = a[10] & b[11];
+    vector y142 = y28 ^ y30;
+    vector y157 = y10 ^ y142;
+    vector h21 = y22 ^ y157;
+    vector y31 = a[10] & b[10];
+    vector y219 = y27 ^ y31;
+    vector y224 = y29 ^ y219;
+    vector h20 = y224 ^ y239;
+    vector y32 = a[10] & b[9];
+    vector y33 = a[9] & b[10];
+    vector y179 = y32 ^ y33;
+    vector y34 = a[9] & b[9];
+    vector y35 = a[8] & b[8];
+    vector y180 = y35 ^ y179;
+    vector y185 = y26 ^ y180;
+    vector y36 = a[8] & b[6];
+    vector y37 = a[8] & b[7];
+    vector y38 = a[6] & b[8];
+    vector y39 = a[7] & b[8];
+    vector y137 = y34 ^ y39;
+    vector y141 = y37 ^ y137;
+    vector y144 = y141 ^ y142;
+    vector y174 = y144 ^ y160;
+    vector y40 = a[7] & b[7];
+    vector y222 = y36 ^ y40;
+    vector y225 = y38 ^ y222;
+    vector y227 = y224 ^ y225;
+    vector y41 = a[7] & b[6];
+    vector y42 = a[6] & b[7];
+    vector y43 = a[6] & b[6];
+    vector y44 = a[5] & b[5];
+    vector y178 = y42 ^ y44;
+    vector y183 = y41 ^ y178;
+    vector y45 = a[5] & b[3];
+    vector y46 = a[5] & b[4];
+    vector y140 = y43 ^ y46;
+    vector y47 = a[3] & b[5];
+    vector y48 = a[4] & b[5];
+    vector y143 = y48 ^ y140;
+    vector y49 = a[4] & b[4];
+    vector y220 = y45 ^ y49;
+    vector y221 = y47 ^ y220;
+    vector y245 = y15 ^ y221;
+    vector y248 = y3 ^ y245;
+    vector y50 = a[4] & b[3];
+    vector y51 = a[3] & b[4];
+    vector y181 = y50 ^ y51;
+    vector y52 = a[3] & b[3];
+    vector y53 = a[2] & b[2];
+    vector y184 = y53 ^ y181;
+    vector y54 = a[2] & b[0];
+    vector y55 = a[2] & b[1];
+    vector y56 = a[0] & b[2];
+    vector y223 = y54 ^ y56;
+    vector y57 = a[1] & b[2];
+    vector y138 = y52 ^ y57;
+    vector y139 = y55 ^ y138;
+    vector y58 = a[1] & b[1];
+    t[2] = y58 ^ y223;
+    vector y228 = y221 ^ t[2];
+    vector y59 = a[1] & b[0];
+    vector y60 = a[0] & b[1];
+    t[1] = y59 ^ y60;
+    vector y186 = t[1] ^ y184;
+    t[0] = a[0] & b[0];
+    vector y146 = t[0] ^ y139;
+    vector y62 = b[6] ^ b[9];
+    vector y63 = b[7] ^ b[10];
+    vector y64 = b[8] ^ b[11];
+    vector y65 = a[6] ^ a[9];
+    vector y71 = y65 & y64;
+    vector y75 = y65 & y63;
+    vector y76 = y65 & y62;
+    vector y149 = y76 ^ y143;
+    vector y66 = a[7] ^ a[10];
+    vector y72 = y66 & y64;
+    vector y73 = y66 & y63;
+    vector y74 = y66 & y62;
+    vector y194 = y74 ^ y183;
+    vector y195 = y75 ^ y194;
+    vector y200 = y17 ^ y195;
+    vector y205 = y5 ^ y200;
+    vector y67 = a[8] ^ a[11];
+    vector y68 = y67 & y64;
+    vector y193 = y68 ^ y185;
+    vector y210 = y20 ^ y193;
+    vector h19 = y8 ^ y210;
+    vector y69 = y67 & y62;
+    vector y229 = y69 ^ y71;
+    vector y236 = y73 ^ y229;
+    vector y70 = y67 & y63;
+    vector y145 = y70 ^ y72;
+    vector h18 = y145 ^ y174;
+    vector y246 = y227 ^ y236;
+    vector y247 = y18 ^ y246;
+    vector h17 = y6 ^ y247;
+    vector y77 = b[0] ^ b[3];
+    vector y78 = b[1] ^ b[4];
+    vector y79 = b[2] ^ b[5];
+    vector y80 = a[0] ^ a[3];
+    vector y86 = y80 & y79;
+    vector y233 = y86 ^ y228;
+    vector y90 = y80 & y78;
+    vector y91 = y80 & y77;
+    t[3] = y91 ^ y146;
+    vector y158 = y149 ^ t[3];
+    vector y162 = y141 ^ y158;
+    vector y81 = a[1] ^ a[4];
+    vector y87 = y81 & y79;
+    vector y88 = y81 & y78;
+    vector y89 = y81 & y77;
+    vector y191 = y89 ^ y90;
+    t[4] = y186 ^ y191;
+    t[4] ^= h17;
+    vector y82 = a[2] ^ a[5];
+    vector y83 = y82 & y79;
+    vector y187 = y83 ^ y183;
+    vector y84 = y82 & y77;
+    vector y231 = y84 ^ y88;
+    t[5] = y231 ^ y233;
+    vector y85 = y82 & y78;
+    vector y148 = y85 ^ y143;
+    vector y150 = y87 ^ y148;
+    vector y155 = y13 ^ y150;
+    vector y156 = y139 ^ y155;
+    vector y92 = b[3] ^ b[9];
+    vector y93 = b[4] ^ b[10];
+    vector y94 = b[5] ^ b[11];
+    vector y95 = b[0] ^ b[6];
+    vector y122 = y95 ^ y92;
+    vector y96 = b[1] ^ b[7];
+    vector y123 = y96 ^ y93;
+    vector y97 = b[2] ^ b[8];
+    vector y124 = y97 ^ y94;
+    vector y98 = a[3] ^ a[9];
+    vector y116 = y98 & y94;
+    vector y230 = y116 ^ y227;
+    vector y120 = y98 & y93;
+    vector y121 = y98 & y92;
+    vector y99 = a[4] ^ a[10];
+    vector y117 = y99 & y94;
+    vector y118 = y99 & y93;
+    vector y119 = y99 & y92;
+    vector y188 = y119 ^ y120;
+    vector y100 = a[5] ^ a[11];
+    vector y113 = y100 & y94;
+    vector y197 = y113 ^ y185;
+    vector h16 = y197 ^ y205;
+    vector y201 = y113 ^ y193;
+    t[4] ^= h16;
+    t[3] ^= h16;
+    vector y114 = y100 & y92;
+    vector y234 = y114 ^ y230;
+    vector y235 = y118 ^ y234;
+    vector h14 = y235 ^ y248;
+    vector y115 = y100 & y93;
+    vector y147 = y115 ^ y117;
+    vector y154 = y144 ^ y147;
+    vector y163 = y4 ^ y154;
+    vector y165 = y149 ^ y163;
+    vector h15 = y16 ^ y165;
+    vector y101 = a[0] ^ a[6];
+    vector y125 = y101 ^ y98;
+    vector y131 = y125 & y124;
+    vector y135 = y125 & y123;
+    vector y199 = y135 ^ y191;
+    vector y136 = y125 & y122;
+    vector y107 = y101 & y97;
+    vector y111 = y101 & y96;
+    vector y189 = y111 ^ y186;
+    vector y112 = y101 & y95;
+    vector y159 = y112 ^ y150;
+    t[6] = y146 ^ y159;
+    t[6] ^= h19;
+    t[6] ^= h18;
+    t[6] ^= h16;
+    vector y102 = a[1] ^ a[7];
+    vector y126 = y102 ^ y99;
+    vector y132 = y126 & y124;
+    vector y161 = y1 ^ y132;
+    vector y164 = y145 ^ y161;
+    vector y166 = y154 ^ y164;
+    vector y133 = y126 & y123;
+    vector y243 = y131 ^ y133;
+    vector y134 = y126 & y122;
+    vector y196 = y134 ^ y195;
+    vector y207 = y180 ^ y196;
+    vector y108 = y102 & y97;
+    vector y109 = y102 & y96;
+    vector y110 = y102 & y95;
+    vector y190 = y110 ^ y189;
+    t[7] = y187 ^ y190;
+    t[7] ^= h20;
+    t[7] ^= h19;
+    t[7] ^= h17;
+    t[7] ^= h16;
+    vector y103 = a[2] ^ a[8];
+    vector y104 = y103 & y97;
+    vector y192 = y104 ^ y188;
+    vector y202 = y192 ^ y201;
+    vector y204 = y192 ^ y199;
+    vector y214 = y190 ^ y204;
+    t[10] = y207 ^ y214;
+    t[10] ^= h23;
+    t[10] ^= h22;
+    t[10] ^= h20;
+    t[10] ^= h19;
+    vector y105 = y103 & y95;
+    vector y232 = y105 ^ y107;
+    vector y237 = y109 ^ y232;
+    vector y240 = y225 ^ y237;
+    t[8] = y228 ^ y240;
+    vector y242 = y236 ^ y237;
+    t[8] ^= h21;
+    t[8] ^= h20;
+    t[8] ^= h18;
+    t[8] ^= h17;
+    vector y106 = y103 & y96;
+    vector y152 = y106 ^ y121;
+    vector y153 = y108 ^ y152;
+    vector y127 = y103 ^ y100;
+    vector y128 = y127 & y124;
+    vector y203 = y2 ^ y128;
+    vector y208 = y184 ^ y203;
+    vector y209 = y187 ^ y208;
+    vector y216 = y14 ^ y209;
+    vector h13 = y202 ^ y216;
+    h13 ^= h23;
+    h13 ^= h22;
+    t[0] ^= h13;
+    vector y129 = y127 & y122;
+    vector y251 = y129 ^ y243;
+    vector y252 = y242 ^ y251;
+    vector y130 = y127 & y123;
+    vector y172 = y130 ^ y153;
+    vector y173 = y166 ^ y172;
+    t[12] = y156 ^ y173;
+    vector y167 = y136 ^ y153;
+    vector y170 = y112 ^ y167;
+    t[9] = y162 ^ y170;
+    t[9] ^= h22;
+    t[9] ^= h21;
+    t[9] ^= h19;
+    t[9] ^= h18;
+    vector y253 = t[5] ^ y252;
+    t[11] = y235 ^ y253;
+    t[5] ^= h18;
+    t[5] ^= h17;
+    vector h24 = a[12] & b[12];
+    h15 ^= h24;
+    t[6] ^= h15;
+    t[5] ^= h15;
+    t[3] ^= h15;
+    t[2] ^= h15;
+    t[3] ^= h13;
+    h14 ^= h24;
+    h14 ^= h23;
+    t[5] ^= h14;
+    t[4] ^= h14;
+    t[4] ^= h13;
+    t[2] ^= h14;
+    t[1] ^= h14;
+    t[1] ^= h13;
+    t[12] ^= h24;
+    t[12] ^= h22;
+    t[11] ^= h24;
+    t[11] ^= h23;
+    t[11] ^= h21;
+    t[11] ^= h20;
+    t[12] ^= h21;
+    
+    c[ 0] = t[ 0]; c[ 1] = t[ 1];
+    c[ 2] = t[ 2]; c[ 3] = t[ 3];
+    c[ 4] = t[ 4]; c[ 5] = t[ 5];
+    c[ 6] = t[ 6]; c[ 7] = t[ 7];
+    c[ 8] = t[ 8]; c[ 9] = t[ 9];
+    c[10] = t[10]; c[11] = t[11];
+    c[12] = t[12];
+}
+
+/**
+ *  Vectorised squaring, {@see FF2m}
+ *
+ *  @param[in]  ff2m  Unused, may be NULL
+ *  @param[out] b     Pointer to an output array
+ *  @param[in]  a     Pointer to an input array
+ **/
+static inline void vector_ff_sqr_13(const FF2m* ff2m, vector* b, const vector* a)
+{
+    b[12]  = a[11] ^ a[12];
+    b[ 0]  = a[ 0] ^ a[11];
+    b[ 1]  = b[12] ^ a[ 7];
+    b[ 2]  = a[ 1] ^ a[ 7];
+    b[ 3]  = b[12] ^ a[ 8];
+    b[ 4]  = b[ 3] ^ a[ 2] ^ a[ 7];
+    b[ 5]  = a[ 7] ^ a[ 9];
+    b[ 6]  = a[ 3] ^ a[ 8] ^ a[ 9] ^ a[12];
+    b[ 7]  = a[ 8] ^ a[10];
+    b[ 8]  = a[ 4] ^ a[ 9] ^ a[10];
+    b[ 9]  = a[ 9] ^ a[11];
+    b[10]  = a[ 5] ^ a[10] ^ a[11];
+    b[11]  = a[10] ^ a[12];
+    b[12] ^= a[ 6];
+}
+
+/**
+ *  Obtain the XOR of the tranposed of the input array, {@see FF2m}
+ *
+ *  @param[in]  ff2m  Unused, may be NULL
+ *  @param[in]  a     Pointer to an input array
+ *  @return The XOR output
+ **/
+static inline ff_unit vector_ff_transpose_xor_13(const struct FF2m* ff2m,
+                                                 const vector* a)
+{
+    ff_unit s = 0;
+    
+    s  = (vector_popcount(a[ 0]) & 1);
+    s |= (vector_popcount(a[ 1]) & 1) <<  1;
+    s |= (vector_popcount(a[ 2]) & 1) <<  2;
+    s |= (vector_popcount(a[ 3]) & 1) <<  3;
+    s |= (vector_popcount(a[ 4]) & 1) <<  4;
+    s |= (vector_popcount(a[ 5]) & 1) <<  5;
+    s |= (vector_popcount(a[ 6]) & 1) <<  6;
+    s |= (vector_popcount(a[ 7]) & 1) <<  7;
+    s |= (vector_popcount(a[ 8]) & 1) <<  8;
+    s |= (vector_popcount(a[ 9]) & 1) <<  9;
+    s |= (vector_popcount(a[10]) & 1) << 10;
+    s |= (vector_popcount(a[11]) & 1) << 11;
+    s |= (vector_popcount(a[12]) & 1) << 12;
+    
+    return s;
+}
+
+/**
+ *  Vectorised inversion, {@see FF2m}
+ **/
+void vector_ff_inv_13(const FF2m* ff2m, vector* b, const vector* a);
+
+/**
+ *  Vectorised square and inversion, {@see FF2m}
+ **/
+void vector_ff_sqr_inv_13(const FF2m* ff2m, vector* b, const vector* a);
+
+#endif /* __NTSKEM_VECTOR_FF_H */
@@ -86,14 +86,17 @@ static void bitslice_butterflies12_64(uint64_t (*out)[12], uint64_t (*in)[12], u
         }
     }
     
-    /* i <- 0 */
+    /**
+     * i <- 0
+     *
+     * The first twiddle-factor, twiddle_factors[0], is zero, so only
+     * the odd points need to be multiplied.
+     **/
     for (j=0; j<32; j++) {
-        bitslice_mul12_64(v[0], out[2*j],   twiddle_factors[ twiddle_idx   ]);
         bitslice_mul12_64(v[1], out[2*j+1], twiddle_factors[ twiddle_idx+1 ]);
         for (b=0; b<12; b++) {
-            v[0][b] = v[1][b];
-            u = (out[2*j][b] ^ v[0][b]);
-            out[2*j+1][b] ^= (v[1][b] ^ out[2*j][b]);
+            u = (out[2*j][b] ^ v[1][b]);
+            out[2*j+1][b] ^= u;
             out[2*j][b] = u;
         }
     }
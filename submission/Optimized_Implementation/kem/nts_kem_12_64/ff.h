@@ -144,21 +144,26 @@ typedef struct FF2m {
     /**
      *  Basis
      **/
-    ff_unit* basis;
+    const ff_unit* basis;
 } FF2m;
 
 /**
- *  Create an instance of FF2m object
- *  
- *  @return FF2m instance on success, otherwise NULL
+ *  Obtain the FF2m instance
+ *
+ *  @note
+ *  The instance is a static constant shared by all callers,
+ *  no memory is allocated.
+ *
+ *  @return FF2m instance
  **/
-FF2m* ff_create();
+const FF2m* ff_create();
 
 /**
- *  Release an FF2m instance created by {@see ff_create}.
+ *  Release an FF2m instance obtained by {@see ff_create}.
+ *  There is nothing to free, this is kept for symmetry.
  *
  *  @param[in] ff2m  Instance to an FF2m object
  **/
-void ff_release(FF2m* ff2m);
+void ff_release(const FF2m* ff2m);
 
 #endif /* ff_h */
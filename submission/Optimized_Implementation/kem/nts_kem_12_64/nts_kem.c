@@ -16,6 +16,7 @@
 #include <inttypes.h>
 #include "nts_kem.h"
 #include "ff.h"
+#include "vector_ff.h"
 #include "bits.h"
 #include "matrix_ff2.h"
 #include "polynomial.h"
@@ -30,12 +31,12 @@
 
 typedef struct {
     uint32_t m;
-    FF2m *ff2m;
+    const FF2m *ff2m;
     ff_unit a[ NTS_KEM_PARAM_BC ];
     ff_unit h[ NTS_KEM_PARAM_BC ];
     ff_unit p[ NTS_KEM_PARAM_N ];
     uint8_t z[ NTS_KEM_KEY_SIZE ];
-    uint8_t pk[ NTS_KEM_PUBLIC_KEY_SIZE ];
+    const uint8_t *pk;          /* The public key within the private key */
 } NTSKEM_private;
 
 static const int kNTSKEMKeysize = NTS_KEM_KEY_SIZE;
@@ -69,6 +70,7 @@ void unpack_buffer(const uint8_t *src, ff_unit *dst, int dst_len);
 int serialise_public_key(NTSKEM* nts_kem, const matrix_ff2* SGP);
 int serialise_private_key(NTSKEM *nts_kem, const matrix_ff2* Q);
 int deserialise_private_key(NTSKEM* nts_kem, const uint8_t *buf);
+void load_private_key(NTSKEM* nts_kem, NTSKEM_private* priv, const uint8_t *sk);
 void load_input_ciphertext(uint64_t *out, const uint8_t *in);
 
 /**
@@ -236,8 +238,14 @@ int nts_kem_init_from_private_key(NTSKEM** nts_kem,
     if (!priv->ff2m)
         goto nts_kem_init_fail;
     
+    /* Keep a copy of the private key blob, the public-key is read from it */
+    nts_kem_ptr->private_key = (uint8_t *)malloc(NTS_KEM_PRIVATE_KEY_SIZE);
+    if (!nts_kem_ptr->private_key)
+        goto nts_kem_init_fail;
+    memcpy(nts_kem_ptr->private_key, ptr, NTS_KEM_PRIVATE_KEY_SIZE);
+    
     /* Deserialise the private key blob */
-    if (deserialise_private_key(nts_kem_ptr, ptr) != NTS_KEM_SUCCESS) {
+    if (deserialise_private_key(nts_kem_ptr, nts_kem_ptr->private_key) != NTS_KEM_SUCCESS) {
         goto nts_kem_init_fail;
     }
     
@@ -368,7 +376,8 @@ int nts_kem_decapsulate(const uint8_t *sk,
     int32_t i, status = NTS_KEM_BAD_MEMORY_ALLOCATION;
     int32_t extended_error = 0;
     uint32_t checksum = 0, error_weight = 0;
-    NTSKEM *nts_kem = NULL;
+    NTSKEM nts_kem_sk, *nts_kem = &nts_kem_sk;
+    NTSKEM_private priv_sk;
     NTSKEM_private *priv = NULL;
     uint64_t in_cipher[NTS_KEM_PARAM_BC_VEC];
     uint64_t vec_syndromes[2][NTS_KEM_PARAM_M] = {{0}};
@@ -389,17 +398,16 @@ int nts_kem_decapsulate(const uint8_t *sk,
     const uint64_t *in_left_ptr = NULL;
     const uint64_t *in_right_ptr = NULL;
 
-    if (!k_r || !c_ast) {
+    if (!sk || !k_r || !c_ast) {
         status = NTS_KEM_BAD_PARAMETERS;
         goto decapsulation_failure;
     }
     
     /**
-     * Construct an NTS object from private key
+     * Construct an NTS object from private key, a, h, p and z are
+     * unpacked to the stack and the public key is read from sk
      **/
-    if (NTS_KEM_SUCCESS != nts_kem_init_from_private_key(&nts_kem, sk, NTS_KEM_PRIVATE_KEY_SIZE))
-        goto decapsulation_failure;
-    
+    load_private_key(nts_kem, &priv_sk, sk);
     priv = nts_kem->priv;
 
     /**
@@ -509,8 +517,7 @@ decapsulation_failure:
     CT_memset(c_prime, 0, NTS_KEM_CIPHERTEXT_SIZE);
     CT_memset(syndromes, 0, sizeof(syndromes));
     CT_memset(evals, 0, sizeof(evals));
-    if (nts_kem)
-        nts_kem_release(nts_kem);
+    CT_memset(&priv_sk, 0, sizeof(priv_sk));
     
     return status;
 }
@@ -703,7 +710,7 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
      * Calculate G(a_i)^{-2} using vectorised implementation
      **/
     for (i=0,j=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-        priv->ff2m->vector_ff_sqr_inv(priv->ff2m, hv1[i], hv0[i]);
+        vector_ff_sqr_inv_12(priv->ff2m, hv1[i], hv0[i]);
     }
     vector_store_2d_64(h, (const uint64_t (*)[])hv1, NTS_KEM_PARAM_N);
     
@@ -723,7 +730,7 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
     }
     /* h_1 = h_0 * a */
     for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-        priv->ff2m->vector_ff_mul(priv->ff2m, hv0[i], hv1[i], av0[i]);
+        vector_ff_mul_12(priv->ff2m, hv0[i], hv1[i], av0[i]);
     }
     /* The second batch of NTS_KEM_PARAM_M rows of parity-check matrix */
     for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
@@ -736,7 +743,7 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
     for (l=2; l<Gz->degree; l+=2) {
         /* h_l = h_{l-1} * a */
         for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-            priv->ff2m->vector_ff_mul(priv->ff2m, hv1[i], hv0[i], av0[i]);
+            vector_ff_mul_12(priv->ff2m, hv1[i], hv0[i], av0[i]);
         }
         /* The l-th batch of NTS_KEM_PARAM_M rows of parity-check matrix */
         for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
@@ -748,7 +755,7 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
         }
         /* h_l = h_{l-1} * a */
         for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
-            priv->ff2m->vector_ff_mul(priv->ff2m, hv0[i], hv1[i], av0[i]);
+            vector_ff_mul_12(priv->ff2m, hv0[i], hv1[i], av0[i]);
         }
         /* The (l+1)-th batch of NTS_KEM_PARAM_M rows of parity-check matrix */
         for (i=0; i<NTS_KEM_PARAM_N_VEC; i++) {
@@ -816,6 +823,45 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
     return Q;
 }
 
+/**
+ *  Pack 8 units of 12 bits into 12 bytes, using a 64-bit and a 32-bit word
+ **/
+static inline void pack_12x8(const ff_unit *src, uint8_t *dst)
+{
+    int32_t i;
+    uint64_t w0;
+    uint32_t w1;
+    
+    w0 = ((uint64_t)(src[0] & 0x0FFF)      ) | ((uint64_t)(src[1] & 0x0FFF) << 12) |
+         ((uint64_t)(src[2] & 0x0FFF) << 24) | ((uint64_t)(src[3] & 0x0FFF) << 36) |
+         ((uint64_t)(src[4] & 0x0FFF) << 48) | ((uint64_t)(src[5] & 0x0FFF) << 60);
+    w1 = ((uint32_t)(src[5] & 0x0FFF) >>  4) | ((uint32_t)(src[6] & 0x0FFF) <<  8) |
+         ((uint32_t)(src[7] & 0x0FFF) << 20);
+    for (i=0; i<8; i++) dst[i]   = (uint8_t)(w0 >> (i << 3));
+    for (i=0; i<4; i++) dst[8+i] = (uint8_t)(w1 >> (i << 3));
+}
+
+/**
+ *  Unpack 12 bytes into 8 units of 12 bits, using a 64-bit and a 32-bit word
+ **/
+static inline void unpack_12x8(const uint8_t *src, ff_unit *dst)
+{
+    int32_t i;
+    uint64_t w0 = 0;
+    uint32_t w1 = 0;
+    
+    for (i=0; i<8; i++) w0 |= ((uint64_t)src[i]   << (i << 3));
+    for (i=0; i<4; i++) w1 |= ((uint32_t)src[8+i] << (i << 3));
+    dst[0] = (ff_unit)( w0        & 0x0FFF);
+    dst[1] = (ff_unit)((w0 >> 12) & 0x0FFF);
+    dst[2] = (ff_unit)((w0 >> 24) & 0x0FFF);
+    dst[3] = (ff_unit)((w0 >> 36) & 0x0FFF);
+    dst[4] = (ff_unit)((w0 >> 48) & 0x0FFF);
+    dst[5] = (ff_unit)(((w0 >> 60) | (w1 << 4)) & 0x0FFF);
+    dst[6] = (ff_unit)((w1 >>  8) & 0x0FFF);
+    dst[7] = (ff_unit)((w1 >> 20) & 0x0FFF);
+}
+
 /**
  *  Pack buffer of 2*src_len bytes into a buffer of
  *  size src_len*3/2.
@@ -826,25 +872,16 @@ matrix_ff2* create_matrix_G(const NTSKEM* nts_kem,
  **/
 void pack_buffer(const uint8_t *src, int src_len, uint8_t *dst)
 {
-    int32_t i;
-    const uint8_t* src_ptr = src;
-    uint8_t *dst_ptr = dst;
+    int32_t i = 0;
+    const ff_unit *src_ptr = (const ff_unit *)src;
+    for (; i+8<=src_len; i+=8) {
+        pack_12x8(&src_ptr[i], &dst[((i*3) >> 1)]);
+    }
     /* Every two units consume three bytes */
-    for (i=0; i<src_len; i+=2) {
-#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
-        *dst_ptr  = src_ptr[1]; dst_ptr++;
-        *dst_ptr  = src_ptr[0];
-        *dst_ptr |= ((src_ptr[3] & 0x0F) << 4); dst_ptr++;
-        *dst_ptr  = ((src_ptr[3] & 0xF0) >> 4);
-        *dst_ptr |= ((src_ptr[2] & 0x0F) << 4); dst_ptr++;
-        src_ptr += 4;
-#else
-        *dst_ptr  = *src_ptr++; dst_ptr++;
-        *dst_ptr  = *src_ptr++;
-        *dst_ptr |= ((*src_ptr   & 0x0F) << 4); dst_ptr++;
-        *dst_ptr  = ((*src_ptr++ & 0xF0) >> 4);
-        *dst_ptr |= ((*src_ptr++ & 0x0F) << 4); dst_ptr++;
-#endif
+    for (; i<src_len; i+=2) {
+        dst[((i*3) >> 1)    ] = (uint8_t)(src_ptr[i] & 0xFF);
+        dst[((i*3) >> 1) + 1] = (uint8_t)(((src_ptr[i] >> 8) & 0x0F) | ((src_ptr[i+1] & 0x0F) << 4));
+        dst[((i*3) >> 1) + 2] = (uint8_t)((src_ptr[i+1] >> 4) & 0xFF);
     }
 }
 
@@ -857,12 +894,13 @@ void pack_buffer(const uint8_t *src, int src_len, uint8_t *dst)
  **/
 void unpack_buffer(const uint8_t *src, ff_unit *dst, int dst_len)
 {
-    int32_t i, value;
-    const uint8_t *src_ptr = src;
-
+    int32_t i = 0, value;
+    for (; i+8<=dst_len; i+=8) {
+        unpack_12x8(&src[((i*3) >> 1)], &dst[i]);
+    }
     /* Read three bytes in ago */
-    for (i=0; i<dst_len; i+=2,src_ptr+=3) {
-        value = (*(src_ptr+2) << 16) | (*(src_ptr+1) << 8) | *src_ptr;
+    for (; i<dst_len; i+=2) {
+        value = (src[((i*3) >> 1) + 2] << 16) | (src[((i*3) >> 1) + 1] << 8) | src[((i*3) >> 1)];
         dst[i]   = (value & 0x00000FFF);
         dst[i+1] = (value & 0x00FFF000) >> 12;
     }
@@ -934,6 +972,7 @@ int serialise_private_key(NTSKEM *nts_kem, const matrix_ff2* Q)
     
     memcpy(key_ptr, priv->z, NTS_KEM_KEY_SIZE);
     key_ptr += NTS_KEM_KEY_SIZE;
+    priv->pk = key_ptr;
 
     for (i=0; i<NTS_KEM_PARAM_K; i++) {
         v_ptr = (packed_t *)row_ptr_matrix_ff2(Q, i);
@@ -947,6 +986,32 @@ int serialise_private_key(NTSKEM *nts_kem, const matrix_ff2* Q)
     return NTS_KEM_SUCCESS;
 }
 
+/**
+ *  Initialise an NTS-KEM object in place from a private key,
+ *  without any memory allocation
+ *
+ *  @note
+ *  The public key is not copied, it is read from the private key
+ *  buffer, which has to outlive the object. The object must not
+ *  be released with {@see nts_kem_release}.
+ *
+ *  @param[out] nts_kem  The NTS-KEM object
+ *  @param[out] priv     The private component of the object
+ *  @param[in]  sk       The pointer to NTS-KEM private key
+ **/
+void load_private_key(NTSKEM* nts_kem, NTSKEM_private* priv, const uint8_t *sk)
+{
+    nts_kem->length = NTS_KEM_PARAM_N;
+    nts_kem->t = NTS_KEM_PARAM_T;
+    nts_kem->public_key = nts_kem->private_key = NULL;
+    nts_kem->public_key_size = 0;
+    nts_kem->private_key_size = NTS_KEM_PRIVATE_KEY_SIZE;
+    nts_kem->priv = priv;
+    priv->m = NTS_KEM_PARAM_M;
+    priv->ff2m = ff_create(priv->m);
+    deserialise_private_key(nts_kem, sk);
+}
+
 /**
  *  Deserialise NTS-KEM private key
  *
@@ -974,8 +1039,8 @@ int deserialise_private_key(NTSKEM* nts_kem, const uint8_t *buf)
     memcpy(priv->z, buf, NTS_KEM_KEY_SIZE);
     buf += NTS_KEM_KEY_SIZE;
 
-    /* Deserialise public-key */
-    memcpy(priv->pk, buf, NTS_KEM_PUBLIC_KEY_SIZE);
+    /* The public-key is used in place */
+    priv->pk = buf;
 
     return NTS_KEM_SUCCESS;
 }
@@ -1021,20 +1086,16 @@ int encapsulate(const uint8_t *e,
     int status = NTS_KEM_BAD_MEMORY_ALLOCATION;
     int32_t i, j, l;
     packed_t v;
-    const uint8_t *pk_ptr = pk;
     uint64_t c_c[NTS_KEM_PARAM_R_VEC];
-    uint64_t Q[NTS_KEM_PARAM_K][NTS_KEM_PARAM_R_VEC];
+    uint64_t q[NTS_KEM_PARAM_R_VEC];
     uint8_t kr_in_buf[kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_N_BYTE];
     uint8_t k_e[kNTSKEMKeysize];
 
     /**
-     * Populate the generator matrix, but only the parity section
+     * The rows of the parity section Q of the generator matrix
+     * are read from the public key as they are needed
      **/
-    for (i=0; i<NTS_KEM_PARAM_K; i++) {
-        Q[i][NTS_KEM_PARAM_R_VEC-1] = 0ULL;
-        memcpy(Q[i], pk_ptr, NTS_KEM_PARAM_CEIL_R_BYTE);
-        pk_ptr += NTS_KEM_PARAM_CEIL_R_BYTE;
-    }
+    q[NTS_KEM_PARAM_R_VEC-1] = 0ULL;
 
     /**
      * Step 3. Compute SHA3_256(e) to produce k_e
@@ -1068,8 +1129,9 @@ int encapsulate(const uint8_t *e,
             l = BITSIZE - ((l >> 3) << 3) - (8 - (l & 7));
 #endif
             l += (BITSIZE*i);
+            memcpy(q, &pk[l*NTS_KEM_PARAM_CEIL_R_BYTE], NTS_KEM_PARAM_CEIL_R_BYTE);
             for (j=0; j<NTS_KEM_PARAM_R_VEC; j++) {
-                c_c[j] ^= Q[l][j];
+                c_c[j] ^= q[j];
             }
         }
     }
@@ -1082,8 +1144,9 @@ int encapsulate(const uint8_t *e,
         l = BITSIZE - ((l >> 3) << 3) - (8 - (l & 7));
 #endif
         l += (BITSIZE*i);
+        memcpy(q, &pk[l*NTS_KEM_PARAM_CEIL_R_BYTE], NTS_KEM_PARAM_CEIL_R_BYTE);
         for (j=0; j<NTS_KEM_PARAM_R_VEC; j++) {
-            c_c[j] ^= Q[l][j];
+            c_c[j] ^= q[j];
         }
     }
     for (i=0; i<NTS_KEM_PARAM_B >> LOG2; i++) {
@@ -1095,8 +1158,9 @@ int encapsulate(const uint8_t *e,
             l = BITSIZE - ((l >> 3) << 3) - (8 - (l & 7));
 #endif
             l += ((BITSIZE*i) + NTS_KEM_PARAM_A);
+            memcpy(q, &pk[l*NTS_KEM_PARAM_CEIL_R_BYTE], NTS_KEM_PARAM_CEIL_R_BYTE);
             for (j=0; j<NTS_KEM_PARAM_R_VEC; j++) {
-                c_c[j] ^= Q[l][j];
+                c_c[j] ^= q[j];
             }
         }
     }
@@ -1138,6 +1202,7 @@ int encapsulate(const uint8_t *e,
     sha3_256(kr_in_buf, kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_N_BYTE, k_r);
 
     status = NTS_KEM_SUCCESS;
+    CT_memset(q, 0, sizeof(q));
     CT_memset(kr_in_buf, 0, kNTSKEMKeysize + NTS_KEM_PARAM_CEIL_N_BYTE);
 
     return status;
@@ -1163,7 +1228,7 @@ int encapsulate(const uint8_t *e,
 int compute_syndrome(const NTSKEM* nts_kem, const uint64_t *c_ptr, ff_unit* s)
 {
     int32_t i, j;
-    FF2m *ff2m = NULL;
+    const FF2m *ff2m = NULL;
     NTSKEM_private *priv = NULL;
     uint64_t a[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
     uint64_t g[NTS_KEM_PARAM_BC_VEC][NTS_KEM_PARAM_M];
@@ -1184,15 +1249,15 @@ int compute_syndrome(const NTSKEM* nts_kem, const uint64_t *c_ptr, ff_unit* s)
         for (j=0; j<NTS_KEM_PARAM_M; j++)
             g[i][j] &= *c_ptr;
         c_ptr++;
-        s[0] ^= ff2m->vector_ff_transpose_xor(ff2m, g[i]);
+        s[0] ^= vector_ff_transpose_xor_12(ff2m, g[i]);
         for (j=1; j<=2*NTS_KEM_PARAM_T-2; j+=2) {
-            ff2m->vector_ff_mul(ff2m, h[i], a[i], g[i]);
-            s[j]   ^= ff2m->vector_ff_transpose_xor(ff2m, h[i]);
-            ff2m->vector_ff_mul(ff2m, g[i], a[i], h[i]);
-            s[j+1] ^= ff2m->vector_ff_transpose_xor(ff2m, g[i]);
+            vector_ff_mul_12(ff2m, h[i], a[i], g[i]);
+            s[j]   ^= vector_ff_transpose_xor_12(ff2m, h[i]);
+            vector_ff_mul_12(ff2m, g[i], a[i], h[i]);
+            s[j+1] ^= vector_ff_transpose_xor_12(ff2m, g[i]);
         }
-        ff2m->vector_ff_mul(ff2m, h[i], a[i], g[i]);
-        s[j] ^= ff2m->vector_ff_transpose_xor(ff2m, h[i]);
+        vector_ff_mul_12(ff2m, h[i], a[i], g[i]);
+        s[j] ^= vector_ff_transpose_xor_12(ff2m, h[i]);
     }
     
     CT_memset(a, 0, sizeof(a));
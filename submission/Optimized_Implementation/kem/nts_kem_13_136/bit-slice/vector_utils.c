@@ -19,6 +19,59 @@
 #undef bit_value
 #define bit_value(v,i)          (((v)[(i)>>6] & (1ULL<<((i) & 63))) >> ((i) & 63))
 
+/* Transpose an 8x8 bit matrix stored one row per byte */
+static inline uint64_t transpose_8x8(uint64_t x)
+{
+    uint64_t t;
+
+    t = (x ^ (x >>  7)) & 0x00AA00AA00AA00AAULL; x ^= t ^ (t <<  7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL; x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL; x ^= t ^ (t << 28);
+    return x;
+}
+
+/* Bitslice 64 field elements, 8 at a time as two 8x8 bit matrices */
+static void load_block_64(uint64_t b[PARAM_M], const uint16_t* a)
+{
+    int32_t i, j, k;
+    uint64_t lo, hi;
+
+    for (i=0; i<PARAM_M; i++)
+        b[i] = 0ULL;
+    for (j=0; j<8; j++) {
+        lo = hi = 0ULL;
+        for (k=0; k<8; k++) {
+            lo |= (uint64_t)(a[8*j + k] & 0xFF) << (8*k);
+            hi |= (uint64_t)(a[8*j + k] >> 8) << (8*k);
+        }
+        lo = transpose_8x8(lo);
+        hi = transpose_8x8(hi);
+        for (i=0; i<8; i++)
+            b[i] |= ((lo >> (8*i)) & 0xFF) << (8*j);
+        for (i=8; i<PARAM_M; i++)
+            b[i] |= ((hi >> (8*(i-8))) & 0xFF) << (8*j);
+    }
+}
+
+/* Inverse of load_block_64 */
+static void store_block_64(uint16_t* b, const uint64_t a[PARAM_M])
+{
+    int32_t i, j, k;
+    uint64_t lo, hi;
+
+    for (j=0; j<8; j++) {
+        lo = hi = 0ULL;
+        for (i=0; i<8; i++)
+            lo |= ((a[i] >> (8*j)) & 0xFF) << (8*i);
+        for (i=8; i<PARAM_M; i++)
+            hi |= ((a[i] >> (8*j)) & 0xFF) << (8*(i-8));
+        lo = transpose_8x8(lo);
+        hi = transpose_8x8(hi);
+        for (k=0; k<8; k++)
+            b[8*j + k] = (uint16_t)(((lo >> (8*k)) & 0xFF) | (((hi >> (8*k)) & 0xFF) << 8));
+    }
+}
+
 uint64_t vector_ff_or_64(const uint64_t *in)
 {
     int32_t i;
@@ -42,21 +95,17 @@ void vector_load_1d_64(uint64_t b[PARAM_M], const uint16_t* a, int32_t size)
 
 void vector_load_2d_64(uint64_t (*b)[PARAM_M], const uint16_t* a, int32_t size)
 {
-    int32_t i, j, k;
+    int32_t j;
+    uint16_t t[64];
 
-    for (i=0; i<PARAM_M; i++) {
-        for (j=0; j<size/64; j++) {
-            b[j][i] = 0ULL;
-            for (k=0; k<64; k++) {
-                b[j][i] |= ((uint64_t)((a[64*j + k] >> i) & 1) << k);
-            }
-        }
-        if (size & 0x3F) {
-            b[j][i] = 0ULL;
-            for (k=0; k<(size & 0x3F); k++) {
-                b[j][i] |= ((uint64_t)((a[64*j + k] >> i) & 1) << k);
-            }
-        }
+    for (j=0; j<size/64; j++) {
+        load_block_64(b[j], &a[64*j]);
+    }
+    if (size & 0x3F) {
+        CT_memset(t, 0, sizeof(t));
+        memcpy(t, &a[64*j], (size & 0x3F)*sizeof(uint16_t));
+        load_block_64(b[j], t);
+        CT_memset(t, 0, sizeof(t));
     }
 }
 
@@ -74,22 +123,15 @@ void vector_store_1d_64(uint16_t* b, const uint64_t a[PARAM_M], int32_t size)
 
 void vector_store_2d_64(uint16_t* b, const uint64_t (*a)[PARAM_M], int32_t size)
 {
-    int32_t i, j, k;
-    uint64_t v[1];
-    
-    CT_memset(b, 0, size*sizeof(uint16_t));
-    for (i=0; i<PARAM_M; i++) {
-        for (j=0; j<size/64; j++) {
-            v[0] = a[j][i];
-            for (k=0; k<64; k++) {
-                b[j*64 + k] |= (bit_value(v, k) << i);
-            }
-        }
-        if (size & 0x3F) {
-            v[0] = a[j][i];
-            for (k=0; k<(size & 0x3F); k++) {
-                b[j*64 + k] |= (bit_value(v, k) << i);
-            }
-        }
+    int32_t j;
+    uint16_t t[64];
+
+    for (j=0; j<size/64; j++) {
+        store_block_64(&b[64*j], a[j]);
+    }
+    if (size & 0x3F) {
+        store_block_64(t, a[j]);
+        memcpy(&b[64*j], t, (size & 0x3F)*sizeof(uint16_t));
+        CT_memset(t, 0, sizeof(t));
     }
 }
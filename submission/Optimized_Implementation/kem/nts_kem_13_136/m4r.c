@@ -30,8 +30,9 @@
 
 #define STRIPE_SIZE         8
 #define STRIPE_SIZE_LOG     3
-#define NUM_GRAY_TABLES     8
-#define NUM_GRAY_TABLES_LOG 3
+#define NUM_GRAY_TABLES     4
+#define NUM_GRAY_TABLES_LOG 2
+#define M4R_BLOCK_SIZE      128  /* Number of packed_t per column block */
 #define M4R_ROW(M, r)       ((uint8_t *)(M)->v + ((r) * (M)->stride))
 #define GRAY_TO_BIN(x)      ((x) ^ ((x) >> 1))
 
@@ -73,27 +74,31 @@ const uint8_t* _gray_codes_lut[] = {
     _gray_codes_lut7, _gray_codes_lut8
 };
 
-static inline void zero_vector(uint8_t *row_ptr, uint32_t stride)
-{
-    CT_memset(row_ptr, 0, stride);
-}
-
+/**
+ *  Construct the Gray-code table T of the `k` rows of B ending at
+ *  row `r_end`, over the columns [0, c_end)
+ *
+ *  @note
+ *  Each row of T is written over (c_end + MOD) >> LOG2 blocks, plus
+ *  one cleared block so that tables of adjacent stripes can be added
+ *  together over the same number of blocks
+ **/
 void _m4ri_make_table_rev(matrix_ff2* T,
                           const matrix_ff2* B,
                           uint32_t r_end,
                           uint32_t c_end,
                           uint32_t k)
 {
-    int32_t i, j, is_zero, nblocks;
+    int32_t i, j, is_zero, nblocks, ncleared;
     const uint8_t *gray_codes_lut;
 
-    packed_t *B_ptr = NULL;
-    packed_t *S_ptr = NULL;
+    const packed_t *B_ptr = NULL;
+    const packed_t *S_ptr = NULL;
     packed_t *T_ptr = NULL;
-    packed_t *U_ptr = NULL;
     packed_t mask = 0;
     
     nblocks = ((c_end + MOD) >> LOG2);
+    ncleared = CT_min(nblocks + 1, T->nblocks);
     
     /**
      * This is equivalent to
@@ -105,40 +110,30 @@ void _m4ri_make_table_rev(matrix_ff2* T,
     mask = mask ^ (-is_zero & (~mask ^ mask));
 
     /* Note: the 0-th row of T is always 00...0 */
-    zero_vector(M4R_ROW(T, 0), T->stride);
+    T_ptr = (packed_t *)M4R_ROW(T, 0);
+    for (j=0; j<ncleared; j++) T_ptr[j] = 0;
     
-    /* 1-st row of T, starting at block l */
-    zero_vector(M4R_ROW(T, 1), T->stride);
-
-    S_ptr = T_ptr = ((packed_t *)M4R_ROW(T, 1));
-    /* r_start-th row of B, starting at block l */
-    B_ptr = ((packed_t *)M4R_ROW(B, r_end-k));
-
-    for (j=0; j<nblocks; j++) {
-        *T_ptr = *B_ptr++;
-        T_ptr++;
-    }
-    S_ptr[nblocks-1] &= mask; /* Clear unwanted bits */
+    /* 1-st row of T is the (r_end-k)-th row of B */
+    T_ptr = (packed_t *)M4R_ROW(T, 1);
+    B_ptr = (const packed_t *)M4R_ROW(B, r_end-k);
+    for (j=0; j<nblocks; j++) T_ptr[j] = B_ptr[j];
+    T_ptr[nblocks-1] &= mask; /* Clear unwanted bits */
+    for (j=nblocks; j<ncleared; j++) T_ptr[j] = 0;
     
     /* S_ptr is a pointer to the previous row of T */
+    S_ptr = T_ptr;
     
     /* Subsequent rows of T */
     gray_codes_lut = _gray_codes_lut[k];
     for (i=2; i<(1 << k); i++) {
-        /* i-th row of T, starting at block l */
-        j = GRAY_TO_BIN(i);
-        zero_vector(M4R_ROW(T, j), T->stride);
-        U_ptr = T_ptr = ((packed_t *)M4R_ROW(T, j));
-        /* (r+Gray[i])-th row of B, starting at block l */
-        B_ptr = ((packed_t *)M4R_ROW(B, r_end - k + gray_codes_lut[i-1]));
-
-        for (j=0; j<nblocks; j++) {
-            *T_ptr = (*S_ptr++ ^ *B_ptr++);
-            T_ptr++;
-        }
-        U_ptr[nblocks-1] &= mask; /* Clear unwanted bits */
+        /* i-th row of T is the previous row added with (r+Gray[i])-th row of B */
+        T_ptr = (packed_t *)M4R_ROW(T, GRAY_TO_BIN(i));
+        B_ptr = (const packed_t *)M4R_ROW(B, r_end - k + gray_codes_lut[i-1]);
+        for (j=0; j<nblocks; j++) T_ptr[j] = S_ptr[j] ^ B_ptr[j];
+        T_ptr[nblocks-1] &= mask; /* Clear unwanted bits */
+        for (j=nblocks; j<ncleared; j++) T_ptr[j] = 0;
         
-        S_ptr = U_ptr; /* Pointer to the previous row of T */
+        S_ptr = T_ptr;
     }
 }
 
@@ -185,44 +180,97 @@ static inline void _m4ri_add_rows_rev(packed_t *dst,
     dst[nblocks-1] ^= (*src_ptr & mask);
 }
 
-static inline void _m4ri_add_rows_rev_from_gray_table(matrix_ff2* A,
-                                                      const matrix_ff2 *T,
-                                                      uint32_t r_start,
-                                                      uint32_t r_end,
-                                                      uint32_t c_end,
-                                                      uint32_t k)
+/**
+ *  Read `k` bits (k <= STRIPE_SIZE) of a row starting at column `col`
+ **/
+static inline uint32_t _m4ri_read_bits(const packed_t *v, uint32_t col, uint32_t k)
 {
-    int32_t i;
-    uint8_t *ptr, *prev_ptr, x, x0, x1, mask;
-    uint32_t hi, lo;
-    int8_t prev_offset = 0;
-    uint8_t mask_hi = 0, mask_lo = 0;
+    uint32_t block = col >> LOG2, spot = col & MOD;
+    packed_t x = v[block] >> spot;
     
-    hi = (c_end-1) >> 3;
-    lo = (c_end-k) >> 3;
-    mask_hi = (1 << (c_end & 7))-1;
-    mask_lo = ~((1 << ((c_end-k) & 7))-1);
-    mask = (mask_hi & mask_lo);
-    mask = CT_mux(CT_is_equal_zero(mask_hi), mask_lo, mask);
+    if (spot + k > BITSIZE)
+        x |= v[block + 1] << (BITSIZE - spot);
     
-#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
-    prev_offset = (int8_t)CT_mux(CT_is_equal_zero(hi & 7), (int8_t)-15, (int8_t)1);
-#else
-    prev_offset = -1;
-#endif
-    for (i=(int32_t)r_start-1; i>=(int32_t)r_end; i--) {
-#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
-        ptr = M4R_ROW(A, i) + hi - (2*(hi & 7)-7);
-#else
-        ptr = M4R_ROW(A, i) + hi;
-#endif
-        prev_ptr = ptr + prev_offset;
-        x0 = (((*ptr & mask_hi) << (STRIPE_SIZE - ((c_end-k) & 7))) |
-              ((*prev_ptr & mask_lo) >> ((c_end-k) & 7)));
-        x1 = (*ptr & mask) >> ((c_end-k) & 7);
-        x = (uint8_t)CT_mux(CT_is_equal(hi, lo), x1, x0);
-        x &= ((1 << k)-1);
-        _m4ri_add_rows_rev((packed_t *)M4R_ROW(A, i), (const packed_t *)M4R_ROW(T, x), c_end);
+    return (uint32_t)(x & ((ONE << k)-1));
+}
+
+/**
+ *  Add to row `dst` the rows `src[0], src[1], ..., src[n-1]` over
+ *  the blocks [start, end) and store the output at row `dst`
+ *
+ *  @note
+ *  The loops are written so that the compiler can vectorise them
+ *  with the widest vector available to the target
+ **/
+static inline void _m4ri_add_rows_multi(packed_t *restrict dst,
+                                        const packed_t *const *src,
+                                        int32_t n,
+                                        int32_t start,
+                                        int32_t end)
+{
+    int32_t j;
+    const packed_t *restrict s0 = src[0];
+    const packed_t *restrict s1 = src[1];
+    const packed_t *restrict s2 = src[2];
+    const packed_t *restrict s3 = src[3];
+    
+    switch (n) {
+        case 4:
+            for (j=start; j<end; j++) dst[j] ^= (s0[j] ^ s1[j]) ^ (s2[j] ^ s3[j]);
+            break;
+        case 3:
+            for (j=start; j<end; j++) dst[j] ^= (s0[j] ^ s1[j]) ^ s2[j];
+            break;
+        case 2:
+            for (j=start; j<end; j++) dst[j] ^= s0[j] ^ s1[j];
+            break;
+        default:
+            for (j=start; j<end; j++) dst[j] ^= s0[j];
+    }
+}
+
+/**
+ *  Eliminate the columns [c_end-k, c_end) from the rows [r_end, r_start)
+ *  of A using the Gray-code tables T[0], T[1], ..., one table for every
+ *  STRIPE_SIZE columns, in a single pass over each row.
+ *
+ *  @note
+ *  The table indices of all rows are read first, then the row additions
+ *  are done in blocks of M4R_BLOCK_SIZE columns so that the slices of the
+ *  tables in use stay in the cache while all the rows are visited.
+ **/
+static inline void _m4ri_add_rows_rev_from_gray_tables(matrix_ff2* A,
+                                                       matrix_ff2 *const *T,
+                                                       uint8_t *index,
+                                                       uint32_t r_start,
+                                                       uint32_t r_end,
+                                                       uint32_t c_end,
+                                                       uint32_t k)
+{
+    int32_t i, t, nt, start, end, nblocks;
+    uint32_t kt;
+    uint8_t *x = NULL;
+    const packed_t *src[NUM_GRAY_TABLES] = {NULL};
+    
+    nt = (int32_t)((k + STRIPE_SIZE - 1) >> STRIPE_SIZE_LOG);
+    nblocks = (int32_t)((c_end + MOD) >> LOG2);
+    
+    for (i=(int32_t)r_end, x=index; i<(int32_t)r_start; i++, x+=NUM_GRAY_TABLES) {
+        for (t=0; t<nt; t++) {
+            kt = CT_min(STRIPE_SIZE, k - t*STRIPE_SIZE);
+            x[t] = (uint8_t)_m4ri_read_bits((const packed_t *)M4R_ROW(A, i),
+                                            c_end - t*STRIPE_SIZE - kt, kt);
+        }
+    }
+    
+    for (start=0; start<nblocks; start+=M4R_BLOCK_SIZE) {
+        end = CT_min(start + M4R_BLOCK_SIZE, nblocks);
+        for (i=(int32_t)r_end, x=index; i<(int32_t)r_start; i++, x+=NUM_GRAY_TABLES) {
+            for (t=0; t<nt; t++) {
+                src[t] = (const packed_t *)M4R_ROW(T[t], x[t]);
+            }
+            _m4ri_add_rows_multi((packed_t *)M4R_ROW(A, i), src, nt, start, end);
+        }
     }
 }
 
@@ -274,24 +322,30 @@ uint32_t _m4ri_gauss_submatrix(matrix_ff2* A,
 
 uint32_t m4r_rref(matrix_ff2* A)
 {
-    int32_t r = 0, c = 0, rank = 0;
-    int32_t k = STRIPE_SIZE, rk;
-    matrix_ff2 *T = NULL;
+    int32_t i, r = 0, c = 0, rank = 0;
+    int32_t k, kt, rk;
+    matrix_ff2 *T[NUM_GRAY_TABLES] = {NULL};
+    uint8_t *index = NULL;
     
-    if (!(T = alloc_matrix_ff2(sizeof(_gray_codes_lut8), A->ncols)))
-        return 0;
+    for (i=0; i<NUM_GRAY_TABLES; i++) {
+        if (!(T[i] = alloc_matrix_ff2(sizeof(_gray_codes_lut8), A->ncols)))
+            goto m4r_rref_fail;
+    }
+    if (!(index = (uint8_t *)malloc(A->nrows * NUM_GRAY_TABLES)))
+        goto m4r_rref_fail;
     
     r = A->nrows;
     c = A->ncols;
     while (c > 0) {
-        if (c - k < 0) {
-            k = c;
-        }
+        k = CT_min(NUM_GRAY_TABLES * STRIPE_SIZE, c);
         rk = _m4ri_gauss_submatrix(A, r, c, 0, k);
         if (rk > 0) {
-            _m4ri_make_table_rev(T, A, r, c, rk);
-            _m4ri_add_rows_rev_from_gray_table(A, T, r-rk, 0, c, rk);
-            _m4ri_add_rows_rev_from_gray_table(A, T, A->nrows, r, c, rk);
+            for (i=0; i*STRIPE_SIZE<rk; i++) {
+                kt = CT_min(STRIPE_SIZE, rk - i*STRIPE_SIZE);
+                _m4ri_make_table_rev(T[i], A, r - i*STRIPE_SIZE, c - i*STRIPE_SIZE, kt);
+            }
+            _m4ri_add_rows_rev_from_gray_tables(A, T, index, r-rk, 0, c, rk);
+            _m4ri_add_rows_rev_from_gray_tables(A, T, index, A->nrows, r, c, rk);
         }
         r -= rk;
         c -= rk;
@@ -300,8 +354,17 @@ uint32_t m4r_rref(matrix_ff2* A)
             --c;
     }
     
-    free_matrix_ff2(T);
+m4r_rref_fail:
+    if (index) {
+        CT_memset(index, 0, A->nrows * NUM_GRAY_TABLES);
+        free(index);
+    }
+    for (i=0; i<NUM_GRAY_TABLES; i++) {
+        if (T[i]) {
+            zero_matrix_ff2(T[i]);
+            free_matrix_ff2(T[i]);
+        }
+    }
     
     return (uint32_t)rank;
-
 }
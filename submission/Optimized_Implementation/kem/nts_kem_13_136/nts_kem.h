@@ -88,6 +88,10 @@ int nts_kem_encapsulate(const uint8_t *pk,
 /**
  *  NTS-KEM decapsulation
  *
+ *  @note
+ *  No memory is allocated, the private key is unpacked to the stack
+ *  and the public key within it is used in place
+ *
  *  @param[in]  sk      The pointer to NTS-KEM private key
  *  @param[in]  c_ast   The pointer to the NTS-KEM ciphertext
  *  @param[out] k_r     The pointer to the encapsulated key
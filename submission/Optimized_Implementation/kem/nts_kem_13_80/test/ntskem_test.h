@@ -15,4 +15,6 @@
 
 int testkem_nts(int iterations);
 
+int testkem_ff_mul();
+
 #endif /* _NTSKEM_TEST_H */